@@ -0,0 +1,71 @@
+using BenchmarkDotNet.Attributes;
+using System;
+using System.IO;
+using System.TBA;
+using System.Threading.Tasks;
+
+namespace Benchmarks;
+
+// Compares capturing large output into a chain of pooled segments that is copied into one array at the end (CaptureCombined)
+// with returning the segments as they are (CaptureOutputBytes), and decoding them (CaptureOutput).
+[BenchmarkCategory(nameof(CaptureBytes))]
+public class CaptureBytes
+{
+    private string? _filePath;
+    private ProcessStartOptions _options = null!;
+
+    [Params(1, 100, 1024)]
+    public int SizeInMegabytes { get; set; }
+
+    [GlobalSetup]
+    public void Setup()
+    {
+        _filePath = Path.GetTempFileName();
+        using (FileStream file = File.OpenWrite(_filePath))
+        {
+            file.SetLength(SizeInMegabytes * 1024L * 1024L);
+        }
+
+        _options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "type", _filePath } }
+            : new("cat") { Arguments = { _filePath } };
+    }
+
+    [GlobalCleanup]
+    public void Cleanup() => File.Delete(_filePath!);
+
+    [Benchmark(Baseline = true)]
+    public long CaptureCombined()
+    {
+        CombinedOutput output = ChildProcess.CaptureCombined(_options);
+        return output.Bytes.Length;
+    }
+
+    [Benchmark]
+    public long CaptureOutputBytes()
+    {
+        using ProcessOutputBytes output = ChildProcess.CaptureOutputBytes(_options);
+        return output.StandardOutput.Length;
+    }
+
+    [Benchmark]
+    public long CaptureOutput()
+    {
+        ProcessOutput output = ChildProcess.CaptureOutput(_options);
+        return output.StandardOutput.Length;
+    }
+
+    [Benchmark]
+    public async Task<long> CaptureCombinedAsync()
+    {
+        CombinedOutput output = await ChildProcess.CaptureCombinedAsync(_options);
+        return output.Bytes.Length;
+    }
+
+    [Benchmark]
+    public async Task<long> CaptureOutputBytesAsync()
+    {
+        using ProcessOutputBytes output = await ChildProcess.CaptureOutputBytesAsync(_options);
+        return output.StandardOutput.Length;
+    }
+}
@@ -0,0 +1,42 @@
+using BenchmarkDotNet.Attributes;
+using System;
+using System.TBA;
+
+namespace Benchmarks;
+
+// Measures the fixed cost of capturing the output of processes that exit immediately: what is left after the spawn
+// is the time it takes to notice that the output is complete (EOF on the pipes after the exit of the process).
+[BenchmarkCategory(nameof(CaptureLatency))]
+public class CaptureLatency
+{
+    private ProcessStartOptions _true = null!, _echo = null!;
+
+    [GlobalSetup]
+    public void Setup()
+    {
+        _true = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "exit", "0" } }
+            : ProcessStartOptions.ResolvePath("true");
+
+        _echo = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo", "hello" } }
+            : ProcessStartOptions.ResolvePath("echo");
+        if (!OperatingSystem.IsWindows())
+        {
+            _echo.Arguments.Add("hello");
+        }
+    }
+
+    // No pipes: the cost of starting and waiting for the process.
+    [Benchmark(Baseline = true)]
+    public int Discard_True() => ChildProcess.Discard(_true).ExitCode;
+
+    [Benchmark]
+    public int CaptureOutput_True() => ChildProcess.CaptureOutput(_true).ExitStatus.ExitCode;
+
+    [Benchmark]
+    public int CaptureOutput_Echo() => ChildProcess.CaptureOutput(_echo).StandardOutput.Length;
+
+    [Benchmark]
+    public int CaptureCombined_Echo() => ChildProcess.CaptureCombined(_echo).Bytes.Length;
+}
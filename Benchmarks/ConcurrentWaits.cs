@@ -0,0 +1,133 @@
+using BenchmarkDotNet.Attributes;
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.IO;
+using System.TBA;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Benchmarks;
+
+// Measures the latency of observing the exit of many processes that exit at the same time,
+// and how many thread pool threads are needed to serve the pending waits.
+// All the processes read the same pipe, so closing its write end makes all of them exit at once.
+// WaitAll observes all the exits with a single kernel wait, WaitForExitsAsync reports them in completion order.
+[BenchmarkCategory(nameof(ConcurrentWaits))]
+public class ConcurrentWaits
+{
+    private SafeChildProcessHandle[] _handles = null!;
+    private SafeFileHandle _writePipe = null!;
+    private Task[] _waits = null!;
+    private int _maxThreadCount;
+
+    [Params(10, 100, 1000)]
+    public int Count { get; set; }
+
+    [IterationSetup(Target = nameof(BlockingWaitPerTask))]
+    public void Setup_BlockingWaitPerTask()
+    {
+        StartProcesses();
+
+        // What WaitForExitAsync used to do: block a thread pool thread for every pending wait.
+        for (int i = 0; i < _handles.Length; i++)
+        {
+            SafeChildProcessHandle handle = _handles[i];
+            _waits[i] = Task.Run(() => handle.WaitForExit());
+        }
+    }
+
+    [IterationSetup(Target = nameof(WaitForExitAsync))]
+    public void Setup_WaitForExitAsync()
+    {
+        StartProcesses();
+
+        for (int i = 0; i < _handles.Length; i++)
+        {
+            _waits[i] = _handles[i].WaitForExitAsync();
+        }
+    }
+
+    [IterationSetup(Targets = [nameof(WaitAll), nameof(WaitForExitsAsync)])]
+    public void Setup_SingleWait() => StartProcesses();
+
+    [Benchmark(Baseline = true)]
+    public void BlockingWaitPerTask() => ReleaseAndWait();
+
+    [Benchmark]
+    public void WaitForExitAsync() => ReleaseAndWait();
+
+    // A single kernel wait for all the processes, on the current thread.
+    [Benchmark]
+    public void WaitAll()
+    {
+        _writePipe.Dispose();
+
+        SafeChildProcessHandle.WaitAll(_handles, Timeout.InfiniteTimeSpan);
+
+        // WaitAll does not reap the processes, the other benchmarks do.
+        foreach (SafeChildProcessHandle handle in _handles)
+        {
+            handle.WaitForExit();
+        }
+
+        _maxThreadCount = Math.Max(_maxThreadCount, ThreadPool.ThreadCount);
+    }
+
+    [Benchmark]
+    public async Task WaitForExitsAsync()
+    {
+        _writePipe.Dispose();
+
+        await foreach ((SafeChildProcessHandle, ProcessExitStatus) _ in SafeChildProcessHandle.WaitForExitsAsync(_handles))
+        {
+        }
+
+        _maxThreadCount = Math.Max(_maxThreadCount, ThreadPool.ThreadCount);
+    }
+
+    [IterationCleanup]
+    public void Cleanup()
+    {
+        foreach (SafeChildProcessHandle handle in _handles)
+        {
+            handle.Dispose();
+        }
+    }
+
+    [GlobalCleanup]
+    public void ReportThreadCount() => Console.WriteLine($"// Max thread pool thread count: {_maxThreadCount}");
+
+    private void StartProcesses()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? ProcessStartOptions.ResolvePath("findstr.exe")
+            : ProcessStartOptions.ResolvePath("cat");
+
+        if (OperatingSystem.IsWindows())
+        {
+            options.Arguments.Add("x");
+        }
+
+        File.CreatePipe(out SafeFileHandle readPipe, out _writePipe);
+
+        using (readPipe)
+        {
+            _handles = new SafeChildProcessHandle[Count];
+            for (int i = 0; i < _handles.Length; i++)
+            {
+                _handles[i] = SafeChildProcessHandle.Start(options, input: readPipe, output: null, error: null);
+            }
+        }
+
+        _waits = new Task[Count];
+    }
+
+    private void ReleaseAndWait()
+    {
+        _writePipe.Dispose();
+
+        Task.WaitAll(_waits);
+
+        _maxThreadCount = Math.Max(_maxThreadCount, ThreadPool.ThreadCount);
+    }
+}
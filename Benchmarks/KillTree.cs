@@ -2,6 +2,7 @@
 using Microsoft.Win32.SafeHandles;
 using System;
 using System.Diagnostics;
+using System.IO;
 using System.TBA;
 
 namespace Benchmarks;
@@ -63,4 +64,90 @@ public class KillTree
         _childProcessHandle!.KillProcessGroup();
         _childProcessHandle.WaitForExit();
     }
+
+    [IterationSetup(Target = nameof(SafeProcessHandle_KillProcessTree))]
+    public void Setup_Isolated()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("powershell")
+            {
+                Arguments = { "-Command", "Start-Process timeout -ArgumentList '/t','30','/nobreak' -NoNewWindow; Start-Process timeout -ArgumentList '/t','30','/nobreak' -NoNewWindow; Start-Process timeout -ArgumentList '/t','30','/nobreak' -NoNewWindow; timeout /t 30 /nobreak" },
+            }
+            : new("sh")
+            {
+                Arguments = { "-c", "sleep 30 & sleep 30 & sleep 30 & sleep 30 & wait" },
+            };
+        options.IsolateProcessTree = true;
+
+        SafeFileHandle? stdin = OperatingSystem.IsWindows() ? Console.OpenStandardInputHandle() : null;
+        _childProcessHandle = SafeChildProcessHandle.Start(options, input: stdin, output: null, error: null);
+    }
+
+    [Benchmark]
+    public void SafeProcessHandle_KillProcessTree()
+    {
+        _childProcessHandle!.KillProcessTree();
+        _childProcessHandle.WaitForExit();
+    }
+}
+
+/// <summary>
+/// Kills a tree of 1000 processes that started their own sessions (Linux only: IsolateProcessTree requires cgroup v2).
+/// </summary>
+public class KillForkBomb
+{
+    private const string Script = "for i in $(seq 1000); do setsid sleep 30 & done; echo ready; wait";
+
+    private Process? _process;
+    private SafeChildProcessHandle? _childProcessHandle;
+
+    [IterationSetup(Target = nameof(Process_Kill_EntireProcessTree))]
+    public void Setup_Process()
+    {
+        _process = Process.Start(new ProcessStartInfo
+        {
+            FileName = "sh",
+            Arguments = $"-c \"{Script}\"",
+            UseShellExecute = false,
+            RedirectStandardOutput = true
+        })!;
+
+        // All the descendants are running when the iteration starts.
+        _process.StandardOutput.ReadLine();
+    }
+
+    [Benchmark(Baseline = true)]
+    public void Process_Kill_EntireProcessTree()
+    {
+        _process!.Kill(entireProcessTree: true);
+        _process.WaitForExit();
+        _process.Dispose();
+    }
+
+    [IterationSetup(Target = nameof(SafeProcessHandle_KillProcessTree))]
+    public void Setup_Isolated()
+    {
+        ProcessStartOptions options = new("sh")
+        {
+            Arguments = { "-c", Script },
+            IsolateProcessTree = true
+        };
+
+        File.CreatePipe(out SafeFileHandle readPipe, out SafeFileHandle writePipe);
+        using (writePipe)
+        {
+            _childProcessHandle = SafeChildProcessHandle.Start(options, input: null, output: writePipe, error: null);
+        }
+
+        using StreamReader reader = new(new FileStream(readPipe, FileAccess.Read, bufferSize: 1));
+        reader.ReadLine();
+    }
+
+    [Benchmark]
+    public void SafeProcessHandle_KillProcessTree()
+    {
+        _childProcessHandle!.KillProcessTree();
+        _childProcessHandle.WaitForExit();
+        _childProcessHandle.Dispose();
+    }
 }
@@ -0,0 +1,48 @@
+using BenchmarkDotNet.Attributes;
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.TBA;
+
+namespace Benchmarks;
+
+// Repeatedly starting the same command with a custom environment,
+// the managed allocations reported for the template are only the returned handle.
+[BenchmarkCategory(nameof(LaunchTemplate))]
+public class LaunchTemplate
+{
+    private ProcessStartOptions _options = null!;
+    private ProcessLaunchTemplate _template = null!;
+    private readonly string?[] _arguments = new string?[OperatingSystem.IsWindows() ? 4 : 2];
+
+    [GlobalSetup]
+    public void Setup()
+    {
+        _options = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "exit", "--probe", "liveness" } }
+            : new("true") { Arguments = { "--probe", "liveness" } };
+        _options.Environment["HEALTH_CHECK_TIMEOUT"] = "5";
+
+        _template = new(_options);
+        _arguments[^1] = "readiness";
+    }
+
+    [GlobalCleanup]
+    public void Cleanup() => _template.Dispose();
+
+    [Benchmark(Baseline = true)]
+    public void Options() => WaitForExit(SafeChildProcessHandle.Start(_options, input: null, output: null, error: null));
+
+    [Benchmark]
+    public void Template() => WaitForExit(_template.Start(input: null, output: null, error: null));
+
+    [Benchmark]
+    public void Template_ReplacedArgument() => WaitForExit(_template.Start(input: null, output: null, error: null, _arguments));
+
+    private static void WaitForExit(SafeChildProcessHandle handle)
+    {
+        using (handle)
+        {
+            handle.WaitForExit();
+        }
+    }
+}
@@ -1,4 +1,6 @@
 ﻿using BenchmarkDotNet.Attributes;
+using Microsoft.Win32.SafeHandles;
+using System;
 using System.TBA;
 using System.Diagnostics;
 using System.Threading.Tasks;
@@ -76,3 +78,105 @@ public class NoRedirection
     [Benchmark]
     public async Task<int> NewAsync_Resolved() => (await ChildProcess.InheritAsync(_resolved)).ExitCode;
 }
+
+// The cost of building the command line and the environment block for every CreateProcess call (Windows only):
+// the same worker command, with as many arguments and variables as an MSBuild node, started with the options vs a launch template.
+[BenchmarkCategory(nameof(NoRedirectionWorker))]
+public class NoRedirectionWorker
+{
+    private ProcessStartOptions _options = null!;
+    private ProcessLaunchTemplate _template = null!;
+
+    [GlobalSetup]
+    public void Setup()
+    {
+        _options = ProcessStartOptions.ResolvePath("cmd.exe");
+        _options.Arguments.Add("/c");
+        _options.Arguments.Add("exit");
+        foreach (string argument in new[] { "/nologo", "/nodemode:1", "/nodeReuse:false", "/low:false", "/p:Configuration=Release", "/p:Platform=Any CPU" })
+        {
+            _options.Arguments.Add(argument);
+        }
+        for (int i = 0; i < 20; i++)
+        {
+            _options.Environment[$"MSBUILD_WORKER_SETTING_{i}"] = $"C:\\Program Files\\Worker\\{i}";
+        }
+
+        _template = new(_options);
+    }
+
+    [GlobalCleanup]
+    public void Cleanup() => _template.Dispose();
+
+    [Benchmark(Baseline = true)]
+    public void Options() => WaitForExit(SafeChildProcessHandle.Start(_options, input: null, output: null, error: null));
+
+    [Benchmark]
+    public void Template() => WaitForExit(_template.Start(input: null, output: null, error: null));
+
+    private static void WaitForExit(SafeChildProcessHandle handle)
+    {
+        using (handle)
+        {
+            handle.WaitForExit();
+        }
+    }
+}
+
+// Spawn cost from a parent with a large, fully committed heap.
+// Copying the page tables of the parent (fork) gets more expensive with every resident page,
+// while a child sharing the address space of the parent until it calls execve (vfork) does not.
+[BenchmarkCategory(nameof(NoRedirectionLargeHeap))]
+public class NoRedirectionLargeHeap
+{
+    private const int ChunkSize = 64 * 1024 * 1024;
+
+    private byte[][] _heap = null!;
+    private ProcessStartOptions _resolved = null!;
+
+    [Params(0, 4)]
+    public int HeapSizeInGigabytes { get; set; }
+
+    [GlobalSetup]
+    public void Setup()
+    {
+        _heap = new byte[HeapSizeInGigabytes * 1024L * 1024L * 1024L / ChunkSize][];
+        for (int i = 0; i < _heap.Length; i++)
+        {
+            _heap[i] = new byte[ChunkSize];
+            // Touch every page, so it's backed by memory and mapped by the page tables.
+            _heap[i].AsSpan().Fill(1);
+        }
+
+        // A program that exits right away, so the spawn itself dominates.
+        _resolved = ProcessStartOptions.ResolvePath(OperatingSystem.IsWindows() ? "cmd" : "true");
+        if (OperatingSystem.IsWindows())
+        {
+            _resolved.Arguments.Add("/c");
+            _resolved.Arguments.Add("exit");
+        }
+    }
+
+    [GlobalCleanup]
+    public void Cleanup() => _heap = null!;
+
+    [Benchmark(Baseline = true)]
+    public void Old()
+    {
+        ProcessStartInfo info = new()
+        {
+            FileName = _resolved.FileName,
+            UseShellExecute = false
+        };
+        foreach (string argument in _resolved.Arguments)
+        {
+            info.ArgumentList.Add(argument);
+        }
+
+        using Process process = Process.Start(info)!;
+        process.WaitForExit();
+    }
+
+    [Benchmark]
+    public int New() => ChildProcess.Inherit(_resolved).ExitCode;
+}
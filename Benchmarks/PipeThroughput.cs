@@ -0,0 +1,59 @@
+using BenchmarkDotNet.Attributes;
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.IO;
+using System.TBA;
+
+namespace Benchmarks;
+
+// Measures how fast the output of a child that writes as fast as it can ("head -c 4G /dev/zero", Unix only)
+// can be consumed, depending on the capacity of the pipe (0 is the system default, 64 KB on Linux).
+[BenchmarkCategory(nameof(PipeThroughput))]
+public class PipeThroughput
+{
+    private const long ReadLength = 4L * 1024 * 1024 * 1024;
+    private const long CaptureLength = 256L * 1024 * 1024;
+
+    private byte[] _buffer = null!;
+
+    [Params(0, 1024 * 1024)]
+    public int PipeCapacity { get; set; }
+
+    [GlobalSetup]
+    public void Setup() => _buffer = new byte[1024 * 1024];
+
+    // The pipe is read directly, with the largest read size, to show the cost of the context switches alone.
+    [Benchmark(Baseline = true)]
+    public long Read()
+    {
+        File.CreatePipe(out SafeFileHandle read, out SafeFileHandle write, capacity: PipeCapacity);
+
+        using (read)
+        using (SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(CreateProducer(ReadLength), input: null, output: write, error: null))
+        using (FileStream stream = new(read, FileAccess.Read, bufferSize: 0))
+        {
+            long total = 0;
+            int bytesRead;
+            while ((bytesRead = stream.Read(_buffer)) > 0)
+            {
+                total += bytesRead;
+            }
+
+            processHandle.WaitForExit();
+            return total;
+        }
+    }
+
+    // The capture loop grows its reads with the segments of the buffer and, on Linux, grows the default pipe once it finds it full.
+    [Benchmark]
+    public long CaptureOutputBytes()
+    {
+        ProcessStartOptions options = CreateProducer(CaptureLength);
+        options.OutputPipeCapacity = PipeCapacity;
+
+        using ProcessOutputBytes output = ChildProcess.CaptureOutputBytes(options);
+        return output.StandardOutput.Length;
+    }
+
+    private static ProcessStartOptions CreateProducer(long length) => new("head") { Arguments = { "-c", length.ToString(), "/dev/zero" } };
+}
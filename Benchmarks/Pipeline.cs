@@ -0,0 +1,65 @@
+using BenchmarkDotNet.Attributes;
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.IO;
+using System.TBA;
+
+namespace Benchmarks;
+
+// Measures the cost of a three stage pipeline (Unix only): "producer | grep | sort" connected by hand vs StartPipeline.
+[BenchmarkCategory(nameof(Pipeline))]
+public class Pipeline
+{
+    private ProcessStartOptions[] _stages = null!;
+
+    [GlobalSetup]
+    public void Setup()
+    {
+        ProcessStartOptions producer = ProcessStartOptions.ResolvePath("seq");
+        producer.Arguments.Add("10000");
+
+        ProcessStartOptions filter = ProcessStartOptions.ResolvePath("grep");
+        filter.Arguments.Add("7");
+
+        ProcessStartOptions sort = ProcessStartOptions.ResolvePath("sort");
+
+        _stages = [producer, filter, sort];
+    }
+
+    [Benchmark(Baseline = true)]
+    public void Manual()
+    {
+        SafeChildProcessHandle[] handles = new SafeChildProcessHandle[_stages.Length];
+        SafeFileHandle? input = null;
+
+        for (int i = 0; i < _stages.Length; i++)
+        {
+            SafeFileHandle? nextInput = null, output = null;
+            if (i < _stages.Length - 1)
+            {
+                File.CreatePipe(out nextInput, out output);
+            }
+
+            // The write end is closed by Start, the read end has to be closed by us.
+            handles[i] = SafeChildProcessHandle.Start(_stages[i], input, output, error: null);
+            input?.Dispose();
+            input = nextInput;
+        }
+
+        WaitForAll(handles);
+    }
+
+    [Benchmark]
+    public void StartPipeline() => WaitForAll(SafeChildProcessHandle.StartPipeline(_stages, input: null, output: null, error: null));
+
+    private static void WaitForAll(SafeChildProcessHandle[] handles)
+    {
+        foreach (SafeChildProcessHandle handle in handles)
+        {
+            using (handle)
+            {
+                handle.WaitForExit();
+            }
+        }
+    }
+}
@@ -8,6 +8,20 @@ using BenchmarkDotNet.Reports;
 using BenchmarkDotNet.Running;
 using Perfolizer.Horology;
 
+if (args.Length > 0 && args[0] == "--suite")
+{
+    // The per-operation latency suite shared with BenchmarksGo, see Suite.cs.
+    Benchmarks.Suite.Run(args[1..]);
+    return;
+}
+
+if (args.Length > 0 && args[0] == "--startup")
+{
+    // The time to the first child exit of the NativeAOT apps, see Startup.cs.
+    Benchmarks.Startup.Run(args[1..]);
+    return;
+}
+
 var job = Job.Default
     .WithWarmupCount(1) // 1 warmup is enough for our purpose
     .WithIterationTime(TimeInterval.FromMilliseconds(250)) // the default is 0.5s per iteration, which is slighlty too much for us
@@ -1,4 +1,5 @@
 ﻿using BenchmarkDotNet.Attributes;
+using System;
 using System.TBA;
 using System.Diagnostics;
 using System.Threading.Tasks;
@@ -135,3 +136,67 @@ public class RedirectToFile
         return (await ChildProcess.RedirectToFilesAsync(info, inputFile: null, outputFile: _filePath!, errorFile: null)).ExitCode;
     }
 }
+
+// Compares persisting large output by copying it through user space (Process + Stream.CopyTo)
+// with Tee, which moves it from the pipe to the file in the kernel when possible.
+[BenchmarkCategory(nameof(TeeToFile))]
+public class TeeToFile
+{
+    private string? _inputPath;
+    private string? _outputPath;
+    private ProcessStartOptions _options = null!;
+
+    [Params(100, 1024)]
+    public int SizeInMegabytes { get; set; }
+
+    [GlobalSetup]
+    public void Setup()
+    {
+        _inputPath = Path.GetTempFileName();
+        _outputPath = Path.GetTempFileName();
+        using (FileStream file = File.OpenWrite(_inputPath))
+        {
+            file.SetLength(SizeInMegabytes * 1024L * 1024L);
+        }
+
+        _options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "type", _inputPath } }
+            : new("cat") { Arguments = { _inputPath } };
+    }
+
+    [GlobalCleanup]
+    public void Cleanup()
+    {
+        File.Delete(_inputPath!);
+        File.Delete(_outputPath!);
+    }
+
+    [Benchmark(Baseline = true)]
+    public int Old()
+    {
+        using FileStream output = new(_outputPath!, FileMode.Create, FileAccess.Write);
+        using (Process process = new())
+        {
+            process.StartInfo.FileName = _options.FileName;
+            foreach (string argument in _options.Arguments)
+            {
+                process.StartInfo.ArgumentList.Add(argument);
+            }
+            process.StartInfo.RedirectStandardOutput = true;
+
+            process.Start();
+
+            process.StandardOutput.BaseStream.CopyTo(output);
+
+            process.WaitForExit();
+
+            return process.ExitCode;
+        }
+    }
+
+    [Benchmark]
+    public int RedirectToFiles() => ChildProcess.RedirectToFiles(_options, inputFile: null, outputFile: _outputPath!, errorFile: null).ExitCode;
+
+    [Benchmark]
+    public int Tee() => ChildProcess.Tee(_options, _outputPath!).ExitStatus.ExitCode;
+}
@@ -123,6 +123,23 @@ public class RedirectToPipe
         return lines.ExitStatus.ExitCode;
     }
 
+    [Benchmark]
+    public int NewReadLineViews()
+    {
+        ProcessStartOptions info = new("dotnet")
+        {
+            Arguments = { "--help" },
+        };
+
+        var lines = ChildProcess.StreamOutputLines(info);
+        foreach (var line in lines.EnumerateLineViews())
+        {
+            // We don't decode, so the benchmark focuses on reading and splitting only.
+            _ = line.Bytes;
+        }
+        return lines.ExitStatus.ExitCode;
+    }
+
     [Benchmark]
     public int NewCombinedOutput()
     {
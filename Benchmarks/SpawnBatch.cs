@@ -0,0 +1,60 @@
+using BenchmarkDotNet.Attributes;
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.TBA;
+
+namespace Benchmarks;
+
+// Measures the cost of starting many short-lived processes at once.
+// Divide BatchSize by the Mean to get processes per second.
+[BenchmarkCategory(nameof(SpawnBatch))]
+public class SpawnBatch
+{
+    private ProcessStartOptions[] _options = null!;
+
+    [Params(1, 16, 256)]
+    public int BatchSize { get; set; }
+
+    [GlobalSetup]
+    public void Setup()
+    {
+        ProcessStartOptions resolved = OperatingSystem.IsWindows()
+            ? ProcessStartOptions.ResolvePath("cmd.exe")
+            : ProcessStartOptions.ResolvePath("true");
+
+        if (OperatingSystem.IsWindows())
+        {
+            resolved.Arguments.Add("/c");
+            resolved.Arguments.Add("exit");
+        }
+
+        _options = new ProcessStartOptions[BatchSize];
+        Array.Fill(_options, resolved);
+    }
+
+    [Benchmark(Baseline = true)]
+    public void Loop()
+    {
+        SafeChildProcessHandle[] handles = new SafeChildProcessHandle[_options.Length];
+        for (int i = 0; i < _options.Length; i++)
+        {
+            handles[i] = SafeChildProcessHandle.Start(_options[i], input: null, output: null, error: null);
+        }
+
+        WaitForAll(handles);
+    }
+
+    [Benchmark]
+    public void StartMany() => WaitForAll(SafeChildProcessHandle.StartMany(_options, input: null, output: null, error: null));
+
+    private static void WaitForAll(SafeChildProcessHandle[] handles)
+    {
+        foreach (SafeChildProcessHandle handle in handles)
+        {
+            using (handle)
+            {
+                handle.WaitForExit();
+            }
+        }
+    }
+}
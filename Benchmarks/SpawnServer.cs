@@ -0,0 +1,71 @@
+using BenchmarkDotNet.Attributes;
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.TBA;
+
+namespace Benchmarks;
+
+// Spawn cost from a parent with a large, fully committed heap, with and without the spawn server.
+// The server is started before the heap is allocated, as an application would do at startup,
+// so it does not pay for the pages of the parent no matter how large the heap grows.
+[BenchmarkCategory(nameof(SpawnServer))]
+public class SpawnServer
+{
+    private const int ChunkSize = 64 * 1024 * 1024;
+
+    private byte[][] _heap = null!;
+    private ProcessStartOptions _resolved = null!;
+
+    [Params(100, 10240)]
+    public int HeapSizeInMegabytes { get; set; }
+
+    [GlobalSetup(Target = nameof(Direct))]
+    public void SetupDirect() => Setup();
+
+    [GlobalSetup(Target = nameof(Server))]
+    public void SetupServer()
+    {
+        if (!ProcessSpawnServer.Start())
+        {
+            throw new PlatformNotSupportedException("The spawn server is not supported on this platform.");
+        }
+
+        Setup();
+    }
+
+    private void Setup()
+    {
+        long heapSize = HeapSizeInMegabytes * 1024L * 1024L;
+        _heap = new byte[(heapSize + ChunkSize - 1) / ChunkSize][];
+        for (int i = 0; i < _heap.Length; i++)
+        {
+            _heap[i] = new byte[Math.Min(ChunkSize, heapSize - (long)i * ChunkSize)];
+            // Touch every page, so it's backed by memory and mapped by the page tables.
+            _heap[i].AsSpan().Fill(1);
+        }
+
+        // A program that exits right away, so the spawn itself dominates.
+        _resolved = ProcessStartOptions.ResolvePath("true");
+    }
+
+    [GlobalCleanup]
+    public void Cleanup()
+    {
+        ProcessSpawnServer.Stop();
+        _heap = null!;
+    }
+
+    [Benchmark(Baseline = true)]
+    public void Direct() => WaitForExit(SafeChildProcessHandle.Start(_resolved, input: null, output: null, error: null));
+
+    [Benchmark]
+    public void Server() => WaitForExit(SafeChildProcessHandle.Start(_resolved, input: null, output: null, error: null));
+
+    private static void WaitForExit(SafeChildProcessHandle handle)
+    {
+        using (handle)
+        {
+            handle.WaitForExit();
+        }
+    }
+}
@@ -0,0 +1,100 @@
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.TBA;
+
+namespace Benchmarks;
+
+// The time from the start of a NativeAOT app (SizeOnDiskNew or SizeOnDiskOld) to the exit of its first child,
+// so the cost of loading libpal_process (or not, when it's statically linked) is included: `dotnet run -c Release -- --startup <app>...`.
+// Every app starts the same child, which exits immediately, and exits right after it.
+internal static class Startup
+{
+    private const string Header = "app,size_on_disk_bytes,operations,p50_us,p99_us,mean_us";
+
+    internal static void Run(string[] args)
+    {
+        int iterations = 200;
+        int first = 0;
+        if (args.Length > 1 && args[0] == "--iterations")
+        {
+            iterations = int.Parse(args[1], CultureInfo.InvariantCulture);
+            first = 2;
+        }
+
+        if (first >= args.Length)
+        {
+            throw new ArgumentException("Usage: --startup [--iterations N] <app>...");
+        }
+
+        string child = OperatingSystem.IsWindows() ? "cmd" : ProcessStartOptions.ResolvePath("true").FileName;
+        Console.WriteLine(Header);
+
+        for (int i = first; i < args.Length; i++)
+        {
+            Measure(Path.GetFullPath(args[i]), child, iterations);
+        }
+    }
+
+    private static void Measure(string app, string child, int iterations)
+    {
+        ProcessStartOptions options = new(app) { Arguments = { child } };
+        if (OperatingSystem.IsWindows())
+        {
+            options.Arguments.Add("/c");
+            options.Arguments.Add("exit 0");
+        }
+
+        long[] latencies = new long[iterations];
+
+        // Warmup: the app and the child are in the page cache.
+        Start(options);
+
+        long elapsed = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            long start = Stopwatch.GetTimestamp();
+            Start(options);
+            latencies[i] = Stopwatch.GetTimestamp() - start;
+            elapsed += latencies[i];
+        }
+
+        Array.Sort(latencies);
+
+        Console.WriteLine(string.Join(',',
+            Path.GetFileName(Path.GetDirectoryName(app)) + "/" + Path.GetFileName(app),
+            GetSizeOnDisk(Path.GetDirectoryName(app)!).ToString(CultureInfo.InvariantCulture),
+            iterations.ToString(CultureInfo.InvariantCulture),
+            Suite.Microseconds(Suite.Percentile(latencies, 0.50)),
+            Suite.Microseconds(Suite.Percentile(latencies, 0.99)),
+            Suite.Microseconds(elapsed / iterations)));
+    }
+
+    private static void Start(ProcessStartOptions options)
+    {
+        using SafeChildProcessHandle handle = SafeChildProcessHandle.Start(options, input: null, output: null, error: null);
+
+        int exitCode = handle.WaitForExit().ExitCode;
+        if (exitCode != 0)
+        {
+            throw new InvalidOperationException($"{options.FileName} exited with {exitCode}.");
+        }
+    }
+
+    // The whole publish directory: with the shared library, libpal_process.so/.dylib has to be deployed next to the app.
+    // The debug symbols are not deployed.
+    private static long GetSizeOnDisk(string directory)
+    {
+        long size = 0;
+        foreach (string file in Directory.EnumerateFiles(directory))
+        {
+            if (Path.GetExtension(file) is not (".dbg" or ".pdb" or ".dSYM"))
+            {
+                size += new FileInfo(file).Length;
+            }
+        }
+        return size;
+    }
+}
@@ -0,0 +1,296 @@
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.TBA;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Benchmarks;
+
+// The scenarios shared with BenchmarksGo/suite.go, run for the old Process API and this library: `dotnet run -c Release -- --suite`.
+// BenchmarkDotNet reports the mean of iterations that each run many operations, the suite times every operation on its own instead,
+// so it can report the latency percentiles. Both suites print the same CSV columns and compute the percentiles the same way
+// (nearest rank), so their output can be concatenated and compared.
+internal static class Suite
+{
+    private const string Header = "runtime,scenario,parameter,operations,p50_us,p99_us,p99.9_us,ops_per_s,allocated_bytes_per_op";
+
+    internal static void Run(string[] args)
+    {
+        Options options = Options.Parse(args);
+        string? filePath = null;
+
+        try
+        {
+            Console.WriteLine(Header);
+
+            // The scenarios are created lazily, so the ones that are filtered out don't allocate anything.
+            foreach (Scenario scenario in CreateScenarios(options, path => filePath = path))
+            {
+                Measure("dotnet-process", scenario, scenario.Process, options);
+                Measure("dotnet-childprocess", scenario, scenario.ChildProcess, options);
+            }
+        }
+        finally
+        {
+            if (filePath is not null)
+            {
+                File.Delete(filePath);
+            }
+        }
+    }
+
+    private static IEnumerable<Scenario> CreateScenarios(Options options, Action<string> onFileCreated)
+    {
+        (string fileName, string[] arguments) exitImmediately = OperatingSystem.IsWindows() ? ("cmd", ["/c", "exit 0"]) : (Which("true"), []);
+
+        if (options.Includes("spawn"))
+        {
+            yield return new("spawn", "", 1000, () => SpawnWithProcess(exitImmediately), () => SpawnWithChildProcess(exitImmediately));
+        }
+
+        foreach ((string parameter, long size, int iterations) in new[] { ("1KB", 1024L, 1000), ("1MB", 1024L * 1024, 200), ("1GB", 1024L * 1024 * 1024, 5) })
+        {
+            if (!options.Includes("capture"))
+            {
+                break;
+            }
+
+            string path = Path.GetTempFileName();
+            onFileCreated(path);
+            using (FileStream file = File.OpenWrite(path))
+            {
+                file.SetLength(size);
+            }
+
+            (string fileName, string[] arguments) print = OperatingSystem.IsWindows() ? ("cmd", ["/c", "type", path]) : (Which("cat"), [path]);
+            yield return new("capture", parameter, iterations, () => CaptureWithProcess(print, size), () => CaptureWithChildProcess(print, size));
+            File.Delete(path);
+        }
+
+        foreach ((int concurrency, int iterations) in new[] { (1, 1000), (8, 200), (64, 50), (256, 20) })
+        {
+            if (!options.Includes("concurrent"))
+            {
+                break;
+            }
+
+            ThreadPool.GetMinThreads(out int workerThreads, out int completionPortThreads);
+            ThreadPool.SetMinThreads(Math.Max(workerThreads, concurrency), completionPortThreads);
+
+            // The latencies are the ones of a whole batch of concurrent spawns, the throughput counts every spawn.
+            yield return new("concurrent", concurrency.ToString(CultureInfo.InvariantCulture), iterations, OperationsPerIteration: concurrency,
+                Process: () => Parallel.For(0, concurrency, new ParallelOptions { MaxDegreeOfParallelism = concurrency }, _ => SpawnWithProcess(exitImmediately)),
+                ChildProcess: () => Parallel.For(0, concurrency, new ParallelOptions { MaxDegreeOfParallelism = concurrency }, _ => SpawnWithChildProcess(exitImmediately)));
+        }
+
+        if (options.Includes("spawn-large-rss"))
+        {
+            // The cost of fork grows with the memory of the parent, the one of vfork and posix_spawn does not.
+            byte[] ballast = new byte[options.RssMegabytes * 1024L * 1024L];
+            for (long i = 0; i < ballast.LongLength; i += Environment.SystemPageSize)
+            {
+                ballast[i] = 1;
+            }
+
+            yield return new("spawn-large-rss", $"{options.RssMegabytes}MB", 1000, () => SpawnWithProcess(exitImmediately), () => SpawnWithChildProcess(exitImmediately));
+            GC.KeepAlive(ballast);
+        }
+
+        if (!OperatingSystem.IsWindows() && options.Includes("kill-tree"))
+        {
+            // Only the kill and the wait are timed, the tree is started by the setup.
+            Process? process = null;
+            SafeChildProcessHandle? handle = null;
+            yield return new("kill-tree", "4", 50,
+                Process: () =>
+                {
+                    process!.Kill(entireProcessTree: true);
+                    process.WaitForExit();
+                    process.Dispose();
+                },
+                ChildProcess: () =>
+                {
+                    handle!.KillProcessGroup();
+                    handle.WaitForExit();
+                    handle.Dispose();
+                })
+            {
+                ProcessSetup = () => process = StartTreeWithProcess(),
+                ChildProcessSetup = () => handle = StartTreeWithChildProcess(),
+            };
+        }
+    }
+
+    private static void Measure(string runtime, Scenario scenario, Action operation, Options options)
+    {
+        Action? setup = ReferenceEquals(operation, scenario.Process) ? scenario.ProcessSetup : scenario.ChildProcessSetup;
+        int iterations = options.Iterations ?? scenario.Iterations;
+        long[] latencies = new long[iterations];
+
+        // Warmup: JIT, the path resolution caches, the thread pool.
+        setup?.Invoke();
+        operation();
+
+        long elapsed = 0, allocated = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            setup?.Invoke();
+
+            // The allocations are read outside of the timed region, and don't include the ones of the setup.
+            long allocatedBefore = GC.GetTotalAllocatedBytes(precise: true);
+            long start = Stopwatch.GetTimestamp();
+            operation();
+            latencies[i] = Stopwatch.GetTimestamp() - start;
+            allocated += GC.GetTotalAllocatedBytes(precise: true) - allocatedBefore;
+            elapsed += latencies[i];
+        }
+
+        Array.Sort(latencies);
+        long operations = (long)iterations * scenario.OperationsPerIteration;
+
+        Console.WriteLine(string.Join(',',
+            runtime,
+            scenario.Name,
+            scenario.Parameter,
+            operations.ToString(CultureInfo.InvariantCulture),
+            Microseconds(Percentile(latencies, 0.50)),
+            Microseconds(Percentile(latencies, 0.99)),
+            Microseconds(Percentile(latencies, 0.999)),
+            (operations / Stopwatch.GetElapsedTime(0, elapsed).TotalSeconds).ToString("F1", CultureInfo.InvariantCulture),
+            (allocated / operations).ToString(CultureInfo.InvariantCulture)));
+    }
+
+    // Nearest rank: the smallest latency that is greater or equal to the given fraction of them.
+    internal static long Percentile(long[] sorted, double fraction) => sorted[Math.Max((int)Math.Ceiling(fraction * sorted.Length) - 1, 0)];
+
+    internal static string Microseconds(long ticks) => Stopwatch.GetElapsedTime(0, ticks).TotalMicroseconds.ToString("F1", CultureInfo.InvariantCulture);
+
+    private static string Which(string program) => ProcessStartOptions.ResolvePath(program).FileName;
+
+    private static void SpawnWithProcess((string FileName, string[] Arguments) command)
+    {
+        ProcessStartInfo info = new(command.FileName, command.Arguments) { UseShellExecute = false };
+
+        using Process process = Process.Start(info)!;
+        process.WaitForExit();
+    }
+
+    private static void SpawnWithChildProcess((string FileName, string[] Arguments) command)
+        => ChildProcess.Inherit(CreateOptions(command));
+
+    private static void CaptureWithProcess((string FileName, string[] Arguments) command, long expectedLength)
+    {
+        ProcessStartInfo info = new(command.FileName, command.Arguments)
+        {
+            UseShellExecute = false,
+            RedirectStandardOutput = true,
+            RedirectStandardError = true,
+        };
+
+        using Process process = Process.Start(info)!;
+        using MemoryStream output = new();
+        Task<string> error = process.StandardError.ReadToEndAsync();
+        process.StandardOutput.BaseStream.CopyTo(output);
+        error.Wait();
+        process.WaitForExit();
+
+        Check(output.Length, expectedLength);
+    }
+
+    private static void CaptureWithChildProcess((string FileName, string[] Arguments) command, long expectedLength)
+    {
+        using ProcessOutputBytes output = ChildProcess.CaptureOutputBytes(CreateOptions(command));
+
+        Check(output.StandardOutput.Length, expectedLength);
+    }
+
+    private static Process StartTreeWithProcess()
+    {
+        ProcessStartInfo info = new("sh", ["-c", TreeScript]) { UseShellExecute = false, RedirectStandardOutput = true };
+
+        Process process = Process.Start(info)!;
+        process.StandardOutput.ReadLine();
+        return process;
+    }
+
+    private static SafeChildProcessHandle StartTreeWithChildProcess()
+    {
+        ProcessStartOptions options = new("sh") { Arguments = { "-c", TreeScript }, CreateNewProcessGroup = true };
+
+        File.CreatePipe(out SafeFileHandle readPipe, out SafeFileHandle writePipe);
+        SafeChildProcessHandle handle;
+        using (writePipe)
+        {
+            handle = SafeChildProcessHandle.Start(options, input: null, output: writePipe, error: null);
+        }
+
+        // All the descendants are running when the operation starts.
+        using StreamReader reader = new(new FileStream(readPipe, FileAccess.Read, bufferSize: 1));
+        reader.ReadLine();
+        return handle;
+    }
+
+    private const string TreeScript = "sleep 30 & sleep 30 & sleep 30 & echo ready; wait";
+
+    private static ProcessStartOptions CreateOptions((string FileName, string[] Arguments) command)
+    {
+        ProcessStartOptions options = new(command.FileName);
+        foreach (string argument in command.Arguments)
+        {
+            options.Arguments.Add(argument);
+        }
+        return options;
+    }
+
+    private static void Check(long length, long expectedLength)
+    {
+        if (length != expectedLength)
+        {
+            throw new InvalidOperationException($"Captured {length} bytes, expected {expectedLength}.");
+        }
+    }
+
+    private sealed record Scenario(string Name, string Parameter, int Iterations, Action Process, Action ChildProcess, int OperationsPerIteration = 1)
+    {
+        internal Action? ProcessSetup { get; init; }
+        internal Action? ChildProcessSetup { get; init; }
+    }
+
+    private sealed class Options
+    {
+        internal int? Iterations { get; private set; }
+        internal string? Filter { get; private set; }
+        internal int RssMegabytes { get; private set; } = 2048;
+
+        internal bool Includes(string scenario) => Filter is null || scenario.Contains(Filter, StringComparison.OrdinalIgnoreCase);
+
+        // --iterations N: the same number of operations for every scenario. --scenario name: the scenarios whose name contains it.
+        // --rss-mb N: the memory of the parent in the spawn-large-rss scenario.
+        internal static Options Parse(string[] args)
+        {
+            Options options = new();
+            for (int i = 0; i + 1 < args.Length; i += 2)
+            {
+                switch (args[i])
+                {
+                    case "--iterations":
+                        options.Iterations = int.Parse(args[i + 1], CultureInfo.InvariantCulture);
+                        break;
+                    case "--scenario":
+                        options.Filter = args[i + 1];
+                        break;
+                    case "--rss-mb":
+                        options.RssMegabytes = int.Parse(args[i + 1], CultureInfo.InvariantCulture);
+                        break;
+                    default:
+                        throw new ArgumentException($"Unknown option {args[i]}.");
+                }
+            }
+            return options;
+        }
+    }
+}
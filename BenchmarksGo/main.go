@@ -1,14 +1,24 @@
 package main
 
+import (
+	"fmt"
+	"os"
+)
+
 // This package contains benchmarks for process execution in Go.
 // These benchmarks mirror the C# benchmarks in the parent Benchmarks directory.
 //
 // To run the benchmarks, use:
 //   go test -bench=. -benchmem
 //
+// To run the latency suite shared with Benchmarks/Suite.cs, use:
+//   go run . -iterations N -scenario name -rss-mb N
+//
 // See README.md for more detailed instructions.
 
 func main() {
-	// This is a benchmark-only package.
-	// Run: go test -bench=. -benchmem
+	if err := runSuite(os.Args[1:]); err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
 }
@@ -0,0 +1,252 @@
+package main
+
+import (
+	"bytes"
+	"flag"
+	"fmt"
+	"math"
+	"os"
+	"os/exec"
+	"runtime"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+)
+
+// The scenarios shared with Benchmarks/Suite.cs: `go run . -iterations N -scenario name -rss-mb N`.
+// The testing package reports the mean of b.N operations, the suite times every operation on its own instead,
+// so it can report the latency percentiles. Both suites print the same CSV columns and compute the percentiles
+// the same way (nearest rank), so their output can be concatenated and compared.
+
+const suiteHeader = "runtime,scenario,parameter,operations,p50_us,p99_us,p99.9_us,ops_per_s,allocated_bytes_per_op"
+
+type scenario struct {
+	name                   string
+	parameter              string
+	iterations             int
+	operationsPerIteration int
+	setup                  func()
+	operation              func()
+}
+
+type suiteOptions struct {
+	iterations   int
+	filter       string
+	rssMegabytes int
+}
+
+func (o suiteOptions) includes(name string) bool {
+	return o.filter == "" || strings.Contains(strings.ToLower(name), strings.ToLower(o.filter))
+}
+
+func runSuite(args []string) error {
+	var options suiteOptions
+	flags := flag.NewFlagSet("suite", flag.ContinueOnError)
+	flags.IntVar(&options.iterations, "iterations", 0, "the same number of operations for every scenario")
+	flags.StringVar(&options.filter, "scenario", "", "run only the scenarios whose name contains it")
+	flags.IntVar(&options.rssMegabytes, "rss-mb", 2048, "the memory of the parent in the spawn-large-rss scenario")
+	if err := flags.Parse(args); err != nil {
+		return err
+	}
+
+	fmt.Println(suiteHeader)
+	return forEachScenario(options, func(s scenario) error {
+		return measure("go-exec", s, options)
+	})
+}
+
+// forEachScenario creates the scenarios one at a time, so the ones that are filtered out don't allocate anything.
+func forEachScenario(options suiteOptions, run func(scenario) error) error {
+	exitImmediately := []string{"true"}
+	if runtime.GOOS == "windows" {
+		exitImmediately = []string{"cmd", "/c", "exit 0"}
+	}
+
+	if options.includes("spawn") {
+		if err := run(scenario{name: "spawn", iterations: 1000, operation: func() { spawn(exitImmediately) }}); err != nil {
+			return err
+		}
+	}
+
+	if options.includes("capture") {
+		for _, c := range []struct {
+			parameter  string
+			size       int64
+			iterations int
+		}{{"1KB", 1024, 1000}, {"1MB", 1024 * 1024, 200}, {"1GB", 1024 * 1024 * 1024, 5}} {
+			if err := runCapture(c.parameter, c.size, c.iterations, run); err != nil {
+				return err
+			}
+		}
+	}
+
+	if options.includes("concurrent") {
+		for _, c := range []struct{ concurrency, iterations int }{{1, 1000}, {8, 200}, {64, 50}, {256, 20}} {
+			concurrency := c.concurrency
+			// The latencies are the ones of a whole batch of concurrent spawns, the throughput counts every spawn.
+			err := run(scenario{
+				name:                   "concurrent",
+				parameter:              strconv.Itoa(concurrency),
+				iterations:             c.iterations,
+				operationsPerIteration: concurrency,
+				operation: func() {
+					var wg sync.WaitGroup
+					wg.Add(concurrency)
+					for i := 0; i < concurrency; i++ {
+						go func() {
+							defer wg.Done()
+							spawn(exitImmediately)
+						}()
+					}
+					wg.Wait()
+				},
+			})
+			if err != nil {
+				return err
+			}
+		}
+	}
+
+	if options.includes("spawn-large-rss") {
+		// The cost of fork grows with the memory of the parent, the one of vfork and posix_spawn does not.
+		ballast := make([]byte, options.rssMegabytes*1024*1024)
+		pageSize := os.Getpagesize()
+		for i := 0; i < len(ballast); i += pageSize {
+			ballast[i] = 1
+		}
+
+		err := run(scenario{
+			name:       "spawn-large-rss",
+			parameter:  fmt.Sprintf("%dMB", options.rssMegabytes),
+			iterations: 1000,
+			operation:  func() { spawn(exitImmediately) },
+		})
+		runtime.KeepAlive(ballast)
+		if err != nil {
+			return err
+		}
+	}
+
+	if options.includes("kill-tree") {
+		if s, ok := killTreeScenario(); ok {
+			if err := run(s); err != nil {
+				return err
+			}
+		}
+	}
+
+	return nil
+}
+
+func runCapture(parameter string, size int64, iterations int, run func(scenario) error) error {
+	file, err := os.CreateTemp("", "suite")
+	if err != nil {
+		return err
+	}
+	path := file.Name()
+	defer os.Remove(path)
+
+	err = file.Truncate(size)
+	file.Close()
+	if err != nil {
+		return err
+	}
+
+	command := []string{"cat", path}
+	if runtime.GOOS == "windows" {
+		command = []string{"cmd", "/c", "type", path}
+	}
+
+	// The collection frees the buffer of the previous operation before the next one grows, so 1GB fits in memory.
+	return run(scenario{name: "capture", parameter: parameter, iterations: iterations, setup: runtime.GC, operation: func() { capture(command, size) }})
+}
+
+func measure(runtimeName string, s scenario, options suiteOptions) error {
+	iterations := s.iterations
+	if options.iterations > 0 {
+		iterations = options.iterations
+	}
+	operationsPerIteration := s.operationsPerIteration
+	if operationsPerIteration == 0 {
+		operationsPerIteration = 1
+	}
+	latencies := make([]time.Duration, iterations)
+
+	// Warmup: the path lookup, the goroutine stacks.
+	if s.setup != nil {
+		s.setup()
+	}
+	s.operation()
+
+	var elapsed time.Duration
+	var allocated uint64
+	var before, after runtime.MemStats
+	for i := 0; i < iterations; i++ {
+		if s.setup != nil {
+			s.setup()
+		}
+
+		// The allocations are read outside of the timed region, and don't include the ones of the setup.
+		runtime.ReadMemStats(&before)
+		start := time.Now()
+		s.operation()
+		latencies[i] = time.Since(start)
+		runtime.ReadMemStats(&after)
+		allocated += after.TotalAlloc - before.TotalAlloc
+		elapsed += latencies[i]
+	}
+
+	sort.Slice(latencies, func(i, j int) bool { return latencies[i] < latencies[j] })
+	operations := iterations * operationsPerIteration
+
+	fmt.Println(strings.Join([]string{
+		runtimeName,
+		s.name,
+		s.parameter,
+		strconv.Itoa(operations),
+		microseconds(percentile(latencies, 0.50)),
+		microseconds(percentile(latencies, 0.99)),
+		microseconds(percentile(latencies, 0.999)),
+		strconv.FormatFloat(float64(operations)/elapsed.Seconds(), 'f', 1, 64),
+		strconv.FormatUint(allocated/uint64(operations), 10),
+	}, ","))
+	return nil
+}
+
+// percentile uses the nearest rank: the smallest latency that is greater or equal to the given fraction of them.
+func percentile(sorted []time.Duration, fraction float64) time.Duration {
+	rank := int(math.Ceil(fraction*float64(len(sorted)))) - 1
+	if rank < 0 {
+		rank = 0
+	}
+	return sorted[rank]
+}
+
+func microseconds(d time.Duration) string {
+	return strconv.FormatFloat(float64(d.Nanoseconds())/1000, 'f', 1, 64)
+}
+
+func spawn(command []string) {
+	cmd := exec.Command(command[0], command[1:]...)
+	cmd.Stdin = os.Stdin
+	cmd.Stdout = os.Stdout
+	cmd.Stderr = os.Stderr
+	if err := cmd.Run(); err != nil {
+		panic(err)
+	}
+}
+
+func capture(command []string, expectedLength int64) {
+	var stdout, stderr bytes.Buffer
+	cmd := exec.Command(command[0], command[1:]...)
+	cmd.Stdout = &stdout
+	cmd.Stderr = &stderr
+	if err := cmd.Run(); err != nil {
+		panic(err)
+	}
+	if int64(stdout.Len()) != expectedLength {
+		panic(fmt.Sprintf("captured %d bytes, expected %d", stdout.Len(), expectedLength))
+	}
+}
@@ -0,0 +1,43 @@
+//go:build unix
+
+package main
+
+import (
+	"bufio"
+	"os/exec"
+	"syscall"
+)
+
+const treeScript = "sleep 30 & sleep 30 & sleep 30 & echo ready; wait"
+
+// killTreeScenario kills a shell and its three children through their process group.
+// Only the kill and the wait are timed, the tree is started by the setup.
+func killTreeScenario() (scenario, bool) {
+	var cmd *exec.Cmd
+	return scenario{
+		name:       "kill-tree",
+		parameter:  "4",
+		iterations: 50,
+		setup: func() {
+			cmd = exec.Command("sh", "-c", treeScript)
+			cmd.SysProcAttr = &syscall.SysProcAttr{Setpgid: true}
+			stdout, err := cmd.StdoutPipe()
+			if err != nil {
+				panic(err)
+			}
+			if err := cmd.Start(); err != nil {
+				panic(err)
+			}
+			// All the descendants are running when the operation starts.
+			if _, err := bufio.NewReader(stdout).ReadString('\n'); err != nil {
+				panic(err)
+			}
+		},
+		operation: func() {
+			if err := syscall.Kill(-cmd.Process.Pid, syscall.SIGKILL); err != nil {
+				panic(err)
+			}
+			_ = cmd.Wait()
+		},
+	}, true
+}
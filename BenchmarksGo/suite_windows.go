@@ -0,0 +1,8 @@
+//go:build windows
+
+package main
+
+// killTreeScenario is Unix only, like the one of Benchmarks/Suite.cs.
+func killTreeScenario() (scenario, bool) {
+	return scenario{}, false
+}
@@ -1,8 +1,8 @@
+using System.Buffers;
 using System.IO;
 using System.Threading;
 using System.Threading.Tasks;
 using Microsoft.Win32.SafeHandles;
-using System.Buffers;
 using System.Text;
 
 namespace System.TBA;
@@ -151,6 +151,187 @@ public static partial class ChildProcess
         return await procHandle.WaitForExitAsync(cancellationToken);
     }
 
+    /// <summary>
+    /// Executes the stages as a pipeline (<c>stage1 | stage2 | stage3</c>), with STD IN of the first stage, STD OUT of the last stage
+    /// and STD ERR of all the stages redirected to current process. Waits for their completion.
+    /// </summary>
+    /// <param name="stages">The start options of the stages, in pipeline order.</param>
+    /// <returns>The exit statuses of the stages, in the same order as <paramref name="stages"/>.</returns>
+    public static ProcessExitStatus[] Pipeline(params ProcessStartOptions[] stages)
+    {
+        ArgumentNullException.ThrowIfNull(stages);
+
+        using SafeFileHandle inputHandle = Console.OpenStandardInputHandle();
+        using SafeFileHandle outputHandle = Console.OpenStandardOutputHandle();
+        using SafeFileHandle errorHandle = Console.OpenStandardErrorHandle();
+
+        return Pipeline(stages, inputHandle, outputHandle, errorHandle);
+    }
+
+    /// <summary>
+    /// Executes the stages as a pipeline (<c>stage1 | stage2 | stage3</c>). Waits for their completion.
+    /// </summary>
+    /// <param name="stages">The start options of the stages, in pipeline order.</param>
+    /// <param name="input">The handle to use for standard input of the first stage. When null, no input is provided.</param>
+    /// <param name="output">The handle to use for standard output of the last stage. When null, all output is discarded.</param>
+    /// <param name="error">The handle to use for standard error of all the stages. When null, all error is discarded.</param>
+    /// <param name="timeout">The maximum time to wait for all the stages to exit.</param>
+    /// <returns>The exit statuses of the stages, in the same order as <paramref name="stages"/>.
+    /// The stages that were still running when the timeout expired are killed and have Canceled set to true.</returns>
+    /// <remarks>
+    /// The data flows from one stage to the next through pipes, without going through the current process.
+    /// When <paramref name="timeout"/> is specified, the stages are started in a single process group,
+    /// so the processes they started are killed with them. When it's not specified, the default is to wait indefinitely.
+    /// </remarks>
+    public static ProcessExitStatus[] Pipeline(ReadOnlySpan<ProcessStartOptions> stages, SafeFileHandle? input, SafeFileHandle? output, SafeFileHandle? error, TimeSpan? timeout = default)
+    {
+        TimeoutHelper timeoutHelper = TimeoutHelper.Start(timeout);
+        bool processGroup = timeoutHelper.CanExpire;
+
+        SafeChildProcessHandle[] handles = SafeChildProcessHandle.StartPipeline(stages, input, output, error, processGroup);
+        try
+        {
+            ProcessExitStatus[] exitStatuses = new ProcessExitStatus[handles.Length];
+            for (int i = 0; i < handles.Length; i++)
+            {
+                if (!handles[i].TryWaitForExit(timeoutHelper.GetRemaining(), out ProcessExitStatus? exitStatus))
+                {
+                    KillPipeline(handles, i, processGroup);
+                    for (; i < handles.Length; i++)
+                    {
+                        exitStatuses[i] = AsCanceled(handles[i].WaitForExit());
+                    }
+                    break;
+                }
+
+                exitStatuses[i] = exitStatus;
+            }
+
+            return exitStatuses;
+        }
+        finally
+        {
+            DisposeAll(handles);
+        }
+    }
+
+    /// <summary>
+    /// Executes the stages as a pipeline (<c>stage1 | stage2 | stage3</c>). Awaits their completion.
+    /// </summary>
+    /// <param name="stages">The start options of the stages, in pipeline order.</param>
+    /// <param name="input">The handle to use for standard input of the first stage. When null, no input is provided.</param>
+    /// <param name="output">The handle to use for standard output of the last stage. When null, all output is discarded.</param>
+    /// <param name="error">The handle to use for standard error of all the stages. When null, all error is discarded.</param>
+    /// <param name="cancellationToken">The cancellation token that kills the stages that are still running.</param>
+    /// <returns>The exit statuses of the stages, in the same order as <paramref name="stages"/>.
+    /// The stages that were still running when the operation was canceled are killed and have Canceled set to true.</returns>
+    /// <remarks>When <paramref name="cancellationToken"/> can be canceled, the stages are started in a single process group.</remarks>
+    public static async Task<ProcessExitStatus[]> PipelineAsync(ProcessStartOptions[] stages, SafeFileHandle? input = null, SafeFileHandle? output = null, SafeFileHandle? error = null, CancellationToken cancellationToken = default)
+    {
+        ArgumentNullException.ThrowIfNull(stages);
+
+        bool processGroup = cancellationToken.CanBeCanceled;
+
+        SafeChildProcessHandle[] handles = SafeChildProcessHandle.StartPipeline(stages, input, output, error, processGroup);
+        try
+        {
+            ProcessExitStatus[] exitStatuses = new ProcessExitStatus[handles.Length];
+            int exited = 0;
+            try
+            {
+                for (; exited < handles.Length; exited++)
+                {
+                    exitStatuses[exited] = await handles[exited].WaitForExitAsync(cancellationToken);
+                }
+            }
+            catch (OperationCanceledException) when (cancellationToken.IsCancellationRequested)
+            {
+                KillPipeline(handles, exited, processGroup);
+                for (; exited < handles.Length; exited++)
+                {
+                    exitStatuses[exited] = AsCanceled(await handles[exited].WaitForExitAsync(CancellationToken.None));
+                }
+            }
+
+            return exitStatuses;
+        }
+        finally
+        {
+            DisposeAll(handles);
+        }
+    }
+
+    private static void KillPipeline(SafeChildProcessHandle[] stages, int firstRunning, bool processGroup)
+    {
+        // On Unix, all the stages are in the process group of the first one, which can't be reused
+        // while stages[firstRunning] has not been reaped, even when the first stage has been.
+        if (processGroup && !OperatingSystem.IsWindows())
+        {
+            stages[0].KillCore(throwOnError: false, entireProcessGroup: true);
+            return;
+        }
+
+        for (int i = firstRunning; i < stages.Length; i++)
+        {
+            stages[i].KillCore(throwOnError: false, entireProcessGroup: processGroup);
+        }
+    }
+
+    private static ProcessExitStatus AsCanceled(ProcessExitStatus exitStatus) => new(exitStatus.ExitCode, cancelled: true, exitStatus.Signal, exitStatus.ResourceUsage);
+
+    private static void DisposeAll(SafeChildProcessHandle[] handles)
+    {
+        foreach (SafeChildProcessHandle handle in handles)
+        {
+            handle.Dispose();
+        }
+    }
+
+    /// <summary>
+    /// Executes the process with STD OUT and ERR written to the specified file and returns the last bytes of the output. Waits for its completion.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="outputFile">The file to write standard output and error to. It's created or overwritten.</param>
+    /// <param name="tailLength">The maximum number of the last bytes of the output to return.</param>
+    /// <param name="input">An optional handle to a file that provides input to the process's standard input stream. If null, no input is provided.</param>
+    /// <param name="timeout">An optional timeout that specifies the maximum duration to wait for the process to complete. If null, the
+    /// process will wait indefinitely.</param>
+    /// <returns>A <see cref="CombinedOutput" /> object containing the process's exit code, id and the last <paramref name="tailLength"/> bytes of its output.</returns>
+    /// <remarks>
+    /// On Linux, the output is moved from the pipe to the file by the kernel (splice), so it never goes through user space.
+    /// On other platforms, it's copied with a single pooled buffer.
+    /// </remarks>
+    public static CombinedOutput Tee(ProcessStartOptions options, string outputFile, int tailLength = 4096, SafeFileHandle? input = null, TimeSpan? timeout = null)
+    {
+        ArgumentNullException.ThrowIfNull(options);
+        ArgumentException.ThrowIfNullOrEmpty(outputFile);
+        ArgumentOutOfRangeException.ThrowIfNegative(tailLength);
+
+        SafeFileHandle read, write;
+        TimeoutHelper timeoutHelper = TimeoutHelper.Start(timeout);
+
+        // Design: unlike RedirectToFiles, the parent reads the output, so it can keep the tail and the output can't outlive the timeout.
+        // The file is opened for reading too, so the tail of the data that was moved by the kernel can be read back.
+        using SafeFileHandle fileHandle = File.OpenHandle(outputFile, FileMode.Create, FileAccess.ReadWrite, FileShare.ReadWrite);
+
+        File.CreatePipe(out read, out write, asyncRead: true, capacity: options.OutputPipeCapacity);
+
+        using (read)
+        using (write)
+        using (SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input, output: write, error: write))
+        using (TeeWriter writer = new(fileHandle, tailLength))
+        {
+            Multiplexing.TeeCombinedOutputCore(read, processHandle, timeoutHelper, writer);
+
+            TimeSpan remaining = timeoutHelper.GetRemaining();
+            var exitStatus = remaining == Timeout.InfiniteTimeSpan
+                ? processHandle.WaitForExit()
+                : processHandle.WaitForExitOrKillOnTimeout(remaining);
+
+            return new(exitStatus, writer.GetTail(), processHandle.ProcessId);
+        }
+    }
+
     /// <summary>
     /// Creates an instance of <see cref="ProcessOutputLines"/> to stream the output of the process.
     /// </summary>
@@ -178,150 +359,432 @@ public static partial class ChildProcess
     {
         ArgumentNullException.ThrowIfNull(options);
 
+        encoding ??= Encoding.UTF8;
+        using ProcessOutputBytes outputBytes = CaptureOutputBytesCore(options, input, timeout, encoding);
+
+        // The characters are counted while the process runs, so the strings are decoded in a single pass, straight into their final size.
+        return outputBytes.Decode(encoding);
+    }
+
+    /// <summary>
+    /// Starts a process with the specified options, writes the provided bytes to its standard input and returns the standard output and error.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="input">The bytes written to the process's standard input, which is closed once they have all been written.</param>
+    /// <param name="encoding">The encoding to use when reading the output. If null, the default encoding is used (UTF-8).</param>
+    /// <param name="timeout">An optional timeout that specifies the maximum duration to wait for the process to complete. If null, the
+    /// process will wait indefinitely.</param>
+    /// <returns>A <see cref="ProcessOutput" /> object containing the process's exit code, id, standard output and standard error data.</returns>
+    /// <remarks>See <see cref="CaptureOutputBytes(ProcessStartOptions, ReadOnlySequence{byte}, TimeSpan?)"/>.</remarks>
+    public static ProcessOutput CaptureOutput(ProcessStartOptions options, ReadOnlyMemory<byte> input, Encoding? encoding = null, TimeSpan? timeout = null)
+        => CaptureOutput(options, new ReadOnlySequence<byte>(input), encoding, timeout);
+
+    /// <summary>
+    /// Starts a process with the specified options, writes the provided bytes to its standard input and returns the standard output and error.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="input">The bytes written to the process's standard input, which is closed once they have all been written.</param>
+    /// <param name="encoding">The encoding to use when reading the output. If null, the default encoding is used (UTF-8).</param>
+    /// <param name="timeout">An optional timeout that specifies the maximum duration to wait for the process to complete. If null, the
+    /// process will wait indefinitely.</param>
+    /// <returns>A <see cref="ProcessOutput" /> object containing the process's exit code, id, standard output and standard error data.</returns>
+    /// <remarks>See <see cref="CaptureOutputBytes(ProcessStartOptions, ReadOnlySequence{byte}, TimeSpan?)"/>.</remarks>
+    public static ProcessOutput CaptureOutput(ProcessStartOptions options, ReadOnlySequence<byte> input, Encoding? encoding = null, TimeSpan? timeout = null)
+    {
+        ArgumentNullException.ThrowIfNull(options);
+
+        encoding ??= Encoding.UTF8;
+        using ProcessOutputBytes outputBytes = CaptureOutputBytesCore(options, input: null, timeout, encoding, input);
+
+        return outputBytes.Decode(encoding);
+    }
+
+    /// <summary>
+    /// Starts a process with the specified options and returns the standard output and error.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="encoding">The encoding to use when reading the output. If null, the default encoding is used (UTF-8).</param>
+    /// <param name="input">An optional handle to a file that provides input to the process's standard input stream. If null, no input is provided.</param>
+    /// <param name="cancellationToken">A cancellation token to cancel the operation.</param>
+    /// <returns>A <see cref="ProcessOutput" /> object containing the process's exit code, id, standard output and standard error data.</returns>
+    /// <remarks>Use <see cref="Console.OpenStandardInputHandle()"/> to provide input of the process.</remarks>
+    public static async Task<ProcessOutput> CaptureOutputAsync(ProcessStartOptions options, Encoding? encoding = null, SafeFileHandle? input = null, CancellationToken cancellationToken = default)
+    {
+        ArgumentNullException.ThrowIfNull(options);
+
+        encoding ??= Encoding.UTF8;
+        using ProcessOutputBytes outputBytes = await CaptureOutputBytesCoreAsync(options, input, encoding, cancellationToken);
+
+        // The characters are counted while the process runs, so the strings are decoded in a single pass, straight into their final size.
+        return outputBytes.Decode(encoding);
+    }
+
+    /// <summary>
+    /// Starts a process with the specified options and returns the raw bytes of the standard output and error.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="input">An optional handle to a file that provides input to the process's standard input stream. If null, no input is provided.</param>
+    /// <param name="timeout">An optional timeout that specifies the maximum duration to wait for the process to complete. If null, the
+    /// process will wait indefinitely.</param>
+    /// <returns>A <see cref="ProcessOutputBytes" /> object containing the process's exit code, id, standard output and standard error data.
+    /// It must be disposed to return the buffers to the pool.</returns>
+    /// <remarks>The output is gathered into a chain of pooled buffers, so it's never copied, no matter how large it is.</remarks>
+    public static ProcessOutputBytes CaptureOutputBytes(ProcessStartOptions options, SafeFileHandle? input = null, TimeSpan? timeout = null)
+    {
+        ArgumentNullException.ThrowIfNull(options);
+
+        return CaptureOutputBytesCore(options, input, timeout, encoding: null);
+    }
+
+    /// <summary>
+    /// Starts a process with the specified options, writes the provided bytes to its standard input and returns the raw bytes of the standard output and error.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="input">The bytes written to the process's standard input, which is closed once they have all been written.</param>
+    /// <param name="timeout">An optional timeout that specifies the maximum duration to wait for the process to complete. If null, the
+    /// process will wait indefinitely.</param>
+    /// <returns>A <see cref="ProcessOutputBytes" /> object containing the process's exit code, id, standard output and standard error data.
+    /// It must be disposed to return the buffers to the pool.</returns>
+    /// <remarks>See <see cref="CaptureOutputBytes(ProcessStartOptions, ReadOnlySequence{byte}, TimeSpan?)"/>.</remarks>
+    public static ProcessOutputBytes CaptureOutputBytes(ProcessStartOptions options, ReadOnlyMemory<byte> input, TimeSpan? timeout = null)
+        => CaptureOutputBytes(options, new ReadOnlySequence<byte>(input), timeout);
+
+    /// <summary>
+    /// Starts a process with the specified options, writes the provided bytes to its standard input and returns the raw bytes of the standard output and error.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="input">The bytes written to the process's standard input, which is closed once they have all been written.</param>
+    /// <param name="timeout">An optional timeout that specifies the maximum duration to wait for the process to complete. If null, the
+    /// process will wait indefinitely.</param>
+    /// <returns>A <see cref="ProcessOutputBytes" /> object containing the process's exit code, id, standard output and standard error data.
+    /// It must be disposed to return the buffers to the pool.</returns>
+    /// <remarks>
+    /// The input is written by the thread that reads the output, whenever the pipe has room for it: the process never waits for its output
+    /// to be read while the input is being written, however large both are. The bytes must not be modified until the method returns.
+    /// What the process has not read when it closes its standard input or exits is dropped.
+    /// </remarks>
+    public static ProcessOutputBytes CaptureOutputBytes(ProcessStartOptions options, ReadOnlySequence<byte> input, TimeSpan? timeout = null)
+    {
+        ArgumentNullException.ThrowIfNull(options);
+
+        return CaptureOutputBytesCore(options, input: null, timeout, encoding: null, input);
+    }
+
+    private static ProcessOutputBytes CaptureOutputBytesCore(ProcessStartOptions options, SafeFileHandle? input, TimeSpan? timeout, Encoding? encoding,
+        ReadOnlySequence<byte>? inputBytes = null)
+    {
         SafeFileHandle readStdOut, writeStdOut, readStdErr, writeStdErr;
+        SafeFileHandle? readStdIn = null, writeStdIn = null;
         TimeoutHelper timeoutHelper = TimeoutHelper.Start(timeout);
 
+        if (inputBytes.HasValue)
+        {
+            // The write end is non-blocking (overlapped on Windows), so the loop reading the output can write the input as well.
+            File.CreatePipe(out readStdIn, out writeStdIn, asyncWrite: true);
+            input = readStdIn;
+        }
+
         // We open ASYNC read handles:
         // - On Windows, to allow for cancellation for timeout.
         // - On Unix, read can block even after fd notification, we need async read and handle EWOULDBLOCK/EAGAIN.
-        File.CreatePipe(out readStdOut, out writeStdOut, asyncRead: true);
+        File.CreatePipe(out readStdOut, out writeStdOut, asyncRead: true, capacity: options.OutputPipeCapacity);
         File.CreatePipe(out readStdErr, out writeStdErr, asyncRead: true);
 
+        using (readStdIn)
+        using (writeStdIn)
         using (readStdOut)
         using (writeStdOut)
         using (readStdErr)
         using (writeStdErr)
         using (SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input, output: writeStdOut, error: writeStdErr))
         {
-            int outputBytesRead = 0, errorBytesRead = 0;
+            // Only the process reads the input: once it stops, the writes fail instead of filling the pipe.
+            readStdIn?.Dispose();
 
-            byte[] outputBuffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
-            byte[] errorBuffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
+            SegmentedBuffer outputBuffer = new(options.MaxOutputBytes, options.OutputLimitPolicy, encoding);
+            SegmentedBuffer errorBuffer = new(options.MaxOutputBytes, options.OutputLimitPolicy, encoding);
 
             try
             {
-                Multiplexing.ReadProcessOutputCore(processHandle, readStdOut, readStdErr, timeoutHelper,
-                    ref outputBytesRead, ref errorBytesRead, ref outputBuffer, ref errorBuffer);
+                Multiplexing.ReadProcessOutputCore(processHandle, readStdOut, readStdErr, timeoutHelper, outputBuffer, errorBuffer,
+                    writeStdIn, inputBytes.GetValueOrDefault());
 
                 TimeSpan remaining = timeoutHelper.GetRemaining();
                 var exitStatus = remaining == Timeout.InfiniteTimeSpan
                     ? processHandle.WaitForExit()
                     : processHandle.WaitForExitOrKillOnTimeout(remaining);
 
-                // Instead of decoding on the fly, we decode once at the end.
-                encoding ??= Encoding.UTF8;
-                string output = encoding.GetString(outputBuffer, 0, outputBytesRead);
-                string error = encoding.GetString(errorBuffer, 0, errorBytesRead);
-
-                return new(exitStatus, output, error, processHandle.ProcessId);
+                return new(exitStatus, outputBuffer, errorBuffer, processHandle.ProcessId);
             }
-            finally
+            catch
             {
-                ArrayPool<byte>.Shared.Return(outputBuffer);
-                ArrayPool<byte>.Shared.Return(errorBuffer);
+                outputBuffer.Dispose();
+                errorBuffer.Dispose();
+                throw;
             }
         }
     }
 
     /// <summary>
-    /// Starts a process with the specified options and returns the standard output and error.
+    /// Starts a process with the specified options and returns the raw bytes of the standard output and error.
     /// </summary>
     /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
-    /// <param name="encoding">The encoding to use when reading the output. If null, the default encoding is used (UTF-8).</param>
     /// <param name="input">An optional handle to a file that provides input to the process's standard input stream. If null, no input is provided.</param>
     /// <param name="cancellationToken">A cancellation token to cancel the operation.</param>
-    /// <returns>A <see cref="ProcessOutput" /> object containing the process's exit code, id, standard output and standard error data.</returns>
-    /// <remarks>Use <see cref="Console.OpenStandardInputHandle()"/> to provide input of the process.</remarks>
-    public static async Task<ProcessOutput> CaptureOutputAsync(ProcessStartOptions options, Encoding? encoding = null, SafeFileHandle? input = null, CancellationToken cancellationToken = default)
+    /// <returns>A <see cref="ProcessOutputBytes" /> object containing the process's exit code, id, standard output and standard error data.
+    /// It must be disposed to return the buffers to the pool.</returns>
+    /// <remarks>The output is gathered into a chain of pooled buffers, so it's never copied, no matter how large it is.</remarks>
+    public static async Task<ProcessOutputBytes> CaptureOutputBytesAsync(ProcessStartOptions options, SafeFileHandle? input = null, CancellationToken cancellationToken = default)
     {
         ArgumentNullException.ThrowIfNull(options);
 
+        return await CaptureOutputBytesCoreAsync(options, input, encoding: null, cancellationToken);
+    }
+
+    private static async Task<ProcessOutputBytes> CaptureOutputBytesCoreAsync(ProcessStartOptions options, SafeFileHandle? input, Encoding? encoding, CancellationToken cancellationToken)
+    {
+        SegmentedBuffer outputBuffer = new(options.MaxOutputBytes, options.OutputLimitPolicy, encoding);
+        SegmentedBuffer errorBuffer = new(options.MaxOutputBytes, options.OutputLimitPolicy, encoding);
+
+        try
+        {
+            (ProcessExitStatus exitStatus, int processId) = await ReadOutputAsync(options, input, outputBuffer, errorBuffer, cancellationToken);
+
+            return new(exitStatus, outputBuffer, errorBuffer, processId);
+        }
+        catch
+        {
+            outputBuffer.Dispose();
+            errorBuffer.Dispose();
+            throw;
+        }
+    }
+
+    /// <summary>
+    /// Starts a process with the specified options and writes its standard output and error to the provided writers, as they are read.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="output">The writer the standard output is read into.</param>
+    /// <param name="error">The writer the standard error is read into. It must not be the same instance as <paramref name="output"/>.</param>
+    /// <param name="input">An optional handle to a file that provides input to the process's standard input stream. If null, no input is provided.</param>
+    /// <param name="timeout">An optional timeout that specifies the maximum duration to wait for the process to complete. If null, the
+    /// process will wait indefinitely.</param>
+    /// <returns>The exit status of the process.</returns>
+    /// <exception cref="ArgumentException">Thrown when <paramref name="output"/> and <paramref name="error"/> are the same instance.</exception>
+    /// <remarks>
+    /// <para>
+    /// The pipes are read straight into the memory returned by <see cref="IBufferWriter{T}.GetMemory(int)"/>, without any intermediate buffer or decoding,
+    /// and every read is followed by <see cref="IBufferWriter{T}.Advance(int)"/>. The writers are not flushed nor completed, that's up to the caller.
+    /// </para>
+    /// <para>
+    /// The writers are called by the thread that reads the pipes: while a writer does not return memory, its pipe is not read,
+    /// so once the pipe is full the process is blocked until the writer catches up.
+    /// <see cref="ProcessStartOptions.MaxOutputBytes"/> does not apply, the writers decide what they keep.
+    /// </para>
+    /// </remarks>
+    public static ProcessExitStatus StreamTo(ProcessStartOptions options, IBufferWriter<byte> output, IBufferWriter<byte> error, SafeFileHandle? input = null, TimeSpan? timeout = null)
+    {
+        ValidateWriters(options, output, error);
+
+        return StreamToCore(options, output, error, input, timeout, out _);
+    }
+
+    private static ProcessExitStatus StreamToCore(ProcessStartOptions options, IBufferWriter<byte> output, IBufferWriter<byte> error, SafeFileHandle? input, TimeSpan? timeout,
+        out int processId)
+    {
         SafeFileHandle readStdOut, writeStdOut, readStdErr, writeStdErr;
+        TimeoutHelper timeoutHelper = TimeoutHelper.Start(timeout);
 
-        // We open ASYNC read handles to allow for cancellation for timeout on Windows.
-        File.CreatePipe(out readStdOut, out writeStdOut, asyncRead: OperatingSystem.IsWindows());
-        File.CreatePipe(out readStdErr, out writeStdErr, asyncRead: OperatingSystem.IsWindows());
+        File.CreatePipe(out readStdOut, out writeStdOut, asyncRead: true, capacity: options.OutputPipeCapacity);
+        File.CreatePipe(out readStdErr, out writeStdErr, asyncRead: true);
 
         using (readStdOut)
         using (writeStdOut)
         using (readStdErr)
         using (writeStdErr)
         using (SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input, output: writeStdOut, error: writeStdErr))
-        using (Stream outputStream = StreamHelper.CreateReadStream(readStdOut, cancellationToken))
-        using (Stream errorStream = StreamHelper.CreateReadStream(readStdErr, cancellationToken))
         {
-            byte[] outputBuffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
-            byte[] errorBuffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
+            Multiplexing.ReadProcessOutputCore(processHandle, readStdOut, readStdErr, timeoutHelper, output, error);
+
+            processId = processHandle.ProcessId;
+            TimeSpan remaining = timeoutHelper.GetRemaining();
+            return remaining == Timeout.InfiniteTimeSpan
+                ? processHandle.WaitForExit()
+                : processHandle.WaitForExitOrKillOnTimeout(remaining);
+        }
+    }
+
+    /// <summary>
+    /// Starts a process with the specified options and writes its standard output and error to the provided writers, as they are read.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="output">The writer the standard output is read into.</param>
+    /// <param name="error">The writer the standard error is read into. It must not be the same instance as <paramref name="output"/>.</param>
+    /// <param name="input">An optional handle to a file that provides input to the process's standard input stream. If null, no input is provided.</param>
+    /// <param name="cancellationToken">A cancellation token to cancel the operation.</param>
+    /// <returns>The exit status of the process.</returns>
+    /// <exception cref="ArgumentException">Thrown when <paramref name="output"/> and <paramref name="error"/> are the same instance.</exception>
+    /// <remarks>
+    /// Every read is awaited before the memory of the next one is requested from the writer, see <see cref="StreamTo"/>.
+    /// The writers are called by the continuations of the reads, never concurrently for the same writer.
+    /// </remarks>
+    public static async Task<ProcessExitStatus> StreamToAsync(ProcessStartOptions options, IBufferWriter<byte> output, IBufferWriter<byte> error, SafeFileHandle? input = null, CancellationToken cancellationToken = default)
+    {
+        ValidateWriters(options, output, error);
+
+        return (await ReadOutputAsync(options, input, output, error, cancellationToken)).ExitStatus;
+    }
+
+    private static void ValidateWriters(ProcessStartOptions options, IBufferWriter<byte> output, IBufferWriter<byte> error)
+    {
+        ArgumentNullException.ThrowIfNull(options);
+        ArgumentNullException.ThrowIfNull(output);
+        ArgumentNullException.ThrowIfNull(error);
+
+        if (ReferenceEquals(output, error))
+        {
+            // Both pipes are read at the same time, the memory of one read would be overwritten by the other.
+            throw new ArgumentException("The standard output and error must be written to different writers.", nameof(error));
+        }
+    }
 
-            int outputStartIndex = 0, errorStartIndex = 0;
+    private static async Task<(ProcessExitStatus ExitStatus, int ProcessId)> ReadOutputAsync(ProcessStartOptions options, SafeFileHandle? input,
+        IBufferWriter<byte> outputBuffer, IBufferWriter<byte> errorBuffer, CancellationToken cancellationToken)
+    {
+        SafeFileHandle readStdOut, writeStdOut, readStdErr, writeStdErr;
 
-            Task<int> outputRead = outputStream.ReadAsync(outputBuffer, outputStartIndex, outputBuffer.Length - outputStartIndex, cancellationToken);
-            Task<int> errorRead = errorStream.ReadAsync(errorBuffer, errorStartIndex, errorBuffer.Length - errorStartIndex, cancellationToken);
+        // We open ASYNC read handles:
+        // - On Windows, to allow for cancellation for timeout.
+        // - On Unix, to wait for the data with the shared reactor instead of blocking a thread.
+        File.CreatePipe(out readStdOut, out writeStdOut, asyncRead: true, capacity: options.OutputPipeCapacity);
+        File.CreatePipe(out readStdErr, out writeStdErr, asyncRead: true);
+
+        using (readStdOut)
+        using (writeStdOut)
+        using (readStdErr)
+        using (writeStdErr)
+        using (SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input, output: writeStdOut, error: writeStdErr))
+        {
+            // On Unix, we watch for the process exit, because it's possible for a process to exit
+            // without signaling EOF on stdout or stderr (when it spawns other processes that derive the file descriptors).
+            Task<ProcessExitStatus>? processExited = OperatingSystem.IsWindows() ? null : processHandle.WaitForExitAsync(cancellationToken);
+
+            using Stream outputStream = StreamHelper.CreateReadStream(readStdOut, processExited);
+            using Stream errorStream = StreamHelper.CreateReadStream(readStdErr, processExited);
+
+            Task<int> outputRead = outputStream.ReadAsync(outputBuffer.GetMemory(), cancellationToken).AsTask();
+            Task<int> errorRead = errorStream.ReadAsync(errorBuffer.GetMemory(), cancellationToken).AsTask();
 
             Task<int>[] tasks = [outputRead, errorRead];
 
-            try
+            while (!readStdOut.IsClosed || !readStdErr.IsClosed)
             {
-                while (!readStdOut.IsClosed || !readStdErr.IsClosed)
+                await Task.WhenAny(tasks);
+                // Don't compare the tasks by reference: reads that complete synchronously can return the same cached task instance.
+                bool isError = tasks.Length == 2 ? !outputRead.IsCompleted : readStdOut.IsClosed;
+                Task<int> finished = isError ? errorRead : outputRead;
+
+                int bytesRead = await finished;
+                if (bytesRead > 0)
                 {
-                    Task<int> finished = await Task.WhenAny(tasks);
-                    bool isError = finished == errorRead;
+                    ChildProcessTelemetry.OutputRead(processHandle, bytesRead);
 
-                    int bytesRead = await finished;
-                    if (bytesRead > 0)
+                    if (isError)
                     {
-                        if (isError)
-                        {
-                            errorStartIndex += bytesRead;
-                            if (errorStartIndex == errorBuffer.Length)
-                            {
-                                BufferHelper.RentLargerBuffer(ref errorBuffer);
-                            }
-                            // The tasks array may get resized, so we refer to error as last element.
-                            tasks[^1] = errorRead = errorStream.ReadAsync(errorBuffer, errorStartIndex, errorBuffer.Length - errorStartIndex, cancellationToken);
-                        }
-                        else
-                        {
-                            outputStartIndex += bytesRead;
-                            if (outputStartIndex == outputBuffer.Length)
-                            {
-                                BufferHelper.RentLargerBuffer(ref outputBuffer);
-                            }
-                            tasks[0] = outputRead = outputStream.ReadAsync(outputBuffer, outputStartIndex, outputBuffer.Length - outputStartIndex, cancellationToken);
-                        }
+                        errorBuffer.Advance(bytesRead);
+                        // The tasks array may get resized, so we refer to error as last element.
+                        tasks[^1] = errorRead = errorStream.ReadAsync(errorBuffer.GetMemory(), cancellationToken).AsTask();
                     }
                     else
                     {
-                        (isError ? errorStream : outputStream).Close();
-
-                        if (tasks.Length == 2)
-                        {
-                            tasks = [(isError ? outputRead : errorRead)];
-                        }
+                        outputBuffer.Advance(bytesRead);
+                        tasks[0] = outputRead = outputStream.ReadAsync(outputBuffer.GetMemory(), cancellationToken).AsTask();
                     }
                 }
-
-                ProcessExitStatus exitStatus;
-                if (!processHandle.TryGetExitCode(out int exitCode, out PosixSignal? signal))
-                {
-                    exitStatus = await processHandle.WaitForExitAsync(cancellationToken);
-                }
                 else
                 {
-                    exitStatus = new ProcessExitStatus(exitCode, cancelled: false, signal);
-                }
+                    (isError ? errorStream : outputStream).Close();
 
-                // Instead of decoding on the fly, we decode once at the end.
-                string output = (encoding ?? Encoding.UTF8).GetString(outputBuffer, 0, outputStartIndex);
-                string error = (encoding ?? Encoding.UTF8).GetString(errorBuffer, 0, errorStartIndex);
+                    if (tasks.Length == 2)
+                    {
+                        tasks = [(isError ? outputRead : errorRead)];
+                    }
+                }
+            }
 
-                return new(exitStatus, output, error, processHandle.ProcessId);
+            ProcessExitStatus? exitStatus;
+            if (processExited is not null)
+            {
+                exitStatus = await processExited;
             }
-            finally
+            else if (!processHandle.TryGetExitStatus(canceled: false, out exitStatus))
             {
-                ArrayPool<byte>.Shared.Return(outputBuffer);
-                ArrayPool<byte>.Shared.Return(errorBuffer);
+                exitStatus = await processHandle.WaitForExitAsync(cancellationToken);
             }
+
+            return (exitStatus, processHandle.ProcessId);
+        }
+    }
+
+    /// <summary>
+    /// Starts a process with the specified options and returns the raw bytes of the standard output and error,
+    /// along with the order in which they were read and when.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="input">An optional handle to a file that provides input to the process's standard input stream. If null, no input is provided.</param>
+    /// <param name="timeout">An optional timeout that specifies the maximum duration to wait for the process to complete. If null, the
+    /// process will wait indefinitely.</param>
+    /// <returns>An <see cref="InterleavedOutput" /> object containing the process's exit code, id, standard output and standard error data,
+    /// and the chunks they were read in. It must be disposed to return the buffers to the pool.</returns>
+    /// <remarks>
+    /// Unlike <see cref="CaptureCombined(ProcessStartOptions, SafeFileHandle?, TimeSpan?)"/>, the streams are read from separate pipes, so every byte
+    /// is known to come from one or the other. Every read is recorded with its stream, offset, length and timestamp, which is enough to rebuild
+    /// the merged view or either stream without copying the bytes.
+    /// <see cref="ProcessStartOptions.MaxOutputBytes"/> does not apply, the offsets of the chunks would not point into the bytes that are kept.
+    /// </remarks>
+    public static InterleavedOutput CaptureInterleaved(ProcessStartOptions options, SafeFileHandle? input = null, TimeSpan? timeout = null)
+    {
+        ArgumentNullException.ThrowIfNull(options);
+
+        InterleavedBuffer buffer = new();
+        try
+        {
+            ProcessExitStatus exitStatus = StreamToCore(options, buffer.Output, buffer.Error, input, timeout, out int processId);
+
+            return new(exitStatus, buffer, processId);
+        }
+        catch
+        {
+            buffer.Dispose();
+            throw;
+        }
+    }
+
+    /// <summary>
+    /// Starts a process with the specified options and returns the raw bytes of the standard output and error,
+    /// along with the order in which they were read and when.
+    /// </summary>
+    /// <param name="options">The configuration options used to start the process. Cannot be null.</param>
+    /// <param name="input">An optional handle to a file that provides input to the process's standard input stream. If null, no input is provided.</param>
+    /// <param name="cancellationToken">A cancellation token to cancel the operation.</param>
+    /// <returns>An <see cref="InterleavedOutput" /> object containing the process's exit code, id, standard output and standard error data,
+    /// and the chunks they were read in. It must be disposed to return the buffers to the pool.</returns>
+    /// <remarks>See <see cref="CaptureInterleaved"/>.</remarks>
+    public static async Task<InterleavedOutput> CaptureInterleavedAsync(ProcessStartOptions options, SafeFileHandle? input = null, CancellationToken cancellationToken = default)
+    {
+        ArgumentNullException.ThrowIfNull(options);
+
+        InterleavedBuffer buffer = new();
+        try
+        {
+            (ProcessExitStatus exitStatus, int processId) = await ReadOutputAsync(options, input, buffer.Output, buffer.Error, cancellationToken);
+
+            return new(exitStatus, buffer, processId);
+        }
+        catch
+        {
+            buffer.Dispose();
+            throw;
         }
     }
 
@@ -342,31 +805,22 @@ public static partial class ChildProcess
         SafeFileHandle read, write;
         TimeoutHelper timeoutHelper = TimeoutHelper.Start(timeout);
 
-        File.CreatePipe(out read, out write, asyncRead: true);
+        File.CreatePipe(out read, out write, asyncRead: true, capacity: options.OutputPipeCapacity);
 
         using (read)
         using (write)
         using (SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input, output: write, error: write))
         {
-            int totalBytesRead = 0;
-            byte[] buffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
+            using SegmentedBuffer buffer = new(options.MaxOutputBytes, options.OutputLimitPolicy);
 
-            try
-            {
-                Multiplexing.ReadCombinedOutputCore(read, processHandle, timeoutHelper, ref totalBytesRead, ref buffer);
+            Multiplexing.ReadCombinedOutputCore(read, processHandle, timeoutHelper, buffer);
 
-                TimeSpan remaining = timeoutHelper.GetRemaining();
-                var exitStatus = remaining == Timeout.InfiniteTimeSpan
-                    ? processHandle.WaitForExit()
-                    : processHandle.WaitForExitOrKillOnTimeout(remaining);
+            TimeSpan remaining = timeoutHelper.GetRemaining();
+            var exitStatus = remaining == Timeout.InfiniteTimeSpan
+                ? processHandle.WaitForExit()
+                : processHandle.WaitForExitOrKillOnTimeout(remaining);
 
-                byte[] resultBuffer = BufferHelper.CreateCopy(buffer, totalBytesRead);
-                return new(exitStatus, resultBuffer, processHandle.ProcessId);
-            }
-            finally
-            {
-                ArrayPool<byte>.Shared.Return(buffer);
-            }
+            return new(exitStatus, buffer.ToArray(), processHandle.ProcessId, buffer.DroppedBytes);
         }
     }
 
@@ -385,50 +839,51 @@ public static partial class ChildProcess
 
         SafeFileHandle read, write;
 
-        // We open ASYNC read handle and sync write handle to allow for cancellation on Windows.
-        File.CreatePipe(out read, out write, asyncRead: OperatingSystem.IsWindows());
+        // We open ASYNC read handle and sync write handle:
+        // - On Windows, to allow for cancellation.
+        // - On Unix, to wait for the data with the shared reactor instead of blocking a thread.
+        File.CreatePipe(out read, out write, asyncRead: true, capacity: options.OutputPipeCapacity);
 
         using (read)
         using (write)
         using (SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input, output: write, error: write))
-        using (Stream outputStream = StreamHelper.CreateReadStream(read, cancellationToken))
         {
             int processId = processHandle.ProcessId;
 
-            byte[] buffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
-            int totalBytesRead = 0;
+            // On Unix, we watch for the process exit, because it's possible for a process to exit
+            // without signaling EOF (when it spawns other processes that derive the file descriptor).
+            Task<ProcessExitStatus>? processExited = OperatingSystem.IsWindows() ? null : processHandle.WaitForExitAsync(cancellationToken);
 
-            try
-            {
-                while (true)
-                {
-                    int bytesRead = await outputStream.ReadAsync(buffer.AsMemory(totalBytesRead), cancellationToken);
-                    if (bytesRead <= 0)
-                    {
-                        break;
-                    }
+            using Stream outputStream = StreamHelper.CreateReadStream(read, processExited);
 
-                    totalBytesRead += bytesRead;
-                    if (totalBytesRead == buffer.Length)
-                    {
-                        BufferHelper.RentLargerBuffer(ref buffer);
-                    }
-                }
+            using SegmentedBuffer buffer = new(options.MaxOutputBytes, options.OutputLimitPolicy);
 
-                byte[] resultBuffer = BufferHelper.CreateCopy(buffer, totalBytesRead);
-                // It's possible for the process to close STD OUT and ERR keep running.
-                // We optimize for hot path: process already exited and exit code is available.
-                if (!processHandle.TryGetExitStatus(canceled: false, out ProcessExitStatus? exitStatus))
+            while (true)
+            {
+                int bytesRead = await outputStream.ReadAsync(buffer.GetMemory(), cancellationToken);
+                if (bytesRead <= 0)
                 {
-                    exitStatus = await processHandle.WaitForExitAsync(cancellationToken);
+                    break;
                 }
 
-                return new(exitStatus, resultBuffer, processId);
+                buffer.Advance(bytesRead);
+                ChildProcessTelemetry.OutputRead(processHandle, bytesRead);
             }
-            finally
+
+            byte[] resultBuffer = buffer.ToArray();
+            // It's possible for the process to close STD OUT and ERR keep running.
+            // We optimize for hot path: process already exited and exit code is available.
+            ProcessExitStatus? exitStatus;
+            if (processExited is not null)
+            {
+                exitStatus = await processExited;
+            }
+            else if (!processHandle.TryGetExitStatus(canceled: false, out exitStatus))
             {
-                ArrayPool<byte>.Shared.Return(buffer);
+                exitStatus = await processHandle.WaitForExitAsync(cancellationToken);
             }
+
+            return new(exitStatus, resultBuffer, processId, buffer.DroppedBytes);
         }
     }
 
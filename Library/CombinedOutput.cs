@@ -20,11 +20,17 @@ public readonly struct CombinedOutput
     /// <remarks>This information can be useful to process any diagnostics/tracing data post run.</remarks>
     public int ProcessId { get; }
 
-    public CombinedOutput(ProcessExitStatus exitStatus, ReadOnlyMemory<byte> bytes, int processId) : this()
+    /// <summary>
+    /// Gets the number of bytes the process has written but that were not kept because of <see cref="ProcessStartOptions.MaxOutputBytes"/>.
+    /// </summary>
+    public long DroppedBytes { get; }
+
+    public CombinedOutput(ProcessExitStatus exitStatus, ReadOnlyMemory<byte> bytes, int processId, long droppedBytes = 0) : this()
     {
         ExitStatus = exitStatus;
         Bytes = bytes;
         ProcessId = processId;
+        DroppedBytes = droppedBytes;
     }
 
     public string GetText(Encoding? encoding = null)
@@ -0,0 +1,31 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+using System;
+using System.Runtime.InteropServices;
+using Microsoft.Win32.SafeHandles;
+
+internal static partial class Interop
+{
+    internal static partial class Kernel32
+    {
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct PROCESS_MEMORY_COUNTERS
+        {
+            internal uint cb;
+            internal uint PageFaultCount;
+            internal UIntPtr PeakWorkingSetSize;
+            internal UIntPtr WorkingSetSize;
+            internal UIntPtr QuotaPeakPagedPoolUsage;
+            internal UIntPtr QuotaPagedPoolUsage;
+            internal UIntPtr QuotaPeakNonPagedPoolUsage;
+            internal UIntPtr QuotaNonPagedPoolUsage;
+            internal UIntPtr PagefileUsage;
+            internal UIntPtr PeakPagefileUsage;
+        }
+
+        [LibraryImport(Libraries.Kernel32, EntryPoint = "K32GetProcessMemoryInfo", SetLastError = true)]
+        [return: MarshalAs(UnmanagedType.Bool)]
+        internal static partial bool GetProcessMemoryInfo(SafeChildProcessHandle handle, ref PROCESS_MEMORY_COUNTERS counters, uint size);
+    }
+}
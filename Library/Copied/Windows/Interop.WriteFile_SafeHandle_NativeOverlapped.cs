@@ -0,0 +1,21 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+using System;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+internal static partial class Interop
+{
+    internal static partial class Kernel32
+    {
+        [LibraryImport(Libraries.Kernel32, SetLastError = true)]
+        internal static unsafe partial
+         int WriteFile(
+            SafeHandle handle,
+            byte* bytes,
+            int numBytesToWrite,
+            IntPtr numBytesWritten_mustBeZero,
+            NativeOverlapped* lpOverlapped);
+    }
+}
@@ -0,0 +1,197 @@
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading;
+
+namespace System.TBA;
+
+/// <summary>
+/// The process-wide cache of the executable paths resolved for file names that are not rooted.
+/// </summary>
+/// <remarks>
+/// <para>
+/// Resolving a file name probes the executable directory, the current directory (and the system directories on Windows)
+/// and then every directory listed in the PATH environment variable, which is often more expensive than starting the process.
+/// The results, including the file names that could not be resolved, are cached per file name, PATH value and current directory.
+/// </para>
+/// <para>
+/// The entries expire after <see cref="PositiveEntryTimeToLive"/> and <see cref="NegativeEntryTimeToLive"/> respectively.
+/// When <see cref="WatchPathDirectories"/> is enabled, the cache is also cleared as soon as a file is created, deleted or renamed
+/// in any of the searched directories. Changes made by other machines to network file systems may not be reported.
+/// </para>
+/// </remarks>
+public static class ExecutablePathCache
+{
+    // Prevents unbounded growth when the callers use ever-changing file names or PATH values: the cache is cleared when full.
+    private const int MaxEntryCount = 1024;
+
+    private static readonly ConcurrentDictionary<Key, Entry> s_entries = new();
+    private static readonly Dictionary<string, FileSystemWatcher> s_watchers = new(StringComparer.Ordinal);
+    private static long s_hits, s_misses;
+    private static long s_positiveTimeToLiveMilliseconds = 60_000, s_negativeTimeToLiveMilliseconds = 2_000;
+    private static bool s_watchPathDirectories;
+
+    /// <summary>
+    /// Gets the number of resolutions served from the cache.
+    /// </summary>
+    public static long Hits => Interlocked.Read(ref s_hits);
+
+    /// <summary>
+    /// Gets the number of resolutions that had to probe the file system.
+    /// </summary>
+    public static long Misses => Interlocked.Read(ref s_misses);
+
+    /// <summary>
+    /// Gets or sets how long a resolved path is cached. The default is one minute.
+    /// </summary>
+    /// <remarks><see cref="TimeSpan.Zero"/> disables caching of resolved paths, <see cref="Timeout.InfiniteTimeSpan"/> keeps them until <see cref="Clear"/> is called.</remarks>
+    public static TimeSpan PositiveEntryTimeToLive
+    {
+        get => FromMilliseconds(Interlocked.Read(ref s_positiveTimeToLiveMilliseconds));
+        set => Interlocked.Exchange(ref s_positiveTimeToLiveMilliseconds, ToMilliseconds(value));
+    }
+
+    /// <summary>
+    /// Gets or sets how long a file name that could not be resolved is cached. The default is two seconds.
+    /// </summary>
+    /// <remarks><see cref="TimeSpan.Zero"/> disables caching of failed resolutions, <see cref="Timeout.InfiniteTimeSpan"/> keeps them until <see cref="Clear"/> is called.</remarks>
+    public static TimeSpan NegativeEntryTimeToLive
+    {
+        get => FromMilliseconds(Interlocked.Read(ref s_negativeTimeToLiveMilliseconds));
+        set => Interlocked.Exchange(ref s_negativeTimeToLiveMilliseconds, ToMilliseconds(value));
+    }
+
+    /// <summary>
+    /// Gets or sets a value indicating whether the searched directories are watched for changes (inotify on Linux, FSEvents on macOS),
+    /// so the cache reflects added, removed or renamed executables before the entries expire. Disabled by default.
+    /// </summary>
+    public static bool WatchPathDirectories
+    {
+        get => Volatile.Read(ref s_watchPathDirectories);
+        set
+        {
+            lock (s_watchers)
+            {
+                s_watchPathDirectories = value;
+
+                if (!value)
+                {
+                    foreach (FileSystemWatcher watcher in s_watchers.Values)
+                    {
+                        watcher.Dispose();
+                    }
+                    s_watchers.Clear();
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// Removes all the entries from the cache.
+    /// </summary>
+    public static void Clear() => s_entries.Clear();
+
+    internal static string Resolve(string fileName, Func<string, string?> probe)
+    {
+        string? pathEnvVar = Environment.GetEnvironmentVariable("PATH");
+        Key key = new(fileName, pathEnvVar, Directory.GetCurrentDirectory());
+        long now = Environment.TickCount64;
+
+        if (s_entries.TryGetValue(key, out Entry? entry) && now < entry.ExpiresAt)
+        {
+            Interlocked.Increment(ref s_hits);
+            return entry.Path ?? throw new FileNotFoundException("Could not resolve the file.", fileName);
+        }
+
+        Interlocked.Increment(ref s_misses);
+
+        if (WatchPathDirectories)
+        {
+            // Watch before probing, so a change that happens in between is not missed.
+            Watch(key.CurrentDirectory, pathEnvVar);
+        }
+
+        string? resolvedPath = probe(fileName);
+
+        long timeToLive = Interlocked.Read(ref resolvedPath is null ? ref s_negativeTimeToLiveMilliseconds : ref s_positiveTimeToLiveMilliseconds);
+        if (timeToLive != 0)
+        {
+            if (s_entries.Count >= MaxEntryCount)
+            {
+                s_entries.Clear();
+            }
+
+            s_entries[key] = new Entry(resolvedPath, timeToLive < 0 ? long.MaxValue : now + timeToLive);
+        }
+
+        return resolvedPath ?? throw new FileNotFoundException("Could not resolve the file.", fileName);
+    }
+
+    private static void Watch(string currentDirectory, string? pathEnvVar)
+    {
+        lock (s_watchers)
+        {
+            if (!s_watchPathDirectories)
+            {
+                return;
+            }
+
+            TryWatch(currentDirectory);
+
+            if (pathEnvVar is not null)
+            {
+                StringParser pathParser = new(pathEnvVar, Path.PathSeparator, skipEmpty: true);
+                while (pathParser.MoveNext())
+                {
+                    TryWatch(pathParser.ExtractCurrent());
+                }
+            }
+        }
+
+        static void TryWatch(string directory)
+        {
+            if (s_watchers.ContainsKey(directory) || !Directory.Exists(directory))
+            {
+                return;
+            }
+
+            try
+            {
+                FileSystemWatcher watcher = new(directory)
+                {
+                    NotifyFilter = NotifyFilters.FileName,
+                    IncludeSubdirectories = false,
+                };
+                watcher.Created += OnDirectoryChanged;
+                watcher.Deleted += OnDirectoryChanged;
+                watcher.Renamed += OnDirectoryChanged;
+                watcher.EnableRaisingEvents = true;
+
+                s_watchers.Add(directory, watcher);
+            }
+            catch (Exception ex) when (ex is IOException or UnauthorizedAccessException or ArgumentException)
+            {
+                // The directory can't be watched (for example the inotify watch limit was reached), the entries still expire.
+            }
+        }
+    }
+
+    private static void OnDirectoryChanged(object sender, FileSystemEventArgs e) => Clear();
+
+    private static TimeSpan FromMilliseconds(long milliseconds) => milliseconds < 0 ? Timeout.InfiniteTimeSpan : TimeSpan.FromMilliseconds(milliseconds);
+
+    private static long ToMilliseconds(TimeSpan value)
+    {
+        if (value == Timeout.InfiniteTimeSpan)
+        {
+            return -1;
+        }
+
+        ArgumentOutOfRangeException.ThrowIfLessThan(value, TimeSpan.Zero);
+        return (long)value.TotalMilliseconds;
+    }
+
+    private readonly record struct Key(string FileName, string? PathEnvironmentVariable, string CurrentDirectory);
+
+    private sealed record Entry(string? Path, long ExpiresAt);
+}
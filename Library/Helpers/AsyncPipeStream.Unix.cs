@@ -0,0 +1,149 @@
+using Microsoft.Win32.SafeHandles;
+using System.ComponentModel;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace System.TBA;
+
+/// <summary>
+/// This class exists so we can have cancellable async pipe reads on Unix without blocking any thread
+/// while waiting for the data: the readiness of the non-blocking pipe is awaited with <see cref="ProcessReactor"/>.
+/// </summary>
+internal sealed class AsyncPipeStream : Stream
+{
+    private readonly SafeFileHandle _pipeHandle;
+    private readonly Task? _processExited;
+
+    /// <param name="pipeHandle">The non-blocking read end of the pipe. It's owned by the stream.</param>
+    /// <param name="processExited">When provided, the stream reports EOF once the process has exited and all the data
+    /// written before the exit has been consumed, even if the pipe is kept open by the descendants of the process.</param>
+    internal AsyncPipeStream(SafeFileHandle pipeHandle, Task? processExited)
+    {
+        _pipeHandle = pipeHandle;
+        _processExited = processExited;
+    }
+
+    protected override void Dispose(bool disposing)
+    {
+        try
+        {
+            if (disposing)
+            {
+                _pipeHandle.Dispose();
+            }
+        }
+        finally
+        {
+            base.Dispose(disposing);
+        }
+    }
+
+    public override bool CanRead => true;
+
+    public override bool CanSeek => false;
+
+    public override bool CanWrite => false;
+
+    public override long Length => throw new NotImplementedException();
+
+    public override long Position { get => throw new NotImplementedException(); set => throw new NotImplementedException(); }
+
+    public override Task<int> ReadAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken = default)
+    {
+        return ReadAsync(new Memory<byte>(buffer, offset, count), cancellationToken).AsTask();
+    }
+
+    public override async ValueTask<int> ReadAsync(Memory<byte> buffer, CancellationToken cancellationToken = default)
+    {
+        ProcessReactor reactor = ProcessReactor.Instance;
+
+        while (true)
+        {
+            cancellationToken.ThrowIfCancellationRequested();
+
+            if (TryRead(buffer.Span, out int bytesRead))
+            {
+                return bytesRead;
+            }
+
+            // Nothing is buffered and the process has exited: don't wait for the descendants that may keep the pipe open.
+            if (_processExited is { IsCompletedSuccessfully: true })
+            {
+                return 0;
+            }
+
+            Task readable = reactor.WaitForReadAsync(_pipeHandle, cancellationToken);
+
+            if (_processExited is { IsCompleted: false })
+            {
+                Task completed = await Task.WhenAny(readable, _processExited).ConfigureAwait(false);
+                if (completed == _processExited && _processExited.IsCompletedSuccessfully)
+                {
+                    // Consume the data written before the exit.
+                    reactor.CancelWaitForRead(_pipeHandle);
+                    continue;
+                }
+            }
+
+            await readable.ConfigureAwait(false);
+        }
+    }
+
+    private unsafe bool TryRead(Span<byte> buffer, out int bytesRead)
+    {
+        int EWOULDBLOCK = OperatingSystem.IsLinux() ? 11 : 35;
+
+        while (true)
+        {
+            nint result;
+            fixed (byte* ptr = buffer)
+            {
+                result = PollHelper.read((int)_pipeHandle.DangerousGetHandle(), ptr, (nuint)buffer.Length);
+            }
+
+            if (result >= 0)
+            {
+                bytesRead = (int)result;
+                return true;
+            }
+
+            int errno = Marshal.GetLastPInvokeError();
+            if (errno == EWOULDBLOCK)
+            {
+                bytesRead = 0;
+                return false;
+            }
+            else if (errno != UnixHelpers.EINTR)
+            {
+                throw new Win32Exception(errno, $"read() failed with errno={errno}");
+            }
+        }
+    }
+
+    public override void Flush()
+    {
+        throw new NotImplementedException();
+    }
+
+    public override int Read(byte[] buffer, int offset, int count)
+    {
+        throw new NotImplementedException();
+    }
+
+    public override long Seek(long offset, SeekOrigin origin)
+    {
+        throw new NotImplementedException();
+    }
+
+    public override void SetLength(long value)
+    {
+        throw new NotImplementedException();
+    }
+
+    public override void Write(byte[] buffer, int offset, int count)
+    {
+        throw new NotImplementedException();
+    }
+}
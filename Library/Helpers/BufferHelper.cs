@@ -28,11 +28,4 @@ internal static class BufferHelper
             ArrayPool<byte>.Shared.Return(oldBuffer);
         }
     }
-
-    internal static byte[] CreateCopy(byte[] buffer, int totalBytesRead)
-    {
-        byte[] resultBuffer = GC.AllocateUninitializedArray<byte>(totalBytesRead);
-        Buffer.BlockCopy(buffer, 0, resultBuffer, 0, totalBytesRead);
-        return resultBuffer;
-    }
 }
@@ -0,0 +1,39 @@
+using System.Diagnostics.Tracing;
+
+namespace System.TBA;
+
+/// <summary>
+/// Traces the starts and exits of the child processes (dotnet-trace, PerfView, EventListener).
+/// The detailed timings and the counters are reported by <see cref="ChildProcessTelemetry"/>.
+/// </summary>
+[EventSource(Name = ChildProcessTelemetry.SourceName)]
+internal sealed class ChildProcessEventSource : EventSource
+{
+    internal static readonly ChildProcessEventSource Log = new();
+
+    private const int SpawnStartEventId = 1;
+    private const int SpawnStopEventId = 2;
+    private const int SpawnFailedEventId = 3;
+    private const int ProcessExitedEventId = 4;
+
+    private ChildProcessEventSource()
+    {
+    }
+
+    public static class Tasks
+    {
+        public const EventTask Spawn = (EventTask)1;
+    }
+
+    [Event(SpawnStartEventId, Level = EventLevel.Informational, Task = Tasks.Spawn, Opcode = EventOpcode.Start)]
+    public void SpawnStart(string fileName) => WriteEvent(SpawnStartEventId, fileName);
+
+    [Event(SpawnStopEventId, Level = EventLevel.Informational, Task = Tasks.Spawn, Opcode = EventOpcode.Stop)]
+    public void SpawnStop(int processId, double durationMilliseconds) => WriteEvent(SpawnStopEventId, processId, durationMilliseconds);
+
+    [Event(SpawnFailedEventId, Level = EventLevel.Error)]
+    public void SpawnFailed(string fileName, string message) => WriteEvent(SpawnFailedEventId, fileName, message);
+
+    [Event(ProcessExitedEventId, Level = EventLevel.Informational)]
+    public void ProcessExited(int processId, int exitCode, int signal, bool canceled) => WriteEvent(ProcessExitedEventId, processId, exitCode, signal, canceled);
+}
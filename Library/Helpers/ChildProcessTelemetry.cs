@@ -0,0 +1,145 @@
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Diagnostics.Metrics;
+using System.Threading;
+using Microsoft.Win32.SafeHandles;
+
+namespace System.TBA;
+
+/// <summary>
+/// The metrics of the child processes, observable with dotnet-counters or any MeterListener (for example, OpenTelemetry):
+/// <list type="bullet">
+/// <item><c>tba.process.start.duration</c>: the duration of the whole start, in milliseconds.</item>
+/// <item><c>tba.process.start.phase.duration</c>: the duration of each phase of the start, tagged with <c>phase</c>:
+/// <c>resolve_path</c>, <c>marshal_arguments</c> and <c>spawn</c> (fork/CreateProcess up to the exec handshake).</item>
+/// <item><c>tba.process.output.first_byte.duration</c>: the time from the start to the first byte of captured output.</item>
+/// <item><c>tba.process.output.bytes</c>: the number of bytes of output captured by the current process.</item>
+/// <item><c>tba.process.active</c>: the number of started children whose exit has not been observed yet.</item>
+/// </list>
+/// </summary>
+/// <remarks>
+/// Nothing is measured (no timestamps are taken) while there is no listener.
+/// </remarks>
+internal static class ChildProcessTelemetry
+{
+    internal const string SourceName = "System.TBA.ChildProcess";
+
+    internal const string ResolvePathPhase = "resolve_path";
+    internal const string MarshalArgumentsPhase = "marshal_arguments";
+    internal const string SpawnPhase = "spawn";
+
+    // SafeChildProcessHandle.TelemetryFlags
+    private const int CountedAsActive = 1, FirstOutputRecorded = 2;
+
+    private static readonly Meter s_meter = new(SourceName);
+    private static readonly Histogram<double> s_startDuration = s_meter.CreateHistogram<double>(
+        "tba.process.start.duration", "ms", "The duration of the start of a child process.");
+    private static readonly Histogram<double> s_startPhaseDuration = s_meter.CreateHistogram<double>(
+        "tba.process.start.phase.duration", "ms", "The duration of a phase of the start of a child process.");
+    private static readonly Histogram<double> s_firstOutputDuration = s_meter.CreateHistogram<double>(
+        "tba.process.output.first_byte.duration", "ms", "The time from the start of a child process to the first byte of its captured output.");
+    private static readonly Counter<long> s_outputBytes = s_meter.CreateCounter<long>(
+        "tba.process.output.bytes", "By", "The number of bytes of output captured from child processes.");
+    private static readonly UpDownCounter<long> s_activeProcesses = s_meter.CreateUpDownCounter<long>(
+        "tba.process.active", "{process}", "The number of started child processes whose exit has not been observed yet.");
+
+    /// <summary>
+    /// Returns the current timestamp when the start is measured, 0 otherwise.
+    /// </summary>
+    internal static long GetStartTimestamp()
+        => s_startDuration.Enabled || s_startPhaseDuration.Enabled || s_firstOutputDuration.Enabled || ChildProcessEventSource.Log.IsEnabled()
+            ? Stopwatch.GetTimestamp()
+            : 0;
+
+    /// <summary>
+    /// Records the duration of a phase that started at <paramref name="timestamp"/>, returns the timestamp of the start of the next phase.
+    /// </summary>
+    internal static long RecordPhase(string phase, long timestamp)
+    {
+        if (timestamp == 0 || !s_startPhaseDuration.Enabled)
+        {
+            return timestamp;
+        }
+
+        long now = Stopwatch.GetTimestamp();
+        s_startPhaseDuration.Record(Stopwatch.GetElapsedTime(timestamp, now).TotalMilliseconds, new KeyValuePair<string, object?>("phase", phase));
+        return now;
+    }
+
+    internal static void SpawnStarting(string fileName, long timestamp)
+    {
+        if (timestamp != 0 && ChildProcessEventSource.Log.IsEnabled())
+        {
+            ChildProcessEventSource.Log.SpawnStart(fileName);
+        }
+    }
+
+    internal static void SpawnFailed(string fileName, Exception exception)
+    {
+        if (ChildProcessEventSource.Log.IsEnabled())
+        {
+            ChildProcessEventSource.Log.SpawnFailed(fileName, exception.Message);
+        }
+    }
+
+    internal static void ProcessStarted(SafeChildProcessHandle processHandle, long timestamp)
+    {
+        if (s_activeProcesses.Enabled)
+        {
+            processHandle.TelemetryFlags = CountedAsActive;
+            s_activeProcesses.Add(1);
+        }
+
+        if (timestamp == 0)
+        {
+            return;
+        }
+
+        // Time to the first byte of output is measured from here.
+        processHandle.StartTimestamp = timestamp;
+
+        double milliseconds = Stopwatch.GetElapsedTime(timestamp).TotalMilliseconds;
+        s_startDuration.Record(milliseconds);
+
+        if (ChildProcessEventSource.Log.IsEnabled())
+        {
+            ChildProcessEventSource.Log.SpawnStop(processHandle.ProcessId, milliseconds);
+        }
+    }
+
+    internal static void OutputRead(SafeChildProcessHandle processHandle, long bytesRead)
+    {
+        if (bytesRead <= 0)
+        {
+            return;
+        }
+
+        s_outputBytes.Add(bytesRead);
+
+        if (processHandle.StartTimestamp != 0 && (processHandle.TelemetryFlags & FirstOutputRecorded) == 0
+            && (Interlocked.Or(ref processHandle.TelemetryFlags, FirstOutputRecorded) & FirstOutputRecorded) == 0)
+        {
+            s_firstOutputDuration.Record(Stopwatch.GetElapsedTime(processHandle.StartTimestamp).TotalMilliseconds);
+        }
+    }
+
+    internal static void ProcessExited(SafeChildProcessHandle processHandle, ProcessExitStatus exitStatus)
+    {
+        ProcessReleased(processHandle);
+
+        if (ChildProcessEventSource.Log.IsEnabled())
+        {
+            ChildProcessEventSource.Log.ProcessExited(processHandle.ProcessId, exitStatus.ExitCode, (int)(exitStatus.Signal ?? 0), exitStatus.Canceled);
+        }
+    }
+
+    // The exit was observed or the handle was released: the process is not tracked anymore.
+    internal static void ProcessReleased(SafeChildProcessHandle processHandle)
+    {
+        if ((processHandle.TelemetryFlags & CountedAsActive) != 0
+            && (Interlocked.And(ref processHandle.TelemetryFlags, ~CountedAsActive) & CountedAsActive) != 0)
+        {
+            s_activeProcesses.Add(-1);
+        }
+    }
+}
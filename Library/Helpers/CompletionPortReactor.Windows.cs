@@ -0,0 +1,480 @@
+using Microsoft.Win32.SafeHandles;
+using System.Collections.Generic;
+using System.ComponentModel;
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace System.TBA;
+
+#pragma warning disable CA1416 // Validate platform compatibility
+
+/// <summary>
+/// A single process-wide I/O completion port that all the pipes read by the captures are bound to,
+/// so any number of running captures costs neither an event per read operation nor a kernel wait per capture.
+/// Process exits are delivered to the same port by a job object (JOBOBJECT_ASSOCIATE_COMPLETION_PORT) the captured processes are assigned to.
+/// One thread dequeues the completions and wakes up the waiting captures.
+/// A process can't leave a job: the captured processes (and the processes they start) stay in it until they exit.
+/// It sets no limits but JOB_OBJECT_LIMIT_BREAKAWAY_OK, and a new job they are assigned to is nested in it.
+/// The processes that can't be assigned (their job does not allow it) are awaited by a registered wait instead.
+/// </summary>
+internal sealed unsafe partial class CompletionPortReactor
+{
+    private const int EntryBufferSize = 64;
+
+    // The completion keys: the reads and writes are identified by their OVERLAPPED, the job messages by the process ID.
+    private const nuint ReadKey = 0;
+    private const nuint JobKey = 1;
+
+    private const int JOB_OBJECT_MSG_EXIT_PROCESS = 7;
+    private const int JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS = 8;
+    private const int JobObjectAssociateCompletionPortInformation = 7;
+    private const uint JOB_OBJECT_LIMIT_BREAKAWAY_OK = 0x00000800;
+    private const int WAIT_OBJECT_0 = 0;
+
+    private static readonly object s_initializationLock = new();
+    private static CompletionPortReactor? s_instance;
+
+    private readonly IntPtr _port;
+    private readonly IntPtr _job;
+    // A process can be captured by only one capture at a time, as it is reaped by it.
+    private readonly Dictionary<int, Group> _exitWaiters = new();
+
+    private CompletionPortReactor(IntPtr port, IntPtr job)
+    {
+        _port = port;
+        _job = job;
+
+        Thread thread = new(static state => ((CompletionPortReactor)state!).EventLoop())
+        {
+            IsBackground = true,
+            Name = "Process Completion Port"
+        };
+        thread.UnsafeStart(this);
+    }
+
+    internal static CompletionPortReactor Instance => s_instance ?? Initialize();
+
+    private static CompletionPortReactor Initialize()
+    {
+        lock (s_initializationLock)
+        {
+            if (s_instance is null)
+            {
+                IntPtr port = CreateIoCompletionPort(new IntPtr(-1), IntPtr.Zero, 0, 1);
+                if (port == IntPtr.Zero)
+                {
+                    throw new Win32Exception(Marshal.GetLastPInvokeError(), "Failed to create the I/O completion port");
+                }
+
+                // The job only observes the processes: the processes started by them can still break away from it, as they could before.
+                IntPtr job = Interop.Kernel32.CreateJobObjectW(IntPtr.Zero, IntPtr.Zero);
+                JOBOBJECT_ASSOCIATE_COMPLETION_PORT association = new() { CompletionKey = (IntPtr)JobKey, CompletionPort = port };
+                Interop.Kernel32.JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = default;
+                limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_BREAKAWAY_OK;
+                if (job == IntPtr.Zero
+                    || !SetInformationJobObject(job, JobObjectAssociateCompletionPortInformation, ref association, (uint)sizeof(JOBOBJECT_ASSOCIATE_COMPLETION_PORT))
+                    || !Interop.Kernel32.SetInformationJobObject(job, Interop.Kernel32.JOBOBJECTINFOCLASS.JobObjectExtendedLimitInformation,
+                        ref limits, (uint)sizeof(Interop.Kernel32.JOBOBJECT_EXTENDED_LIMIT_INFORMATION)))
+                {
+                    int errorCode = Marshal.GetLastPInvokeError();
+                    if (job != IntPtr.Zero)
+                    {
+                        Interop.Kernel32.CloseHandle(job);
+                    }
+                    Interop.Kernel32.CloseHandle(port);
+                    throw new Win32Exception(errorCode, "Failed to create the job object reporting to the I/O completion port");
+                }
+
+                s_instance = new(port, job);
+            }
+
+            return s_instance;
+        }
+    }
+
+    /// <summary>
+    /// Creates a group of read (or write) operations, optionally completed early by the exit of the given process.
+    /// </summary>
+    internal Group CreateGroup(int operationCount, SafeChildProcessHandle? processHandle) => new(this, operationCount, processHandle);
+
+    private void EventLoop()
+    {
+        OVERLAPPED_ENTRY* entries = stackalloc OVERLAPPED_ENTRY[EntryBufferSize];
+
+        while (true)
+        {
+            if (!GetQueuedCompletionStatusEx(_port, entries, EntryBufferSize, out int count, Timeout.Infinite, fAlertable: false))
+            {
+                // It can fail only due to a bug (invalid handle or arguments), and all pending captures would hang otherwise.
+                int errorCode = Marshal.GetLastPInvokeError();
+                Environment.FailFast($"GetQueuedCompletionStatusEx() failed with {errorCode}");
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                OVERLAPPED_ENTRY entry = entries[i];
+                if (entry.lpCompletionKey == ReadKey)
+                {
+                    OperationBlock* block = (OperationBlock*)entry.lpOverlapped;
+                    ((Group)GCHandle.FromIntPtr(block->Group).Target!).OnReadCompleted(block->Index);
+                }
+                else if (entry.dwNumberOfBytesTransferred is JOB_OBJECT_MSG_EXIT_PROCESS or JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS)
+                {
+                    // The descendants of the captured processes are in the job too, and are not awaited.
+                    // The lock keeps the group (and its process handle) from being disposed in the meantime.
+                    lock (_exitWaiters)
+                    {
+                        if (_exitWaiters.TryGetValue((int)(nint)entry.lpOverlapped, out Group? group))
+                        {
+                            group.OnProcessExitReported();
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // The OVERLAPPED must be the first field: the completion packets point to it.
+    [StructLayout(LayoutKind.Sequential)]
+    private struct OperationBlock
+    {
+        internal NativeOverlapped Overlapped;
+        internal IntPtr Group;
+        internal int Index;
+    }
+
+    private struct Operation
+    {
+        internal SafeFileHandle? Handle;
+        // Issued and its completion packet not dequeued yet: the OVERLAPPED must not be reused nor freed.
+        internal bool IsPending;
+        // Dequeued and not consumed by WaitAny yet.
+        internal bool IsCompleted;
+        // The error of a read that failed synchronously, no completion packet is queued for those.
+        internal int SynchronousError;
+    }
+
+    /// <summary>
+    /// The read operations of a single capture. The methods must not be called concurrently.
+    /// </summary>
+    internal sealed class Group : IDisposable
+    {
+        /// <summary>Returned by <see cref="WaitAny"/> when the process has exited.</summary>
+        internal const int ProcessExited = -1;
+
+        // Job notifications are not guaranteed to be delivered, so the process handle is also checked periodically.
+        private const int ExitPollingIntervalMilliseconds = 1000;
+
+        private readonly CompletionPortReactor _reactor;
+        private readonly SafeChildProcessHandle? _processHandle;
+        // Used only when the process could not be assigned to the job.
+        private readonly Interop.Kernel32.ProcessWaitHandle? _exitWaitHandle;
+        private readonly RegisteredWaitHandle? _exitRegistration;
+        private readonly Operation[] _operations;
+        private readonly OperationBlock* _blocks;
+        private GCHandle _self;
+        private bool _processExited;
+        private int _nextIndex;
+
+        internal Group(CompletionPortReactor reactor, int operationCount, SafeChildProcessHandle? processHandle)
+        {
+            _reactor = reactor;
+            _operations = new Operation[operationCount];
+            _blocks = (OperationBlock*)NativeMemory.AllocZeroed((nuint)operationCount, (nuint)sizeof(OperationBlock));
+            _self = GCHandle.Alloc(this);
+
+            for (int i = 0; i < operationCount; i++)
+            {
+                _blocks[i].Group = GCHandle.ToIntPtr(_self);
+                _blocks[i].Index = i;
+            }
+
+            if (processHandle is not null)
+            {
+                _processHandle = processHandle;
+
+                lock (reactor._exitWaiters)
+                {
+                    reactor._exitWaiters[processHandle.ProcessId] = this;
+                }
+
+                // Registered before the assignment, so the exit can't be missed. A process that has already exited is observed below.
+                if (!Interop.Kernel32.AssignProcessToJobObject(reactor._job, processHandle.DangerousGetHandle()))
+                {
+                    // It's in a job that does not allow it (KillOnParentExit, CreateNewProcessGroup and the like),
+                    // the thread pool waits for its exit instead.
+                    _exitWaitHandle = new(processHandle);
+                    _exitRegistration = ThreadPool.UnsafeRegisterWaitForSingleObject(
+                        _exitWaitHandle,
+                        static (state, timedOut) => ((Group)state!).OnProcessExited(),
+                        this,
+                        Timeout.Infinite,
+                        executeOnlyOnce: true);
+                }
+                _processExited = HasProcessExited();
+            }
+        }
+
+        /// <summary>
+        /// Binds the overlapped handle to the completion port, it stays bound until it's closed.
+        /// </summary>
+        internal void Bind(SafeFileHandle handle)
+        {
+            if (CreateIoCompletionPort(handle.DangerousGetHandle(), _reactor._port, ReadKey, 0) == IntPtr.Zero)
+            {
+                throw new Win32Exception(Marshal.GetLastPInvokeError(), "Failed to bind the handle to the I/O completion port");
+            }
+        }
+
+        /// <summary>
+        /// Issues an overlapped read, its completion is reported by <see cref="WaitAny"/>.
+        /// </summary>
+        internal void Read(int index, SafeFileHandle handle, byte* buffer, int length) => Issue(index, handle, buffer, length, isWrite: false);
+
+        /// <summary>
+        /// Issues an overlapped write, its completion is reported by <see cref="WaitAny"/> like the one of a read.
+        /// </summary>
+        internal void Write(int index, SafeFileHandle handle, byte* buffer, int length) => Issue(index, handle, buffer, length, isWrite: true);
+
+        private void Issue(int index, SafeFileHandle handle, byte* buffer, int length, bool isWrite)
+        {
+            ref Operation operation = ref _operations[index];
+            Debug.Assert(!operation.IsPending && !operation.IsCompleted);
+
+            NativeOverlapped* overlapped = &_blocks[index].Overlapped;
+            *overlapped = default;
+
+            operation.Handle = handle;
+            operation.SynchronousError = 0;
+            operation.IsPending = true;
+
+            // An operation that completes synchronously still queues a completion packet, one that fails does not.
+            int result = isWrite
+                ? Interop.Kernel32.WriteFile(handle, buffer, length, IntPtr.Zero, overlapped)
+                : Interop.Kernel32.ReadFile(handle, buffer, length, IntPtr.Zero, overlapped);
+            if (result == 0)
+            {
+                int errorCode = Marshal.GetLastPInvokeError();
+                if (errorCode != Interop.Errors.ERROR_IO_PENDING)
+                {
+                    lock (_operations)
+                    {
+                        operation.IsPending = false;
+                        operation.IsCompleted = true;
+                        operation.SynchronousError = errorCode;
+                    }
+                }
+            }
+        }
+
+        /// <summary>
+        /// Waits for a read to complete or the process to exit.
+        /// </summary>
+        /// <returns>The index of the completed read, <see cref="ProcessExited"/> or <see cref="WaitHandle.WaitTimeout"/>.</returns>
+        internal int WaitAny(int timeoutMilliseconds)
+        {
+            long deadline = timeoutMilliseconds == Timeout.Infinite ? long.MaxValue : Environment.TickCount64 + timeoutMilliseconds;
+
+            lock (_operations)
+            {
+                while (true)
+                {
+                    // Round-robin, so a very chatty pipe does not starve the other one.
+                    for (int i = 0; i < _operations.Length; i++)
+                    {
+                        int index = (_nextIndex + i) % _operations.Length;
+                        if (_operations[index].IsCompleted)
+                        {
+                            _operations[index].IsCompleted = false;
+                            _nextIndex = index + 1;
+                            return index;
+                        }
+                    }
+
+                    if (_processExited)
+                    {
+                        return ProcessExited;
+                    }
+
+                    long remaining = deadline - Environment.TickCount64;
+                    if (remaining <= 0)
+                    {
+                        return WaitHandle.WaitTimeout;
+                    }
+
+                    // The registered wait is reliable, only the job notifications are polled for.
+                    bool poll = _processHandle is not null && _exitRegistration is null;
+                    int slice = poll ? (int)Math.Min(remaining, ExitPollingIntervalMilliseconds) : (int)Math.Min(remaining, int.MaxValue);
+                    if (!Monitor.Wait(_operations, slice) && poll)
+                    {
+                        _processExited = HasProcessExited();
+                    }
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets the number of bytes transferred by the completed operation: 0 for EOF, or for a write when the reader has closed the pipe.
+        /// </summary>
+        internal int GetResult(int index)
+        {
+            ref Operation operation = ref _operations[index];
+            int errorCode = operation.SynchronousError;
+            int bytesRead = 0;
+
+            if (errorCode == 0 && !Interop.Kernel32.GetOverlappedResult(operation.Handle!, &_blocks[index].Overlapped, ref bytesRead, bWait: false))
+            {
+                errorCode = operation.Handle!.GetLastWin32ErrorAndDisposeHandleIfInvalid();
+            }
+
+            switch (errorCode)
+            {
+                case 0:
+                    return bytesRead;
+                case Interop.Errors.ERROR_HANDLE_EOF: // logically success with 0 bytes read (read at end of file)
+                case Interop.Errors.ERROR_BROKEN_PIPE: // For pipes, ERROR_BROKEN_PIPE is the normal end of the pipe.
+                case Interop.Errors.ERROR_PIPE_NOT_CONNECTED: // Named pipe server has disconnected, return 0 to match NamedPipeClientStream behaviour
+                case Interop.Errors.ERROR_NO_DATA: // The reader has closed the pipe that is being written to.
+                    return 0; // EOF!
+                default:
+                    throw new Win32Exception(errorCode);
+            }
+        }
+
+        /// <summary>
+        /// Cancels the read (if it's still pending), waits for its completion packet and closes the handle.
+        /// </summary>
+        internal void CancelPendingIO(int index)
+        {
+            SafeFileHandle handle = _operations[index].Handle!;
+
+            // CancelIoEx does not wait for the canceled operation to complete, and the OVERLAPPED
+            // must not be reused or freed until its completion packet is dequeued.
+            if (!Interop.Kernel32.CancelIoEx(handle, &_blocks[index].Overlapped))
+            {
+                // ERROR_NOT_FOUND: the read has already completed (or was never issued).
+                int errorCode = Marshal.GetLastPInvokeError();
+                Debug.Assert(errorCode == Interop.Errors.ERROR_NOT_FOUND, $"CancelIoEx failed with {errorCode}.");
+            }
+
+            WaitUntilNotPending(index);
+            _operations[index].IsCompleted = false;
+
+            handle.Close();
+        }
+
+        public void Dispose()
+        {
+            if (!_self.IsAllocated)
+            {
+                return;
+            }
+
+            if (_processHandle is not null)
+            {
+                lock (_reactor._exitWaiters)
+                {
+                    if (_reactor._exitWaiters.TryGetValue(_processHandle.ProcessId, out Group? group) && ReferenceEquals(group, this))
+                    {
+                        _reactor._exitWaiters.Remove(_processHandle.ProcessId);
+                    }
+                }
+
+                // A callback that is already running does not use the wait handle.
+                _exitRegistration?.Unregister(null);
+                _exitWaitHandle?.Dispose();
+            }
+
+            // Reads may still be pending when the capture has failed, closing the handle cancels them too.
+            for (int i = 0; i < _operations.Length; i++)
+            {
+                if (_operations[i].IsPending)
+                {
+                    SafeFileHandle handle = _operations[i].Handle!;
+                    if (!handle.IsClosed)
+                    {
+                        Interop.Kernel32.CancelIoEx(handle, &_blocks[i].Overlapped);
+                    }
+                    WaitUntilNotPending(i);
+                }
+            }
+
+            _self.Free();
+            NativeMemory.Free(_blocks);
+        }
+
+        internal void OnReadCompleted(int index)
+        {
+            lock (_operations)
+            {
+                _operations[index].IsPending = false;
+                _operations[index].IsCompleted = true;
+                Monitor.PulseAll(_operations);
+            }
+        }
+
+        internal void OnProcessExitReported()
+        {
+            // The message may be about a previous process with the same ID, it's only a hint.
+            if (HasProcessExited())
+            {
+                OnProcessExited();
+            }
+        }
+
+        // Called by the registered wait too, which may run after the group (and the process handle) is disposed.
+        private void OnProcessExited()
+        {
+            lock (_operations)
+            {
+                _processExited = true;
+                Monitor.PulseAll(_operations);
+            }
+        }
+
+        private void WaitUntilNotPending(int index)
+        {
+            lock (_operations)
+            {
+                while (_operations[index].IsPending)
+                {
+                    Monitor.Wait(_operations);
+                }
+            }
+        }
+
+        private bool HasProcessExited() => WaitForSingleObject(_processHandle!, 0) == WAIT_OBJECT_0;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    private struct OVERLAPPED_ENTRY
+    {
+        internal nuint lpCompletionKey;
+        internal NativeOverlapped* lpOverlapped;
+        internal nuint Internal;
+        internal int dwNumberOfBytesTransferred;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    private struct JOBOBJECT_ASSOCIATE_COMPLETION_PORT
+    {
+        internal IntPtr CompletionKey;
+        internal IntPtr CompletionPort;
+    }
+
+    [LibraryImport(Interop.Libraries.Kernel32, SetLastError = true)]
+    private static partial IntPtr CreateIoCompletionPort(IntPtr FileHandle, IntPtr ExistingCompletionPort, nuint CompletionKey, int NumberOfConcurrentThreads);
+
+    [LibraryImport(Interop.Libraries.Kernel32, SetLastError = true)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    private static partial bool GetQueuedCompletionStatusEx(IntPtr CompletionPort, OVERLAPPED_ENTRY* lpCompletionPortEntries, int ulCount,
+        out int ulNumEntriesRemoved, int dwMilliseconds, [MarshalAs(UnmanagedType.Bool)] bool fAlertable);
+
+    [LibraryImport(Interop.Libraries.Kernel32, SetLastError = true)]
+    [return: MarshalAs(UnmanagedType.Bool)]
+    private static partial bool SetInformationJobObject(IntPtr hJob, int JobObjectInfoClass, ref JOBOBJECT_ASSOCIATE_COMPLETION_PORT lpJobObjectInfo, uint cbJobObjectInfoLength);
+
+    [LibraryImport(Interop.Libraries.Kernel32, SetLastError = true)]
+    private static partial int WaitForSingleObject(SafeHandle hHandle, int dwMilliseconds);
+}
@@ -0,0 +1,192 @@
+using System.ComponentModel;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace System.TBA;
+
+/// <summary>
+/// A cgroup v2 created for a single process tree (Linux only). The child is started directly in it (CLONE_INTO_CGROUP),
+/// so all its descendants are in it too, whatever they do (setsid, double fork, etc.), and they can all be killed at once with cgroup.kill.
+/// </summary>
+/// <remarks>
+/// The cgroups are created in the cgroup of the current process, which must be writable (delegated) by the current user.
+/// </remarks>
+internal sealed partial class ControlGroup : IDisposable
+{
+    // O_DIRECTORY differs between the architectures, the directory has just been created anyway.
+    private const int O_RDONLY = 0x0000, O_CLOEXEC = 0x80000;
+    private const int SIGKILL = 9;
+
+    private static readonly Lazy<string?> s_parentDirectory = new(FindParentDirectory);
+    private static int s_counter;
+
+    private readonly string _path;
+    private int _directoryFd;
+
+    private ControlGroup(string path, int directoryFd)
+    {
+        _path = path;
+        _directoryFd = directoryFd;
+    }
+
+    internal int DirectoryFd => _directoryFd;
+
+    internal static ControlGroup Create()
+    {
+        if (!OperatingSystem.IsLinux())
+        {
+            throw new PlatformNotSupportedException("Isolating the process tree requires cgroup v2, which is available only on Linux.");
+        }
+
+        string parentDirectory = s_parentDirectory.Value
+            ?? throw new PlatformNotSupportedException("Isolating the process tree requires a mounted cgroup v2 hierarchy.");
+        string path = Path.Combine(parentDirectory, $"tba-{Environment.ProcessId}-{Interlocked.Increment(ref s_counter)}");
+
+        try
+        {
+            Directory.CreateDirectory(path);
+        }
+        catch (Exception exception) when (exception is UnauthorizedAccessException or IOException)
+        {
+            throw new PlatformNotSupportedException($"Isolating the process tree requires the cgroup {parentDirectory} to be delegated to the current user.", exception);
+        }
+
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            int errno = Marshal.GetLastPInvokeError();
+            TryDelete(path);
+            throw new Win32Exception(errno, $"Failed to open the cgroup {path} (errno={errno})");
+        }
+
+        return new(path, fd);
+    }
+
+    /// <summary>
+    /// Kills all the processes in the cgroup and waits until they are all gone.
+    /// </summary>
+    /// <returns><c>true</c> if the cgroup was not empty.</returns>
+    internal bool Kill()
+    {
+        bool wasPopulated = IsPopulated();
+
+        string killFile = Path.Combine(_path, "cgroup.kill");
+        if (File.Exists(killFile))
+        {
+            // Every process in the cgroup gets SIGKILL at once, including the ones being forked.
+            File.WriteAllText(killFile, "1");
+        }
+        else
+        {
+            // cgroup.kill was added in Linux 5.14: freeze the cgroup, so no process can fork anymore, then kill them one by one.
+            string freezeFile = Path.Combine(_path, "cgroup.freeze");
+            File.WriteAllText(freezeFile, "1");
+
+            string[] processIds;
+            while ((processIds = File.ReadAllLines(Path.Combine(_path, "cgroup.procs"))).Length > 0)
+            {
+                foreach (string processId in processIds)
+                {
+                    // Frozen processes still receive fatal signals. The process may be gone already.
+                    kill(int.Parse(processId), SIGKILL);
+                }
+
+                Thread.Yield();
+            }
+
+            File.WriteAllText(freezeFile, "0");
+        }
+
+        if (wait_for_cgroup_empty(Path.Combine(_path, "cgroup.events"), Timeout.Infinite) != 0)
+        {
+            int errno = Marshal.GetLastPInvokeError();
+            throw new Win32Exception(errno, $"Failed to wait for the cgroup {_path} to be empty (errno={errno})");
+        }
+
+        return wasPopulated;
+    }
+
+    public void Dispose()
+    {
+        int fd = Interlocked.Exchange(ref _directoryFd, -1);
+        if (fd >= 0)
+        {
+            close(fd);
+
+            // Fails when some processes are still running in it: the cgroup is left behind, as they are.
+            TryDelete(_path);
+        }
+    }
+
+    private bool IsPopulated() => File.ReadAllText(Path.Combine(_path, "cgroup.events")).Contains("populated 1", StringComparison.Ordinal);
+
+    private static void TryDelete(string path)
+    {
+        try
+        {
+            Directory.Delete(path);
+        }
+        catch (IOException)
+        {
+        }
+    }
+
+    // The directory of the cgroup of the current process, in the cgroup v2 hierarchy.
+    private static string? FindParentDirectory()
+    {
+        try
+        {
+            // 36 35 0:30 / /sys/fs/cgroup rw,nosuid,nodev,noexec,relatime shared:9 - cgroup2 cgroup2 rw,nsdelegate
+            string? mountRoot = null, mountPoint = null;
+            foreach (string line in File.ReadLines("/proc/self/mountinfo"))
+            {
+                string[] fields = line.Split(' ');
+                int separator = Array.IndexOf(fields, "-");
+                if (separator > 0 && separator + 1 < fields.Length && fields[separator + 1] == "cgroup2")
+                {
+                    mountRoot = fields[3];
+                    mountPoint = fields[4];
+                    break;
+                }
+            }
+
+            if (mountPoint is null)
+            {
+                return null;
+            }
+
+            // 0::/user.slice/user-1000.slice/session-2.scope
+            foreach (string line in File.ReadLines("/proc/self/cgroup"))
+            {
+                if (line.StartsWith("0::", StringComparison.Ordinal))
+                {
+                    string cgroup = line.Substring(3);
+                    if (mountRoot != "/" && cgroup.StartsWith(mountRoot!, StringComparison.Ordinal))
+                    {
+                        cgroup = cgroup.Substring(mountRoot!.Length);
+                    }
+
+                    return mountPoint + cgroup.TrimEnd('/');
+                }
+            }
+        }
+        catch (IOException)
+        {
+        }
+
+        return null;
+    }
+
+    [LibraryImport("libc", SetLastError = true, StringMarshalling = StringMarshalling.Utf8)]
+    private static partial int open(string path, int flags);
+
+    [LibraryImport("libc", SetLastError = true)]
+    private static partial int close(int fd);
+
+    [LibraryImport("libc", SetLastError = true)]
+    private static partial int kill(int pid, int signal);
+
+    [LibraryImport("pal_process", SetLastError = true, StringMarshalling = StringMarshalling.Utf8)]
+    private static partial int wait_for_cgroup_empty(string events_path, int timeout_ms);
+}
@@ -0,0 +1,108 @@
+using System.Buffers;
+using System.Diagnostics;
+using System.Text;
+
+namespace System.TBA;
+
+/// <summary>
+/// Counts the characters of the output while it's being read, so it can be decoded into a string of the exact length
+/// as soon as the process exits, in a single pass.
+/// </summary>
+/// <remarks>
+/// As long as the output is pure ASCII and the encoding maps ASCII to itself (UTF-8, ASCII, Latin-1), the bytes are only validated
+/// as they arrive and widened at the end, without going through the decoder.
+/// Otherwise, they are decoded into a small scratch buffer as they arrive, just to count the characters: unlike
+/// <see cref="Decoder.GetCharCount(ReadOnlySpan{byte}, bool)"/>, it keeps the state of the sequences split between two reads.
+/// </remarks>
+internal sealed class IncrementalDecoder
+{
+    private const int ScratchBufferSize = 1024;
+
+    private readonly Decoder _decoder;
+    private char[]? _scratchBuffer;
+    private long _charCount;
+    private bool _isAscii;
+
+    internal IncrementalDecoder(Encoding encoding)
+    {
+        _decoder = encoding.GetDecoder();
+        _isAscii = encoding.CodePage is 65001 or 20127 or 28591; // UTF-8, US-ASCII, Latin-1
+    }
+
+    /// <summary>
+    /// Accounts for the bytes that have just been read.
+    /// </summary>
+    internal void Append(ReadOnlySpan<byte> bytes)
+    {
+        if (_isAscii)
+        {
+            if (Ascii.IsValid(bytes))
+            {
+                _charCount += bytes.Length;
+                return;
+            }
+
+            // The decoder has not seen the ASCII bytes, but they have not left it in any pending state either.
+            _isAscii = false;
+        }
+
+        Count(bytes, flush: false);
+    }
+
+    /// <summary>
+    /// Decodes all the bytes that were appended, which are given again as <paramref name="bytes"/>.
+    /// </summary>
+    internal string GetString(ReadOnlySequence<byte> bytes)
+    {
+        if (bytes.IsEmpty)
+        {
+            return string.Empty;
+        }
+
+        if (_isAscii)
+        {
+            return string.Create(checked((int)bytes.Length), bytes, static (chars, bytes) =>
+            {
+                foreach (ReadOnlyMemory<byte> segment in bytes)
+                {
+                    OperationStatus status = Ascii.ToUtf16(segment.Span, chars, out int written);
+                    Debug.Assert(status == OperationStatus.Done);
+                    chars = chars.Slice(written);
+                }
+            });
+        }
+
+        // The incomplete sequence at the end, if any, is decoded as a replacement character.
+        Count(ReadOnlySpan<byte>.Empty, flush: true);
+        ArrayPool<char>.Shared.Return(_scratchBuffer!);
+        _scratchBuffer = null;
+        _decoder.Reset();
+
+        return string.Create(checked((int)_charCount), (bytes, _decoder), static (chars, state) =>
+        {
+            (ReadOnlySequence<byte> bytes, Decoder decoder) = state;
+
+            foreach (ReadOnlyMemory<byte> segment in bytes)
+            {
+                int written = decoder.GetChars(segment.Span, chars, flush: false);
+                chars = chars.Slice(written);
+            }
+            chars = chars.Slice(decoder.GetChars(ReadOnlySpan<byte>.Empty, chars, flush: true));
+
+            Debug.Assert(chars.IsEmpty);
+        });
+    }
+
+    private void Count(ReadOnlySpan<byte> bytes, bool flush)
+    {
+        char[] scratchBuffer = _scratchBuffer ??= ArrayPool<char>.Shared.Rent(ScratchBufferSize);
+
+        do
+        {
+            _decoder.Convert(bytes, scratchBuffer, flush, out int bytesUsed, out int charsUsed, out _);
+            _charCount += charsUsed;
+            bytes = bytes.Slice(bytesUsed);
+        }
+        while (!bytes.IsEmpty);
+    }
+}
@@ -0,0 +1,96 @@
+using System.Buffers;
+using System.Diagnostics;
+
+namespace System.TBA;
+
+/// <summary>
+/// Gathers standard output and error into a <see cref="SegmentedBuffer"/> each, and records the order in which they were read:
+/// every read is a <see cref="ProcessOutputChunk"/> that points into the buffer of its stream.
+/// </summary>
+/// <remarks>
+/// The streams can't share a single buffer: on Windows both pipes are read at the same time, each into the memory it was given.
+/// The merged view is rebuilt from the chunks, without copying nor reading the bytes again.
+/// </remarks>
+internal sealed class InterleavedBuffer : IDisposable
+{
+    private const int InitialChunkCapacity = 64;
+
+    private readonly SegmentedBuffer _output = new(), _error = new();
+    private readonly long _startTimestamp = Stopwatch.GetTimestamp();
+    private ProcessOutputChunk[] _chunks = ArrayPool<ProcessOutputChunk>.Shared.Rent(InitialChunkCapacity);
+    private int _chunkCount;
+
+    internal InterleavedBuffer()
+    {
+        Output = new Writer(this, _output, standardError: false);
+        Error = new Writer(this, _error, standardError: true);
+    }
+
+    /// <summary>
+    /// Gets the writer the standard output is read into.
+    /// </summary>
+    internal IBufferWriter<byte> Output { get; }
+
+    /// <summary>
+    /// Gets the writer the standard error is read into.
+    /// </summary>
+    internal IBufferWriter<byte> Error { get; }
+
+    internal ReadOnlySpan<ProcessOutputChunk> Chunks => _chunks.AsSpan(0, _chunkCount);
+
+    internal SegmentedBuffer GetBuffer(bool standardError) => standardError ? _error : _output;
+
+    public void Dispose()
+    {
+        _output.Dispose();
+        _error.Dispose();
+
+        if (_chunks.Length > 0)
+        {
+            ArrayPool<ProcessOutputChunk>.Shared.Return(_chunks);
+            _chunks = [];
+            _chunkCount = 0;
+        }
+    }
+
+    private void Record(bool standardError, long offset, int length)
+    {
+        if (_chunkCount == _chunks.Length)
+        {
+            ProcessOutputChunk[] chunks = ArrayPool<ProcessOutputChunk>.Shared.Rent(_chunks.Length * 2);
+            Chunks.CopyTo(chunks);
+            ArrayPool<ProcessOutputChunk>.Shared.Return(_chunks);
+            _chunks = chunks;
+        }
+
+        _chunks[_chunkCount++] = new(offset, length, standardError, Stopwatch.GetElapsedTime(_startTimestamp));
+    }
+
+    private sealed class Writer : IBufferWriter<byte>
+    {
+        private readonly InterleavedBuffer _owner;
+        private readonly SegmentedBuffer _buffer;
+        private readonly bool _standardError;
+
+        internal Writer(InterleavedBuffer owner, SegmentedBuffer buffer, bool standardError)
+        {
+            _owner = owner;
+            _buffer = buffer;
+            _standardError = standardError;
+        }
+
+        public Memory<byte> GetMemory(int sizeHint = 0) => _buffer.GetMemory();
+
+        public Span<byte> GetSpan(int sizeHint = 0) => _buffer.GetSpan();
+
+        public void Advance(int count)
+        {
+            if (count > 0)
+            {
+                long offset = _buffer.Length;
+                _buffer.Advance(count);
+                _owner.Record(_standardError, offset, count);
+            }
+        }
+    }
+}
@@ -0,0 +1,112 @@
+using System.Buffers;
+
+namespace System.TBA;
+
+/// <summary>
+/// Buffers the bytes read from a pipe and splits them into lines (both \n and \r\n are recognized).
+/// </summary>
+internal sealed class LineBuffer : IDisposable
+{
+    private byte[] _buffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
+    // _start is the beginning of the current line, _end is the end of the buffered data.
+    // The bytes between _start and _scanned are known to not contain a line feed, so they are not searched again.
+    private int _start, _scanned, _end;
+
+    /// <summary>
+    /// Gets the underlying buffer. It's replaced when <see cref="EnsureFreeSpace"/> returns true.
+    /// </summary>
+    internal byte[] Array => _buffer;
+
+    /// <summary>
+    /// Gets the index of the free space where the next read should store the data.
+    /// </summary>
+    internal int End => _end;
+
+    internal Span<byte> FreeSpace => _buffer.AsSpan(_end);
+
+    /// <summary>
+    /// Marks <paramref name="count"/> bytes of <see cref="FreeSpace"/> as buffered.
+    /// </summary>
+    internal void Advance(int count) => _end += count;
+
+    /// <summary>
+    /// Returns the next complete line, without the line ending.
+    /// </summary>
+    /// <remarks>The line refers to the buffer, it's valid until <see cref="EnsureFreeSpace"/> is called.</remarks>
+    internal bool TryReadLine(out ReadOnlyMemory<byte> line)
+    {
+        // IndexOf is vectorized, it uses the widest SIMD instructions available (up to AVX-512).
+        int index = _buffer.AsSpan(_scanned, _end - _scanned).IndexOf((byte)'\n');
+        if (index < 0)
+        {
+            _scanned = _end;
+            line = default;
+            return false;
+        }
+
+        int lineEnd = _scanned + index;
+        int contentEnd = lineEnd > _start && _buffer[lineEnd - 1] == '\r' ? lineEnd - 1 : lineEnd;
+
+        line = _buffer.AsMemory(_start, contentEnd - _start);
+        _start = _scanned = lineEnd + 1;
+        return true;
+    }
+
+    /// <summary>
+    /// Returns the last line that was not terminated with a line ending, once the pipe has reported EOF.
+    /// </summary>
+    internal bool TryReadRemaining(out ReadOnlyMemory<byte> line)
+    {
+        if (_start == _end)
+        {
+            line = default;
+            return false;
+        }
+
+        line = _buffer.AsMemory(_start, _end - _start);
+        _start = _scanned = _end;
+        return true;
+    }
+
+    /// <summary>
+    /// Makes sure there is free space for the next read, by moving the current line to the beginning of the buffer
+    /// or by renting a larger buffer when the line does not fit.
+    /// </summary>
+    /// <returns>True if the buffer was replaced.</returns>
+    internal bool EnsureFreeSpace()
+    {
+        if (_start == _end)
+        {
+            _start = _scanned = _end = 0;
+        }
+
+        if (_end < _buffer.Length)
+        {
+            return false;
+        }
+
+        int remaining = _end - _start;
+        bool replaced = remaining == _buffer.Length;
+        if (replaced)
+        {
+            // The buffer is too small to hold a single line.
+            BufferHelper.RentLargerBuffer(ref _buffer);
+        }
+        else
+        {
+            Buffer.BlockCopy(_buffer, _start, _buffer, 0, remaining);
+        }
+
+        _scanned -= _start;
+        _end = remaining;
+        _start = 0;
+        return replaced;
+    }
+
+    public void Dispose()
+    {
+        byte[] buffer = _buffer;
+        _buffer = [];
+        ArrayPool<byte>.Shared.Return(buffer);
+    }
+}
@@ -14,6 +14,7 @@ internal static partial class PollHelper
     }
 
     internal const short POLLIN = 0x0001;
+    internal const short POLLOUT = 0x0004;
     internal const short POLLHUP = 0x0010;
     internal const short POLLERR = 0x0008;
     internal const int EINTR = 4; // Interrupted system call
@@ -0,0 +1,418 @@
+using Microsoft.Win32.SafeHandles;
+using System.Collections.Generic;
+using System.ComponentModel;
+using System.Diagnostics.CodeAnalysis;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace System.TBA;
+
+/// <summary>
+/// A single process-wide thread that waits for the exit of the processes and the readiness of the pipes awaited asynchronously,
+/// so any number of pending async operations costs a single thread instead of one blocked thread pool thread per operation.
+/// It uses epoll (on process descriptors for exits) on Linux and kqueue (EVFILT_PROC for exits) on macOS and FreeBSD.
+/// </summary>
+internal sealed partial class ProcessReactor
+{
+    private const int EventBufferSize = 64;
+
+    // The upper 32 bits of a token describe what is awaited, the lower 32 bits identify it (process ID or file descriptor).
+    private const ulong ExitToken = 0;
+    private const ulong ReadToken = 1UL << 32;
+    private const ulong ReapToken = 2UL << 32;
+
+    private static readonly object s_initializationLock = new();
+    private static ProcessReactor? s_instance;
+    private static bool s_isNotSupported;
+    // On Linux, the exits are awaited through the process descriptors (epoll), elsewhere through the process IDs (kqueue).
+    private static readonly bool s_exitsAreDescriptors = OperatingSystem.IsLinux();
+
+    private readonly int _reactor;
+    // A process or a pipe can be awaited by only one async operation at a time:
+    // only one of them could reap the process, and concurrent reads from the same pipe would interleave the data.
+    private readonly Dictionary<ulong, Registration> _registrations = new();
+    // The process descriptors of the abandoned processes (NoPidFd outside of Linux), reaped by the event loop when they exit.
+    private readonly Dictionary<ulong, int> _abandoned = new();
+
+    private ProcessReactor(int reactor)
+    {
+        _reactor = reactor;
+
+        Thread thread = new(static state => ((ProcessReactor)state!).EventLoop())
+        {
+            IsBackground = true,
+            Name = "Process Reactor"
+        };
+        thread.UnsafeStart(this);
+    }
+
+    /// <summary>
+    /// Gets the reactor used to wait for pipe readiness.
+    /// </summary>
+    internal static ProcessReactor Instance => s_instance ?? Initialize() ?? throw new PlatformNotSupportedException();
+
+    /// <summary>
+    /// Gets the reactor, or returns false when process exits can't be monitored for the given process.
+    /// </summary>
+    internal static bool TryGetInstance(SafeChildProcessHandle processHandle, [NotNullWhen(true)] out ProcessReactor? reactor)
+    {
+        // On Linux, process exits are observed through the process descriptor.
+        if (OperatingSystem.IsLinux() && (int)processHandle.DangerousGetHandle() == SafeChildProcessHandle.NoPidFd)
+        {
+            reactor = null;
+            return false;
+        }
+
+        reactor = s_instance ?? Initialize();
+        return reactor is not null;
+    }
+
+    /// <summary>
+    /// Like <see cref="TryGetInstance"/>, but never creates the reactor, so it can't fail: it's safe to call from a finalizer.
+    /// </summary>
+    internal static bool TryGetExistingInstance(SafeChildProcessHandle processHandle, [NotNullWhen(true)] out ProcessReactor? reactor)
+    {
+        if (OperatingSystem.IsLinux() && (int)processHandle.DangerousGetHandle() == SafeChildProcessHandle.NoPidFd)
+        {
+            reactor = null;
+            return false;
+        }
+
+        reactor = s_instance;
+        return reactor is not null;
+    }
+
+    /// <summary>
+    /// Creates the reactor if it's supported and does not exist yet, so <see cref="TryGetExistingInstance"/> finds it later.
+    /// </summary>
+    internal static void EnsureInitialized()
+    {
+        if (s_instance is null)
+        {
+            Initialize();
+        }
+    }
+
+    private static ProcessReactor? Initialize()
+    {
+        lock (s_initializationLock)
+        {
+            if (s_instance is null && !s_isNotSupported)
+            {
+                int reactor = create_reactor();
+                if (reactor == -1)
+                {
+                    int errno = Marshal.GetLastPInvokeError();
+                    if (errno != ENOTSUP)
+                    {
+                        throw new Win32Exception(errno, $"create_reactor() failed with (errno={errno})");
+                    }
+
+                    s_isNotSupported = true;
+                }
+                else
+                {
+                    s_instance = new(reactor);
+                }
+            }
+
+            return s_instance;
+        }
+    }
+
+    /// <summary>
+    /// Returns a task that completes when the process exits. The process is not reaped.
+    /// </summary>
+    internal Task WaitForExitAsync(SafeChildProcessHandle processHandle, CancellationToken cancellationToken)
+        => RegisterAsync(processHandle, ExitToken | (uint)processHandle.ProcessId, cancellationToken);
+
+    /// <summary>
+    /// Returns a task that completes when data or EOF is available for reading from the non-blocking pipe.
+    /// </summary>
+    internal Task WaitForReadAsync(SafeFileHandle pipeHandle, CancellationToken cancellationToken)
+        => RegisterAsync(pipeHandle, ReadToken | (uint)(int)pipeHandle.DangerousGetHandle(), cancellationToken);
+
+    /// <summary>
+    /// Cancels the pending <see cref="WaitForReadAsync"/> for the given pipe, if any.
+    /// </summary>
+    internal void CancelWaitForRead(SafeFileHandle pipeHandle)
+    {
+        ulong token = ReadToken | (uint)(int)pipeHandle.DangerousGetHandle();
+
+        Registration? registration;
+        lock (_registrations)
+        {
+            _registrations.TryGetValue(token, out registration);
+        }
+
+        if (registration is not null)
+        {
+            Cancel(registration, cancellationToken: default);
+        }
+    }
+
+    /// <summary>
+    /// Takes the ownership of the process descriptor of a child process that nobody is going to wait for, and reaps the process once it exits.
+    /// Returns false when the process can't be monitored, the descriptor is still owned by the caller then.
+    /// </summary>
+    internal unsafe bool TryReapWhenExited(int pidfd, int pid)
+    {
+        ulong token = ReapToken | (uint)pid;
+
+        lock (_registrations)
+        lock (_abandoned)
+        {
+            // kqueue has a single EVFILT_PROC filter per process ID: registering it again would replace the pending exit wait.
+            if ((!s_exitsAreDescriptors && _registrations.ContainsKey(ExitToken | (uint)pid)) || !_abandoned.TryAdd(token, pidfd))
+            {
+                return false;
+            }
+        }
+
+        int result = reactor_register_exit(_reactor, pidfd, pid, token);
+        if (result == 0)
+        {
+            return true;
+        }
+
+        bool removed;
+        lock (_abandoned)
+        {
+            removed = _abandoned.Remove(token);
+        }
+
+        if (result == 1 && removed) // The process has already exited
+        {
+            reap_abandoned_processes(&pidfd, &pid, 1);
+            return true;
+        }
+
+        // Otherwise the event loop has already taken it.
+        return !removed;
+    }
+
+    private Task RegisterAsync(SafeHandle handle, ulong token, CancellationToken cancellationToken)
+    {
+        if (cancellationToken.IsCancellationRequested)
+        {
+            return Task.FromCanceled(cancellationToken);
+        }
+
+        // Keep the descriptor alive for as long as it's registered.
+        bool refAdded = false;
+        handle.DangerousAddRef(ref refAdded);
+
+        Registration registration = new(this, handle, token, cancellationToken);
+
+        lock (_registrations)
+        lock (_abandoned)
+        {
+            // Same as in TryReapWhenExited: with kqueue, the filter of an abandoned process with the same ID must not be replaced.
+            if ((IsExit(token) && !s_exitsAreDescriptors && _abandoned.ContainsKey(ReapToken | (uint)token)) || !_registrations.TryAdd(token, registration))
+            {
+                handle.DangerousRelease();
+                throw new InvalidOperationException(IsExit(token)
+                    ? "The process is already being waited for."
+                    : "The pipe is already being read.");
+            }
+        }
+
+        // The registration must be visible to the event loop before it can fire.
+        int fd = (int)handle.DangerousGetHandle();
+        int result = IsExit(token)
+            ? reactor_register_exit(_reactor, fd, (int)(uint)token, token)
+            : reactor_register_read(_reactor, fd, token);
+        if (result != 0)
+        {
+            int errno = Marshal.GetLastPInvokeError();
+            if (TryRemove(registration))
+            {
+                handle.DangerousRelease();
+
+                if (result == 1) // The process has already exited
+                {
+                    registration.TrySetResult();
+                }
+                else
+                {
+                    registration.TrySetException(new Win32Exception(errno, $"Registering for {(IsExit(token) ? "process exit" : "read")} failed with (errno={errno})"));
+                }
+            }
+
+            return registration.Task;
+        }
+
+        if (cancellationToken.CanBeCanceled)
+        {
+            CancellationTokenRegistration cancellationRegistration = cancellationToken.UnsafeRegister(static state =>
+            {
+                Registration registration = (Registration)state!;
+                registration.Reactor.Cancel(registration, registration.CancellationToken);
+            }, registration);
+
+            lock (_registrations)
+            {
+                if (_registrations.TryGetValue(token, out Registration? current) && ReferenceEquals(current, registration))
+                {
+                    registration.CancellationRegistration = cancellationRegistration;
+                    cancellationRegistration = default;
+                }
+            }
+
+            // The registration has fired or was canceled in the meantime.
+            cancellationRegistration.Unregister();
+        }
+
+        return registration.Task;
+    }
+
+    private void Cancel(Registration registration, CancellationToken cancellationToken)
+    {
+        CancellationTokenRegistration cancellationRegistration;
+        lock (_registrations)
+        {
+            if (!_registrations.TryGetValue(registration.Token, out Registration? current) || !ReferenceEquals(current, registration))
+            {
+                return;
+            }
+
+            _registrations.Remove(registration.Token);
+            cancellationRegistration = registration.CancellationRegistration;
+        }
+
+        // Best effort: the registration might have fired and the notification might be already consumed.
+        int fd = (int)registration.Handle.DangerousGetHandle();
+        _ = IsExit(registration.Token)
+            ? reactor_unregister_exit(_reactor, fd, (int)(uint)registration.Token)
+            : reactor_unregister_read(_reactor, fd);
+
+        cancellationRegistration.Unregister();
+        registration.Handle.DangerousRelease();
+        registration.TrySetCanceled(cancellationToken);
+    }
+
+    private bool TryRemove(Registration registration)
+    {
+        lock (_registrations)
+        {
+            if (_registrations.TryGetValue(registration.Token, out Registration? current) && ReferenceEquals(current, registration))
+            {
+                return _registrations.Remove(registration.Token);
+            }
+        }
+
+        return false;
+    }
+
+    private unsafe void EventLoop()
+    {
+        ulong* tokens = stackalloc ulong[EventBufferSize];
+        int* abandonedPidfds = stackalloc int[EventBufferSize];
+        int* abandonedPids = stackalloc int[EventBufferSize];
+
+        while (true)
+        {
+            int count = reactor_wait(_reactor, tokens, EventBufferSize);
+            if (count < 0)
+            {
+                // It can fail only due to a bug (invalid descriptor or arguments), and all pending operations would hang otherwise.
+                int errno = Marshal.GetLastPInvokeError();
+                Environment.FailFast($"reactor_wait() failed with (errno={errno})");
+            }
+
+            int abandonedCount = 0;
+            for (int i = 0; i < count; i++)
+            {
+                if (IsReap(tokens[i]))
+                {
+                    lock (_abandoned)
+                    {
+                        if (_abandoned.Remove(tokens[i], out abandonedPidfds[abandonedCount]))
+                        {
+                            abandonedPids[abandonedCount++] = (int)(uint)tokens[i];
+                        }
+                    }
+
+                    continue;
+                }
+
+                Registration? registration;
+                CancellationTokenRegistration cancellationRegistration = default;
+
+                lock (_registrations)
+                {
+                    if (_registrations.Remove(tokens[i], out registration))
+                    {
+                        cancellationRegistration = registration.CancellationRegistration;
+                    }
+                }
+
+                if (registration is not null)
+                {
+                    // Unregister does not wait for a callback that is currently running, so the event loop is never blocked.
+                    cancellationRegistration.Unregister();
+                    registration.Handle.DangerousRelease();
+                    registration.TrySetResult();
+                }
+            }
+
+            // The abandoned processes that exited are reaped with a single call, which does not block since they have all exited.
+            if (abandonedCount > 0)
+            {
+                reap_abandoned_processes(abandonedPidfds, abandonedPids, abandonedCount);
+            }
+        }
+    }
+
+    private static bool IsExit(ulong token) => (token & ~(ulong)uint.MaxValue) == ExitToken;
+
+    private static bool IsReap(ulong token) => (token & ~(ulong)uint.MaxValue) == ReapToken;
+
+    private sealed class Registration : TaskCompletionSource
+    {
+        internal Registration(ProcessReactor reactor, SafeHandle handle, ulong token, CancellationToken cancellationToken)
+            // The continuations must not run on the event loop thread.
+            : base(TaskCreationOptions.RunContinuationsAsynchronously)
+        {
+            Reactor = reactor;
+            Handle = handle;
+            Token = token;
+            CancellationToken = cancellationToken;
+        }
+
+        internal ProcessReactor Reactor { get; }
+
+        internal SafeHandle Handle { get; }
+
+        internal ulong Token { get; }
+
+        internal CancellationToken CancellationToken { get; }
+
+        // Guarded by the reactor's registrations lock.
+        internal CancellationTokenRegistration CancellationRegistration { get; set; }
+    }
+
+    private static int ENOTSUP => OperatingSystem.IsLinux() ? 95 : 45;
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int create_reactor();
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int reactor_register_exit(int reactor, int pidfd, int pid, ulong token);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int reactor_register_read(int reactor, int fd, ulong token);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int reactor_unregister_exit(int reactor, int pidfd, int pid);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int reactor_unregister_read(int reactor, int fd);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static unsafe partial int reap_abandoned_processes(int* pidfds, int* pids, int count);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static unsafe partial int reactor_wait(int reactor, ulong* tokens, int capacity);
+}
@@ -0,0 +1,348 @@
+using System.Buffers;
+using System.Diagnostics;
+using System.Text;
+
+namespace System.TBA;
+
+/// <summary>
+/// Gathers bytes into a chain of buffers rented from <see cref="ArrayPool{T}.Shared"/>.
+/// Unlike <see cref="BufferHelper.RentLargerBuffer"/>, growing never copies the data that was already written.
+/// </summary>
+/// <remarks>
+/// When it's limited, the bytes over the limit are still accepted, so the pipes keep being drained, but they are not kept:
+/// the head is a chain that stops growing, the tail is a ring of segments that reuses the oldest one. The memory stays proportional to the limit.
+/// </remarks>
+internal sealed class SegmentedBuffer : IBufferWriter<byte>, IDisposable
+{
+    // Segments larger than that would not make the reads any faster, they would just waste more memory when not filled.
+    private const int MaxSegmentSize = 1024 * 1024;
+    // The bytes that are not kept are read into it.
+    private const int DiscardBufferSize = 64 * 1024;
+
+    private readonly long _headCapacity, _tailCapacity;
+    private Segment? _first, _last;
+    private Segment? _tailFirst, _tailLast;
+    private long _tailLength, _droppedBytes, _length;
+    private byte[]? _discardBuffer;
+    private Target _target;
+    private readonly IncrementalDecoder? _decoder;
+
+    internal SegmentedBuffer()
+    {
+        _headCapacity = long.MaxValue;
+    }
+
+    /// <param name="limit">The maximum number of bytes to keep, or 0 to keep them all.</param>
+    /// <param name="policy">Which bytes to keep when there are more than <paramref name="limit"/>.</param>
+    /// <param name="encoding">The encoding of the text that will be read with <see cref="GetString"/>, if any.
+    /// When all the bytes are kept, the text is counted while it's being written, so it can be decoded in a single pass.</param>
+    internal SegmentedBuffer(int limit, OutputLimitPolicy policy, Encoding? encoding = null)
+    {
+        Debug.Assert(limit >= 0);
+
+        (_headCapacity, _tailCapacity) = limit == 0
+            ? (long.MaxValue, 0)
+            : policy switch
+            {
+                OutputLimitPolicy.KeepTail => (0, limit),
+                OutputLimitPolicy.KeepHeadAndTail => (limit - limit / 2, limit / 2),
+                _ => ((long)limit, 0L),
+            };
+
+        if (encoding is not null && limit == 0)
+        {
+            _decoder = new(encoding);
+        }
+    }
+
+    private enum Target : byte
+    {
+        Head,
+        Tail,
+        Discard,
+    }
+
+    /// <summary>
+    /// Gets the number of bytes written so far, including the ones that were not kept because of the limit.
+    /// </summary>
+    internal long Length => _length;
+
+    /// <summary>
+    /// Gets the number of bytes that were written but not kept because of the limit.
+    /// </summary>
+    internal long DroppedBytes => _droppedBytes + Math.Max(_tailLength - _tailCapacity, 0);
+
+    private long HeadLength => _last is null ? 0 : _last.RunningIndex + _last.Count;
+
+    /// <summary>
+    /// Returns the free space at the end of the buffer, renting a new segment when the last one is full.
+    /// </summary>
+    /// <remarks>
+    /// <see cref="Advance"/> can be called several times for the same memory, as long as the total does not exceed its length.
+    /// </remarks>
+    internal Memory<byte> GetMemory()
+    {
+        long headFree = _headCapacity - HeadLength;
+        if (headFree > 0)
+        {
+            if (_last is null || _last.Count == _last.Array.Length)
+            {
+                AddSegment(headFree);
+            }
+
+            _target = Target.Head;
+            Memory<byte> memory = _last!.Array.AsMemory(_last.Count);
+            return headFree < memory.Length ? memory.Slice(0, (int)headFree) : memory;
+        }
+
+        if (_tailCapacity > 0)
+        {
+            if (_tailLast is null || _tailLast.Count == _tailLast.Array.Length)
+            {
+                AddTailSegment();
+            }
+
+            _target = Target.Tail;
+            return _tailLast!.Array.AsMemory(_tailLast.Count);
+        }
+
+        _target = Target.Discard;
+        return _discardBuffer ??= ArrayPool<byte>.Shared.Rent(DiscardBufferSize);
+    }
+
+    internal Span<byte> GetSpan() => GetMemory().Span;
+
+    // The readers read whatever is free, they never ask for a minimum size.
+    Memory<byte> IBufferWriter<byte>.GetMemory(int sizeHint) => GetMemory();
+
+    Span<byte> IBufferWriter<byte>.GetSpan(int sizeHint) => GetSpan();
+
+    /// <summary>
+    /// Marks <paramref name="count"/> bytes of the memory returned by <see cref="GetMemory"/> as written.
+    /// </summary>
+    public void Advance(int count)
+    {
+        Debug.Assert(count >= 0);
+
+        switch (_target)
+        {
+            case Target.Head:
+                Debug.Assert(_last is not null && _last.Count + count <= _last.Array.Length);
+                _decoder?.Append(_last.Array.AsSpan(_last.Count, count));
+                _last.Count += count;
+                break;
+            case Target.Tail:
+                Debug.Assert(_tailLast is not null && _tailLast.Count + count <= _tailLast.Array.Length);
+                _tailLast.Count += count;
+                _tailLength += count;
+                break;
+            default:
+                _droppedBytes += count;
+                break;
+        }
+
+        _length += count;
+    }
+
+    /// <summary>
+    /// Returns the sequence of the bytes kept so far: the head followed by the tail. It's valid until the buffer is written to or disposed.
+    /// </summary>
+    internal ReadOnlySequence<byte> GetSequence()
+    {
+        Segment? start = _first, end = _last;
+
+        if (_tailFirst is not null)
+        {
+            TrimTail();
+
+            // The tail segments get reordered by the ring, link them after the head now.
+            Segment? previous = _last;
+            for (Segment? segment = _tailFirst; segment is not null; segment = segment.NextSegment)
+            {
+                segment.Link(previous);
+                previous = segment;
+            }
+
+            start ??= _tailFirst;
+            end = _tailLast;
+        }
+
+        if (start is null)
+        {
+            return ReadOnlySequence<byte>.Empty;
+        }
+
+        return start == end
+            ? new ReadOnlySequence<byte>(start.Memory)
+            : new ReadOnlySequence<byte>(start, 0, end!, end!.Memory.Length);
+    }
+
+    /// <summary>
+    /// Decodes the bytes kept so far.
+    /// </summary>
+    internal string GetString(Encoding encoding)
+        => _decoder is not null ? _decoder.GetString(GetSequence()) : encoding.GetString(GetSequence());
+
+    /// <summary>
+    /// Copies the bytes kept so far to a new array.
+    /// </summary>
+    internal byte[] ToArray()
+    {
+        ReadOnlySequence<byte> sequence = GetSequence();
+        byte[] array = GC.AllocateUninitializedArray<byte>(checked((int)sequence.Length));
+        sequence.CopyTo(array);
+        return array;
+    }
+
+    public void Dispose()
+    {
+        // When the tail has been linked after the head, the head chain continues with it: stop at the last head segment.
+        Return(_first, _last);
+        Return(_tailFirst, _tailLast);
+        _first = _last = _tailFirst = _tailLast = null;
+
+        if (_discardBuffer is not null)
+        {
+            ArrayPool<byte>.Shared.Return(_discardBuffer);
+            _discardBuffer = null;
+        }
+
+        static void Return(Segment? segment, Segment? last)
+        {
+            while (segment is not null)
+            {
+                ArrayPool<byte>.Shared.Return(segment.Array);
+                segment = segment == last ? null : segment.NextSegment;
+            }
+        }
+    }
+
+    private void AddSegment(long maxSize)
+    {
+        int size = _last is null
+            ? BufferHelper.InitialRentedBufferSize
+            : Math.Min(_last.Array.Length * 2, MaxSegmentSize);
+
+        Segment segment = new(ArrayPool<byte>.Shared.Rent((int)Math.Min(size, maxSize)));
+
+        if (_last is null)
+        {
+            _first = segment;
+        }
+        else
+        {
+            _last.Append(segment);
+        }
+
+        _last = segment;
+    }
+
+    private void AddTailSegment()
+    {
+        Segment segment;
+
+        // The oldest segment is no longer needed when the others hold enough bytes: reuse it as the newest.
+        if (_tailFirst != _tailLast && _tailLength - _tailFirst!.Memory.Length >= _tailCapacity)
+        {
+            segment = _tailFirst;
+            _tailFirst = segment.NextSegment;
+
+            _droppedBytes += segment.Memory.Length;
+            _tailLength -= segment.Memory.Length;
+            segment.Reset();
+        }
+        else
+        {
+            int size = _tailLast is null
+                ? BufferHelper.InitialRentedBufferSize
+                : Math.Min(_tailLast.Array.Length * 2, MaxSegmentSize);
+
+            segment = new(ArrayPool<byte>.Shared.Rent((int)Math.Min(size, _tailCapacity)));
+        }
+
+        if (_tailLast is null)
+        {
+            _tailFirst = segment;
+        }
+        else
+        {
+            _tailLast.Append(segment);
+        }
+
+        _tailLast = segment;
+    }
+
+    // Drops the oldest bytes of the tail, so it holds no more than its capacity.
+    private void TrimTail()
+    {
+        long excess = _tailLength - _tailCapacity;
+
+        while (excess > 0 && _tailFirst != _tailLast && _tailFirst!.Memory.Length <= excess)
+        {
+            Segment segment = _tailFirst;
+            _tailFirst = segment.NextSegment;
+
+            excess -= segment.Memory.Length;
+            _droppedBytes += segment.Memory.Length;
+            _tailLength -= segment.Memory.Length;
+            ArrayPool<byte>.Shared.Return(segment.Array);
+        }
+
+        if (excess > 0)
+        {
+            _tailFirst!.Trim((int)excess);
+            _droppedBytes += excess;
+            _tailLength -= excess;
+        }
+    }
+
+    private sealed class Segment : ReadOnlySequenceSegment<byte>
+    {
+        private int _offset, _count;
+
+        internal Segment(byte[] array) => Array = array;
+
+        internal byte[] Array { get; }
+
+        internal Segment? NextSegment => (Segment?)Next;
+
+        // The number of bytes written to the array, including the ones that were trimmed from the start.
+        internal int Count
+        {
+            get => _count;
+            set
+            {
+                _count = value;
+                Memory = Array.AsMemory(_offset, value - _offset);
+            }
+        }
+
+        internal void Append(Segment next)
+        {
+            next.RunningIndex = RunningIndex + Memory.Length;
+            Next = next;
+        }
+
+        internal void Link(Segment? previous)
+        {
+            RunningIndex = previous is null ? 0 : previous.RunningIndex + previous.Memory.Length;
+            if (previous is not null)
+            {
+                previous.Next = this;
+            }
+        }
+
+        internal void Trim(int count)
+        {
+            _offset += count;
+            Count = _count;
+        }
+
+        internal void Reset()
+        {
+            _offset = 0;
+            Next = null;
+            Count = 0;
+        }
+    }
+}
@@ -1,22 +1,20 @@
 ﻿using Microsoft.Win32.SafeHandles;
 using System.IO;
-using System.Threading;
+using System.Threading.Tasks;
 
 namespace System.TBA;
 
 internal static class StreamHelper
 {
-    internal static Stream CreateReadStream(SafeFileHandle read, CancellationToken cancellationToken)
+    /// <param name="read">The read end of the pipe, opened for async reads. It's owned by the returned stream.</param>
+    /// <param name="processExited">On Unix, when provided, the stream reports EOF once the process has exited and the data written
+    /// before the exit has been consumed, even if the pipe is kept open by the descendants of the process.</param>
+    internal static Stream CreateReadStream(SafeFileHandle read, Task? processExited = null)
     {
 #if WINDOWS
         return new FileStream(read, FileAccess.Read, bufferSize: 1, isAsync: true);
 #else
-        if (!cancellationToken.CanBeCanceled)
-        {
-            return new FileStream(read, FileAccess.Read, bufferSize: 1, isAsync: false);
-        }
-
-        return new CancellableAsyncPipeStream(read);
+        return new AsyncPipeStream(read, processExited);
 #endif
     }
 }
@@ -0,0 +1,89 @@
+using Microsoft.Win32.SafeHandles;
+using System.ComponentModel;
+using System.Runtime.InteropServices;
+
+namespace System.TBA;
+
+internal sealed partial class TeeWriter
+{
+    private bool _spliceNotSupported;
+
+    /// <summary>
+    /// Moves all the data that is currently available in the non-blocking pipe to the file.
+    /// </summary>
+    /// <returns>True if more data may be available, false if EOF (pipe closed)</returns>
+    internal bool Drain(SafeFileHandle pipeHandle)
+    {
+        if (!_spliceNotSupported)
+        {
+            long fileOffset = _fileOffset;
+            int result = splice_to_file((int)pipeHandle.DangerousGetHandle(), (int)_file.DangerousGetHandle(), ref fileOffset);
+
+            if (fileOffset != _fileOffset)
+            {
+                _fileOffset = fileOffset;
+                _bypassedUserSpace = true;
+            }
+
+            if (result >= 0)
+            {
+                return result == 1;
+            }
+
+            int errno = Marshal.GetLastPInvokeError();
+            if (errno != ENOTSUP && errno != ENOSYS && errno != EINVAL && errno != ESPIPE)
+            {
+                throw new Win32Exception(errno, $"splice_to_file() failed with (errno={errno})");
+            }
+
+            // Not supported by the platform or the file (for example a file opened for appending), copy instead.
+            _spliceNotSupported = true;
+        }
+
+        return Copy(pipeHandle);
+    }
+
+    private unsafe bool Copy(SafeFileHandle pipeHandle)
+    {
+        int EWOULDBLOCK = OperatingSystem.IsLinux() ? 11 : 35;
+        byte[] buffer = CopyBuffer;
+
+        while (true)
+        {
+            nint result;
+            fixed (byte* ptr = buffer)
+            {
+                result = PollHelper.read((int)pipeHandle.DangerousGetHandle(), ptr, (nuint)buffer.Length);
+            }
+
+            if (result > 0)
+            {
+                Write(buffer.AsSpan(0, (int)result));
+            }
+            else if (result == 0)
+            {
+                return false; // EOF - pipe closed
+            }
+            else
+            {
+                int errno = Marshal.GetLastPInvokeError();
+                if (errno == EWOULDBLOCK)
+                {
+                    return true; // No more data available right now (non-blocking)
+                }
+                else if (errno != UnixHelpers.EINTR)
+                {
+                    throw new Win32Exception(errno, $"read() failed with errno={errno}");
+                }
+            }
+        }
+    }
+
+    private const int EINVAL = 22;
+    private const int ESPIPE = 29;
+    private static int ENOTSUP => OperatingSystem.IsLinux() ? 95 : 45;
+    private static int ENOSYS => OperatingSystem.IsLinux() ? 38 : 78;
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int splice_to_file(int pipeFd, int fileFd, ref long fileOffset);
+}
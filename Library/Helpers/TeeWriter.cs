@@ -0,0 +1,96 @@
+using Microsoft.Win32.SafeHandles;
+using System.Buffers;
+using System.IO;
+
+namespace System.TBA;
+
+/// <summary>
+/// Writes the output of a process to a file and keeps the last bytes of it in memory.
+/// </summary>
+internal sealed partial class TeeWriter : IDisposable
+{
+    private const int CopyBufferSize = 64 * 1024;
+
+    private readonly SafeFileHandle _file;
+    // A ring buffer with the last bytes that were copied through user space.
+    private readonly byte[] _tail;
+    private int _tailStart, _tailCount;
+    private byte[]? _copyBuffer;
+    private long _fileOffset;
+    // When some of the data was moved to the file by the kernel, the tail is read back from the file.
+    private bool _bypassedUserSpace;
+
+    internal TeeWriter(SafeFileHandle file, int tailLength)
+    {
+        _file = file;
+        _tail = tailLength == 0 ? [] : new byte[tailLength];
+    }
+
+    /// <summary>
+    /// Gets a pooled buffer for reading the data to write.
+    /// </summary>
+    internal byte[] CopyBuffer => _copyBuffer ??= ArrayPool<byte>.Shared.Rent(CopyBufferSize);
+
+    internal void Write(ReadOnlySpan<byte> data)
+    {
+        RandomAccess.Write(_file, data, _fileOffset);
+        _fileOffset += data.Length;
+
+        if (_tail.Length == 0)
+        {
+            return;
+        }
+
+        if (data.Length >= _tail.Length)
+        {
+            data.Slice(data.Length - _tail.Length).CopyTo(_tail);
+            _tailStart = 0;
+            _tailCount = _tail.Length;
+            return;
+        }
+
+        int end = (_tailStart + _tailCount) % _tail.Length;
+        int firstPart = Math.Min(data.Length, _tail.Length - end);
+        data.Slice(0, firstPart).CopyTo(_tail.AsSpan(end));
+        data.Slice(firstPart).CopyTo(_tail);
+
+        int overflow = _tailCount + data.Length - _tail.Length;
+        if (overflow > 0)
+        {
+            _tailStart = (_tailStart + overflow) % _tail.Length;
+            _tailCount = _tail.Length;
+        }
+        else
+        {
+            _tailCount += data.Length;
+        }
+    }
+
+    /// <summary>
+    /// Returns the last bytes written to the file.
+    /// </summary>
+    internal byte[] GetTail()
+    {
+        if (_bypassedUserSpace)
+        {
+            byte[] fromFile = GC.AllocateUninitializedArray<byte>((int)Math.Min(_tail.Length, _fileOffset));
+            int bytesRead = RandomAccess.Read(_file, fromFile, _fileOffset - fromFile.Length);
+            return bytesRead == fromFile.Length ? fromFile : fromFile.AsSpan(0, bytesRead).ToArray();
+        }
+
+        byte[] result = GC.AllocateUninitializedArray<byte>(_tailCount);
+        int firstPart = Math.Min(_tailCount, _tail.Length - _tailStart);
+        _tail.AsSpan(_tailStart, firstPart).CopyTo(result);
+        _tail.AsSpan(0, _tailCount - firstPart).CopyTo(result.AsSpan(firstPart));
+        return result;
+    }
+
+    public void Dispose()
+    {
+        if (_copyBuffer is not null)
+        {
+            ArrayPool<byte>.Shared.Return(_copyBuffer);
+            _copyBuffer = null;
+        }
+    }
+}
@@ -1,4 +1,5 @@
 ﻿using Microsoft.Win32.SafeHandles;
+using System.Buffers;
 using System.Collections.Generic;
 using System.ComponentModel;
 using System.Diagnostics;
@@ -18,6 +19,18 @@ internal static partial class UnixHelpers
     [LibraryImport("libc", SetLastError = true)]
     private static unsafe partial nint read(SafeHandle fd, byte* buf, nint count);
 
+    [LibraryImport("libc", SetLastError = true)]
+    private static unsafe partial nint write(SafeHandle fd, byte* buf, nint count);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int get_pipe_capacity(SafeHandle fd);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int set_pipe_capacity(SafeHandle fd, int capacity);
+
+    // The default /proc/sys/fs/pipe-max-size, the limit for unprivileged processes.
+    private const int MaxGrownPipeCapacity = 1024 * 1024;
+
     internal static bool IsExecutable(string path)
     {
         // Check for execute permission (X_OK = 1)
@@ -96,34 +109,66 @@ internal static partial class UnixHelpers
         }
     }
 
+    /// <summary>
+    /// Grows the capacity of the pipe (Linux only) when a single wake-up has drained as much data as the pipe can hold.
+    /// </summary>
+    /// <remarks>
+    /// The writer was most likely blocked on the full pipe, so doubling the capacity halves the number of times
+    /// the writer and the reader have to wake each other up. It stops at the limit for unprivileged processes or at the first failure.
+    /// </remarks>
+    /// <param name="pipeHandle">The read end of the pipe.</param>
+    /// <param name="bytesDrained">The number of bytes read since the last wake-up.</param>
+    /// <param name="capacity">The last known capacity of the pipe: 0 when it's not known yet, -1 when it can't grow.</param>
+    internal static void GrowPipeCapacityIfDrainedFull(SafeFileHandle pipeHandle, long bytesDrained, ref int capacity)
+    {
+        if (capacity < 0 || !OperatingSystem.IsLinux())
+        {
+            return;
+        }
+
+        if (capacity == 0 && (capacity = get_pipe_capacity(pipeHandle)) <= 0)
+        {
+            capacity = -1;
+            return;
+        }
+
+        if (bytesDrained < capacity)
+        {
+            return;
+        }
+
+        int newCapacity = capacity < MaxGrownPipeCapacity ? set_pipe_capacity(pipeHandle, capacity * 2) : -1;
+        capacity = newCapacity > capacity ? newCapacity : -1;
+    }
+
     /// <summary>
     /// Read all available data from the file descriptor until EAGAIN/EWOULDBLOCK
     /// </summary>
+    /// <param name="bytesRead">The number of bytes written to <paramref name="writer"/>.</param>
     /// <returns>True if more data may be available, false if EOF (pipe closed)</returns>
-    internal static bool DrainPipe(SafeFileHandle pipeHandle, ref byte[] buffer, ref int bytesRead)
+    internal static bool DrainPipe(SafeFileHandle pipeHandle, IBufferWriter<byte> writer, out long bytesRead)
     {
         int EWOULDBLOCK = OperatingSystem.IsLinux() ? 11 : 35;
 
+        bytesRead = 0;
         nint result;
         while (true)
         {
+            Span<byte> span = writer.GetSpan();
             unsafe
             {
-                fixed (byte* ptr = &buffer[bytesRead])
+                fixed (byte* ptr = span)
                 {
-                    result = read(pipeHandle, ptr, buffer.Length - bytesRead);
+                    result = read(pipeHandle, ptr, span.Length);
                 }
             }
 
             if (result > 0)
             {
-                bytesRead += (int)result;
+                writer.Advance((int)result);
+                bytesRead += result;
 
-                if (bytesRead == buffer.Length)
-                {
-                    BufferHelper.RentLargerBuffer(ref buffer);
-                }
-                else
+                if (result < span.Length)
                 {
                     // Read has returned less data than requested, so we have drained the pipe for now.
                     // Don't repeat the sys-call (PERF).
@@ -152,4 +197,71 @@ internal static partial class UnixHelpers
             }
         }
     }
+
+    /// <summary>
+    /// Write as much of the input as the non-blocking pipe accepts, until EAGAIN/EWOULDBLOCK
+    /// </summary>
+    /// <param name="input">The bytes to write, sliced past the ones that were written.</param>
+    /// <returns>True if the pipe may accept more data, false if the reader has closed it (EPIPE)</returns>
+    /// <remarks>The runtime ignores SIGPIPE, so a closed pipe is reported as EPIPE.</remarks>
+    internal static bool FillPipe(SafeFileHandle pipeHandle, ref ReadOnlySequence<byte> input)
+    {
+        int EWOULDBLOCK = OperatingSystem.IsLinux() ? 11 : 35;
+        const int EPIPE = 32;
+
+        while (!input.IsEmpty)
+        {
+            ReadOnlySpan<byte> span = input.FirstSpan;
+            if (span.IsEmpty)
+            {
+                // Skip the empty segment, TryGet moves the position to the next one.
+                SequencePosition next = input.Start;
+                input.TryGet(ref next, out _);
+                input = input.Slice(next);
+                continue;
+            }
+
+            nint result;
+            unsafe
+            {
+                fixed (byte* ptr = span)
+                {
+                    result = write(pipeHandle, ptr, span.Length);
+                }
+            }
+
+            if (result >= 0)
+            {
+                input = input.Slice(result);
+
+                if (result < span.Length)
+                {
+                    // The pipe is full for now, don't repeat the sys-call (PERF).
+                    return true;
+                }
+            }
+            else
+            {
+                int errno = Marshal.GetLastPInvokeError();
+                if (errno == EWOULDBLOCK)
+                {
+                    return true;
+                }
+                else if (errno == EINTR)
+                {
+                    continue;
+                }
+                else if (errno == EPIPE)
+                {
+                    return false;
+                }
+                else
+                {
+                    throw new Win32Exception(errno, $"write() failed with errno={errno}");
+                }
+            }
+        }
+
+        return true;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+using System.Buffers;
+using System.Text;
+
+namespace System.TBA;
+
+/// <summary>
+/// The raw standard output and error of a process, stored in pooled buffers, along with the order in which they were read.
+/// </summary>
+/// <remarks>
+/// <para>
+/// Each read is recorded as a <see cref="ProcessOutputChunk"/>: enumerating <see cref="Chunks"/> and calling <see cref="GetBytes"/>
+/// gives the merged view, while <see cref="StandardOutput"/> and <see cref="StandardError"/> give each stream on its own.
+/// The order is the one in which the chunks were read, which follows the order in which they were written only as closely as the reads do.
+/// </para>
+/// <para>The buffers are returned to the pool when the instance is disposed, so the sequences and chunks must not be used after that.</para>
+/// </remarks>
+public sealed class InterleavedOutput : IDisposable
+{
+    private const int ScratchBufferSize = 1024;
+
+    private readonly InterleavedBuffer _buffer;
+    private bool _disposed;
+
+    internal InterleavedOutput(ProcessExitStatus exitStatus, InterleavedBuffer buffer, int processId)
+    {
+        ExitStatus = exitStatus;
+        _buffer = buffer;
+        ProcessId = processId;
+    }
+
+    /// <summary>
+    /// Gets the exit status of the process after it has terminated.
+    /// </summary>
+    public ProcessExitStatus ExitStatus { get; }
+
+    /// <summary>
+    /// Gets the process ID that was used when it was running.
+    /// </summary>
+    /// <remarks>This information can be useful to process any diagnostics/tracing data post run.</remarks>
+    public int ProcessId { get; }
+
+    /// <summary>
+    /// Gets the bytes written to standard output.
+    /// </summary>
+    public ReadOnlySequence<byte> StandardOutput => GetSequence(standardError: false);
+
+    /// <summary>
+    /// Gets the bytes written to standard error.
+    /// </summary>
+    public ReadOnlySequence<byte> StandardError => GetSequence(standardError: true);
+
+    /// <summary>
+    /// Gets the chunks of both streams, in the order they were read.
+    /// </summary>
+    public ReadOnlySpan<ProcessOutputChunk> Chunks
+    {
+        get
+        {
+            ObjectDisposedException.ThrowIf(_disposed, this);
+            return _buffer.Chunks;
+        }
+    }
+
+    /// <summary>
+    /// Gets the bytes of the given chunk, without copying them.
+    /// </summary>
+    public ReadOnlySequence<byte> GetBytes(ProcessOutputChunk chunk) => GetSequence(chunk.StandardError).Slice(chunk.Offset, chunk.Length);
+
+    /// <summary>
+    /// Decodes both streams into a single string, in the order the chunks were read.
+    /// </summary>
+    /// <remarks>Each stream is decoded on its own, so a character split between two chunks of the same stream is decoded as one.</remarks>
+    public string GetText(Encoding? encoding = null)
+    {
+        encoding ??= Encoding.UTF8;
+        ReadOnlySequence<byte> output = StandardOutput, error = StandardError;
+        Decoder outputDecoder = encoding.GetDecoder(), errorDecoder = encoding.GetDecoder();
+
+        char[] scratchBuffer = ArrayPool<char>.Shared.Rent(ScratchBufferSize);
+        try
+        {
+            StringBuilder builder = new();
+
+            foreach (ProcessOutputChunk chunk in Chunks)
+            {
+                ReadOnlySequence<byte> bytes = (chunk.StandardError ? error : output).Slice(chunk.Offset, chunk.Length);
+                Decoder decoder = chunk.StandardError ? errorDecoder : outputDecoder;
+
+                foreach (ReadOnlyMemory<byte> segment in bytes)
+                {
+                    Append(builder, decoder, segment.Span, scratchBuffer, flush: false);
+                }
+            }
+
+            Append(builder, outputDecoder, ReadOnlySpan<byte>.Empty, scratchBuffer, flush: true);
+            Append(builder, errorDecoder, ReadOnlySpan<byte>.Empty, scratchBuffer, flush: true);
+
+            return builder.ToString();
+        }
+        finally
+        {
+            ArrayPool<char>.Shared.Return(scratchBuffer);
+        }
+
+        static void Append(StringBuilder builder, Decoder decoder, ReadOnlySpan<byte> bytes, char[] scratchBuffer, bool flush)
+        {
+            do
+            {
+                decoder.Convert(bytes, scratchBuffer, flush, out int bytesUsed, out int charsUsed, out _);
+                builder.Append(scratchBuffer, 0, charsUsed);
+                bytes = bytes.Slice(bytesUsed);
+            }
+            while (!bytes.IsEmpty);
+        }
+    }
+
+    /// <summary>
+    /// Returns the buffers to the pool.
+    /// </summary>
+    public void Dispose()
+    {
+        if (!_disposed)
+        {
+            _disposed = true;
+            _buffer.Dispose();
+        }
+    }
+
+    private ReadOnlySequence<byte> GetSequence(bool standardError)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        return _buffer.GetBuffer(standardError).GetSequence();
+    }
+}
@@ -1,4 +1,5 @@
 using Microsoft.Win32.SafeHandles;
+using System.Buffers;
 using System.ComponentModel;
 using System.IO;
 using System.Threading;
@@ -10,11 +11,17 @@ namespace System.TBA;
 
 internal static class Multiplexing
 {
+    // How long the pipes are still read after the process has exited, when its descendants have inherited them.
+    private const int ExitedProcessGracePeriodMilliseconds = 10;
+
+    /// <param name="inputHandle">The non-blocking write end of the standard input pipe, if <paramref name="input"/> is written to it.
+    /// It's closed once all of it has been written, or the process has stopped reading.</param>
     internal static void ReadProcessOutputCore(SafeChildProcessHandle processHandle, SafeFileHandle readStdOut, SafeFileHandle readStdErr, TimeoutHelper timeout,
-        ref int outputBytesRead, ref int errorBytesRead, ref byte[] outputBuffer, ref byte[] errorBuffer)
+        IBufferWriter<byte> outputBuffer, IBufferWriter<byte> errorBuffer, SafeFileHandle? inputHandle = null, ReadOnlySequence<byte> input = default)
     {
         int outputFd = (int)readStdOut.DangerousGetHandle();
         int errorFd = (int)readStdErr.DangerousGetHandle();
+        int inputFd = inputHandle is null ? -1 : (int)inputHandle.DangerousGetHandle();
 
         int kq = create_kqueue_cloexec();
         if (kq == -1)
@@ -26,20 +33,47 @@ internal static class Multiplexing
         {
             // Register three events: stdout read, stderr read, and process exit
             bool processExited = !RegisterKqueueEvents(kq, outputFd, errorFd, processHandle.ProcessId);
+            long graceDeadline = processExited ? Environment.TickCount64 + ExitedProcessGracePeriodMilliseconds : 0;
             bool outputClosed = false;
             bool errorClosed = false;
 
-            while (!processExited && (!outputClosed || !errorClosed))
+            if (inputHandle is not null)
             {
-                Span<KEvent> events = stackalloc KEvent[3];
-                if (!timeout.TryGetRemainingMilliseconds(out int timeoutMs))
+                // The input is written by the same loop, as the pipe accepts it, so the pipes can't fill up on both sides.
+                // Closing the fd removes its event from the kqueue.
+                if (processExited || input.IsEmpty)
+                {
+                    inputHandle.Close();
+                }
+                else
                 {
-                    return;
+                    RegisterWriteEvent(kq, inputFd);
                 }
-                int numEvents = WaitForEvents(kq, events, timeoutMs);
-                if (numEvents == 0)
+            }
+
+            // The read events stay registered after the process has exited: the pipes are complete once kqueue reports EV_EOF for them,
+            // which happens as soon as the process has exited, unless its descendants have inherited the pipes.
+            while (!outputClosed || !errorClosed)
+            {
+                Span<KEvent> events = stackalloc KEvent[4];
+                int numEvents;
+                if (!TryGetWaitTimeout(timeout, processExited, graceDeadline, out int timeoutMs) || (numEvents = WaitForEvents(kq, events, timeoutMs)) == 0)
                 {
-                    return; // Timeout
+                    if (processExited)
+                    {
+                        // The descendants keep the pipes open, consume what has been written so far.
+                        if (!outputClosed)
+                        {
+                            DrainPipe(processHandle, readStdOut, outputBuffer, endOfFile: false);
+                        }
+
+                        if (!errorClosed)
+                        {
+                            DrainPipe(processHandle, readStdErr, errorBuffer, endOfFile: false);
+                        }
+                    }
+
+                    return; // Timeout, or the end of the grace period
                 }
 
                 for (int i = 0; i < numEvents; i++)
@@ -49,40 +83,87 @@ internal static class Multiplexing
                     if (evt.filter == EVFILT_READ)
                     {
                         int fd = (int)evt.ident;
-                        
+                        bool endOfFile = (evt.flags & EV_EOF) != 0;
+
                         if (fd == outputFd && !outputClosed)
                         {
-                            outputClosed = !UnixHelpers.DrainPipe(readStdOut, ref outputBuffer, ref outputBytesRead);
+                            outputClosed = !DrainPipe(processHandle, readStdOut, outputBuffer, endOfFile);
                         }
                         else if (fd == errorFd && !errorClosed)
                         {
-                            errorClosed = !UnixHelpers.DrainPipe(readStdErr, ref errorBuffer, ref errorBytesRead);
+                            errorClosed = !DrainPipe(processHandle, readStdErr, errorBuffer, endOfFile);
+                        }
+                    }
+                    else if (evt.filter == EVFILT_WRITE && !inputHandle!.IsClosed)
+                    {
+                        // EV_EOF: the process has closed its standard input, the rest of the input is dropped.
+                        if ((evt.flags & EV_EOF) != 0 || !UnixHelpers.FillPipe(inputHandle, ref input) || input.IsEmpty)
+                        {
+                            inputHandle.Close();
                         }
                     }
                     else if (evt.filter == EVFILT_PROC && (evt.fflags & NOTE_EXIT) != 0)
                     {
                         processExited = true;
+                        graceDeadline = Environment.TickCount64 + ExitedProcessGracePeriodMilliseconds;
+
+                        // Nobody is going to read the rest of the input.
+                        inputHandle?.Close();
                     }
                 }
             }
+        }
+        finally
+        {
+            // Closing the kqueue fd automatically removes all registered events
+            close(kq);
+        }
+    }
 
-            // If process exited, drain any remaining buffered data from pipes
-            if (!outputClosed || !errorClosed)
-            {
-                // Small delay to allow data to arrive.
-                // We have tried other solutions:
-                // - Repeated non-blocking reads until EAGAIN: doesn't work, data may not have arrived yet.
-                // - Waiting on kqueue with zero timeout: doesn't work, kqueue doesn't always signal again.
-                Thread.Sleep(TimeSpan.FromMilliseconds(1));
+    internal static unsafe void ReadCombinedOutputCore(SafeFileHandle fileHandle, SafeChildProcessHandle processHandle, TimeoutHelper timeout, SegmentedBuffer buffer)
+    {
+        int kq = create_kqueue_cloexec();
+        if (kq == -1)
+        {
+            ThrowForLastError(nameof(create_kqueue_cloexec));
+        }
+
+        try
+        {
+            // Register two events: file handle read and process exit
+            bool processExited = !RegisterKqueueEventsForCombined(kq, fileHandle, processHandle.ProcessId);
+            long graceDeadline = processExited ? Environment.TickCount64 + ExitedProcessGracePeriodMilliseconds : 0;
+            bool closed = false;
 
-                if (!outputClosed)
+            // Wait for EV_EOF even when the process has exited, see ReadProcessOutputCore.
+            while (!closed)
+            {
+                Span<KEvent> events = stackalloc KEvent[2];
+                int numEvents;
+                if (!TryGetWaitTimeout(timeout, processExited, graceDeadline, out int timeoutMs) || (numEvents = WaitForEvents(kq, events, timeoutMs)) == 0)
                 {
-                    UnixHelpers.DrainPipe(readStdOut, ref outputBuffer, ref outputBytesRead);
+                    if (processExited)
+                    {
+                        // The descendants keep the pipe open, consume what has been written so far.
+                        DrainPipe(processHandle, fileHandle, buffer, endOfFile: false);
+                    }
+
+                    return; // Timeout, or the end of the grace period
                 }
 
-                if (!errorClosed)
+                for (int i = 0; i < numEvents; i++)
                 {
-                    UnixHelpers.DrainPipe(readStdErr, ref errorBuffer, ref errorBytesRead);
+                    ref KEvent evt = ref events[i];
+
+                    if (evt.filter == EVFILT_READ)
+                    {
+                        closed = !DrainPipe(processHandle, fileHandle, buffer, (evt.flags & EV_EOF) != 0);
+                    }
+                    else if (evt.filter == EVFILT_PROC && (evt.fflags & NOTE_EXIT) != 0)
+                    {
+                        processExited = true;
+                        graceDeadline = Environment.TickCount64 + ExitedProcessGracePeriodMilliseconds;
+                    }
                 }
             }
         }
@@ -93,7 +174,47 @@ internal static class Multiplexing
         }
     }
 
-    internal static unsafe void ReadCombinedOutputCore(SafeFileHandle fileHandle, SafeChildProcessHandle processHandle, TimeoutHelper timeout, ref int totalBytesRead, ref byte[] array)
+    // UnixHelpers.DrainPipe that reports the bytes read to the telemetry.
+    // DrainPipe stops after a short read: once kqueue has reported EV_EOF (no writers left), read until the end, so the pipe is known to be closed.
+    private static bool DrainPipe(SafeChildProcessHandle processHandle, SafeFileHandle pipeHandle, IBufferWriter<byte> buffer, bool endOfFile)
+    {
+        long totalBytesRead = 0;
+        bool isOpen;
+        do
+        {
+            isOpen = UnixHelpers.DrainPipe(pipeHandle, buffer, out long bytesRead);
+            totalBytesRead += bytesRead;
+        }
+        while (isOpen && endOfFile);
+        ChildProcessTelemetry.OutputRead(processHandle, totalBytesRead);
+        return isOpen;
+    }
+
+    // Once the process has exited, the wait is bounded by the grace period: the pipes that are still open are held by its descendants.
+    // Returns false when the timeout has expired, or the grace period has ended: descendants that keep writing would otherwise
+    // report a read event on every wait, and the loop would never end.
+    private static bool TryGetWaitTimeout(TimeoutHelper timeout, bool processExited, long graceDeadline, out int timeoutMs)
+    {
+        if (!timeout.TryGetRemainingMilliseconds(out timeoutMs))
+        {
+            return false;
+        }
+
+        if (processExited)
+        {
+            long graceMs = graceDeadline - Environment.TickCount64;
+            if (graceMs <= 0)
+            {
+                return false;
+            }
+
+            timeoutMs = timeoutMs == Timeout.Infinite ? (int)graceMs : (int)Math.Min(timeoutMs, graceMs);
+        }
+
+        return true;
+    }
+
+    internal static unsafe void TeeCombinedOutputCore(SafeFileHandle fileHandle, SafeChildProcessHandle processHandle, TimeoutHelper timeout, TeeWriter writer)
     {
         int kq = create_kqueue_cloexec();
         if (kq == -1)
@@ -105,15 +226,23 @@ internal static class Multiplexing
         {
             // Register two events: file handle read and process exit
             bool processExited = !RegisterKqueueEventsForCombined(kq, fileHandle, processHandle.ProcessId);
+            long graceDeadline = processExited ? Environment.TickCount64 + ExitedProcessGracePeriodMilliseconds : 0;
             bool closed = false;
 
-            while (!processExited && !closed)
+            // Wait for EV_EOF even when the process has exited, see ReadProcessOutputCore.
+            while (!closed)
             {
                 Span<KEvent> events = stackalloc KEvent[2];
                 int numEvents;
-                if (!timeout.TryGetRemainingMilliseconds(out int timeoutMs) || (numEvents = WaitForEvents(kq, events, timeoutMs)) == 0)
+                if (!TryGetWaitTimeout(timeout, processExited, graceDeadline, out int timeoutMs) || (numEvents = WaitForEvents(kq, events, timeoutMs)) == 0)
                 {
-                    return; // Timeout
+                    if (processExited)
+                    {
+                        // The descendants keep the pipe open, consume what has been written so far.
+                        writer.Drain(fileHandle);
+                    }
+
+                    return; // Timeout, or the end of the grace period
                 }
 
                 for (int i = 0; i < numEvents; i++)
@@ -122,25 +251,20 @@ internal static class Multiplexing
 
                     if (evt.filter == EVFILT_READ)
                     {
-                        closed = !UnixHelpers.DrainPipe(fileHandle, ref array, ref totalBytesRead);
+                        bool endOfFile = (evt.flags & EV_EOF) != 0;
+                        bool isOpen;
+                        while ((isOpen = writer.Drain(fileHandle)) && endOfFile)
+                        {
+                        }
+                        closed = !isOpen;
                     }
                     else if (evt.filter == EVFILT_PROC && (evt.fflags & NOTE_EXIT) != 0)
                     {
                         processExited = true;
+                        graceDeadline = Environment.TickCount64 + ExitedProcessGracePeriodMilliseconds;
                     }
                 }
             }
-
-            // If process exited, drain any remaining buffered data from pipe
-            if (!closed)
-            {
-                // Small delay to allow data to arrive.
-                // We have tried other solutions:
-                // - Repeated non-blocking reads until EAGAIN: doesn't work, data may not have arrived yet.
-                // - Waiting on kqueue with zero timeout: doesn't work, kqueue doesn't always signal again.
-                Thread.Sleep(TimeSpan.FromMilliseconds(1));
-                UnixHelpers.DrainPipe(fileHandle, ref array, ref totalBytesRead);
-            }
         }
         finally
         {
@@ -206,6 +330,25 @@ internal static class Multiplexing
         return false; // Process already exited
     }
 
+    private static unsafe void RegisterWriteEvent(int kq, int fd)
+    {
+        // Monitor the input for free space
+        KEvent change = new KEvent
+        {
+            ident = (nuint)fd,
+            filter = EVFILT_WRITE,
+            flags = EV_ADD,
+            fflags = 0,
+            data = 0,
+            udata = 0
+        };
+
+        if (kevent(kq, &change, 1, null, 0, null) == -1)
+        {
+            ThrowForLastError("kevent() registration");
+        }
+    }
+
     private static bool RegisterKqueueEventsForCombined(int kq, SafeFileHandle fd, int pid)
     {
         Span<KEvent> changes = stackalloc KEvent[2];
@@ -316,10 +459,12 @@ internal static class Multiplexing
 
     // kqueue filters
     private const short EVFILT_READ = -1;
+    private const short EVFILT_WRITE = -2;
     private const short EVFILT_PROC = -5;
 
     // kqueue flags
     private const ushort EV_ADD = 0x0001;
+    private const ushort EV_EOF = 0x8000;
 
     // EVFILT_PROC flags
     private const uint NOTE_EXIT = 0x80000000;
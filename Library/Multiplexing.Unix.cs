@@ -11,27 +11,37 @@ namespace System.TBA;
 
 internal static class Multiplexing
 {
+    /// <param name="inputHandle">The non-blocking write end of the standard input pipe, if <paramref name="input"/> is written to it.
+    /// It's closed once all of it has been written, or the process has stopped reading.</param>
     internal static void ReadProcessOutputCore(SafeChildProcessHandle processHandle, SafeFileHandle readStdOut, SafeFileHandle readStdErr, TimeoutHelper timeout,
-        ref int outputBytesRead, ref int errorBytesRead, ref byte[] outputBuffer, ref byte[] errorBuffer)
+        IBufferWriter<byte> outputBuffer, IBufferWriter<byte> errorBuffer, SafeFileHandle? inputHandle = null, ReadOnlySequence<byte> input = default)
     {
         using FileStream stdoutStream = new(readStdOut, FileAccess.Read, bufferSize: 1, isAsync: false);
         using FileStream stderrStream = new(readStdErr, FileAccess.Read, bufferSize: 1, isAsync: false);
 
         int outputFd = (int)readStdOut.DangerousGetHandle();
         int errorFd = (int)readStdErr.DangerousGetHandle();
+        int inputFd = inputHandle is null ? -1 : (int)inputHandle.DangerousGetHandle();
         bool outputClosed = false, errorClosed = false;
+        int outputCapacity = 0, errorCapacity = 0;
+
+        if (inputHandle is not null && input.IsEmpty)
+        {
+            inputHandle.Close();
+        }
 
         // Get the pidfd for process exit detection
         int pidfd = (int)processHandle.DangerousGetHandle();
         bool hasPidFd = pidfd != SafeChildProcessHandle.NoPidFd;
 
         // Allocate pollfd buffer once, outside the loop
-        // We need up to 3 entries: stdout, stderr, and optionally pidfd
+        // We need up to 4 entries: stdout, stderr, optionally stdin and pidfd
         // We watch for pidfd, because it's possible for a process to exit
         // without signaling EOF on stdout or stderr.
         // It happens when the child process spawns other processes
         // that derive the file descriptors.
-        PollFd[] pollFdsBuffer = new PollFd[3];
+        // The input is written by the same loop, as the pipe accepts it, so the pipes can't fill up on both sides.
+        PollFd[] pollFdsBuffer = new PollFd[4];
 
         // Main loop: use poll to wait for data on either stdout or stderr
         while (!outputClosed || !errorClosed)
@@ -54,6 +64,14 @@ internal static class Multiplexing
                 numFds++;
             }
 
+            if (inputHandle is not null && !inputHandle.IsClosed)
+            {
+                pollFdsBuffer[numFds].fd = inputFd;
+                pollFdsBuffer[numFds].events = POLLOUT;
+                pollFdsBuffer[numFds].revents = 0;
+                numFds++;
+            }
+
             // Add pidfd to detect process exit, if available and not yet exited
             if (hasPidFd)
             {
@@ -90,24 +108,29 @@ internal static class Multiplexing
             // Check which file descriptors have data available
             for (int i = 0; i < numFds; i++)
             {
-                if ((pollFdsBuffer[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+                if ((pollFdsBuffer[i].revents & (POLLIN | POLLOUT | POLLHUP | POLLERR)) == 0)
                 {
                     continue; // No events on this fd
                 }
 
                 if (hasPidFd && i == numFds - 1)
                 {
+                    // Nobody is going to read the rest of the input.
+                    inputHandle?.Close();
+
                     // Process is the last descriptor if pidfd is used.
-                    // Since we have already checked both stdout and stderr,
-                    // we just close any remaining open streams and exit.
+                    // The streams may not have been drained after their last wake-up, so we consume what the process has written
+                    // before exiting, then close any remaining open streams and exit.
                     if (!outputClosed)
                     {
+                        DrainExitedProcessPipe(processHandle, readStdOut, outputBuffer);
                         stdoutStream.Close();
                         outputClosed = true;
                     }
 
                     if (!errorClosed)
                     {
+                        DrainExitedProcessPipe(processHandle, readStdErr, errorBuffer);
                         stderrStream.Close();
                         errorClosed = true;
                     }
@@ -115,23 +138,29 @@ internal static class Multiplexing
                     return;
                 }
 
+                if (pollFdsBuffer[i].fd == inputFd)
+                {
+                    // POLLERR: the process has closed its standard input, the rest of the input is dropped.
+                    if ((pollFdsBuffer[i].revents & POLLERR) != 0 || !UnixHelpers.FillPipe(inputHandle!, ref input) || input.IsEmpty)
+                    {
+                        inputHandle!.Close();
+                    }
+                    continue;
+                }
+
                 bool isError = pollFdsBuffer[i].fd == errorFd;
                 FileStream currentFs = isError ? stderrStream : stdoutStream;
-                ref byte[] currentArray = ref (isError ? ref errorBuffer : ref outputBuffer);
-                ref int currentBytesRead = ref (isError ? ref errorBytesRead : ref outputBytesRead);
+                SafeFileHandle currentHandle = isError ? readStdErr : readStdOut;
+                IBufferWriter<byte> currentBuffer = isError ? errorBuffer : outputBuffer;
                 ref bool closed = ref (isError ? ref errorClosed : ref outputClosed);
 
-                int bytesRead = currentFs.Read(currentArray.AsSpan(currentBytesRead));
-                if (bytesRead > 0)
-                {
-                    currentBytesRead += bytesRead;
+                // Read until the pipe is empty: the more the child writes, the larger the segments of the buffer and the reads get.
+                bool isOpen = UnixHelpers.DrainPipe(currentHandle, currentBuffer, out long bytesRead);
 
-                    if (currentBytesRead == currentArray.Length)
-                    {
-                        BufferHelper.RentLargerBuffer(ref currentArray);
-                    }
-                }
-                else
+                ChildProcessTelemetry.OutputRead(processHandle, bytesRead);
+                UnixHelpers.GrowPipeCapacityIfDrainedFull(currentHandle, bytesRead, ref isError ? ref errorCapacity : ref outputCapacity);
+
+                if (!isOpen)
                 {
                     currentFs.Close();
                     closed = true;
@@ -140,7 +169,20 @@ internal static class Multiplexing
         }
     }
 
-    internal static unsafe void ReadCombinedOutputCore(SafeFileHandle fileHandle, SafeChildProcessHandle processHandle, TimeoutHelper timeout, ref int totalBytesRead, ref byte[] array)
+    private static void DrainExitedProcessPipe(SafeChildProcessHandle processHandle, SafeFileHandle pipeHandle, IBufferWriter<byte> buffer)
+    {
+        // DrainPipe stops after a short read, repeat until nothing more is buffered.
+        // We don't wait for EOF, as the descendants of the process may keep the pipe open.
+        long totalBytesRead = 0, bytesRead;
+        while (UnixHelpers.DrainPipe(pipeHandle, buffer, out bytesRead) && bytesRead != 0)
+        {
+            totalBytesRead += bytesRead;
+        }
+
+        ChildProcessTelemetry.OutputRead(processHandle, totalBytesRead + bytesRead);
+    }
+
+    internal static unsafe void ReadCombinedOutputCore(SafeFileHandle fileHandle, SafeChildProcessHandle processHandle, TimeoutHelper timeout, SegmentedBuffer buffer)
     {
         // Get the pidfd for process exit detection
         int pidfd = (int)processHandle.DangerousGetHandle();
@@ -153,6 +195,7 @@ internal static class Multiplexing
         // It happens when the child process spawns other processes
         // that derive the file descriptor.
         PollFd[] pollFdsBuffer = new PollFd[2];
+        int capacity = 0;
 
         // Main loop: use poll to wait for data
         while (true)
@@ -208,7 +251,90 @@ internal static class Multiplexing
                     return;
                 }
 
-                if (!UnixHelpers.DrainPipe(fileHandle, ref array, ref totalBytesRead))
+                bool isOpen = UnixHelpers.DrainPipe(fileHandle, buffer, out long bytesRead);
+
+                ChildProcessTelemetry.OutputRead(processHandle, bytesRead);
+                UnixHelpers.GrowPipeCapacityIfDrainedFull(fileHandle, bytesRead, ref capacity);
+
+                if (!isOpen)
+                {
+                    return; // EOF reached
+                }
+            }
+        }
+    }
+
+    internal static unsafe void TeeCombinedOutputCore(SafeFileHandle fileHandle, SafeChildProcessHandle processHandle, TimeoutHelper timeout, TeeWriter writer)
+    {
+        // Get the pidfd for process exit detection
+        int pidfd = (int)processHandle.DangerousGetHandle();
+        bool hasPidFd = pidfd != SafeChildProcessHandle.NoPidFd;
+
+        // Allocate pollfd buffer once, outside the loop
+        // We need up to 2 entries: the file handle and optionally pidfd
+        // We watch for pidfd, because it's possible for a process to exit
+        // without signaling EOF on the pipe.
+        // It happens when the child process spawns other processes
+        // that derive the file descriptor.
+        PollFd[] pollFdsBuffer = new PollFd[2];
+
+        // Main loop: use poll to wait for data
+        while (true)
+        {
+            int numFds = 0;
+
+            pollFdsBuffer[numFds].fd = (int)fileHandle.DangerousGetHandle();
+            pollFdsBuffer[numFds].events = POLLIN;
+            pollFdsBuffer[numFds].revents = 0;
+            numFds++;
+
+            // Add pidfd to detect process exit, if available
+            if (hasPidFd)
+            {
+                pollFdsBuffer[numFds].fd = pidfd;
+                pollFdsBuffer[numFds].events = POLLIN | POLLHUP; // Linux uses POLLIN, FreeBSD uses POLLHUP.
+                pollFdsBuffer[numFds].revents = 0;
+                numFds++;
+            }
+
+            int timeoutMs = timeout.GetRemainingMilliseconds();
+            int pollResult;
+            fixed (PollFd* pollFds = pollFdsBuffer)
+            {
+                pollResult = poll(pollFds, (nuint)numFds, timeoutMs);
+            }
+
+            if (pollResult < 0)
+            {
+                int errno = Marshal.GetLastPInvokeError();
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw new Win32Exception(errno, "poll() failed");
+            }
+            else if (pollResult == 0)
+            {
+                return; // Timeout occurred
+            }
+
+            // Check which file descriptors have data available
+            for (int i = 0; i < numFds; i++)
+            {
+                if ((pollFdsBuffer[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+                {
+                    continue; // No events on this fd
+                }
+
+                if (hasPidFd && i == 1)
+                {
+                    // Process has exited (pidfd is always the last descriptor).
+                    // Consume what it has written before exiting, but don't wait for EOF.
+                    writer.Drain(fileHandle);
+                    return;
+                }
+
+                if (!writer.Drain(fileHandle))
                 {
                     return; // EOF reached
                 }
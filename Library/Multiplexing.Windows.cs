@@ -1,101 +1,127 @@
 ﻿using Microsoft.Win32.SafeHandles;
 using System.Buffers;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
 using System.Threading;
 
 namespace System.TBA;
 
 internal static class Multiplexing
 {
+    private const int OutputIndex = 0, ErrorIndex = 1, InputIndex = 2;
+
+    /// <param name="inputHandle">The overlapped write end of the standard input pipe, if <paramref name="input"/> is written to it.
+    /// It's closed once all of it has been written, or the process has stopped reading.</param>
     internal static void ReadProcessOutputCore(SafeChildProcessHandle processHandle, SafeFileHandle readStdOut, SafeFileHandle readStdErr, TimeoutHelper timeout,
-        ref int outputBytesRead, ref int errorBytesRead, ref byte[] outputBuffer, ref byte[] errorBuffer)
+        IBufferWriter<byte> outputBuffer, IBufferWriter<byte> errorBuffer, SafeFileHandle? inputHandle = null, ReadOnlySequence<byte> input = default)
     {
-        MemoryHandle outputPin = outputBuffer.AsMemory().Pin();
-        MemoryHandle errorPin = errorBuffer.AsMemory().Pin();
+        // The free space of the last segment of each buffer, the whole segment is kept pinned until it's full.
+        // Any other writer is asked for new memory after every read, as the memory it returned is no longer valid once advanced.
+        Memory<byte> outputMemory = outputBuffer.GetMemory();
+        Memory<byte> errorMemory = errorBuffer.GetMemory();
+        MemoryHandle outputPin = outputMemory.Pin();
+        MemoryHandle errorPin = errorMemory.Pin();
+        MemoryHandle inputPin = default;
 
         try
         {
-            using OverlappedContext outputContext = OverlappedContext.Allocate();
-            using OverlappedContext errorContext = OverlappedContext.Allocate();
-            using Interop.Kernel32.ProcessWaitHandle processWaitHandle = new(processHandle);
-
             // A pipe signals EOF by returning 0 bytes read.
             // It happens when the write end of the pipe is closed.
             // But to be exact, it happens when all write handles to the pipe are closed.
             // It's possible that the child process spawns other processes inheriting the write handle.
             // In such case, the pipe won't signal EOF until all those processes exit.
             // So we wait until EOF or process exit.
-            WaitHandle[] waitHandles = [processWaitHandle, outputContext.WaitHandle, errorContext.WaitHandle];
+            using CompletionPortReactor.Group group = CompletionPortReactor.Instance.CreateGroup(operationCount: inputHandle is null ? 2 : 3, processHandle);
+            group.Bind(readStdOut);
+            group.Bind(readStdErr);
+
+            if (inputHandle is not null)
+            {
+                // The input is written by the same loop, one segment at a time, so the pipes can't fill up on both sides.
+                group.Bind(inputHandle);
+                WriteInput(group, inputHandle, input, ref inputPin);
+            }
 
             unsafe
             {
                 // Issue first reads.
-                Interop.Kernel32.ReadFile(readStdOut, (byte*)outputPin.Pointer, outputBuffer.Length, IntPtr.Zero, outputContext.GetOverlapped());
-                Interop.Kernel32.ReadFile(readStdErr, (byte*)errorPin.Pointer, errorBuffer.Length, IntPtr.Zero, errorContext.GetOverlapped());
+                group.Read(OutputIndex, readStdOut, (byte*)outputPin.Pointer, outputMemory.Length);
+                group.Read(ErrorIndex, readStdErr, (byte*)errorPin.Pointer, errorMemory.Length);
             }
 
             while (!readStdOut.IsClosed || !readStdErr.IsClosed)
             {
                 int waitResult = timeout.TryGetRemainingMilliseconds(out int remainingMilliseconds)
-                    ? WaitHandle.WaitAny(waitHandles, remainingMilliseconds)
+                    ? group.WaitAny(remainingMilliseconds)
                     : WaitHandle.WaitTimeout;
 
-                if (waitResult is 1 or 2)
+                if (waitResult is OutputIndex or ErrorIndex)
                 {
-                    bool isError = waitResult == 2;
+                    bool isError = waitResult == ErrorIndex;
 
-                    OverlappedContext currentContext = isError ? errorContext : outputContext;
                     SafeFileHandle currentFileHandle = isError ? readStdErr : readStdOut;
-                    ref int totalBytesRead = ref (isError ? ref errorBytesRead : ref outputBytesRead);
-                    ref byte[] currentBuffer = ref (isError ? ref errorBuffer : ref outputBuffer);
+                    IBufferWriter<byte> currentBuffer = isError ? errorBuffer : outputBuffer;
+                    ref Memory<byte> currentMemory = ref (isError ? ref errorMemory : ref outputMemory);
 
-                    int bytesRead = currentContext.GetOverlappedResult(currentFileHandle);
+                    int bytesRead = group.GetResult(waitResult);
                     if (bytesRead > 0)
                     {
-                        totalBytesRead += bytesRead;
+                        currentBuffer.Advance(bytesRead);
+                        currentMemory = currentBuffer is SegmentedBuffer ? currentMemory.Slice(bytesRead) : Memory<byte>.Empty;
+                        ChildProcessTelemetry.OutputRead(processHandle, bytesRead);
 
-                        if (totalBytesRead == currentBuffer.Length)
+                        if (currentMemory.IsEmpty)
                         {
                             ref MemoryHandle currentPin = ref (isError ? ref errorPin : ref outputPin);
                             currentPin.Dispose();
 
-                            BufferHelper.RentLargerBuffer(ref currentBuffer);
+                            currentMemory = currentBuffer.GetMemory();
 
-                            currentPin = currentBuffer.AsMemory().Pin();
+                            currentPin = currentMemory.Pin();
                         }
 
                         unsafe
                         {
-                            void* pinPointer = isError ? errorPin.Pointer : outputPin.Pointer;
-                            int sliceLength = currentBuffer.Length - totalBytesRead;
-                            byte* targetPointer = (byte*)pinPointer + totalBytesRead;
+                            // The segment is pinned, so is the remaining part of it.
+                            byte* targetPointer = (byte*)Unsafe.AsPointer(ref MemoryMarshal.GetReference(currentMemory.Span));
 
-                            Interop.Kernel32.ReadFile(currentFileHandle, targetPointer, sliceLength, IntPtr.Zero, currentContext.GetOverlapped());
+                            group.Read(waitResult, currentFileHandle, targetPointer, currentMemory.Length);
                         }
                     }
-                    else
+                    else if (!currentFileHandle.IsClosed)
                     {
-                        if (!currentFileHandle.IsClosed)
-                        {
-                            // Close the handle to stop further reads.
-                            currentFileHandle.Close();
-                            // And reset the wait handle to avoid triggering on closed handle.
-                            currentContext.WaitHandle.Reset();
-                        }
+                        // Close the handle to stop further reads.
+                        currentFileHandle.Close();
                     }
                 }
-                else if (waitResult == 0 || waitResult == WaitHandle.WaitTimeout)
+                else if (waitResult == InputIndex)
+                {
+                    inputPin.Dispose();
+
+                    // Nothing is written once the process has closed its standard input.
+                    int bytesWritten = group.GetResult(InputIndex);
+                    input = bytesWritten > 0 ? input.Slice(bytesWritten) : ReadOnlySequence<byte>.Empty;
+
+                    WriteInput(group, inputHandle!, input, ref inputPin);
+                }
+                else if (waitResult is CompletionPortReactor.Group.ProcessExited or WaitHandle.WaitTimeout)
                 {
                     // Either the process has exited, or we have timed out.
                     // In both cases, we stop reading.
 
                     if (!readStdOut.IsClosed)
                     {
-                        outputContext.CancelPendingIO(readStdOut);
+                        group.CancelPendingIO(OutputIndex);
                     }
 
                     if (!readStdErr.IsClosed)
                     {
-                        errorContext.CancelPendingIO(readStdErr);
+                        group.CancelPendingIO(ErrorIndex);
+                    }
+
+                    if (inputHandle is not null && !inputHandle.IsClosed)
+                    {
+                        group.CancelPendingIO(InputIndex);
                     }
 
                     if (waitResult == WaitHandle.WaitTimeout)
@@ -113,50 +139,103 @@ internal static class Multiplexing
         {
             outputPin.Dispose();
             errorPin.Dispose();
+            inputPin.Dispose();
         }
     }
 
-    internal static unsafe void ReadCombinedOutputCore(SafeFileHandle fileHandle, SafeChildProcessHandle processHandle, TimeoutHelper timeout, ref int totalBytesRead, ref byte[] array)
+    // Issues the write of the next segment of the input, or closes the pipe when there is nothing left, so the process reads EOF.
+    private static unsafe void WriteInput(CompletionPortReactor.Group group, SafeFileHandle inputHandle, ReadOnlySequence<byte> input, ref MemoryHandle inputPin)
     {
-        using OverlappedContext overlappedContext = OverlappedContext.Allocate();
-        using Interop.Kernel32.ProcessWaitHandle processWaitHandle = new(processHandle);
+        if (input.IsEmpty)
+        {
+            inputHandle.Close();
+            return;
+        }
 
-        WaitHandle[] waitHandles = [processWaitHandle, overlappedContext.WaitHandle];
+        // The sequence may contain empty segments, they don't count in the bytes it's sliced by.
+        ReadOnlyMemory<byte> segment = input.First;
+        if (segment.IsEmpty)
+        {
+            foreach (ReadOnlyMemory<byte> memory in input)
+            {
+                if (!memory.IsEmpty)
+                {
+                    segment = memory;
+                    break;
+                }
+            }
+        }
+
+        inputPin = segment.Pin();
+        group.Write(InputIndex, inputHandle, (byte*)inputPin.Pointer, segment.Length);
+    }
+
+    internal static unsafe void ReadCombinedOutputCore(SafeFileHandle fileHandle, SafeChildProcessHandle processHandle, TimeoutHelper timeout, SegmentedBuffer buffer)
+    {
+        using CompletionPortReactor.Group group = CompletionPortReactor.Instance.CreateGroup(operationCount: 1, processHandle);
+        group.Bind(fileHandle);
 
         while (true)
         {
-            Span<byte> remainingBytes = array.AsSpan(totalBytesRead);
+            Span<byte> remainingBytes = buffer.GetSpan();
             fixed (byte* pinnedRemaining = remainingBytes)
             {
-                Interop.Kernel32.ReadFile(fileHandle, pinnedRemaining, remainingBytes.Length, IntPtr.Zero, overlappedContext.GetOverlapped());
+                group.Read(0, fileHandle, pinnedRemaining, remainingBytes.Length);
 
-                int errorCode = fileHandle.GetLastWin32ErrorAndDisposeHandleIfInvalid();
-                if (errorCode == Interop.Errors.ERROR_IO_PENDING)
-                {
-                    int waitResult = timeout.TryGetRemainingMilliseconds(out int remainingMilliseconds)
-                        ? WaitHandle.WaitAny(waitHandles, remainingMilliseconds)
-                        : WaitHandle.WaitTimeout;
+                int waitResult = timeout.TryGetRemainingMilliseconds(out int remainingMilliseconds)
+                    ? group.WaitAny(remainingMilliseconds)
+                    : WaitHandle.WaitTimeout;
 
-                    if (waitResult == 0 || waitResult == WaitHandle.WaitTimeout)
-                    {
-                        // Process has exited or the read has timed out, stop reading (grandchild may still have pipe open)
-                        overlappedContext.CancelPendingIO(fileHandle);
-                        break;
-                    }
+                if (waitResult is CompletionPortReactor.Group.ProcessExited or WaitHandle.WaitTimeout)
+                {
+                    // Process has exited or the read has timed out, stop reading (grandchild may still have pipe open)
+                    group.CancelPendingIO(0);
+                    break;
                 }
 
-                int bytesRead = overlappedContext.GetOverlappedResult(fileHandle);
+                int bytesRead = group.GetResult(0);
                 if (bytesRead <= 0)
                 {
                     break;
                 }
 
-                totalBytesRead += bytesRead;
+                buffer.Advance(bytesRead);
+                ChildProcessTelemetry.OutputRead(processHandle, bytesRead);
             }
+        }
+    }
+
+    internal static unsafe void TeeCombinedOutputCore(SafeFileHandle fileHandle, SafeChildProcessHandle processHandle, TimeoutHelper timeout, TeeWriter writer)
+    {
+        using CompletionPortReactor.Group group = CompletionPortReactor.Instance.CreateGroup(operationCount: 1, processHandle);
+        group.Bind(fileHandle);
+
+        byte[] buffer = writer.CopyBuffer;
 
-            if (array.Length == totalBytesRead)
+        fixed (byte* pinnedBuffer = buffer)
+        {
+            while (true)
             {
-                BufferHelper.RentLargerBuffer(ref array);
+                group.Read(0, fileHandle, pinnedBuffer, buffer.Length);
+
+                int waitResult = timeout.TryGetRemainingMilliseconds(out int remainingMilliseconds)
+                    ? group.WaitAny(remainingMilliseconds)
+                    : WaitHandle.WaitTimeout;
+
+                if (waitResult is CompletionPortReactor.Group.ProcessExited or WaitHandle.WaitTimeout)
+                {
+                    // Process has exited or the read has timed out, stop reading (grandchild may still have pipe open)
+                    group.CancelPendingIO(0);
+                    break;
+                }
+
+                int bytesRead = group.GetResult(0);
+                if (bytesRead <= 0)
+                {
+                    break;
+                }
+
+                writer.Write(buffer.AsSpan(0, bytesRead));
             }
         }
     }
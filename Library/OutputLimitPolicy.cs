@@ -0,0 +1,16 @@
+namespace System.TBA;
+
+/// <summary>
+/// Specifies which part of the output is kept when it exceeds <see cref="ProcessStartOptions.MaxOutputBytes"/>.
+/// </summary>
+public enum OutputLimitPolicy
+{
+    /// <summary>Keep the first bytes, drop the rest.</summary>
+    KeepHead,
+
+    /// <summary>Keep the last bytes, drop the ones written before.</summary>
+    KeepTail,
+
+    /// <summary>Keep the first half and the last half of the limit, drop the bytes in between.</summary>
+    KeepHeadAndTail,
+}
@@ -6,11 +6,12 @@ namespace System.TBA;
 // example: an app may fail with exit code 0 but produce invalid output
 public sealed class ProcessExitStatus
 {
-    public ProcessExitStatus(int exitCode, bool cancelled, PosixSignal? signal = null)
+    public ProcessExitStatus(int exitCode, bool cancelled, PosixSignal? signal = null, ProcessResourceUsage? resourceUsage = null)
     {
         ExitCode = exitCode;
         Signal = signal;
         Canceled = cancelled;
+        ResourceUsage = resourceUsage;
     }
 
     /// <summary>
@@ -38,4 +39,13 @@ public sealed class ProcessExitStatus
     /// Gets a value indicating whether the process has been terminated due to timeout or cancellation.
     /// </summary>
     public bool Canceled { get; }
-}
+
+    /// <summary>
+    /// Gets the resources used by the process, or null if they are not available.
+    /// </summary>
+    /// <remarks>
+    /// On Unix, they are reported by the same syscall that reaps the process. On Windows, they are queried from the process handle
+    /// once the process has exited, which fails only when the handle lacks the PROCESS_QUERY_LIMITED_INFORMATION access right.
+    /// </remarks>
+    public ProcessResourceUsage? ResourceUsage { get; }
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+using Microsoft.Win32.SafeHandles;
+using System.Runtime.InteropServices;
+using System.Text;
+
+namespace System.TBA;
+
+public sealed partial class ProcessLaunchTemplate
+{
+    // Overridden arguments up to this size are encoded on the stack.
+    private const int StackallocThreshold = 1024;
+
+    // A single native block: the argv pointers, the envp pointers, then all the null-terminated UTF-8 strings.
+    private unsafe byte* _block;
+    private unsafe byte** _argv;
+    private unsafe byte** _envp;
+    private unsafe byte* _workingDirectory;
+
+    private unsafe void Initialize()
+    {
+        string[] argv = [_options.FileName, .. _options.Arguments];
+        // Pass null for envp if environment wasn't accessed (native code will use environ)
+        string[]? envp = _options.HasEnvironmentBeenAccessed ? UnixHelpers.GetEnvironmentVariables(_options) : null;
+        string? workingDirectory = _options.WorkingDirectory;
+
+        int pointerCount = argv.Length + 1 + (envp is null ? 0 : envp.Length + 1);
+        nuint size = (nuint)pointerCount * (nuint)sizeof(byte*);
+        foreach (string arg in argv)
+        {
+            size += (nuint)Encoding.UTF8.GetByteCount(arg) + 1;
+        }
+        if (envp is not null)
+        {
+            foreach (string variable in envp)
+            {
+                size += (nuint)Encoding.UTF8.GetByteCount(variable) + 1;
+            }
+        }
+        if (workingDirectory is not null)
+        {
+            size += (nuint)Encoding.UTF8.GetByteCount(workingDirectory) + 1;
+        }
+
+        _block = (byte*)NativeMemory.Alloc(size);
+        byte* end = _block + size;
+        byte* strings = _block + pointerCount * sizeof(byte*);
+
+        _argv = (byte**)_block;
+        for (int i = 0; i < argv.Length; i++)
+        {
+            _argv[i] = strings;
+            strings = WriteNullTerminatedUtf8String(argv[i], strings, end);
+        }
+        _argv[argv.Length] = null;
+
+        if (envp is not null)
+        {
+            _envp = _argv + argv.Length + 1;
+            for (int i = 0; i < envp.Length; i++)
+            {
+                _envp[i] = strings;
+                strings = WriteNullTerminatedUtf8String(envp[i], strings, end);
+            }
+            _envp[envp.Length] = null;
+        }
+
+        if (workingDirectory is not null)
+        {
+            _workingDirectory = strings;
+            WriteNullTerminatedUtf8String(workingDirectory, strings, end);
+        }
+    }
+
+    private static unsafe byte* WriteNullTerminatedUtf8String(string value, byte* destination, byte* end)
+    {
+        int bytesWritten = Encoding.UTF8.GetBytes(value, new Span<byte>(destination, (int)(end - destination)));
+        destination[bytesWritten] = (byte)'\0';
+        return destination + bytesWritten + 1;
+    }
+
+    private unsafe SafeChildProcessHandle StartCore(SafeFileHandle input, SafeFileHandle output, SafeFileHandle error, ReadOnlySpan<string?> arguments)
+    {
+        int stdInFd = (int)input.DangerousGetHandle();
+        int stdOutFd = (int)output.DangerousGetHandle();
+        int stdErrFd = (int)error.DangerousGetHandle();
+
+        int byteCount = 0;
+        foreach (string? argument in arguments)
+        {
+            if (argument is not null)
+            {
+                byteCount += Encoding.UTF8.GetByteCount(argument) + 1;
+            }
+        }
+
+        // The templates are meant for long command lines: the arrays are on the stack only while they're small, like the strings.
+        int pointerCount = byteCount == 0 ? 0 : _argumentCount + 2;
+        int* rentedHandles = null;
+        nint* rentedPointers = null;
+        byte* rented = null;
+        Span<int> inheritedHandles = _inheritedHandles.Length <= StackallocThreshold / sizeof(int)
+            ? stackalloc int[_inheritedHandles.Length]
+            : new Span<int>(rentedHandles = (int*)NativeMemory.Alloc((nuint)_inheritedHandles.Length, sizeof(int)), _inheritedHandles.Length);
+        Span<nint> argv = pointerCount <= StackallocThreshold / sizeof(nint)
+            ? stackalloc nint[pointerCount]
+            : new Span<nint>(rentedPointers = (nint*)NativeMemory.Alloc((nuint)pointerCount, (nuint)sizeof(nint)), pointerCount);
+        Span<byte> scratch = byteCount == 0
+            ? default
+            : byteCount <= StackallocThreshold
+            ? stackalloc byte[StackallocThreshold]
+            : new Span<byte>(rented = (byte*)NativeMemory.Alloc((nuint)byteCount), byteCount);
+
+        try
+        {
+            // The descriptors are read for every launch, as the handles may have been closed and their numbers reused.
+            for (int i = 0; i < _inheritedHandles.Length; i++)
+            {
+                inheritedHandles[i] = (int)_inheritedHandles[i].DangerousGetHandle();
+            }
+
+            fixed (int* inheritedHandlesPtr = inheritedHandles)
+            fixed (nint* argvPtr = argv)
+            fixed (byte* scratchPtr = scratch)
+            {
+                if (byteCount == 0)
+                {
+                    return SafeChildProcessHandle.Spawn(_argv[0], _argv, _envp, _workingDirectory, inheritedHandlesPtr, _inheritedHandles.Length,
+                        _options, stdInFd, stdOutFd, stdErrFd, createSuspended: false, detached: false);
+                }
+
+                // The overridden arguments are encoded into the scratch buffer, the others keep pointing to the template block.
+                new ReadOnlySpan<nint>(_argv, pointerCount).CopyTo(argv);
+
+                byte* strings = scratchPtr;
+                for (int i = 0; i < arguments.Length; i++)
+                {
+                    if (arguments[i] is string argument)
+                    {
+                        // argv[0] is the path of the executable.
+                        argv[i + 1] = (nint)strings;
+                        strings = WriteNullTerminatedUtf8String(argument, strings, scratchPtr + scratch.Length);
+                    }
+                }
+
+                return SafeChildProcessHandle.Spawn((byte*)argv[0], (byte**)argvPtr, _envp, _workingDirectory, inheritedHandlesPtr, _inheritedHandles.Length,
+                    _options, stdInFd, stdOutFd, stdErrFd, createSuspended: false, detached: false);
+            }
+        }
+        finally
+        {
+            NativeMemory.Free(rented);
+            NativeMemory.Free(rentedPointers);
+            NativeMemory.Free(rentedHandles);
+        }
+    }
+
+    private unsafe void DisposeCore()
+    {
+        NativeMemory.Free(_block);
+        _block = null;
+        _argv = null;
+        _envp = null;
+        _workingDirectory = null;
+    }
+}
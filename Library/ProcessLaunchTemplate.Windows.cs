@@ -0,0 +1,64 @@
+using Microsoft.Win32.SafeHandles;
+using System.Text;
+
+namespace System.TBA;
+
+public sealed partial class ProcessLaunchTemplate
+{
+    // The null-terminated path, the command line and the environment block are built once, only the stdio handles change between the launches.
+    // The attribute list is still created by every launch: it holds their handles, and the template can be started by many threads at the same time.
+    private string _applicationName = null!;
+    private string _commandLine = null!;
+    private string? _environmentBlock;
+
+    private void Initialize()
+    {
+        ValueStringBuilder applicationName = new(stackalloc char[256]);
+        ValueStringBuilder commandLine = new(stackalloc char[256]);
+        ProcessUtils.BuildArgs(_options, ref applicationName, ref commandLine);
+
+        _applicationName = applicationName.AsSpan(0, applicationName.Length + 1).ToString();
+        _commandLine = commandLine.ToString();
+        _environmentBlock = _options.HasEnvironmentBeenAccessed
+            ? ProcessUtils.GetEnvironmentVariablesBlock(_options.Environment)
+            : null;
+
+        applicationName.Dispose();
+        commandLine.Dispose();
+    }
+
+    private SafeChildProcessHandle StartCore(SafeFileHandle input, SafeFileHandle output, SafeFileHandle error, ReadOnlySpan<string?> arguments)
+    {
+        long timestamp = ChildProcessTelemetry.GetStartTimestamp();
+
+        // CreateProcess can modify the command line, so every launch gets its own copy.
+        ValueStringBuilder commandLine = new(stackalloc char[256]);
+        if (arguments.IsEmpty)
+        {
+            commandLine.Append(_commandLine);
+        }
+        else
+        {
+            PasteArguments.AppendArgument(ref commandLine, _options.FileName);
+            for (int i = 0; i < _argumentCount; i++)
+            {
+                PasteArguments.AppendArgument(ref commandLine, i < arguments.Length && arguments[i] is string argument ? argument : _options.Arguments[i]);
+            }
+        }
+        commandLine.NullTerminate();
+
+        try
+        {
+            return SafeChildProcessHandle.StartCore(_options, _applicationName, ref commandLine, _environmentBlock,
+                input, output, error, createSuspended: false, detached: false, createNewProcessGroup: false, timestamp);
+        }
+        finally
+        {
+            commandLine.Dispose();
+        }
+    }
+
+    private void DisposeCore()
+    {
+    }
+}
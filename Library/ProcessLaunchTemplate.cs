@@ -0,0 +1,136 @@
+using Microsoft.Win32.SafeHandles;
+using System.IO;
+using System.Runtime.InteropServices;
+
+namespace System.TBA;
+
+/// <summary>
+/// A process launch that is prepared once and can then be started many times.
+/// </summary>
+/// <remarks>
+/// <para>
+/// The executable path is resolved and the options are copied when the template is created,
+/// changes made to the <see cref="ProcessStartOptions"/> afterwards are not observed.
+/// </para>
+/// <para>
+/// On Unix, the arguments, the environment and the working directory are also encoded to UTF-8 into a single native block,
+/// so starting a process does not allocate anything besides the returned handle.
+/// On Windows, the command line and the environment block are built once, only the stdio handles change between the launches.
+/// </para>
+/// <para>
+/// <see cref="Start(SafeFileHandle?, SafeFileHandle?, SafeFileHandle?)"/> can be called by many threads at the same time,
+/// but not after (or while) the template is disposed.
+/// </para>
+/// </remarks>
+public sealed partial class ProcessLaunchTemplate : IDisposable
+{
+    private readonly ProcessStartOptions _options;
+    private readonly SafeHandle[] _inheritedHandles;
+    private readonly int _argumentCount;
+    private readonly SafeFileHandle _nullHandle;
+    private bool _disposed;
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ProcessLaunchTemplate"/> class.
+    /// </summary>
+    /// <param name="options">The process start options to prepare.</param>
+    /// <exception cref="ArgumentNullException">Thrown when <paramref name="options"/> is null.</exception>
+    /// <exception cref="FileNotFoundException">Thrown when the file name cannot be resolved to an existing file.</exception>
+    public ProcessLaunchTemplate(ProcessStartOptions options)
+    {
+        ArgumentNullException.ThrowIfNull(options);
+
+        _options = options.CreateResolvedCopy();
+        _inheritedHandles = _options.HasInheritedHandlesBeenAccessed ? [.. _options.InheritedHandles] : [];
+        _argumentCount = _options.Arguments.Count;
+        _nullHandle = File.OpenNullFileHandle();
+
+        try
+        {
+            Initialize();
+        }
+        catch
+        {
+            _nullHandle.Dispose();
+            throw;
+        }
+    }
+
+    /// <summary>
+    /// Gets the resolved path of the application to start.
+    /// </summary>
+    public string FileName => _options.FileName;
+
+    /// <summary>
+    /// Gets the number of arguments of the template.
+    /// </summary>
+    public int ArgumentCount => _argumentCount;
+
+    /// <summary>
+    /// Starts a new process with the prepared options.
+    /// </summary>
+    /// <param name="input">The handle to use for standard input, or <see langword="null"/> to provide no input.</param>
+    /// <param name="output">The handle to use for standard output, or <see langword="null"/> to discard output.</param>
+    /// <param name="error">The handle to use for standard error, or <see langword="null"/> to discard error.</param>
+    /// <returns>A handle to the started process.</returns>
+    /// <exception cref="ObjectDisposedException">Thrown when the template has been disposed.</exception>
+    public SafeChildProcessHandle Start(SafeFileHandle? input, SafeFileHandle? output, SafeFileHandle? error)
+        => Start(input, output, error, ReadOnlySpan<string?>.Empty);
+
+    /// <summary>
+    /// Starts a new process with the prepared options and some of the arguments replaced.
+    /// </summary>
+    /// <param name="input">The handle to use for standard input, or <see langword="null"/> to provide no input.</param>
+    /// <param name="output">The handle to use for standard output, or <see langword="null"/> to discard output.</param>
+    /// <param name="error">The handle to use for standard error, or <see langword="null"/> to discard error.</param>
+    /// <param name="arguments">
+    /// The arguments to use instead of the prepared ones, by position.
+    /// A <see langword="null"/> element keeps the prepared argument, the arguments past the end of the span are kept too.
+    /// </param>
+    /// <returns>A handle to the started process.</returns>
+    /// <exception cref="ObjectDisposedException">Thrown when the template has been disposed.</exception>
+    /// <exception cref="ArgumentOutOfRangeException">Thrown when <paramref name="arguments"/> is longer than <see cref="ArgumentCount"/>.</exception>
+    public SafeChildProcessHandle Start(SafeFileHandle? input, SafeFileHandle? output, SafeFileHandle? error, ReadOnlySpan<string?> arguments)
+    {
+        ObjectDisposedException.ThrowIf(_disposed, this);
+        ArgumentOutOfRangeException.ThrowIfGreaterThan(arguments.Length, _argumentCount, nameof(arguments));
+
+        input ??= _nullHandle;
+        output ??= _nullHandle;
+        error ??= _nullHandle;
+
+        long timestamp = ChildProcessTelemetry.GetStartTimestamp();
+        ChildProcessTelemetry.SpawnStarting(FileName, timestamp);
+
+        try
+        {
+            SafeChildProcessHandle processHandle = StartCore(input, output, error, arguments);
+            ChildProcessTelemetry.ProcessStarted(processHandle, timestamp);
+            return processHandle;
+        }
+        catch (Exception exception)
+        {
+            ChildProcessTelemetry.SpawnFailed(FileName, exception);
+            throw;
+        }
+        finally
+        {
+            SafeChildProcessHandle.DisposeChildPipeHandles(output, error);
+        }
+    }
+
+    /// <summary>
+    /// Releases the native memory used by the template.
+    /// </summary>
+    public void Dispose()
+    {
+        if (_disposed)
+        {
+            return;
+        }
+
+        _disposed = true;
+        _nullHandle.Dispose();
+        DisposeCore();
+    }
+}
@@ -23,11 +23,24 @@ public readonly struct ProcessOutput
     /// <remarks>This information can be useful to process any diagnostics/tracing data post run.</remarks>
     public int ProcessId { get; }
 
-    public ProcessOutput(ProcessExitStatus exitStatus, string standardOutput, string standardError, int processId) : this()
+    /// <summary>
+    /// Gets the number of bytes written to standard output that were not kept because of <see cref="ProcessStartOptions.MaxOutputBytes"/>.
+    /// </summary>
+    public long StandardOutputDroppedBytes { get; }
+
+    /// <summary>
+    /// Gets the number of bytes written to standard error that were not kept because of <see cref="ProcessStartOptions.MaxOutputBytes"/>.
+    /// </summary>
+    public long StandardErrorDroppedBytes { get; }
+
+    public ProcessOutput(ProcessExitStatus exitStatus, string standardOutput, string standardError, int processId,
+        long standardOutputDroppedBytes = 0, long standardErrorDroppedBytes = 0) : this()
     {
         ExitStatus = exitStatus;
         StandardOutput = standardOutput;
         StandardError = standardError;
         ProcessId = processId;
+        StandardOutputDroppedBytes = standardOutputDroppedBytes;
+        StandardErrorDroppedBytes = standardErrorDroppedBytes;
     }
 }
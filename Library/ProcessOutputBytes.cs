@@ -0,0 +1,83 @@
+using System.Buffers;
+using System.Text;
+
+namespace System.TBA;
+
+/// <summary>
+/// The raw standard output and error of a process, stored in pooled buffers.
+/// </summary>
+/// <remarks>The buffers are returned to the pool when the instance is disposed, so the sequences must not be used after that.</remarks>
+public sealed class ProcessOutputBytes : IDisposable
+{
+    private readonly SegmentedBuffer _output, _error;
+    private bool _disposed;
+
+    internal ProcessOutputBytes(ProcessExitStatus exitStatus, SegmentedBuffer output, SegmentedBuffer error, int processId)
+    {
+        ExitStatus = exitStatus;
+        _output = output;
+        _error = error;
+        ProcessId = processId;
+    }
+
+    /// <summary>
+    /// Gets the exit status of the process after it has terminated.
+    /// </summary>
+    public ProcessExitStatus ExitStatus { get; }
+
+    /// <summary>
+    /// Gets the bytes written to standard output.
+    /// </summary>
+    public ReadOnlySequence<byte> StandardOutput
+    {
+        get
+        {
+            ObjectDisposedException.ThrowIf(_disposed, this);
+            return _output.GetSequence();
+        }
+    }
+
+    /// <summary>
+    /// Gets the bytes written to standard error.
+    /// </summary>
+    public ReadOnlySequence<byte> StandardError
+    {
+        get
+        {
+            ObjectDisposedException.ThrowIf(_disposed, this);
+            return _error.GetSequence();
+        }
+    }
+
+    /// <summary>
+    /// Gets the process ID that was used when it was running.
+    /// </summary>
+    /// <remarks>This information can be useful to process any diagnostics/tracing data post run.</remarks>
+    public int ProcessId { get; }
+
+    /// <summary>
+    /// Gets the number of bytes written to standard output that were not kept because of <see cref="ProcessStartOptions.MaxOutputBytes"/>.
+    /// </summary>
+    public long StandardOutputDroppedBytes => _output.DroppedBytes;
+
+    /// <summary>
+    /// Gets the number of bytes written to standard error that were not kept because of <see cref="ProcessStartOptions.MaxOutputBytes"/>.
+    /// </summary>
+    public long StandardErrorDroppedBytes => _error.DroppedBytes;
+
+    internal ProcessOutput Decode(Encoding encoding)
+        => new(ExitStatus, _output.GetString(encoding), _error.GetString(encoding), ProcessId, StandardOutputDroppedBytes, StandardErrorDroppedBytes);
+
+    /// <summary>
+    /// Returns the buffers to the pool.
+    /// </summary>
+    public void Dispose()
+    {
+        if (!_disposed)
+        {
+            _disposed = true;
+            _output.Dispose();
+            _error.Dispose();
+        }
+    }
+}
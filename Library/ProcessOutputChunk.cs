@@ -0,0 +1,39 @@
+namespace System.TBA;
+
+/// <summary>
+/// A single read of standard output or error, as recorded by <see cref="ChildProcess.CaptureInterleaved"/>.
+/// </summary>
+public readonly struct ProcessOutputChunk
+{
+    // Design: ctor is public to allow for mocking in tests.
+    public ProcessOutputChunk(long offset, int length, bool standardError, TimeSpan timestamp)
+    {
+        ArgumentOutOfRangeException.ThrowIfNegative(offset);
+        ArgumentOutOfRangeException.ThrowIfNegative(length);
+
+        Offset = offset;
+        Length = length;
+        StandardError = standardError;
+        Timestamp = timestamp;
+    }
+
+    /// <summary>
+    /// Gets the position of the first byte of the chunk in the stream it was read from.
+    /// </summary>
+    public long Offset { get; }
+
+    /// <summary>
+    /// Gets the number of bytes of the chunk.
+    /// </summary>
+    public int Length { get; }
+
+    /// <summary>
+    /// Gets a value indicating whether the chunk was read from standard error rather than standard output.
+    /// </summary>
+    public bool StandardError { get; }
+
+    /// <summary>
+    /// Gets the time elapsed between the start of the capture and the read of the chunk.
+    /// </summary>
+    public TimeSpan Timestamp { get; }
+}
@@ -0,0 +1,43 @@
+using System.Text;
+
+namespace System.TBA;
+
+/// <summary>
+/// A line of output that refers to the pooled buffer of the enumerator instead of being copied to a <see cref="string"/>.
+/// </summary>
+/// <remarks>It's valid only until the enumerator moves to the next line.</remarks>
+public readonly struct ProcessOutputLineView
+{
+    private readonly Encoding _encoding;
+
+    internal ProcessOutputLineView(ReadOnlyMemory<byte> bytes, bool standardError, Encoding encoding)
+    {
+        Bytes = bytes;
+        StandardError = standardError;
+        _encoding = encoding;
+    }
+
+    /// <summary>
+    /// Gets the encoded content of the line, without the line ending.
+    /// </summary>
+    public ReadOnlyMemory<byte> Bytes { get; }
+
+    public bool StandardError { get; }
+
+    /// <summary>
+    /// Decodes the line into <paramref name="destination"/>.
+    /// </summary>
+    /// <returns>The number of characters written to <paramref name="destination"/>.</returns>
+    /// <remarks>Use <see cref="GetMaxCharCount"/> to size the destination.</remarks>
+    public int GetChars(Span<char> destination) => _encoding.GetChars(Bytes.Span, destination);
+
+    /// <summary>
+    /// Gets the maximum number of characters produced by <see cref="GetChars"/>.
+    /// </summary>
+    public int GetMaxCharCount() => _encoding.GetMaxCharCount(Bytes.Length);
+
+    /// <summary>
+    /// Decodes the line into a new string.
+    /// </summary>
+    public string GetText() => _encoding.GetString(Bytes.Span);
+}
@@ -14,22 +14,20 @@ namespace System.TBA;
 
 public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, IEnumerable<ProcessOutputLine>
 {
-    public IEnumerator<ProcessOutputLine> GetEnumerator()
+    private IEnumerable<ProcessOutputLineView> EnumerateLineViewsCore()
     {
         // NOTE: we could get current console Encoding here, it's omitted for the sake of simplicity of the proof of concept.
         Encoding encoding = _encoding ?? Encoding.UTF8;
         TimeoutHelper timeoutHelper = TimeoutHelper.Start(_timeout);
 
-        byte[] outputBuffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
-        byte[] errorBuffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
-        int outputStartIndex = 0, outputEndIndex = 0;
-        int errorStartIndex = 0, errorEndIndex = 0;
+        LineBuffer outputBuffer = new();
+        LineBuffer errorBuffer = new();
 
         SafeFileHandle? parentOutputHandle = null, childOutputHandle = null, parentErrorHandle = null, childErrorHandle = null;
         try
         {
             using SafeFileHandle inputHandle = Console.OpenStandardInputHandle();
-            File.CreatePipe(out parentOutputHandle, out childOutputHandle);
+            File.CreatePipe(out parentOutputHandle, out childOutputHandle, capacity: _options.OutputPipeCapacity);
             File.CreatePipe(out parentErrorHandle, out childErrorHandle);
 
             using SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(_options, inputHandle, childOutputHandle, childErrorHandle);
@@ -100,18 +98,16 @@ public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, I
 
                     bool isError = pollFdsBuffer[i].fd == errorFd;
                     int currentFd = pollFdsBuffer[i].fd;
-                    int currentStartIndex = isError ? errorStartIndex : outputStartIndex;
-                    int currentEndIndex = isError ? errorEndIndex : outputEndIndex;
-                    byte[] currentBuffer = isError ? errorBuffer : outputBuffer;
+                    LineBuffer currentBuffer = isError ? errorBuffer : outputBuffer;
 
                     // Read data from the file descriptor
-                    int availableSpace = currentBuffer.Length - currentEndIndex;
+                    currentBuffer.EnsureFreeSpace();
                     nint bytesRead;
                     unsafe
                     {
-                        fixed (byte* bufferPtr = &currentBuffer[currentEndIndex])
+                        fixed (byte* bufferPtr = currentBuffer.FreeSpace)
                         {
-                            bytesRead = read(currentFd, bufferPtr, (nuint)availableSpace);
+                            bytesRead = read(currentFd, bufferPtr, (nuint)currentBuffer.FreeSpace.Length);
                         }
                     }
 
@@ -128,89 +124,28 @@ public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, I
 
                     if (bytesRead > 0)
                     {
-                        int remaining = (int)bytesRead + currentEndIndex - currentStartIndex;
-                        int startIndex = currentStartIndex;
-                        do
-                        {
-                            int lineEnd = currentBuffer.AsSpan(startIndex, remaining).IndexOf((byte)'\n');
-                            if (lineEnd == -1)
-                            {
-                                break;
-                            }
-
-                            // Handle both Unix (\n) and Windows (\r\n) line endings
-                            int contentLength = lineEnd;
-                            if (contentLength > 0 && currentBuffer[startIndex + contentLength - 1] == '\r')
-                            {
-                                contentLength--;
-                            }
-
-                            yield return new ProcessOutputLine(
-                                encoding.GetString(currentBuffer.AsSpan(startIndex, contentLength)),
-                                standardError: isError);
-
-                            startIndex += lineEnd + 1;
-                            remaining -= lineEnd + 1;
-                        } while (remaining > 0);
-
-                        currentStartIndex = startIndex;
-                        currentEndIndex = currentStartIndex + remaining;
-
-                        if (currentEndIndex == currentBuffer.Length)
-                        {
-                            if (remaining == currentBuffer.Length)
-                            {
-                                // The buffer is too small to hold a single line.
-                                if (isError)
-                                {
-                                    BufferHelper.RentLargerBuffer(ref errorBuffer);
-                                    currentBuffer = errorBuffer;
-                                }
-                                else
-                                {
-                                    BufferHelper.RentLargerBuffer(ref outputBuffer);
-                                    currentBuffer = outputBuffer;
-                                }
-                            }
-                            else
-                            {
-                                Buffer.BlockCopy(currentBuffer, currentStartIndex, currentBuffer, 0, remaining);
-                            }
-
-                            currentStartIndex = 0;
-                            currentEndIndex = remaining;
-                        }
+                        currentBuffer.Advance((int)bytesRead);
 
-                        if (isError)
-                        {
-                            errorStartIndex = currentStartIndex;
-                            errorEndIndex = currentEndIndex;
-                        }
-                        else
+                        while (currentBuffer.TryReadLine(out ReadOnlyMemory<byte> line))
                         {
-                            outputStartIndex = currentStartIndex;
-                            outputEndIndex = currentEndIndex;
+                            yield return new ProcessOutputLineView(line, isError, encoding);
                         }
                     }
                     else // EOF on this stream
                     {
                         // Return remaining characters (line without \n at the end)
-                        if (currentStartIndex != currentEndIndex)
+                        if (currentBuffer.TryReadRemaining(out ReadOnlyMemory<byte> line))
                         {
-                            yield return new ProcessOutputLine(
-                                encoding.GetString(currentBuffer, currentStartIndex, currentEndIndex - currentStartIndex),
-                                standardError: isError);
+                            yield return new ProcessOutputLineView(line, isError, encoding);
                         }
 
                         if (isError)
                         {
                             errorClosed = true;
-                            errorStartIndex = errorEndIndex = 0;
                         }
                         else
                         {
                             outputClosed = true;
-                            outputStartIndex = outputEndIndex = 0;
                         }
                     }
                 }
@@ -235,8 +170,8 @@ public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, I
             parentErrorHandle?.Dispose();
             childErrorHandle?.Dispose();
 
-            ArrayPool<byte>.Shared.Return(outputBuffer);
-            ArrayPool<byte>.Shared.Return(errorBuffer);
+            outputBuffer.Dispose();
+            errorBuffer.Dispose();
         }
     }
 }
\ No newline at end of file
@@ -13,47 +13,45 @@ namespace System.TBA;
 
 public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, IEnumerable<ProcessOutputLine>
 {
-    public IEnumerator<ProcessOutputLine> GetEnumerator()
+    private IEnumerable<ProcessOutputLineView> EnumerateLineViewsCore()
     {
         // NOTE: we could get current console Encoding here, it's omitted for the sake of simplicity of the proof of concept.
         Encoding encoding = _encoding ?? Encoding.UTF8;
         TimeoutHelper timeoutHelper = TimeoutHelper.Start(_timeout);
 
-        byte[] outputBuffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
-        byte[] errorBuffer = ArrayPool<byte>.Shared.Rent(BufferHelper.InitialRentedBufferSize);
-        int outputStartIndex = 0, outputEndIndex = 0;
-        int errorStartIndex = 0, errorEndIndex = 0;
+        LineBuffer outputBuffer = new();
+        LineBuffer errorBuffer = new();
 
         SafeFileHandle? parentOutputHandle = null, childOutputHandle = null, parentErrorHandle = null, childErrorHandle = null;
-        MemoryHandle outputPin = outputBuffer.AsMemory().Pin();
-        MemoryHandle errorPin = errorBuffer.AsMemory().Pin();
+        MemoryHandle outputPin = outputBuffer.Array.AsMemory().Pin();
+        MemoryHandle errorPin = errorBuffer.Array.AsMemory().Pin();
         try
         {
             using SafeFileHandle inputHandle = Console.OpenStandardInputHandle();
-            File.CreatePipe(out parentOutputHandle, out childOutputHandle, asyncRead: true);
+            File.CreatePipe(out parentOutputHandle, out childOutputHandle, asyncRead: true, capacity: _options.OutputPipeCapacity);
             File.CreatePipe(out parentErrorHandle, out childErrorHandle, asyncRead: true);
 
             using SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(_options, inputHandle, childOutputHandle, childErrorHandle);
-            using OverlappedContext outputContext = OverlappedContext.Allocate();
-            using OverlappedContext errorContext = OverlappedContext.Allocate();
+            using CompletionPortReactor.Group group = CompletionPortReactor.Instance.CreateGroup(operationCount: 2, processHandle: null);
+            group.Bind(parentOutputHandle);
+            group.Bind(parentErrorHandle);
 
             _processId = processHandle.ProcessId;
 
             // First of all, we need to drain STD OUT and ERR pipes.
             // We don't optimize for reading one (when other is closed).
             // This is a rare scenario, as they are usually both closed at the end of process lifetime.
-            WaitHandle[] waitHandles = [outputContext.WaitHandle, errorContext.WaitHandle];
 
             unsafe
             {
                 // Issue first reads.
-                Interop.Kernel32.ReadFile(parentOutputHandle, (byte*)outputPin.Pointer, outputBuffer.Length, IntPtr.Zero, outputContext.GetOverlapped());
-                Interop.Kernel32.ReadFile(parentErrorHandle, (byte*)errorPin.Pointer, errorBuffer.Length, IntPtr.Zero, errorContext.GetOverlapped());
+                group.Read(0, parentOutputHandle, (byte*)outputPin.Pointer, outputBuffer.Array.Length);
+                group.Read(1, parentErrorHandle, (byte*)errorPin.Pointer, errorBuffer.Array.Length);
             }
 
             while (!parentOutputHandle.IsClosed || !parentErrorHandle.IsClosed)
             {
-                int waitResult = WaitHandle.WaitAny(waitHandles, timeoutHelper.GetRemainingMillisecondsOrThrow());
+                int waitResult = group.WaitAny(timeoutHelper.GetRemainingMillisecondsOrThrow());
 
                 if (waitResult == WaitHandle.WaitTimeout)
                 {
@@ -65,110 +63,47 @@ public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, I
                 {
                     bool isError = waitResult == 1;
 
-                    OverlappedContext currentContext = isError ? errorContext : outputContext;
                     SafeFileHandle currentFileHandle = isError ? parentErrorHandle : parentOutputHandle;
-                    int currentStartIndex = isError ? errorStartIndex : outputStartIndex;
-                    int currentEndIndex = isError ? errorEndIndex : outputEndIndex;
-                    byte[] currentBuffer = isError ? errorBuffer : outputBuffer;
+                    LineBuffer currentBuffer = isError ? errorBuffer : outputBuffer;
 
-                    int bytesRead = currentContext.GetOverlappedResult(currentFileHandle);
+                    int bytesRead = group.GetResult(waitResult);
                     if (bytesRead > 0)
                     {
-                        int remaining = bytesRead + currentEndIndex - currentStartIndex;
-                        int startIndex = currentStartIndex;
-                        do
-                        {
-                            int lineEnd = currentBuffer.AsSpan(startIndex, remaining).IndexOf((byte)'\n');
-                            if (lineEnd == -1)
-                            {
-                                break;
-                            }
-
-                            yield return new ProcessOutputLine(
-                                encoding.GetString(currentBuffer.AsSpan(startIndex, lineEnd - 1)), // Exclude '\r'
-                                standardError: isError);
-
-                            startIndex += lineEnd + 1;
-                            remaining -= lineEnd + 1;
-                        } while (remaining > 0);
+                        currentBuffer.Advance(bytesRead);
 
-                        currentStartIndex = startIndex;
-                        currentEndIndex = currentStartIndex + remaining;
-
-                        if (currentEndIndex == currentBuffer.Length)
+                        while (currentBuffer.TryReadLine(out ReadOnlyMemory<byte> line))
                         {
-                            if (remaining == currentBuffer.Length)
-                            {
-                                // The buffer is too small to hold a single line.
-                                if (isError)
-                                {
-                                    errorPin.Dispose();
-                                    BufferHelper.RentLargerBuffer(ref errorBuffer);
-                                    currentBuffer = errorBuffer;
-                                    errorPin = errorBuffer.AsMemory().Pin();
-                                }
-                                else
-                                {
-                                    outputPin.Dispose();
-                                    BufferHelper.RentLargerBuffer(ref outputBuffer);
-                                    currentBuffer = outputBuffer;
-                                    outputPin = outputBuffer.AsMemory().Pin();
-                                }
-                            }
-                            else
-                            {
-                                Buffer.BlockCopy(currentBuffer, currentStartIndex, currentBuffer, 0, remaining);
-                            }
-
-                            currentStartIndex = 0;
-                            currentEndIndex = remaining;
+                            yield return new ProcessOutputLineView(line, isError, encoding);
                         }
 
-                        if (isError)
-                        {
-                            errorStartIndex = currentStartIndex;
-                            errorEndIndex = currentEndIndex;
-                        }
-                        else
+                        if (currentBuffer.EnsureFreeSpace())
                         {
-                            outputStartIndex = currentStartIndex;
-                            outputEndIndex = currentEndIndex;
+                            ref MemoryHandle currentPin = ref (isError ? ref errorPin : ref outputPin);
+                            currentPin.Dispose();
+                            currentPin = currentBuffer.Array.AsMemory().Pin();
                         }
 
                         unsafe
                         {
                             void* pinPointer = isError ? errorPin.Pointer : outputPin.Pointer;
-                            int sliceLength = currentBuffer.Length - currentEndIndex;
-                            byte* targetPointer = (byte*)pinPointer + currentEndIndex;
+                            int sliceLength = currentBuffer.Array.Length - currentBuffer.End;
+                            byte* targetPointer = (byte*)pinPointer + currentBuffer.End;
 
-                            Interop.Kernel32.ReadFile(currentFileHandle, targetPointer, sliceLength, IntPtr.Zero, currentContext.GetOverlapped());
+                            group.Read(waitResult, currentFileHandle, targetPointer, sliceLength);
                         }
                     }
                     else
                     {
                         // EOF: return remaining characters
-                        if (currentStartIndex != currentEndIndex)
+                        if (currentBuffer.TryReadRemaining(out ReadOnlyMemory<byte> line))
                         {
-                            yield return new ProcessOutputLine(
-                                encoding.GetString(currentBuffer, currentStartIndex, currentEndIndex - currentStartIndex),
-                                standardError: isError);
-
-                            if (isError)
-                            {
-                                errorStartIndex = errorEndIndex = 0;
-                            }
-                            else
-                            {
-                                outputStartIndex = outputEndIndex = 0;
-                            }
+                            yield return new ProcessOutputLineView(line, isError, encoding);
                         }
 
                         if (!currentFileHandle.IsClosed)
                         {
                             // Close the handle to stop further reads.
                             currentFileHandle.Close();
-                            // And reset the wait handle to avoid triggering on closed handle.
-                            currentContext.WaitHandle.Reset();
                         }
                     }
                 }
@@ -200,8 +135,8 @@ public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, I
             outputPin.Dispose();
             errorPin.Dispose();
 
-            ArrayPool<byte>.Shared.Return(outputBuffer);
-            ArrayPool<byte>.Shared.Return(errorBuffer);
+            outputBuffer.Dispose();
+            errorBuffer.Dispose();
         }
     }
 }
@@ -44,9 +44,9 @@ public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, I
     // Design: prevent the deadlocks: the user has to consume output lines, otherwise the process is not even started.
     public async IAsyncEnumerator<ProcessOutputLine> GetAsyncEnumerator(CancellationToken cancellationToken = default)
     {
-        // On Windows, we prefer async pipes to allow for 100% async reads.
-        File.CreatePipe(out SafeFileHandle parentOutputHandle, out SafeFileHandle childOutputHandle, asyncRead: OperatingSystem.IsWindows());
-        File.CreatePipe(out SafeFileHandle parentErrorHandle, out SafeFileHandle childErrorHandle, asyncRead: OperatingSystem.IsWindows());
+        // We prefer async pipes to allow for 100% async reads (on Unix they are driven by the shared reactor).
+        File.CreatePipe(out SafeFileHandle parentOutputHandle, out SafeFileHandle childOutputHandle, asyncRead: true, capacity: _options.OutputPipeCapacity);
+        File.CreatePipe(out SafeFileHandle parentErrorHandle, out SafeFileHandle childErrorHandle, asyncRead: true);
 
         using SafeFileHandle inputHandle = Console.OpenStandardInputHandle();
         using (parentOutputHandle)
@@ -59,8 +59,8 @@ public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, I
 
             // NOTE: we could get current console Encoding here, it's omitted for the sake of simplicity of the proof of concept.
             Encoding encoding = _encoding ?? Encoding.UTF8;
-            using StreamReader outputReader = new(StreamHelper.CreateReadStream(parentOutputHandle, cancellationToken), encoding);
-            using StreamReader errorReader = new(StreamHelper.CreateReadStream(parentErrorHandle, cancellationToken), encoding);
+            using StreamReader outputReader = new(StreamHelper.CreateReadStream(parentOutputHandle), encoding);
+            using StreamReader errorReader = new(StreamHelper.CreateReadStream(parentErrorHandle), encoding);
 
             Task<string?> readOutput = outputReader.ReadLineAsync(cancellationToken).AsTask();
             Task<string?> readError = errorReader.ReadLineAsync(cancellationToken).AsTask();
@@ -134,5 +134,19 @@ public partial class ProcessOutputLines : IAsyncEnumerable<ProcessOutputLine>, I
         }
     }
 
+    public IEnumerator<ProcessOutputLine> GetEnumerator()
+    {
+        foreach (ProcessOutputLineView line in EnumerateLineViewsCore())
+        {
+            yield return new ProcessOutputLine(line.GetText(), line.StandardError);
+        }
+    }
+
+    /// <summary>
+    /// Enumerates the output lines without allocating a <see cref="string"/> for every line.
+    /// </summary>
+    /// <remarks>Each line refers to a pooled buffer and is valid only until the enumerator moves to the next line.</remarks>
+    public IEnumerable<ProcessOutputLineView> EnumerateLineViews() => EnumerateLineViewsCore();
+
     IEnumerator IEnumerable.GetEnumerator() => GetEnumerator();
 }
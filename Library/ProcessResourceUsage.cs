@@ -0,0 +1,85 @@
+namespace System.TBA;
+
+/// <summary>
+/// The resources used by a process during its lifetime, as reported by the operating system when the process exited.
+/// </summary>
+/// <remarks>
+/// <para>On Unix, the values come from the rusage returned by wait4/waitid when the process was reaped,
+/// so they include the descendants the process has waited for.</para>
+/// <para>On Windows, the values come from GetProcessTimes, GetProcessMemoryInfo and GetProcessIoCounters
+/// and describe the process only.</para>
+/// </remarks>
+public sealed class ProcessResourceUsage
+{
+    public ProcessResourceUsage(
+        TimeSpan userProcessorTime,
+        TimeSpan privilegedProcessorTime,
+        long peakWorkingSet,
+        long voluntaryContextSwitches,
+        long involuntaryContextSwitches,
+        long readOperationCount,
+        long writeOperationCount)
+    {
+        UserProcessorTime = userProcessorTime;
+        PrivilegedProcessorTime = privilegedProcessorTime;
+        PeakWorkingSet = peakWorkingSet;
+        VoluntaryContextSwitches = voluntaryContextSwitches;
+        InvoluntaryContextSwitches = involuntaryContextSwitches;
+        ReadOperationCount = readOperationCount;
+        WriteOperationCount = writeOperationCount;
+    }
+
+    /// <summary>
+    /// Gets the time the process has spent running user code.
+    /// </summary>
+    public TimeSpan UserProcessorTime { get; }
+
+    /// <summary>
+    /// Gets the time the process has spent running kernel code.
+    /// </summary>
+    public TimeSpan PrivilegedProcessorTime { get; }
+
+    /// <summary>
+    /// Gets the total processor time of the process: <see cref="UserProcessorTime"/> + <see cref="PrivilegedProcessorTime"/>.
+    /// </summary>
+    public TimeSpan TotalProcessorTime => UserProcessorTime + PrivilegedProcessorTime;
+
+    /// <summary>
+    /// Gets the peak resident set size (working set) of the process, in bytes.
+    /// </summary>
+    public long PeakWorkingSet { get; }
+
+    /// <summary>
+    /// Gets the number of times the process gave up the processor voluntarily, usually to wait for I/O.
+    /// </summary>
+    /// <remarks>
+    /// This property is always 0 on Windows.
+    /// </remarks>
+    public long VoluntaryContextSwitches { get; }
+
+    /// <summary>
+    /// Gets the number of times the process was preempted by the scheduler.
+    /// </summary>
+    /// <remarks>
+    /// This property is always 0 on Windows.
+    /// </remarks>
+    public long InvoluntaryContextSwitches { get; }
+
+    /// <summary>
+    /// Gets the number of read operations performed by the process.
+    /// </summary>
+    /// <remarks>
+    /// On Unix, these are the block input operations (reads served by the page cache are not counted).
+    /// On Windows, these are all the read operations, including the ones on pipes.
+    /// </remarks>
+    public long ReadOperationCount { get; }
+
+    /// <summary>
+    /// Gets the number of write operations performed by the process.
+    /// </summary>
+    /// <remarks>
+    /// On Unix, these are the block output operations.
+    /// On Windows, these are all the write operations, including the ones on pipes.
+    /// </remarks>
+    public long WriteOperationCount { get; }
+}
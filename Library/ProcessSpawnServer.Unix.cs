@@ -0,0 +1,86 @@
+using System.ComponentModel;
+using System.Runtime.InteropServices;
+
+namespace System.TBA;
+
+public static partial class ProcessSpawnServer
+{
+    // The server is only supported on Linux, the other errno values are never needed elsewhere.
+    private const int E2BIG = 7, EPIPE = 32, ECONNRESET = 104;
+
+    private static int s_socket = -1;
+    private static int s_pid;
+
+    private static bool IsRunningCore => s_socket != -1;
+
+    private static bool StartCore()
+    {
+        if (spawn_server_start(out int socket, out int pid) != 0)
+        {
+            int errno = Marshal.GetLastPInvokeError();
+            return errno == ENOTSUP ? false : throw new Win32Exception(errno, "Failed to start the spawn server");
+        }
+
+        s_socket = socket;
+        s_pid = pid;
+        return true;
+    }
+
+    private static void StopCore()
+    {
+        if (s_socket != -1)
+        {
+            spawn_server_stop(s_socket, s_pid);
+            s_socket = -1;
+        }
+    }
+
+    // Returns false when the launch must be started directly: the server is not running, it's gone, or the request is too large.
+    // Otherwise, errorCode is 0 on success and the errno of the failure otherwise.
+    internal static unsafe bool TrySpawn(byte* resolvedPathPtr, byte** argvPtr, byte** envpPtr, byte* workingDirPtr,
+        int stdinFd, int stdoutFd, int stderrFd, bool createNewProcessGroup, bool detached,
+        out int pid, out int pidfd, out int errorCode)
+    {
+        pid = pidfd = errorCode = 0;
+
+        lock (s_lock)
+        {
+            if (s_socket == -1)
+            {
+                return false;
+            }
+
+            if (spawn_server_spawn(s_socket, resolvedPathPtr, argvPtr, envpPtr, stdinFd, stdoutFd, stderrFd, workingDirPtr,
+                createNewProcessGroup ? 1 : 0, detached ? 1 : 0, out pid, out pidfd) == 0)
+            {
+                return true;
+            }
+
+            errorCode = Marshal.GetLastPInvokeError();
+            switch (errorCode)
+            {
+                case E2BIG:
+                    return false;
+                case EPIPE or ECONNRESET:
+                    // The server has exited (or was killed), reap it and don't use it anymore
+                    StopCore();
+                    return false;
+                default:
+                    return true;
+            }
+        }
+    }
+
+    private static int ENOTSUP => OperatingSystem.IsLinux() ? 95 : 45;
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int spawn_server_start(out int socket, out int pid);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static unsafe partial int spawn_server_spawn(int socket, byte* path, byte** argv, byte** envp,
+        int stdin_fd, int stdout_fd, int stderr_fd, byte* working_dir, int create_new_process_group, int detached,
+        out int pid, out int pidfd);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int spawn_server_stop(int socket, int pid);
+}
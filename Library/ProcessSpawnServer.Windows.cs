@@ -0,0 +1,13 @@
+namespace System.TBA;
+
+public static partial class ProcessSpawnServer
+{
+    // CreateProcess does not copy the address space of the parent, so there is nothing to save.
+    private static bool IsRunningCore => false;
+
+    private static bool StartCore() => false;
+
+    private static void StopCore()
+    {
+    }
+}
@@ -0,0 +1,67 @@
+
+namespace System.TBA;
+
+/// <summary>
+/// A helper process that starts the child processes on behalf of the current process.
+/// </summary>
+/// <remarks>
+/// <para>
+/// Even with <c>vfork</c>-like primitives, starting a process from a process with a large heap has a cost that grows with the heap.
+/// The spawn server is forked once, ideally early at startup while the heap is still small, and then receives the launch requests
+/// over a Unix domain socket, together with the standard handles (SCM_RIGHTS).
+/// </para>
+/// <para>
+/// The children are still children of the current process (<c>CLONE_PARENT</c>): waiting for them, killing them
+/// and reading their exit status work exactly as for the processes started directly.
+/// </para>
+/// <para>
+/// While the server is running, it is used for every launch that is not suspended, does not use <see cref="ProcessStartOptions.KillOnParentExit"/>
+/// and does not inherit any handles; all the other launches are started directly. The requests are served one at a time.
+/// </para>
+/// <para>
+/// The spawn server is currently available only on Linux.
+/// </para>
+/// </remarks>
+public static partial class ProcessSpawnServer
+{
+    private static readonly object s_lock = new();
+
+    /// <summary>
+    /// Gets a value indicating whether the spawn server is running.
+    /// </summary>
+    public static bool IsRunning
+    {
+        get
+        {
+            lock (s_lock)
+            {
+                return IsRunningCore;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Starts the spawn server, if it's not running yet.
+    /// </summary>
+    /// <returns><see langword="true"/> if the spawn server is running; <see langword="false"/> if it's not supported on the current platform.</returns>
+    /// <exception cref="ComponentModel.Win32Exception">Thrown when the spawn server could not be started.</exception>
+    public static bool Start()
+    {
+        lock (s_lock)
+        {
+            return IsRunningCore || StartCore();
+        }
+    }
+
+    /// <summary>
+    /// Stops the spawn server and waits for it to exit. Does nothing if it's not running.
+    /// </summary>
+    /// <remarks>The processes started by the server are not affected.</remarks>
+    public static void Stop()
+    {
+        lock (s_lock)
+        {
+            StopCore();
+        }
+    }
+}
@@ -19,6 +19,9 @@ public sealed class ProcessStartOptions
     private IList<string>? _arguments;
     private Dictionary<string, string?>? _envVars;
     private IList<SafeHandle>? _inheritedHandles;
+    private int _outputPipeCapacity;
+    private int _maxOutputBytes;
+    private OutputLimitPolicy _outputLimitPolicy;
 
     // More or less same as ProcessStartInfo
     /// <summary>
@@ -87,6 +90,97 @@ public sealed class ProcessStartOptions
     /// </remarks>
     public bool CreateNewProcessGroup { get; set; }
 
+    /// <summary>
+    /// Gets or sets a value indicating whether the process and all its descendants are started in a new container,
+    /// so the whole tree can be terminated at once with <see cref="SafeChildProcessHandle.KillProcessTree"/>.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// On Linux, the process is started directly in a new cgroup v2 (<c>clone3</c> with <c>CLONE_INTO_CGROUP</c>), created in the cgroup
+    /// of the current process, which must be delegated to the current user (otherwise starting the process throws
+    /// <see cref="PlatformNotSupportedException"/>). Unlike a process group, no descendant can leave it,
+    /// not even the ones that call <c>setsid</c>. The cgroup is removed when the handle is disposed, once it's empty.
+    /// </para>
+    /// <para>
+    /// On Windows, the process is assigned to a new job object, as with <see cref="CreateNewProcessGroup"/>.
+    /// It's not supported on the other platforms.
+    /// </para>
+    /// </remarks>
+    public bool IsolateProcessTree { get; set; }
+
+    /// <summary>
+    /// Gets or sets the capacity, in bytes, of the pipe created for the standard output of the process,
+    /// or 0 (the default) to use the capacity chosen by the system.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// It applies to the pipes created by <see cref="SafeChildProcessHandle.StartPipeline"/> between the stages
+    /// and to the standard output pipes created by the <see cref="ChildProcess"/> methods that capture or stream the output.
+    /// A larger capacity lets a child that writes at a high rate (a decompressor, for example) run longer before it blocks on a full pipe.
+    /// Either way, the synchronous capture loops on Linux double the capacity each time they drain a full pipe, up to 1 MB.
+    /// </para>
+    /// <para>
+    /// On Linux, it's set with <c>F_SETPIPE_SZ</c> and rounded up by the kernel to a power of two number of pages.
+    /// It's best effort: unprivileged processes can't exceed <c>/proc/sys/fs/pipe-max-size</c>.
+    /// On Windows, it's passed to <c>CreatePipe</c> as a suggestion. It's ignored on the other platforms.
+    /// </para>
+    /// </remarks>
+    /// <exception cref="ArgumentOutOfRangeException">Thrown when the value is negative.</exception>
+    public int OutputPipeCapacity
+    {
+        get => _outputPipeCapacity;
+        set
+        {
+            ArgumentOutOfRangeException.ThrowIfNegative(value);
+            _outputPipeCapacity = value;
+        }
+    }
+
+    /// <summary>
+    /// Gets or sets the maximum number of bytes kept by the <see cref="ChildProcess"/> methods that capture the output,
+    /// or 0 (the default) to keep all of it.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// It applies to each captured stream: standard output and error for <see cref="ChildProcess.CaptureOutput"/> and <see cref="ChildProcess.CaptureOutputBytes"/>,
+    /// the combined output for <see cref="ChildProcess.CaptureCombined"/>, and their asynchronous versions.
+    /// The bytes over the limit are still read, so the process never blocks on a full pipe, but they are not kept:
+    /// the memory used stays proportional to the limit, whatever the process writes.
+    /// </para>
+    /// <para>
+    /// <see cref="OutputLimitPolicy"/> selects which bytes are kept, the number of the dropped ones is reported with the output.
+    /// The kept bytes are not aligned on characters or lines, the decoded text may start or end with a replacement character.
+    /// </para>
+    /// </remarks>
+    /// <exception cref="ArgumentOutOfRangeException">Thrown when the value is negative.</exception>
+    public int MaxOutputBytes
+    {
+        get => _maxOutputBytes;
+        set
+        {
+            ArgumentOutOfRangeException.ThrowIfNegative(value);
+            _maxOutputBytes = value;
+        }
+    }
+
+    /// <summary>
+    /// Gets or sets which part of the output is kept when it exceeds <see cref="MaxOutputBytes"/>.
+    /// The default is <see cref="OutputLimitPolicy.KeepHead"/>.
+    /// </summary>
+    /// <exception cref="ArgumentOutOfRangeException">Thrown when the value is not defined.</exception>
+    public OutputLimitPolicy OutputLimitPolicy
+    {
+        get => _outputLimitPolicy;
+        set
+        {
+            if (!Enum.IsDefined(value))
+            {
+                throw new ArgumentOutOfRangeException(nameof(value));
+            }
+            _outputLimitPolicy = value;
+        }
+    }
+
     // Internal property to check if environment was explicitly set
     internal bool HasEnvironmentBeenAccessed => _envVars != null;
 
@@ -113,6 +207,41 @@ public sealed class ProcessStartOptions
         IsFileNameResolved = isResolved;
     }
 
+    /// <summary>
+    /// Creates a copy of the options with the file name resolved, used to keep a snapshot that is not affected by later changes.
+    /// </summary>
+    internal ProcessStartOptions CreateResolvedCopy()
+    {
+        ProcessStartOptions copy = new(IsFileNameResolved ? _fileName : ResolvePathInternal(_fileName), isResolved: true)
+        {
+            WorkingDirectory = WorkingDirectory,
+            CreateNoWindow = CreateNoWindow,
+            KillOnParentExit = KillOnParentExit,
+            CreateNewProcessGroup = CreateNewProcessGroup,
+            IsolateProcessTree = IsolateProcessTree,
+            OutputPipeCapacity = OutputPipeCapacity,
+            MaxOutputBytes = MaxOutputBytes,
+            OutputLimitPolicy = OutputLimitPolicy,
+        };
+
+        if (_arguments is not null)
+        {
+            copy._arguments = new List<string>(_arguments);
+        }
+
+        if (_envVars is not null)
+        {
+            copy._envVars = new Dictionary<string, string?>(_envVars);
+        }
+
+        if (_inheritedHandles is not null)
+        {
+            copy._inheritedHandles = new List<SafeHandle>(_inheritedHandles);
+        }
+
+        return copy;
+    }
+
     private static Dictionary<string, string?> CreateEnvironmentCopy()
     {
         Dictionary<string, string?> envDict = new();
@@ -148,6 +277,12 @@ public sealed class ProcessStartOptions
             return fileName;
         }
 
+        return ExecutablePathCache.Resolve(fileName, ProbeSearchLocations);
+    }
+
+    // Returns null when the file could not be found in any of the search locations.
+    private static string? ProbeSearchLocations(string fileName)
+    {
 #if WINDOWS
         // From: https://learn.microsoft.com/en-us/windows/win32/api/processthreadsapi/nf-processthreadsapi-createprocessw
         // "If the file name does not contain an extension, .exe is appended.
@@ -229,7 +364,7 @@ public sealed class ProcessStartOptions
         return System.Environment.ProcessPath;
     }
 
-    private static string FindProgramInPath(string fileName)
+    private static string? FindProgramInPath(string fileName)
     {
         string? pathEnvVar = System.Environment.GetEnvironmentVariable("PATH");
         if (pathEnvVar is not null)
@@ -251,7 +386,7 @@ public sealed class ProcessStartOptions
             }
         }
 
-        throw new FileNotFoundException("Could not resolve the file.", fileName);
+        return null;
     }
 
     private static bool IsExecutableFile(string path)
@@ -1,4 +1,5 @@
 using System;
+using System.Buffers;
 using System.Collections.Generic;
 using System.ComponentModel;
 using System.Diagnostics.CodeAnalysis;
@@ -21,6 +22,12 @@ public partial class SafeChildProcessHandle
 {
     internal const int NoPidFd = -1;
 
+    // The cgroup of the process tree, when started with IsolateProcessTree (Linux only).
+    private ControlGroup? _controlGroup;
+    // Only the children started by this library are reaped in the background (ReapAbandonedProcesses), and only when not reaped already.
+    private bool _startedByUs;
+    private bool _reaped;
+
     private SafeChildProcessHandle(int pidfd, int pid)
         : this(existingHandle: (IntPtr)pidfd, ownsHandle: true)
     {
@@ -29,6 +36,17 @@ public partial class SafeChildProcessHandle
 
     protected override bool ReleaseHandle()
     {
+        ChildProcessTelemetry.ProcessReleased(this);
+        _controlGroup?.Dispose();
+
+        // The reactor takes the ownership of the process descriptor. It may run on the finalizer thread,
+        // so the reactor is created when the process is started, not here.
+        if (ReapAbandonedProcesses && _startedByUs && !_reaped
+            && ProcessReactor.TryGetExistingInstance(this, out ProcessReactor? reactor) && reactor.TryReapWhenExited((int)this.handle, ProcessId))
+        {
+            return true;
+        }
+
         return (int)this.handle switch
         {
             NoPidFd => true,
@@ -38,13 +56,17 @@ public partial class SafeChildProcessHandle
 
     private static SafeChildProcessHandle StartCore(ProcessStartOptions options, SafeFileHandle inputHandle, SafeFileHandle outputHandle, SafeFileHandle errorHandle, bool createSuspended, bool detached)
     {
-        // Resolve executable path first
-        string? resolvedPath = options.IsFileNameResolved ? options.FileName : ProcessStartOptions.ResolvePathInternal(options.FileName);
-        if (string.IsNullOrEmpty(resolvedPath))
+        long timestamp = ChildProcessTelemetry.GetStartTimestamp();
+
+        if (ReapAbandonedProcesses)
         {
-            throw new Win32Exception(2, $"Cannot find executable: {options.FileName}");
+            ProcessReactor.EnsureInitialized();
         }
 
+        // Resolve executable path first
+        string resolvedPath = ResolveExecutablePath(options);
+        timestamp = ChildProcessTelemetry.RecordPhase(ChildProcessTelemetry.ResolvePathPhase, timestamp);
+
         // Prepare arguments array (argv)
         string[] argv = [resolvedPath, .. options.Arguments];
 
@@ -57,11 +79,11 @@ public partial class SafeChildProcessHandle
         int stdOutFd = (int)outputHandle.DangerousGetHandle();
         int stdErrFd = (int)errorHandle.DangerousGetHandle();
 
-        return StartProcessInternal(resolvedPath, argv, envp, options, stdInFd, stdOutFd, stdErrFd, createSuspended, detached);
+        return StartProcessInternal(resolvedPath, argv, envp, options, stdInFd, stdOutFd, stdErrFd, createSuspended, detached, timestamp);
     }
 
     private static unsafe SafeChildProcessHandle StartProcessInternal(string resolvedPath, string[] argv, string[]? envp,
-        ProcessStartOptions options, int stdinFd, int stdoutFd, int stderrFd, bool createSuspended, bool detached)
+        ProcessStartOptions options, int stdinFd, int stdoutFd, int stderrFd, bool createSuspended, bool detached, long timestamp)
     {
         // Allocate native memory BEFORE forking
         byte* resolvedPathPtr = UnixHelpers.AllocateNullTerminatedUtf8String(resolvedPath);
@@ -93,32 +115,14 @@ public partial class SafeChildProcessHandle
                 }
             }
 
-            // Call native library to spawn process
+            timestamp = ChildProcessTelemetry.RecordPhase(ChildProcessTelemetry.MarshalArgumentsPhase, timestamp);
+
             // Pass null for envpPtr if environment wasn't accessed (native code will use environ)
-            int result = spawn_process(
-                resolvedPathPtr,
-                argvPtr,
-                envpPtr,
-                stdinFd,
-                stdoutFd,
-                stderrFd,
-                workingDirPtr,
-                out int pid,
-                out int pidfd,
-                options.KillOnParentExit ? 1 : 0,
-                createSuspended ? 1 : 0,
-                options.CreateNewProcessGroup ? 1 : 0,
-                detached ? 1 : 0,
-                inheritedHandlesPtr,
-                inheritedHandlesCount);
-
-            if (result == -1)
-            {
-                int errorCode = Marshal.GetLastPInvokeError();
-                throw new Win32Exception(errorCode, "Failed to spawn process");
-            }
+            SafeChildProcessHandle processHandle = Spawn(resolvedPathPtr, argvPtr, envpPtr, workingDirPtr, inheritedHandlesPtr, inheritedHandlesCount,
+                options, stdinFd, stdoutFd, stderrFd, createSuspended, detached);
 
-            return new SafeChildProcessHandle(pidfd, pid);
+            ChildProcessTelemetry.RecordPhase(ChildProcessTelemetry.SpawnPhase, timestamp);
+            return processHandle;
         }
         finally
         {
@@ -131,35 +135,247 @@ public partial class SafeChildProcessHandle
         }
     }
 
-    private bool TryGetExitCodeCore(out int exitCode, out PosixSignal? signal)
+    // Calls the native library to spawn the process, all the strings and arrays must already be in native memory.
+    internal static unsafe SafeChildProcessHandle Spawn(byte* resolvedPathPtr, byte** argvPtr, byte** envpPtr, byte* workingDirPtr,
+        int* inheritedHandlesPtr, int inheritedHandlesCount, ProcessStartOptions options, int stdinFd, int stdoutFd, int stderrFd,
+        bool createSuspended, bool detached)
+    {
+        if (!createSuspended && !options.KillOnParentExit && !options.IsolateProcessTree && inheritedHandlesCount == 0
+            && ProcessSpawnServer.TrySpawn(resolvedPathPtr, argvPtr, envpPtr, workingDirPtr, stdinFd, stdoutFd, stderrFd,
+                options.CreateNewProcessGroup, detached, out int serverPid, out int serverPidfd, out int serverError))
+        {
+            return serverError == 0
+                ? new SafeChildProcessHandle(serverPidfd, serverPid) { _startedByUs = true }
+                : throw new Win32Exception(serverError, "Failed to spawn process");
+        }
+
+        ControlGroup? controlGroup = options.IsolateProcessTree ? ControlGroup.Create() : null;
+
+        int result = spawn_process(
+            resolvedPathPtr,
+            argvPtr,
+            envpPtr,
+            stdinFd,
+            stdoutFd,
+            stderrFd,
+            workingDirPtr,
+            out int pid,
+            out int pidfd,
+            options.KillOnParentExit ? 1 : 0,
+            createSuspended ? 1 : 0,
+            options.CreateNewProcessGroup ? 1 : 0,
+            detached ? 1 : 0,
+            inheritedHandlesPtr,
+            inheritedHandlesCount,
+            controlGroup?.DirectoryFd ?? -1,
+            process_group_id: 0);
+
+        if (result == -1)
+        {
+            int errorCode = Marshal.GetLastPInvokeError();
+            controlGroup?.Dispose();
+            throw new Win32Exception(errorCode, "Failed to spawn process");
+        }
+
+        return new SafeChildProcessHandle(pidfd, pid) { _controlGroup = controlGroup, _startedByUs = true };
+    }
+
+    private static string ResolveExecutablePath(ProcessStartOptions options)
+    {
+        string? resolvedPath = options.IsFileNameResolved ? options.FileName : ProcessStartOptions.ResolvePathInternal(options.FileName);
+        if (string.IsNullOrEmpty(resolvedPath))
+        {
+            throw new Win32Exception(2, $"Cannot find executable: {options.FileName}");
+        }
+
+        return resolvedPath;
+    }
+
+    private static SafeChildProcessHandle[] StartManyCore(ReadOnlySpan<ProcessStartOptions> options, SafeFileHandle inputHandle, SafeFileHandle outputHandle, SafeFileHandle errorHandle)
+        => SpawnMany(options, inputHandle, outputHandle, errorHandle, pipeline: false, createNewProcessGroup: false);
+
+    private static SafeChildProcessHandle[] StartPipelineCore(ReadOnlySpan<ProcessStartOptions> stages, SafeFileHandle inputHandle, SafeFileHandle outputHandle, SafeFileHandle errorHandle, bool createNewProcessGroup)
+        => SpawnMany(stages, inputHandle, outputHandle, errorHandle, pipeline: true, createNewProcessGroup);
+
+    // When pipeline is set, the native code connects the stages with pipes: only the first stage reads inputHandle
+    // and only the last one writes to outputHandle.
+    private static unsafe SafeChildProcessHandle[] SpawnMany(ReadOnlySpan<ProcessStartOptions> options, SafeFileHandle inputHandle, SafeFileHandle outputHandle, SafeFileHandle errorHandle, bool pipeline, bool createNewProcessGroup)
     {
-        signal = null;
-        if (try_get_exit_code(this, ProcessId, out exitCode, out int rawSignal) != -1)
+        int count = options.Length;
+
+        if (ReapAbandonedProcesses)
+        {
+            ProcessReactor.EnsureInitialized();
+        }
+
+        // Resolve all the paths before spawning anything, so a typo in one of the commands does not leave the others running.
+        string[] resolvedPaths = new string[count];
+        for (int i = 0; i < count; i++)
+        {
+            resolvedPaths[i] = ResolveExecutablePath(options[i]);
+        }
+
+        int stdInFd = (int)inputHandle.DangerousGetHandle();
+        int stdOutFd = (int)outputHandle.DangerousGetHandle();
+        int stdErrFd = (int)errorHandle.DangerousGetHandle();
+
+        // Allocate native memory BEFORE forking.
+        // Zeroed, so the finally block can free partially initialized requests.
+        SpawnRequest* requests = (SpawnRequest*)NativeMemory.AllocZeroed((nuint)count, (nuint)sizeof(SpawnRequest));
+        int* pids = (int*)NativeMemory.Alloc((nuint)count, (nuint)sizeof(int));
+        int* pidfds = (int*)NativeMemory.Alloc((nuint)count, (nuint)sizeof(int));
+        int* errors = (int*)NativeMemory.Alloc((nuint)count, (nuint)sizeof(int));
+        int* pipeCapacities = pipeline ? (int*)NativeMemory.Alloc((nuint)count, (nuint)sizeof(int)) : null;
+        int[] argvLengths = new int[count];
+        int[] envpLengths = new int[count];
+        ControlGroup?[] controlGroups = new ControlGroup?[count];
+
+        try
+        {
+            for (int i = 0; i < count; i++)
+            {
+                ProcessStartOptions startOptions = options[i];
+                ref SpawnRequest request = ref requests[i];
+
+                string[] argv = [resolvedPaths[i], .. startOptions.Arguments];
+                argvLengths[i] = argv.Length;
+                UnixHelpers.AllocNullTerminatedArray(argv, ref request.argv);
+
+                // Pass null for envp if environment wasn't accessed (native code will use environ)
+                if (startOptions.HasEnvironmentBeenAccessed)
+                {
+                    string[] envp = UnixHelpers.GetEnvironmentVariables(startOptions);
+                    envpLengths[i] = envp.Length;
+                    UnixHelpers.AllocNullTerminatedArray(envp, ref request.envp);
+                }
+
+                if (startOptions.HasInheritedHandlesBeenAccessed && startOptions.InheritedHandles.Count > 0)
+                {
+                    request.inherited_handles_count = startOptions.InheritedHandles.Count;
+                    request.inherited_handles = (int*)NativeMemory.Alloc((nuint)request.inherited_handles_count, (nuint)sizeof(int));
+
+                    for (int j = 0; j < request.inherited_handles_count; j++)
+                    {
+                        request.inherited_handles[j] = (int)startOptions.InheritedHandles[j].DangerousGetHandle();
+                    }
+                }
+
+                request.path = UnixHelpers.AllocateNullTerminatedUtf8String(resolvedPaths[i]);
+                request.working_dir = UnixHelpers.AllocateNullTerminatedUtf8String(startOptions.WorkingDirectory);
+                request.stdin_fd = stdInFd;
+                request.stdout_fd = stdOutFd;
+                request.stderr_fd = stdErrFd;
+                request.kill_on_parent_death = startOptions.KillOnParentExit ? 1 : 0;
+                request.create_new_process_group = startOptions.CreateNewProcessGroup ? 1 : 0;
+                request.cgroup_fd = -1;
+
+                if (pipeline)
+                {
+                    pipeCapacities[i] = startOptions.OutputPipeCapacity;
+                }
+
+                if (startOptions.IsolateProcessTree)
+                {
+                    controlGroups[i] = ControlGroup.Create();
+                    request.cgroup_fd = controlGroups[i]!.DirectoryFd;
+                }
+            }
+
+            int started = pipeline
+                ? spawn_pipeline(requests, count, pipeCapacities, createNewProcessGroup ? 1 : 0, pids, pidfds, errors)
+                : spawn_processes(requests, count, pids, pidfds, errors);
+
+            SafeChildProcessHandle?[] handles = new SafeChildProcessHandle?[count];
+            int firstFailure = -1;
+            for (int i = 0; i < count; i++)
+            {
+                if (errors[i] == 0)
+                {
+                    handles[i] = new SafeChildProcessHandle(pidfds[i], pids[i]) { _controlGroup = controlGroups[i], _startedByUs = true };
+                    controlGroups[i] = null;
+                }
+                else if (firstFailure == -1)
+                {
+                    firstFailure = i;
+                }
+            }
+
+            if (started != count)
+            {
+                KillAndReap(handles);
+                throw new Win32Exception(errors[firstFailure], $"Failed to spawn process {options[firstFailure].FileName}");
+            }
+
+            return handles!;
+        }
+        finally
         {
-            if (rawSignal != 0)
+            // Free memory - ONLY parent reaches here (child called _exit or execve)
+            for (int i = 0; i < count; i++)
             {
-                signal = (PosixSignal)rawSignal;
+                ref SpawnRequest request = ref requests[i];
+
+                UnixHelpers.FreePointer(request.path);
+                UnixHelpers.FreePointer(request.working_dir);
+                UnixHelpers.FreeArray(request.envp, envpLengths[i]);
+                UnixHelpers.FreeArray(request.argv, argvLengths[i]);
+                NativeMemory.Free(request.inherited_handles);
+
+                // The cgroups of the processes that were not started.
+                controlGroups[i]?.Dispose();
             }
+
+            NativeMemory.Free(requests);
+            NativeMemory.Free(pids);
+            NativeMemory.Free(pidfds);
+            NativeMemory.Free(errors);
+            NativeMemory.Free(pipeCapacities);
+        }
+    }
+
+    private bool TryGetExitStatusCore(bool canceled, [NotNullWhen(true)] out ProcessExitStatus? exitStatus)
+    {
+        if (try_get_exit_code(this, ProcessId, out int exitCode, out int rawSignal, out ResourceUsage usage) != -1)
+        {
+            exitStatus = CreateExitStatus(exitCode, canceled, rawSignal, in usage);
             return true;
         }
+
+        exitStatus = null;
         return false;
     }
 
+    private ProcessExitStatus CreateExitStatus(int exitCode, bool canceled, int rawSignal, in ResourceUsage usage)
+    {
+        ProcessExitStatus exitStatus = new(exitCode, canceled, rawSignal != 0 ? (PosixSignal)rawSignal : null, new ProcessResourceUsage(
+            TimeSpan.FromMicroseconds(usage.user_time_us),
+            TimeSpan.FromMicroseconds(usage.system_time_us),
+            usage.max_rss_bytes,
+            usage.voluntary_context_switches,
+            usage.involuntary_context_switches,
+            usage.block_input_operations,
+            usage.block_output_operations));
+
+        _reaped = true;
+        ChildProcessTelemetry.ProcessExited(this, exitStatus);
+        return exitStatus;
+    }
+
     private ProcessExitStatus WaitForExitCore()
     {
-        switch (wait_for_exit_and_reap(this, ProcessId, out int exitCode, out int rawSignal))
+        switch (wait_for_exit_and_reap(this, ProcessId, out int exitCode, out int rawSignal, out ResourceUsage usage))
         {
             case -1:
                 int errno = Marshal.GetLastPInvokeError();
                 throw new Win32Exception(errno, $"wait_for_exit_and_reap() failed with (errno={errno})");
             default:
-                return new(exitCode, false, rawSignal != 0 ? (PosixSignal)rawSignal : null);
+                return CreateExitStatus(exitCode, false, rawSignal, in usage);
         }
     }
 
     private bool TryWaitForExitCore(int milliseconds, [NotNullWhen(true)] out ProcessExitStatus? exitStatus)
     {
-        switch (try_wait_for_exit(this, ProcessId, milliseconds, out int exitCode, out int rawSignal, out int hasTimedout))
+        switch (try_wait_for_exit(this, ProcessId, milliseconds, out int exitCode, out int rawSignal, out ResourceUsage usage))
         {
             case -1:
                 int errno = Marshal.GetLastPInvokeError();
@@ -168,26 +384,79 @@ public partial class SafeChildProcessHandle
                 exitStatus = null;
                 return false;
             default:
-                exitStatus = new(exitCode, false, rawSignal != 0 ? (PosixSignal)rawSignal : null);
+                exitStatus = CreateExitStatus(exitCode, false, rawSignal, in usage);
                 return true;
         }
     }
 
+    private static unsafe int WaitAnyCore(ReadOnlySpan<SafeChildProcessHandle> handles, int milliseconds)
+    {
+        int count = handles.Length;
+        // The process descriptors followed by the process IDs.
+        int[] descriptors = ArrayPool<int>.Shared.Rent(count * 2);
+        int referenced = 0;
+
+        try
+        {
+            for (; referenced < count; referenced++)
+            {
+                // Keep the descriptors alive for as long as they are waited for.
+                bool refAdded = false;
+                handles[referenced].DangerousAddRef(ref refAdded);
+
+                descriptors[referenced] = (int)handles[referenced].DangerousGetHandle();
+                descriptors[count + referenced] = handles[referenced].ProcessId;
+            }
+
+            fixed (int* pidfds = descriptors)
+            {
+                switch (wait_for_any_exit(pidfds, pidfds + count, count, milliseconds, out int index))
+                {
+                    case -1:
+                        int errno = Marshal.GetLastPInvokeError();
+                        throw new Win32Exception(errno, $"wait_for_any_exit() failed with (errno={errno})");
+                    case 1: // timeout
+                        return -1;
+                    default:
+                        return index;
+                }
+            }
+        }
+        finally
+        {
+            for (int i = 0; i < referenced; i++)
+            {
+                handles[i].DangerousRelease();
+            }
+
+            ArrayPool<int>.Shared.Return(descriptors);
+        }
+    }
+
     private ProcessExitStatus WaitForExitOrKillOnTimeoutCore(int milliseconds)
     {
-        switch (wait_for_exit_or_kill_on_timeout(this, ProcessId, milliseconds, out int exitCode, out int rawSignal, out int hasTimedout))
+        switch (wait_for_exit_or_kill_on_timeout(this, ProcessId, milliseconds, out int exitCode, out int rawSignal, out int hasTimedout, out ResourceUsage usage))
         {
             case -1:
                 int errno = Marshal.GetLastPInvokeError();
                 throw new Win32Exception(errno, $"wait_for_exit_or_kill_on_timeout() failed with (errno={errno})");
             default:
-                return new(exitCode, hasTimedout == 1, rawSignal != 0 ? (PosixSignal)rawSignal : null);
+                return CreateExitStatus(exitCode, hasTimedout == 1, rawSignal, in usage);
         }
     }
 
-    // After the code is moved to dotnet/runtime, it's going to use kqeue and epoll and the sockets thread to optimize perf and resources
+    // The async waits are served by a single process-wide epoll/kqueue thread (ProcessReactor).
+    // Blocking a thread pool thread per wait is used only when process exits can't be monitored that way (Linux without pidfd).
     private async Task<ProcessExitStatus> WaitForExitAsyncCore(CancellationToken cancellationToken)
     {
+        if (ProcessReactor.TryGetInstance(this, out ProcessReactor? reactor))
+        {
+            await reactor.WaitForExitAsync(this, cancellationToken).ConfigureAwait(false);
+
+            // The process has already exited, so reaping it does not block.
+            return WaitForExitCore();
+        }
+
         if (!cancellationToken.CanBeCanceled)
         {
             return await Task.Run(() => WaitForExitCore(), cancellationToken).ConfigureAwait(false);
@@ -205,7 +474,7 @@ public partial class SafeChildProcessHandle
 
             return await Task.Run(() =>
             {
-                switch (try_wait_for_exit_cancellable(this, ProcessId, (int)readHandle.DangerousGetHandle(), out int exitCode, out int rawSignal))
+                switch (try_wait_for_exit_cancellable(this, ProcessId, (int)readHandle.DangerousGetHandle(), out int exitCode, out int rawSignal, out ResourceUsage usage))
                 {
                     case -1:
                         int errno = Marshal.GetLastPInvokeError();
@@ -213,7 +482,7 @@ public partial class SafeChildProcessHandle
                     case 1: // canceled
                         throw new OperationCanceledException(cancellationToken);
                     default:
-                        return new ProcessExitStatus(exitCode, false, rawSignal != 0 ? (PosixSignal)rawSignal : null);
+                        return CreateExitStatus(exitCode, false, rawSignal, in usage);
                 }
             }, cancellationToken);
         }
@@ -221,6 +490,23 @@ public partial class SafeChildProcessHandle
 
     private async Task<ProcessExitStatus> WaitForExitOrKillOnCancellationAsyncCore(CancellationToken cancellationToken)
     {
+        if (ProcessReactor.TryGetInstance(this, out ProcessReactor? reactor))
+        {
+            bool wasKilled = false;
+            try
+            {
+                await reactor.WaitForExitAsync(this, cancellationToken).ConfigureAwait(false);
+            }
+            catch (OperationCanceledException) when (cancellationToken.IsCancellationRequested)
+            {
+                wasKilled = KillCore(throwOnError: false);
+                await reactor.WaitForExitAsync(this, CancellationToken.None).ConfigureAwait(false);
+            }
+
+            ProcessExitStatus status = WaitForExitCore();
+            return new ProcessExitStatus(status.ExitCode, wasKilled, status.Signal, status.ResourceUsage);
+        }
+
         if (!cancellationToken.CanBeCanceled)
         {
             return await Task.Run(() => WaitForExitCore(), cancellationToken).ConfigureAwait(false);
@@ -238,7 +524,7 @@ public partial class SafeChildProcessHandle
 
             return await Task.Run(() =>
             {
-                switch (try_wait_for_exit_cancellable(this, ProcessId, (int)readHandle.DangerousGetHandle(), out int exitCode, out int rawSignal))
+                switch (try_wait_for_exit_cancellable(this, ProcessId, (int)readHandle.DangerousGetHandle(), out int exitCode, out int rawSignal, out ResourceUsage usage))
                 {
                     case -1:
                         int errno = Marshal.GetLastPInvokeError();
@@ -246,9 +532,9 @@ public partial class SafeChildProcessHandle
                     case 1: // canceled
                         bool wasKilled = KillCore(throwOnError: false);
                         ProcessExitStatus status = WaitForExitCore();
-                        return new ProcessExitStatus(status.ExitCode, wasKilled, status.Signal);
+                        return new ProcessExitStatus(status.ExitCode, wasKilled, status.Signal, status.ResourceUsage);
                     default:
-                        return new ProcessExitStatus(exitCode, false, rawSignal != 0 ? (PosixSignal)rawSignal : null);
+                        return CreateExitStatus(exitCode, false, rawSignal, in usage);
                 }
             }, cancellationToken);
         }
@@ -281,6 +567,16 @@ public partial class SafeChildProcessHandle
         throw new Win32Exception(errno, $"Failed to terminate process (errno={errno})");
     }
 
+    private bool KillProcessTreeCore()
+    {
+        if (_controlGroup is null)
+        {
+            throw new InvalidOperationException("Cannot terminate the process tree because the process was not started with IsolateProcessTree=true.");
+        }
+
+        return _controlGroup.Kill();
+    }
+
     private void SendSignalCore(PosixSignal signal, bool entireProcessGroup)
     {
         // If entireProcessGroup is true, send to -pid (negative pid), dont't use pidfd.
@@ -332,25 +628,68 @@ public partial class SafeChildProcessHandle
         int create_new_process_group,
         int detached,
         int* inherited_handles,
-        int inherited_handles_count);
+        int inherited_handles_count,
+        int cgroup_fd,
+        int process_group_id);
+
+    // Must match spawn_request in pal_process.c
+    [StructLayout(LayoutKind.Sequential)]
+    private unsafe struct SpawnRequest
+    {
+        public byte* path;
+        public byte** argv;
+        public byte** envp;
+        public int stdin_fd;
+        public int stdout_fd;
+        public int stderr_fd;
+        public byte* working_dir;
+        public int kill_on_parent_death;
+        public int create_new_process_group;
+        public int* inherited_handles;
+        public int inherited_handles_count;
+        public int cgroup_fd;
+        public int process_group_id;
+    }
+
+    // Must match process_usage in pal_process.c
+    [StructLayout(LayoutKind.Sequential)]
+    private struct ResourceUsage
+    {
+        public long user_time_us;
+        public long system_time_us;
+        public long max_rss_bytes;
+        public long voluntary_context_switches;
+        public long involuntary_context_switches;
+        public long block_input_operations;
+        public long block_output_operations;
+    }
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static unsafe partial int spawn_processes(SpawnRequest* requests, int count, int* pids, int* pidfds, int* errors);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static unsafe partial int spawn_pipeline(SpawnRequest* requests, int count, int* pipe_capacities, int create_process_group, int* pids, int* pidfds, int* errors);
 
     [LibraryImport("pal_process", SetLastError = true)]
     private static partial int send_signal(int pidfd, int pid, PosixSignal managed_signal);
 
     [LibraryImport("pal_process", SetLastError = true)]
-    private static partial int wait_for_exit_and_reap(SafeChildProcessHandle pidfd, int pid, out int exitCode, out int signal);
+    private static partial int wait_for_exit_and_reap(SafeChildProcessHandle pidfd, int pid, out int exitCode, out int signal, out ResourceUsage usage);
+
+    [LibraryImport("pal_process", SetLastError = true)]
+    private static partial int try_wait_for_exit(SafeChildProcessHandle pidfd, int pid, int timeout_ms, out int exitCode, out int signal, out ResourceUsage usage);
 
     [LibraryImport("pal_process", SetLastError = true)]
-    private static partial int try_wait_for_exit(SafeChildProcessHandle pidfd, int pid, int timeout_ms, out int exitCode, out int signal, out int hasTimedout);
+    private static unsafe partial int wait_for_any_exit(int* pidfds, int* pids, int count, int timeout_ms, out int index);
 
     [LibraryImport("pal_process", SetLastError = true)]
-    private static partial int try_wait_for_exit_cancellable(SafeChildProcessHandle pidfd, int pid, int cancelPipeFd, out int exitCode, out int signal);
+    private static partial int try_wait_for_exit_cancellable(SafeChildProcessHandle pidfd, int pid, int cancelPipeFd, out int exitCode, out int signal, out ResourceUsage usage);
 
     [LibraryImport("pal_process", SetLastError = true)]
-    private static partial int wait_for_exit_or_kill_on_timeout(SafeChildProcessHandle pidfd, int pid, int timeout_ms, out int exitCode, out int signal, out int hasTimedout);
+    private static partial int wait_for_exit_or_kill_on_timeout(SafeChildProcessHandle pidfd, int pid, int timeout_ms, out int exitCode, out int signal, out int hasTimedout, out ResourceUsage usage);
 
     [LibraryImport("pal_process", SetLastError = true)]
-    private static partial int try_get_exit_code(SafeChildProcessHandle pidfd, int pid, out int exitCode, out int signal);
+    private static partial int try_get_exit_code(SafeChildProcessHandle pidfd, int pid, out int exitCode, out int signal, out ResourceUsage usage);
 
     [LibraryImport("pal_process", SetLastError = true)]
     private static partial int open_process(int pid, out int out_pidfd);
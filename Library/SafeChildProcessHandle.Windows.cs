@@ -13,6 +13,9 @@ namespace Microsoft.Win32.SafeHandles;
 
 public partial class SafeChildProcessHandle
 {
+    // The maximum number of objects WaitForMultipleObjects can wait for.
+    private const int MaxWaitHandles = 64;
+
     // Static job object used for KillOnParentExit functionality
     // All child processes with KillOnParentExit=true are assigned to this job
     // Note: The job handle is intentionally never closed - it should live for the
@@ -66,6 +69,8 @@ public partial class SafeChildProcessHandle
 
     protected override bool ReleaseHandle()
     {
+        ChildProcessTelemetry.ProcessReleased(this);
+
         // Close the thread handle if it exists (for suspended processes)
         if (_threadHandle != IntPtr.Zero)
         {
@@ -97,20 +102,151 @@ public partial class SafeChildProcessHandle
         return exitCode;
     }
 
-    private bool TryGetExitCodeCore(out int exitCode, out PosixSignal? signal)
+    private bool TryGetExitStatusCore(bool canceled, [NotNullWhen(true)] out ProcessExitStatus? exitStatus)
+    {
+        if (Interop.Kernel32.GetExitCodeProcess(this, out int exitCode)
+            && exitCode != Interop.Kernel32.HandleOptions.STILL_ACTIVE)
+        {
+            exitStatus = new(exitCode, canceled, resourceUsage: GetResourceUsage());
+            ChildProcessTelemetry.ProcessExited(this, exitStatus);
+            return true;
+        }
+
+        exitStatus = null;
+        return false;
+    }
+
+    private ProcessExitStatus CreateExitStatus(bool canceled)
     {
-        signal = default;
+        ProcessExitStatus exitStatus = new(GetExitCode(), canceled, resourceUsage: GetResourceUsage());
+        ChildProcessTelemetry.ProcessExited(this, exitStatus);
+        return exitStatus;
+    }
+
+    // The process has exited, so its counters are final. Windows does not count the context switches per process.
+    private unsafe ProcessResourceUsage? GetResourceUsage()
+    {
+        Interop.Kernel32.PROCESS_MEMORY_COUNTERS memoryCounters = default;
+        memoryCounters.cb = (uint)sizeof(Interop.Kernel32.PROCESS_MEMORY_COUNTERS);
+
+        if (!Interop.Kernel32.GetProcessTimes(this, out _, out _, out long kernelTime, out long userTime)
+            || !Interop.Kernel32.GetProcessMemoryInfo(this, ref memoryCounters, memoryCounters.cb)
+            || !Interop.Kernel32.GetProcessIoCounters(this, out Interop.Kernel32.IO_COUNTERS ioCounters))
+        {
+            return null;
+        }
+
+        return new(
+            TimeSpan.FromTicks(userTime),
+            TimeSpan.FromTicks(kernelTime),
+            (long)(nuint)memoryCounters.PeakWorkingSetSize,
+            voluntaryContextSwitches: 0,
+            involuntaryContextSwitches: 0,
+            (long)ioCounters.ReadOperationCount,
+            (long)ioCounters.WriteOperationCount);
+    }
+
+    private static SafeChildProcessHandle[] StartManyCore(ReadOnlySpan<ProcessStartOptions> options, SafeFileHandle inputHandle, SafeFileHandle outputHandle, SafeFileHandle errorHandle)
+    {
+        // CreateProcess has no batch equivalent, so the processes are started one by one.
+        SafeChildProcessHandle[] handles = new SafeChildProcessHandle[options.Length];
+        int started = 0;
+
+        try
+        {
+            for (; started < options.Length; started++)
+            {
+                handles[started] = StartCore(options[started], inputHandle, outputHandle, errorHandle, createSuspended: false, detached: false);
+            }
+        }
+        catch
+        {
+            KillAndReap(handles.AsSpan(0, started));
+            throw;
+        }
 
-        return Interop.Kernel32.GetExitCodeProcess(this, out exitCode)
-            && exitCode != Interop.Kernel32.HandleOptions.STILL_ACTIVE;
+        return handles;
     }
 
-    private static unsafe SafeChildProcessHandle StartCore(ProcessStartOptions options, SafeFileHandle inputHandle, SafeFileHandle outputHandle, SafeFileHandle errorHandle, bool createSuspended, bool detached)
+    private static SafeChildProcessHandle[] StartPipelineCore(ReadOnlySpan<ProcessStartOptions> stages, SafeFileHandle inputHandle, SafeFileHandle outputHandle, SafeFileHandle errorHandle, bool createNewProcessGroup)
     {
+        // CreateProcess has no batch equivalent, so the stages are started one by one,
+        // each one with the read end of the pipe written by the previous one.
+        SafeChildProcessHandle[] handles = new SafeChildProcessHandle[stages.Length];
+        SafeFileHandle stageInput = inputHandle;
+        int started = 0;
+
+        try
+        {
+            for (; started < stages.Length; started++)
+            {
+                SafeFileHandle? nextInput = null, stageOutput = null;
+                if (started < stages.Length - 1)
+                {
+                    Interop.Kernel32.SECURITY_ATTRIBUTES securityAttributes = default;
+                    if (!Interop.Kernel32.CreatePipe(out nextInput, out stageOutput, ref securityAttributes, stages[started].OutputPipeCapacity))
+                    {
+                        throw new Win32Exception();
+                    }
+                }
+
+                try
+                {
+                    handles[started] = StartCore(stages[started], stageInput, stageOutput ?? outputHandle, errorHandle, createSuspended: false, detached: false, createNewProcessGroup);
+                }
+                catch
+                {
+                    nextInput?.Dispose();
+                    throw;
+                }
+                finally
+                {
+                    // The child has its own copies now, EOF propagates from one stage to the next as they exit.
+                    stageOutput?.Dispose();
+                    if (stageInput != inputHandle)
+                    {
+                        stageInput.Dispose();
+                    }
+                }
+
+                stageInput = nextInput ?? inputHandle;
+            }
+        }
+        catch
+        {
+            KillAndReap(handles.AsSpan(0, started));
+            throw;
+        }
+
+        return handles;
+    }
+
+    internal static SafeChildProcessHandle StartCore(ProcessStartOptions options, SafeFileHandle inputHandle, SafeFileHandle outputHandle, SafeFileHandle errorHandle, bool createSuspended, bool detached, bool createNewProcessGroup = false)
+    {
+        long timestamp = ChildProcessTelemetry.GetStartTimestamp();
         ValueStringBuilder applicationName = new(stackalloc char[256]);
         ValueStringBuilder commandLine = new(stackalloc char[256]);
         ProcessUtils.BuildArgs(options, ref applicationName, ref commandLine);
 
+        string? environmentBlock = options.HasEnvironmentBeenAccessed
+            ? ProcessUtils.GetEnvironmentVariablesBlock(options.Environment)
+            : null;
+
+        return StartCore(options, applicationName.AsSpan(0, applicationName.Length + 1), ref commandLine, environmentBlock,
+            inputHandle, outputHandle, errorHandle, createSuspended, detached, createNewProcessGroup, timestamp);
+    }
+
+    /// <summary>
+    /// Starts the process with a command line and an environment block that have already been built (by <see cref="ProcessLaunchTemplate"/>).
+    /// </summary>
+    /// <param name="applicationName">The null-terminated path of the application.</param>
+    /// <param name="commandLine">The null-terminated command line. CreateProcess can modify it, so it must not be shared.</param>
+    /// <param name="environmentBlock">The environment block, or <see langword="null"/> to inherit the environment of the current process.</param>
+    internal static unsafe SafeChildProcessHandle StartCore(ProcessStartOptions options, ReadOnlySpan<char> applicationName, ref ValueStringBuilder commandLine, string? environmentBlock,
+        SafeFileHandle inputHandle, SafeFileHandle outputHandle, SafeFileHandle errorHandle, bool createSuspended, bool detached, bool createNewProcessGroup, long timestamp)
+    {
+        bool newProcessGroup = options.CreateNewProcessGroup || createNewProcessGroup;
+
         Interop.Kernel32.STARTUPINFOEX startupInfoEx = default;
         Interop.Kernel32.PROCESS_INFORMATION processInfo = default;
         Interop.Kernel32.SECURITY_ATTRIBUTES unused_SecAttrs = default;
@@ -152,9 +288,9 @@ public partial class SafeChildProcessHandle
 
             PrepareHandleAllowList(options, handlesToInherit, ref handleCount, inputPtr, outputPtr, errorPtr);
 
-            // Create a job object if CreateNewProcessGroup is requested or if detached
+            // Create a job object if CreateNewProcessGroup or IsolateProcessTree is requested or if detached
             // This must happen before starting the process to ensure atomicity
-            if (options.CreateNewProcessGroup || detached)
+            if (newProcessGroup || options.IsolateProcessTree || detached)
             {
                 processGroupJobHandle = Interop.Kernel32.CreateJobObjectW(IntPtr.Zero, IntPtr.Zero);
                 if (processGroupJobHandle == IntPtr.Zero)
@@ -165,7 +301,7 @@ public partial class SafeChildProcessHandle
 
             // Determine number of attributes we need
             int attributeCount = 1; // Always need handle list
-            if (options.KillOnParentExit || options.CreateNewProcessGroup || detached)
+            if (options.KillOnParentExit || newProcessGroup || options.IsolateProcessTree || detached)
                 attributeCount++; // Required for PROC_THREAD_ATTRIBUTE_JOB_LIST
 
             // Initialize the attribute list
@@ -197,7 +333,7 @@ public partial class SafeChildProcessHandle
                 throw new Win32Exception();
             }
 
-            if (options.KillOnParentExit || options.CreateNewProcessGroup || detached)
+            if (options.KillOnParentExit || newProcessGroup || options.IsolateProcessTree || detached)
             {
                 IntPtr* pJobHandle = stackalloc IntPtr[2];
                 int jobsCount = 0;
@@ -205,7 +341,7 @@ public partial class SafeChildProcessHandle
                 // The parent job must be added first!
                 if (options.KillOnParentExit)
                     pJobHandle[jobsCount++] = s_killOnParentExitJob.Value;
-                if (options.CreateNewProcessGroup || detached)
+                if (newProcessGroup || options.IsolateProcessTree || detached)
                     pJobHandle[jobsCount++] = processGroupJobHandle;
 
                 if (!Interop.Kernel32.UpdateProcThreadAttribute(
@@ -231,21 +367,22 @@ public partial class SafeChildProcessHandle
             int creationFlags = Interop.Kernel32.EXTENDED_STARTUPINFO_PRESENT;
             if (options.CreateNoWindow) creationFlags |= Interop.Advapi32.StartupInfoOptions.CREATE_NO_WINDOW;
             if (createSuspended) creationFlags |= Interop.Advapi32.StartupInfoOptions.CREATE_SUSPENDED;
-            if (options.CreateNewProcessGroup || detached) creationFlags |= Interop.Advapi32.StartupInfoOptions.CREATE_NEW_PROCESS_GROUP;
+            if (newProcessGroup || detached) creationFlags |= Interop.Advapi32.StartupInfoOptions.CREATE_NEW_PROCESS_GROUP;
             if (detached) creationFlags |= Interop.Advapi32.StartupInfoOptions.DETACHED_PROCESS;
 
-            string? environmentBlock = null;
-            if (options.HasEnvironmentBeenAccessed)
+            if (environmentBlock is not null)
             {
                 creationFlags |= Interop.Advapi32.StartupInfoOptions.CREATE_UNICODE_ENVIRONMENT;
-                environmentBlock = ProcessUtils.GetEnvironmentVariablesBlock(options.Environment);
             }
 
             string? workingDirectory = options.WorkingDirectory;
             int errorCode = 0;
 
+            // The path is resolved by BuildArgs, so it's a part of this phase.
+            timestamp = ChildProcessTelemetry.RecordPhase(ChildProcessTelemetry.MarshalArgumentsPhase, timestamp);
+
             fixed (char* environmentBlockPtr = environmentBlock)
-            fixed (char* applicationNamePtr = &applicationName.GetPinnableReference())
+            fixed (char* applicationNamePtr = applicationName)
             fixed (char* commandLinePtr = &commandLine.GetPinnableReference())
             {
                 bool retVal = Interop.Kernel32.CreateProcess(
@@ -264,6 +401,8 @@ public partial class SafeChildProcessHandle
                     errorCode = Marshal.GetLastPInvokeError();
             }
 
+            ChildProcessTelemetry.RecordPhase(ChildProcessTelemetry.SpawnPhase, timestamp);
+
             if (processInfo.hProcess != IntPtr.Zero && processInfo.hProcess != new IntPtr(-1))
             {
                 // If the process was created suspended, keep the thread handle for later resumption
@@ -395,7 +534,7 @@ public partial class SafeChildProcessHandle
         using Interop.Kernel32.ProcessWaitHandle processWaitHandle = new(this);
         processWaitHandle.WaitOne(Timeout.Infinite);
 
-        return new(GetExitCode(), false);
+        return CreateExitStatus(false);
     }
 
     private bool TryWaitForExitCore(int milliseconds, [NotNullWhen(true)] out ProcessExitStatus? exitStatus)
@@ -407,10 +546,71 @@ public partial class SafeChildProcessHandle
             return false;
         }
 
-        exitStatus = new(GetExitCode(), false);
+        exitStatus = CreateExitStatus(false);
         return true;
     }
 
+    private static int WaitAnyCore(ReadOnlySpan<SafeChildProcessHandle> handles, int milliseconds)
+    {
+        Interop.Kernel32.ProcessWaitHandle[] waitHandles = new Interop.Kernel32.ProcessWaitHandle[handles.Length];
+
+        try
+        {
+            for (int i = 0; i < handles.Length; i++)
+            {
+                waitHandles[i] = new(handles[i]);
+            }
+
+            if (waitHandles.Length <= MaxWaitHandles)
+            {
+                int index = WaitHandle.WaitAny(waitHandles, milliseconds);
+                return index == WaitHandle.WaitTimeout ? -1 : index;
+            }
+
+            return WaitAnyRegistered(waitHandles, milliseconds);
+        }
+        finally
+        {
+            foreach (Interop.Kernel32.ProcessWaitHandle? waitHandle in waitHandles)
+            {
+                waitHandle?.Dispose();
+            }
+        }
+    }
+
+    // WaitForMultipleObjects is limited to 64 handles: the thread pool spreads the registered waits over its wait threads, 63 handles per thread.
+    private static int WaitAnyRegistered(Interop.Kernel32.ProcessWaitHandle[] waitHandles, int milliseconds)
+    {
+        TaskCompletionSource<int> firstExited = new(TaskCreationOptions.RunContinuationsAsynchronously);
+        RegisteredWaitHandle?[] registrations = new RegisteredWaitHandle?[waitHandles.Length];
+
+        try
+        {
+            for (int i = 0; i < waitHandles.Length; i++)
+            {
+                registrations[i] = ThreadPool.RegisterWaitForSingleObject(
+                    waitHandles[i],
+                    static (state, timedOut) =>
+                    {
+                        (TaskCompletionSource<int> tcs, int index) = ((TaskCompletionSource<int>, int))state!;
+                        tcs.TrySetResult(index);
+                    },
+                    (firstExited, i),
+                    Timeout.Infinite,
+                    executeOnlyOnce: true);
+            }
+
+            return firstExited.Task.Wait(milliseconds) ? firstExited.Task.Result : -1;
+        }
+        finally
+        {
+            foreach (RegisteredWaitHandle? registration in registrations)
+            {
+                registration?.Unregister(null);
+            }
+        }
+    }
+
     private ProcessExitStatus WaitForExitOrKillOnTimeoutCore(int milliseconds)
     {
         bool wasKilledOnTimeout = false;
@@ -420,7 +620,7 @@ public partial class SafeChildProcessHandle
             wasKilledOnTimeout = KillCore(throwOnError: false);
         }
 
-        return new(GetExitCode(), wasKilledOnTimeout);
+        return CreateExitStatus(wasKilledOnTimeout);
     }
 
     private async Task<ProcessExitStatus> WaitForExitAsyncCore(CancellationToken cancellationToken)
@@ -460,7 +660,7 @@ public partial class SafeChildProcessHandle
             registeredWaitHandle?.Unregister(null);
         }
 
-        return new(GetExitCode(), false);
+        return CreateExitStatus(false);
     }
 
     private async Task<ProcessExitStatus> WaitForExitOrKillOnCancellationAsyncCore(CancellationToken cancellationToken)
@@ -502,7 +702,7 @@ public partial class SafeChildProcessHandle
             registeredWaitHandle?.Unregister(null);
         }
 
-        return new(GetExitCode(), wasKilledBox.Value);
+        return CreateExitStatus(wasKilledBox.Value);
     }
 
     /// <summary>
@@ -532,6 +732,17 @@ public partial class SafeChildProcessHandle
         };
     }
 
+    private bool KillProcessTreeCore()
+    {
+        // The descendants are in the job of the process, unless they were started with CREATE_BREAKAWAY_FROM_JOB.
+        if (_processGroupJobHandle == IntPtr.Zero)
+        {
+            throw new InvalidOperationException("Cannot terminate the process tree because the process was not started with IsolateProcessTree=true.");
+        }
+
+        return KillCore(throwOnError: true, entireProcessGroup: true);
+    }
+
     private void ResumeCore()
     {
         if (_threadHandle == IntPtr.Zero)
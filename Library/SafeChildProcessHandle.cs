@@ -1,8 +1,11 @@
 using System;
+using System.Collections.Generic;
 using System.Diagnostics.CodeAnalysis;
 using System.IO;
+using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 using System.Threading;
+using System.Threading.Channels;
 using System.Threading.Tasks;
 using System.TBA;
 using PosixSignal = System.TBA.PosixSignal;
@@ -16,6 +19,10 @@ public sealed partial class SafeChildProcessHandle : SafeHandle
 {
     internal static readonly SafeChildProcessHandle InvalidHandle = new();
 
+    // Used by ChildProcessTelemetry, only when there is a listener.
+    internal long StartTimestamp;
+    internal int TelemetryFlags;
+
     /// <summary>
     /// Creates a <see cref="T:Microsoft.Win32.SafeHandles.SafeChildProcessHandle" />.
     /// </summary>
@@ -45,6 +52,22 @@ public sealed partial class SafeChildProcessHandle : SafeHandle
     /// </summary>
     public int ProcessId { get; init; }
 
+    /// <summary>
+    /// Gets or sets a value indicating whether the processes started by this library are reaped in the background
+    /// when their handle is released before their exit status was retrieved, as with <see cref="ChildProcess.FireAndForget"/>.
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// On Unix, a child process that exits stays a zombie, holding its process ID and its process table entry, until its parent waits for it.
+    /// When enabled, the process exit is monitored by the same epoll/kqueue thread that serves the async waits, and the exited processes
+    /// are reaped in batches. Only the processes started by this library are reaped, each one on its own: the children of other code
+    /// in the process are never waited for. On Linux, it requires process descriptors (pidfd, kernel 5.3 or later), without them
+    /// abandoned processes are not reaped.
+    /// </para>
+    /// <para>It has no effect on Windows, where exited processes don't need to be reaped. It's disabled by default.</para>
+    /// </remarks>
+    public static bool ReapAbandonedProcesses { get; set; }
+
     /// <summary>
     /// Creates a <see cref="T:Microsoft.Win32.SafeHandles.SafeChildProcessHandle" /> around a process handle.
     /// </summary>
@@ -145,33 +168,223 @@ public sealed partial class SafeChildProcessHandle : SafeHandle
             error ??= nullHandle;
         }
 
+        long timestamp = ChildProcessTelemetry.GetStartTimestamp();
+        ChildProcessTelemetry.SpawnStarting(options.FileName, timestamp);
+
         try
         {
-            return StartCore(options, input, output, error, createSuspended, detached);
+            SafeChildProcessHandle processHandle = StartCore(options, input, output, error, createSuspended, detached);
+            ChildProcessTelemetry.ProcessStarted(processHandle, timestamp);
+            return processHandle;
+        }
+        catch (Exception exception)
+        {
+            ChildProcessTelemetry.SpawnFailed(options.FileName, exception);
+            throw;
         }
         finally
         {
-            // DESIGN: avoid deadlocks and the need of users being aware of how pipes work by closing the child handles in the parent process.
-            // Close the child handles in the parent process, so the pipe will signal EOF when the child exits.
-            // Otherwise, the parent process will keep the write end of the pipe open, and any read operations will hang.
-            
-            // Track which handles we've already disposed to avoid double-disposal when the same handle is used for multiple streams
-            bool outputDisposed = false;
-            
-            if (output.IsPipe())
-            {
-                output.Dispose();
-                outputDisposed = true;
-            }
+            DisposeChildPipeHandles(output, error);
+
+            nullHandle?.Dispose();
+        }
+    }
+
+    /// <summary>
+    /// Starts a batch of new processes that share the same standard handles.
+    /// </summary>
+    /// <param name="options">The start options of the processes to start.</param>
+    /// <param name="input">The handle to use for standard input of every process, or <see langword="null"/> to provide no input.</param>
+    /// <param name="output">The handle to use for standard output of every process, or <see langword="null"/> to discard output.</param>
+    /// <param name="error">The handle to use for standard error of every process, or <see langword="null"/> to discard error.</param>
+    /// <returns>The handles to the started processes, in the same order as <paramref name="options"/>.</returns>
+    /// <exception cref="ArgumentNullException">Thrown when any element of <paramref name="options"/> is null.</exception>
+    /// <exception cref="Win32Exception">Thrown when any of the processes could not be started.</exception>
+    /// <remarks>
+    /// <para>
+    /// The batch is all-or-nothing: when any of the processes fails to start, the processes that were started
+    /// are killed and reaped before the exception is thrown.
+    /// </para>
+    /// <para>
+    /// On Linux and other Unix systems that use fork/exec, the signal mask and the pipe used to report exec failures
+    /// are set up once for the whole batch and all exec results are collected together.
+    /// On Windows and macOS, the processes are started one by one.
+    /// </para>
+    /// </remarks>
+    public static SafeChildProcessHandle[] StartMany(ReadOnlySpan<ProcessStartOptions> options, SafeFileHandle? input, SafeFileHandle? output, SafeFileHandle? error)
+    {
+        foreach (ProcessStartOptions startOptions in options)
+        {
+            ArgumentNullException.ThrowIfNull(startOptions, nameof(options));
+        }
+
+        if (options.IsEmpty)
+        {
+            return [];
+        }
+
+        SafeFileHandle? nullHandle = null;
+
+        if (input is null || output is null || error is null)
+        {
+            nullHandle = File.OpenNullFileHandle();
+
+            input ??= nullHandle;
+            output ??= nullHandle;
+            error ??= nullHandle;
+        }
+
+        long timestamp = StartingMany(options);
+
+        try
+        {
+            return StartedMany(StartManyCore(options, input, output, error), timestamp);
+        }
+        catch (Exception exception)
+        {
+            FailedMany(options, exception);
+            throw;
+        }
+        finally
+        {
+            DisposeChildPipeHandles(output, error);
+
+            nullHandle?.Dispose();
+        }
+    }
+
+    /// <summary>
+    /// Starts a pipeline of processes, where the standard output of every stage is connected to the standard input of the next one
+    /// (<c>stage1 | stage2 | stage3</c>).
+    /// </summary>
+    /// <param name="stages">The start options of the stages, in pipeline order.</param>
+    /// <param name="input">The handle to use for standard input of the first stage, or <see langword="null"/> to provide no input.</param>
+    /// <param name="output">The handle to use for standard output of the last stage, or <see langword="null"/> to discard output.</param>
+    /// <param name="error">The handle to use for standard error of every stage, or <see langword="null"/> to discard error.</param>
+    /// <param name="createNewProcessGroup">Whether all the stages are started in a single new process group, led by the first stage,
+    /// so they can be killed together with <see cref="KillProcessGroup"/> on the handle of the first stage.</param>
+    /// <returns>The handles to the started processes, in the same order as <paramref name="stages"/>.</returns>
+    /// <exception cref="ArgumentNullException">Thrown when any element of <paramref name="stages"/> is null.</exception>
+    /// <exception cref="Win32Exception">Thrown when any of the stages could not be started.</exception>
+    /// <remarks>
+    /// <para>
+    /// The pipes between the stages are created and closed by the library, the data flows from one process to the next
+    /// without going through the current process. The capacity of the pipe after a stage is its <see cref="ProcessStartOptions.OutputPipeCapacity"/>.
+    /// Like <see cref="StartMany"/>, the pipeline is all-or-nothing.
+    /// </para>
+    /// <para>
+    /// On Unix, the pipes are created and all the stages are spawned by a single native call.
+    /// On Windows, the stages are started one by one and, when <paramref name="createNewProcessGroup"/> is set,
+    /// each stage gets its own process group (job object), so each of them has to be killed with <see cref="KillProcessGroup"/>.
+    /// </para>
+    /// </remarks>
+    public static SafeChildProcessHandle[] StartPipeline(ReadOnlySpan<ProcessStartOptions> stages, SafeFileHandle? input, SafeFileHandle? output, SafeFileHandle? error, bool createNewProcessGroup = false)
+    {
+        foreach (ProcessStartOptions startOptions in stages)
+        {
+            ArgumentNullException.ThrowIfNull(startOptions, nameof(stages));
+        }
+
+        if (stages.IsEmpty)
+        {
+            return [];
+        }
+
+        SafeFileHandle? nullHandle = null;
+
+        if (input is null || output is null || error is null)
+        {
+            nullHandle = File.OpenNullFileHandle();
+
+            input ??= nullHandle;
+            output ??= nullHandle;
+            error ??= nullHandle;
+        }
+
+        long timestamp = StartingMany(stages);
+
+        try
+        {
+            return StartedMany(StartPipelineCore(stages, input, output, error, createNewProcessGroup), timestamp);
+        }
+        catch (Exception exception)
+        {
+            FailedMany(stages, exception);
+            throw;
+        }
+        finally
+        {
+            DisposeChildPipeHandles(output, error);
+
+            nullHandle?.Dispose();
+        }
+    }
+
+    private static long StartingMany(ReadOnlySpan<ProcessStartOptions> options)
+    {
+        long timestamp = ChildProcessTelemetry.GetStartTimestamp();
+        foreach (ProcessStartOptions startOptions in options)
+        {
+            ChildProcessTelemetry.SpawnStarting(startOptions.FileName, timestamp);
+        }
+        return timestamp;
+    }
+
+    private static SafeChildProcessHandle[] StartedMany(SafeChildProcessHandle[] handles, long timestamp)
+    {
+        foreach (SafeChildProcessHandle processHandle in handles)
+        {
+            ChildProcessTelemetry.ProcessStarted(processHandle, timestamp);
+        }
+        return handles;
+    }
+
+    private static void FailedMany(ReadOnlySpan<ProcessStartOptions> options, Exception exception)
+    {
+        foreach (ProcessStartOptions startOptions in options)
+        {
+            ChildProcessTelemetry.SpawnFailed(startOptions.FileName, exception);
+        }
+    }
+
+    internal static void DisposeChildPipeHandles(SafeFileHandle output, SafeFileHandle error)
+    {
+        // DESIGN: avoid deadlocks and the need of users being aware of how pipes work by closing the child handles in the parent process.
+        // Close the child handles in the parent process, so the pipe will signal EOF when the child exits.
+        // Otherwise, the parent process will keep the write end of the pipe open, and any read operations will hang.
+
+        // Track which handles we've already disposed to avoid double-disposal when the same handle is used for multiple streams
+        bool outputDisposed = false;
+
+        if (output.IsPipe())
+        {
+            output.Dispose();
+            outputDisposed = true;
+        }
 
-            // Only dispose error if it's a pipe and it's not the same underlying handle as output
-            // Compare the actual handle values, not just reference equality, since different SafeFileHandle instances can wrap the same handle
-            if (error.IsPipe() && (!outputDisposed || error.DangerousGetHandle() != output.DangerousGetHandle()))
+        // Only dispose error if it's a pipe and it's not the same underlying handle as output
+        // Compare the actual handle values, not just reference equality, since different SafeFileHandle instances can wrap the same handle
+        if (error.IsPipe() && (!outputDisposed || error.DangerousGetHandle() != output.DangerousGetHandle()))
+        {
+            error.Dispose();
+        }
+    }
+
+    /// <summary>
+    /// Used to honor the all-or-nothing contract of <see cref="StartMany"/> and <see cref="StartPipeline"/> when some of the processes failed to start.
+    /// </summary>
+    private static void KillAndReap(ReadOnlySpan<SafeChildProcessHandle?> started)
+    {
+        foreach (SafeChildProcessHandle? handle in started)
+        {
+            if (handle is null)
             {
-                error.Dispose();
+                continue;
             }
 
-            nullHandle?.Dispose();
+            handle.KillCore(throwOnError: false);
+            handle.WaitForExitCore();
+            handle.Dispose();
         }
     }
 
@@ -255,6 +468,131 @@ public sealed partial class SafeChildProcessHandle : SafeHandle
         return WaitForExitOrKillOnCancellationAsyncCore(cancellationToken);
     }
 
+    /// <summary>
+    /// Waits for any of the processes to exit within the specified timeout.
+    /// </summary>
+    /// <param name="handles">The handles of the processes to wait for.</param>
+    /// <param name="timeout">The maximum time to wait for any of the processes to exit.</param>
+    /// <returns>The index of a process that has exited, or -1 if none of them exited before the timeout.</returns>
+    /// <exception cref="ArgumentException">Thrown when <paramref name="handles"/> is empty.</exception>
+    /// <exception cref="ArgumentNullException">Thrown when any element of <paramref name="handles"/> is null.</exception>
+    /// <exception cref="InvalidOperationException">Thrown when any of the handles is invalid.</exception>
+    /// <remarks>
+    /// <para>
+    /// The process is not reaped: <see cref="WaitForExit"/> returns its exit status immediately. Like a signaled <see cref="WaitHandle"/>,
+    /// a process that has exited keeps being reported, so it should be removed from <paramref name="handles"/> before waiting again.
+    /// </para>
+    /// <para>
+    /// All the processes are waited for by a single kernel wait: poll on the process descriptors on Linux, a kqueue (EVFILT_PROC) on macOS and FreeBSD,
+    /// WaitForMultipleObjects on Windows (up to 64 processes, the thread pool wait threads spread the waits over more of them otherwise).
+    /// </para>
+    /// </remarks>
+    public static int WaitAny(ReadOnlySpan<SafeChildProcessHandle> handles, TimeSpan timeout)
+    {
+        if (handles.IsEmpty)
+        {
+            throw new ArgumentException("At least one process handle is required.", nameof(handles));
+        }
+
+        ValidateMany(handles);
+
+        return WaitAnyCore(handles, GetTimeoutInMilliseconds(timeout));
+    }
+
+    /// <summary>
+    /// Waits for all the processes to exit within the specified timeout.
+    /// </summary>
+    /// <param name="handles">The handles of the processes to wait for.</param>
+    /// <param name="timeout">The maximum time to wait for all the processes to exit.</param>
+    /// <returns>true if all the processes exited before the timeout; otherwise, false.</returns>
+    /// <exception cref="ArgumentNullException">Thrown when any element of <paramref name="handles"/> is null.</exception>
+    /// <exception cref="InvalidOperationException">Thrown when any of the handles is invalid.</exception>
+    /// <remarks>
+    /// The processes are not reaped, see <see cref="WaitAny"/>. Every exit is observed by a single kernel wait for all the processes that are still running.
+    /// </remarks>
+    public static bool WaitAll(ReadOnlySpan<SafeChildProcessHandle> handles, TimeSpan timeout)
+    {
+        ValidateMany(handles);
+
+        SafeChildProcessHandle[] pending = handles.ToArray();
+        int count = pending.Length;
+        TimeoutHelper timeoutHelper = TimeoutHelper.Start(timeout);
+
+        while (count > 0)
+        {
+            int index = WaitAnyCore(pending.AsSpan(0, count), timeoutHelper.GetRemainingMilliseconds());
+            if (index == -1)
+            {
+                return false;
+            }
+
+            pending[index] = pending[--count];
+        }
+
+        return true;
+    }
+
+    /// <summary>
+    /// Waits asynchronously for all the processes to exit and reports their exit status in the order they exit.
+    /// </summary>
+    /// <param name="handles">The handles of the processes to wait for.</param>
+    /// <param name="cancellationToken">A cancellation token that can be used to cancel the wait operations.</param>
+    /// <returns>The handles and the exit status of the processes, in completion order.</returns>
+    /// <exception cref="ArgumentNullException">Thrown when <paramref name="handles"/> or any of its elements is null.</exception>
+    /// <exception cref="InvalidOperationException">Thrown when any of the handles is invalid.</exception>
+    /// <exception cref="OperationCanceledException">Thrown by the enumerator when the cancellation token is canceled.</exception>
+    /// <remarks>
+    /// All the processes are awaited as soon as the enumeration starts, with <see cref="WaitForExitAsync"/>: on Unix, a single process-wide thread
+    /// waits for all their exits. The processes are reaped, like with <see cref="WaitForExitAsync"/>, and they are NOT killed on cancellation.
+    /// When the enumeration is stopped early, the processes that have not been reported yet are no longer awaited.
+    /// </remarks>
+    public static IAsyncEnumerable<(SafeChildProcessHandle Handle, ProcessExitStatus ExitStatus)> WaitForExitsAsync(
+        IEnumerable<SafeChildProcessHandle> handles, CancellationToken cancellationToken = default)
+    {
+        ArgumentNullException.ThrowIfNull(handles);
+
+        SafeChildProcessHandle[] array = [.. handles];
+        ValidateMany(array);
+
+        return WaitForExitsAsyncCore(array, cancellationToken);
+    }
+
+    private static async IAsyncEnumerable<(SafeChildProcessHandle Handle, ProcessExitStatus ExitStatus)> WaitForExitsAsyncCore(
+        SafeChildProcessHandle[] handles, [EnumeratorCancellation] CancellationToken cancellationToken)
+    {
+        using CancellationTokenSource cancellationSource = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken);
+
+        // The indexes of the processes that have exited, in completion order.
+        Channel<int> completions = Channel.CreateUnbounded<int>(new UnboundedChannelOptions { SingleReader = true });
+        Task<ProcessExitStatus>[] tasks = new Task<ProcessExitStatus>[handles.Length];
+
+        try
+        {
+            for (int i = 0; i < handles.Length; i++)
+            {
+                tasks[i] = handles[i].WaitForExitAsyncCore(cancellationSource.Token);
+                _ = tasks[i].ContinueWith(static (_, state) =>
+                {
+                    (ChannelWriter<int> writer, int index) = ((ChannelWriter<int>, int))state!;
+                    writer.TryWrite(index);
+                }, (completions.Writer, i), CancellationToken.None, TaskContinuationOptions.ExecuteSynchronously, TaskScheduler.Default);
+            }
+
+            for (int i = 0; i < handles.Length; i++)
+            {
+                // Every task completes, even when canceled: there is no need to cancel the read.
+                int index = await completions.Reader.ReadAsync(CancellationToken.None).ConfigureAwait(false);
+
+                yield return (handles[index], await tasks[index].ConfigureAwait(false));
+            }
+        }
+        finally
+        {
+            // Stops waiting for the processes that were not reported.
+            cancellationSource.Cancel();
+        }
+    }
+
     /// <summary>
     /// Terminates the process.
     /// </summary>
@@ -291,6 +629,26 @@ public sealed partial class SafeChildProcessHandle : SafeHandle
         return KillCore(throwOnError: true, entireProcessGroup: true);
     }
 
+    /// <summary>
+    /// Terminates the process and all its descendants.
+    /// </summary>
+    /// <returns>
+    /// <c>true</c> if the process tree was terminated; <c>false</c> if all its processes had already exited.
+    /// </returns>
+    /// <exception cref="InvalidOperationException">Thrown when the handle is invalid, or the process was not started with <see cref="ProcessStartOptions.IsolateProcessTree"/>=true.</exception>
+    /// <exception cref="Win32Exception">Thrown when the kill operation fails for reasons other than the process having already exited.</exception>
+    /// <remarks>
+    /// On Linux, writes to <c>cgroup.kill</c> of the cgroup of the process: all the processes are killed at once, whatever the size of the tree,
+    /// and the method returns once the cgroup is empty. The process itself still needs to be waited for.
+    /// On Windows, terminates all processes in the job object.
+    /// </remarks>
+    public bool KillProcessTree()
+    {
+        Validate();
+
+        return KillProcessTreeCore();
+    }
+
     /// <summary>
     /// Resumes a suspended process.
     /// </summary>
@@ -359,32 +717,29 @@ public sealed partial class SafeChildProcessHandle : SafeHandle
     /// in cases where we know that both STD OUT and STDERR got closed,
     /// and we suspect that the process has exited.
     /// So instead of creating expensive async machinery to wait for process exit,
-    /// this method attempts to get the exit code directly.
+    /// this method attempts to get the exit status directly.
     /// </summary>
-    internal bool TryGetExitCode(out int exitCode, out PosixSignal? signal)
+    internal bool TryGetExitStatus(bool canceled, [NotNullWhen(true)] out ProcessExitStatus? exitStatus)
     {
         Validate();
 
-        return TryGetExitCodeCore(out exitCode, out signal);
+        return TryGetExitStatusCore(canceled, out exitStatus);
     }
 
-    internal bool TryGetExitStatus(bool canceled, [NotNullWhen(true)] out ProcessExitStatus? exitStatus)
+    private void Validate()
     {
-        if (TryGetExitCodeCore(out int exitCode, out PosixSignal? signal))
+        if (IsInvalid)
         {
-            exitStatus = new(exitCode, canceled, signal);
-            return true;
+            throw new InvalidOperationException("Invalid process handle.");
         }
-
-        exitStatus = null;
-        return false;
     }
 
-    private void Validate()
+    private static void ValidateMany(ReadOnlySpan<SafeChildProcessHandle> handles)
     {
-        if (IsInvalid)
+        foreach (SafeChildProcessHandle handle in handles)
         {
-            throw new InvalidOperationException("Invalid process handle.");
+            ArgumentNullException.ThrowIfNull(handle, nameof(handles));
+            handle.Validate();
         }
     }
 
@@ -13,14 +13,14 @@ public static partial class FileExtensions
         return File.OpenHandle("NUL", FileMode.Open, FileAccess.ReadWrite, FileShare.ReadWrite, FileOptions.None);
     }
 
-    private static void CreatePipeCore(out SafeFileHandle read, out SafeFileHandle write, bool asyncRead, bool asyncWrite)
+    private static void CreatePipeCore(out SafeFileHandle read, out SafeFileHandle write, bool asyncRead, bool asyncWrite, int capacity)
     {
         Interop.Kernel32.SECURITY_ATTRIBUTES securityAttributes = default;
 
         // When neither end is async, use the simple CreatePipe API
         if (!asyncRead && !asyncWrite)
         {
-            bool ret = Interop.Kernel32.CreatePipe(out read, out write, ref securityAttributes, 0);
+            bool ret = Interop.Kernel32.CreatePipe(out read, out write, ref securityAttributes, capacity);
             if (!ret || read.IsInvalid || write.IsInvalid)
             {
                 throw new Win32Exception();
@@ -49,8 +49,8 @@ public static partial class FileExtensions
                        Interop.Kernel32.FileOperations.PIPE_READMODE_BYTE | // Data is read from the pipe as a stream of bytes
                        Interop.Kernel32.FileOperations.PIPE_WAIT; // Blocking mode is enabled (the operations are not completed until there is data to read)
 
-        // We could consider specyfing a larger buffer size.
-        read = Interop.Kernel32.CreateNamedPipe(pipeName, openMode, pipeMode, 1, 0, 0, 0, ref securityAttributes);
+        // The data flows from the client (write end) to the server (read end), so only the input buffer matters.
+        read = Interop.Kernel32.CreateNamedPipe(pipeName, openMode, pipeMode, 1, 0, capacity, 0, ref securityAttributes);
 
         if (read.IsInvalid)
         {
@@ -26,10 +26,21 @@ public static partial class FileExtensions
         /// <param name="write">The write end of the pipe.</param>
         /// <param name="asyncRead">Whether the read end should support asynchronous I/O.</param>
         /// <param name="asyncWrite">Whether the write end should support asynchronous I/O.</param>
+        /// <param name="capacity">The capacity of the pipe in bytes, or 0 to use the capacity chosen by the system.</param>
         /// <remarks>
         /// <para>The read end of the pipe can be used to read data written to the write end.</para>
+        /// <para>
+        /// A larger capacity lets a fast writer run longer before it blocks on a full pipe, so the writer and the reader wake each other up less often.
+        /// On Linux, it's set with <c>F_SETPIPE_SZ</c> (best effort, unprivileged processes can't exceed <c>/proc/sys/fs/pipe-max-size</c>).
+        /// On Windows, it's the buffer size suggested to <c>CreatePipe</c>/<c>CreateNamedPipe</c>. It's ignored on the other platforms.
+        /// </para>
         /// </remarks>
-        public static void CreatePipe(out SafeFileHandle read, out SafeFileHandle write, bool asyncRead = false, bool asyncWrite = false)
-            => CreatePipeCore(out read, out write, asyncRead, asyncWrite);
+        /// <exception cref="ArgumentOutOfRangeException">Thrown when <paramref name="capacity"/> is negative.</exception>
+        public static void CreatePipe(out SafeFileHandle read, out SafeFileHandle write, bool asyncRead = false, bool asyncWrite = false, int capacity = 0)
+        {
+            ArgumentOutOfRangeException.ThrowIfNegative(capacity);
+
+            CreatePipeCore(out read, out write, asyncRead, asyncWrite, capacity);
+        }
     }
 }
@@ -10,12 +10,19 @@ add_definitions(-D_GNU_SOURCE)
 # Check for pipe2 function (Linux, some BSDs)
 set(CMAKE_REQUIRED_DEFINITIONS -D_GNU_SOURCE)
 check_symbol_exists(pipe2 "unistd.h;fcntl.h" HAVE_PIPE2)
+# Check for splice function (Linux), used to move pipe data into files without copying it to user space
+check_symbol_exists(splice "fcntl.h" HAVE_SPLICE)
+# Check for F_SETPIPE_SZ (Linux), used to grow the capacity of the pipes
+check_symbol_exists(F_SETPIPE_SZ "fcntl.h" HAVE_F_SETPIPE_SZ)
+# Check for closefrom (BSDs, glibc 2.34), the fallback used to sanitize the descriptors of a child when close_range is not available
+check_symbol_exists(closefrom "unistd.h" HAVE_CLOSEFROM)
 unset(CMAKE_REQUIRED_DEFINITIONS)
 
 # Check for necessary headers
 check_include_file("sys/syscall.h" HAVE_SYS_SYSCALL_H)
 check_include_file("linux/sched.h" HAVE_LINUX_SCHED_H)
 check_include_file("sys/event.h" HAVE_SYS_EVENT_H)
+check_include_file("sys/epoll.h" HAVE_SYS_EPOLL_H)
 
 # Check for kqueue (macOS, FreeBSD, and other BSDs)
 if(CMAKE_SYSTEM_NAME STREQUAL "Darwin" OR CMAKE_SYSTEM_NAME STREQUAL "FreeBSD")
@@ -91,7 +98,34 @@ if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
             #endif
         }
     " HAVE_CLONE3)
+
+    # Check if the glibc/musl clone() wrapper accepts CLONE_PIDFD, so a child sharing the address space
+    # of the parent (CLONE_VM | CLONE_VFORK) can be started on its own stack, with its pidfd returned atomically
+    check_c_source_compiles("
+        #define _GNU_SOURCE
+        #include <sched.h>
+        #include <signal.h>
+        #include <sys/syscall.h>
+        #include <linux/sched.h>
+        static int child(void* arg) { (void)arg; return 0; }
+        int main() {
+            static char stack[4096];
+            int pidfd;
+            return clone(child, stack + sizeof(stack), CLONE_VM | CLONE_VFORK | CLONE_PIDFD | SIGCHLD, 0, &pidfd);
+        }
+    " HAVE_CLONE_VFORK)
     
+    # Check if clone3 can start the child directly in a cgroup (Linux 5.7), and for inotify to wait for the cgroup to be empty
+    check_c_source_compiles("
+        #include <sys/inotify.h>
+        #include <linux/sched.h>
+        int main() {
+            struct clone_args args = { .flags = CLONE_INTO_CGROUP, .cgroup = 0 };
+            (void)args;
+            return inotify_init1(IN_CLOEXEC);
+        }
+    " HAVE_CLONE_INTO_CGROUP)
+
     check_c_source_compiles("
         #include <sys/syscall.h>
         int main() {
@@ -138,6 +172,13 @@ if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
 
 endif()
 
+# USDT probes (systemtap's sys/sdt.h): each one compiles to a single nop and a note in the ELF, so they are on by default
+# and can be attached with bpftrace or perf without rebuilding. Linux only, since macOS needs DTrace provider definitions.
+option(PAL_USDT_PROBES "Compile the USDT probes of the spawn and wait functions when sys/sdt.h is available" ON)
+if(PAL_USDT_PROBES AND CMAKE_SYSTEM_NAME STREQUAL "Linux")
+    check_include_file("sys/sdt.h" HAVE_SYS_SDT_H)
+endif()
+
 # Generate the configuration header
 configure_file(
     ${CMAKE_CURRENT_SOURCE_DIR}/pal_config.h.in
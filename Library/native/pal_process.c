@@ -10,11 +10,21 @@
 #include <poll.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
 
 #ifdef HAVE_SYS_SYSCALL_H
 #include <sys/syscall.h>
 #endif
 
+#ifdef HAVE_CLONE_VFORK
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
 #ifdef HAVE_LINUX_SCHED_H
 #include <linux/sched.h>
 #endif
@@ -23,17 +33,58 @@
 #include <sys/prctl.h>
 #endif
 
+#ifdef HAVE_CLONE_INTO_CGROUP
+#include <sys/inotify.h>
+#endif
+
 #ifdef HAVE_SYS_EVENT_H
 #include <sys/event.h>
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #ifdef HAVE_POSIX_SPAWN
 #include <spawn.h>
 #endif
 
+#ifdef HAVE_CLONE3
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#endif
+
+// close_range is called through a raw syscall, so headers that predate it don't disable it: it's 436 on the architectures
+// listed below (not on alpha, ia64, mips or x32, which keep the descriptor enumeration), and the kernels that predate it
+// return ENOSYS, which falls back to enumerating the descriptors.
+#if defined(__linux__) && defined(HAVE_SYS_SYSCALL_H) && !defined(HAVE_CLOSE_RANGE) \
+    && ((defined(__x86_64__) && !defined(__ILP32__)) || defined(__i386__) || defined(__aarch64__) || defined(__arm__) \
+        || defined(__riscv) || defined(__powerpc__) || defined(__s390__) || defined(__loongarch__))
+#define __NR_close_range 436
+#define HAVE_CLOSE_RANGE
+#endif
+#if defined(HAVE_CLOSE_RANGE) && !defined(CLOSE_RANGE_CLOEXEC)
+#define CLOSE_RANGE_CLOEXEC (1U << 2)
+#endif
+
 // In the future, we could add support for pidfd on FreeBSD
 #ifdef HAVE_CLONE3
 #define HAVE_PIDFD
+// The spawn server relies on CLONE_PARENT and on sending pidfds back to the client
+#define HAVE_SPAWN_SERVER
+#endif
+
+// USDT probes of the provider "pal_process", e.g. `bpftrace -e 'usdt:libpal_process.so:pal_process:child__exec { ... }'`.
+// When nothing is attached, a probe is a single nop: its arguments are only described in the ELF notes, not evaluated.
+// The child__* probes fire in the child, between the fork and execve, the other ones in the calling process.
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define PAL_PROBE1(name, a) DTRACE_PROBE1(pal_process, name, a)
+#define PAL_PROBE2(name, a, b) DTRACE_PROBE2(pal_process, name, a, b)
+#else
+#define PAL_PROBE1(name, a) ((void)0)
+#define PAL_PROBE2(name, a, b) ((void)0)
 #endif
 
 // External variable containing the current environment.
@@ -42,13 +93,6 @@
 // When envp parameter is NULL, we use this to pass the parent's environment to execve().
 extern char **environ;
 
-// Helper to write errno to pipe and exit (ignores write failures)
-static inline void write_errno_and_exit(int pipe_fd, int err) {
-    // We're about to exit anyway, so ignore write failures
-    (void)write(pipe_fd, &err, sizeof(err));
-    _exit(127);
-}
-
 // Helper function to create a pipe with CLOEXEC flag and optional O_NONBLOCK
 static int create_cloexec_pipe(int pipefd[2]) {
 #ifdef HAVE_PIPE2
@@ -74,10 +118,36 @@ static int create_cloexec_pipe(int pipefd[2]) {
 #endif
 }
 
+// Returns the capacity of the pipe in bytes, or -1 with errno set (ENOTSUP when it can't be queried).
+int get_pipe_capacity(int fd) {
+#ifdef HAVE_F_SETPIPE_SZ
+    return fcntl(fd, F_GETPIPE_SZ);
+#else
+    (void)fd;
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
+
+// Changes the capacity of the pipe (either end), returns the new capacity (the kernel rounds it up to a power of two
+// number of pages) or -1 with errno set: EPERM when an unprivileged process exceeds /proc/sys/fs/pipe-max-size,
+// EBUSY when the pipe holds more data than the new capacity, ENOTSUP when the capacity can't be changed (non-Linux).
+int set_pipe_capacity(int fd, int capacity) {
+#ifdef HAVE_F_SETPIPE_SZ
+    return fcntl(fd, F_SETPIPE_SZ, capacity);
+#else
+    (void)fd;
+    (void)capacity;
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
+
 // Helper function to create a pipe with CLOEXEC flag and optional O_NONBLOCK on either end
 // async_read: if non-zero, sets O_NONBLOCK on the read end (pipefd[0])
 // async_write: if non-zero, sets O_NONBLOCK on the write end (pipefd[1])
-int create_pipe(int pipefd[2], int async_read, int async_write) {
+// capacity: if positive, the requested capacity of the pipe (best effort, see set_pipe_capacity)
+int create_pipe(int pipefd[2], int async_read, int async_write, int capacity) {
     // First create the pipe with CLOEXEC
     if (create_cloexec_pipe(pipefd) != 0) {
         return -1;
@@ -106,6 +176,10 @@ int create_pipe(int pipefd[2], int async_read, int async_write) {
             return -1;
         }
     }
+
+    if (capacity > 0) {
+        (void)set_pipe_capacity(pipefd[1], capacity);
+    }
     
     return 0;
 }
@@ -135,6 +209,587 @@ int create_kqueue_cloexec(void) {
 }
 #endif
 
+// Describes a single child process to be started by spawn_processes.
+// The layout must match SpawnRequest in SafeChildProcessHandle.Unix.cs.
+typedef struct {
+    const char* path;
+    char* const* argv;
+    char* const* envp;
+    int stdin_fd;
+    int stdout_fd;
+    int stderr_fd;
+    const char* working_dir;
+    int kill_on_parent_death;
+    int create_new_process_group;
+    const int* inherited_handles;
+    int inherited_handles_count;
+    // A descriptor of the cgroup v2 directory to start the child in (CLONE_INTO_CGROUP), or -1
+    int cgroup_fd;
+    // The process group to join (see spawn_pipeline), or 0. Ignored when create_new_process_group is set.
+    int process_group_id;
+} spawn_request;
+
+#if !(defined(HAVE_POSIX_SPAWN) && defined(HAVE_POSIX_SPAWN_CLOEXEC_DEFAULT) && defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDINHERIT_NP))
+// The record a child writes to the wait pipe when it fails before (or in) execve.
+// It is smaller than PIPE_BUF, so the write is atomic even when many children share the pipe.
+typedef struct {
+    int index;
+    int error;
+} exec_failure;
+
+// spawn_processes creates one wait pipe per chunk, the size keeps the failure
+// records of a single chunk well below the default pipe capacity (64 KB on Linux),
+// so a child reporting a failure never blocks on a full pipe.
+#define SPAWN_BATCH_CHUNK_SIZE 1024
+
+// The highest descriptor (exclusive) the fallback loops go up to, when the descriptors can't be enumerated: RLIMIT_NOFILE,
+// however high, as no descriptor can be at or above it. Without a limit (RLIM_INFINITY, not possible on Linux) or when it
+// can't be read, the loops stop at DEFAULT_DESCRIPTOR_LIMIT, so the descriptors above it are not sanitized.
+#define DEFAULT_DESCRIPTOR_LIMIT 65536
+
+static int get_descriptor_limit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) {
+        return DEFAULT_DESCRIPTOR_LIMIT;
+    }
+
+    return limit.rlim_cur < (rlim_t)INT_MAX ? (int)limit.rlim_cur : INT_MAX;
+}
+
+#if defined(HAVE_SYS_SYSCALL_H) && defined(SYS_getdents64)
+// The record returned by getdents64, which glibc does not declare.
+typedef struct {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+} linux_dirent64;
+#endif
+
+// Calls action for every open descriptor from lowest_fd onwards, at a cost proportional to the number of open descriptors
+// rather than to RLIMIT_NOFILE, which services commonly raise to a million.
+// Runs between fork and execve, so it does not allocate: /proc/self/fd is read with getdents64 into a buffer on the stack.
+// The descriptors of a batch are acted upon once it has been read, so action may close them.
+// Returns -1 when the descriptors can't be enumerated (no procfs), the caller then falls back to a loop.
+static int for_each_open_fd(int lowest_fd, void (*action)(int fd, void* context), void* context) {
+#if defined(HAVE_SYS_SYSCALL_H) && defined(SYS_getdents64)
+    int dir_fd = open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        return -1;
+    }
+
+    char buffer[1024] __attribute__((aligned(8)));
+    long count;
+    while ((count = syscall(SYS_getdents64, dir_fd, buffer, sizeof(buffer))) > 0) {
+        for (long offset = 0; offset < count; ) {
+            const linux_dirent64* entry = (const linux_dirent64*)(buffer + offset);
+            offset += entry->d_reclen;
+
+            int fd = 0;
+            const char* name = entry->d_name;
+            if (*name < '0' || *name > '9') {
+                continue; // "." and ".."
+            }
+            for (; *name >= '0' && *name <= '9'; name++) {
+                fd = fd * 10 + (*name - '0');
+            }
+
+            if (fd >= lowest_fd && fd != dir_fd) {
+                action(fd, context);
+            }
+        }
+    }
+
+    close(dir_fd);
+    return count == 0 ? 0 : -1;
+#else
+    (void)lowest_fd;
+    (void)action;
+    (void)context;
+    return -1;
+#endif
+}
+
+static int is_inherited_handle(const spawn_request* request, int fd) {
+    for (int i = 0; i < request->inherited_handles_count; i++) {
+        if (request->inherited_handles[i] == fd) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Sets FD_CLOEXEC on the descriptor, or clears it for the handles the request inherits explicitly.
+static void set_cloexec_unless_inherited(int fd, void* context) {
+    int flags = fcntl(fd, F_GETFD);
+    if (flags == -1) {
+        return;
+    }
+
+    int new_flags = is_inherited_handle((const spawn_request*)context, fd) ? flags & ~FD_CLOEXEC : flags | FD_CLOEXEC;
+    if (new_flags != flags) {
+        fcntl(fd, F_SETFD, new_flags);
+    }
+}
+
+// Makes sure that only stdio and the inherited handles survive execve: every other descriptor from 3 onwards gets FD_CLOEXEC.
+// Must be called after the dup2s of stdio, so that stdin_fd/stdout_fd/stderr_fd >= 3 are duplicated before they're marked.
+// The first available of these is used:
+//   close_range(CLOSE_RANGE_CLOEXEC): a single syscall (Linux 5.11)
+//   /proc/self/fd: proportional to the number of open descriptors
+//   closefrom above the highest descriptor the child keeps (BSDs), then a loop below it
+//   a loop up to RLIMIT_NOFILE (or DEFAULT_DESCRIPTOR_LIMIT when there is none, see get_descriptor_limit)
+static void sanitize_descriptors(const spawn_request* request, int wait_pipe_fd) {
+#ifdef HAVE_CLOSE_RANGE
+    if (syscall(__NR_close_range, 3, ~0U, CLOSE_RANGE_CLOEXEC) == 0) {
+        for (int i = 0; i < request->inherited_handles_count; i++) {
+            // Skip stdio fds as they're already handled, and they weren't affected by close_range.
+            // FD_CLOEXEC is the only descriptor flag, and it's known to be set, so a single fcntl clears it.
+            if (request->inherited_handles[i] >= 3) {
+                fcntl(request->inherited_handles[i], F_SETFD, 0);
+            }
+        }
+        return;
+    }
+#endif
+
+    if (for_each_open_fd(3, set_cloexec_unless_inherited, (void*)request) == 0) {
+        return;
+    }
+
+    int limit = get_descriptor_limit();
+#if defined(HAVE_CLOSEFROM) && !defined(__linux__)
+    // glibc's closefrom aborts when neither close_range nor /proc/self/fd is available, which is why we got here on Linux.
+    // Closing the descriptors is equivalent to marking them, since none of them is used before execve.
+    int highest_kept = wait_pipe_fd;
+    for (int i = 0; i < request->inherited_handles_count; i++) {
+        if (request->inherited_handles[i] > highest_kept) {
+            highest_kept = request->inherited_handles[i];
+        }
+    }
+    closefrom(highest_kept + 1);
+    limit = highest_kept + 1;
+#else
+    (void)wait_pipe_fd;
+#endif
+
+    for (int fd = 3; fd < limit; fd++) {
+        set_cloexec_unless_inherited(fd, (void*)request);
+    }
+}
+
+// The signal state a child starts from, prepared by the parent so that the child doesn't have to query it.
+typedef struct {
+    // The mask of the parent, restored right before execve
+    sigset_t mask;
+    // The signals that have a handler, which the child resets to SIG_DFL (see get_handled_signals)
+    sigset_t handled;
+} child_signals;
+
+// Finds the signals that have a handler in the current process.
+// On Linux a single read of SigCgt in /proc/self/status is enough, elsewhere (or without procfs) every signal is queried.
+static void query_handled_signals(sigset_t* out_handled) {
+    sigemptyset(out_handled);
+
+#ifdef __linux__
+    int fd = open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        char buffer[8192];
+        size_t length = 0;
+        ssize_t bytes_read;
+        while (length < sizeof(buffer) - 1
+            && ((bytes_read = read(fd, buffer + length, sizeof(buffer) - 1 - length)) > 0 || (bytes_read < 0 && errno == EINTR))) {
+            length += bytes_read > 0 ? (size_t)bytes_read : 0;
+        }
+        close(fd);
+        buffer[length] = '\0';
+
+        // A hexadecimal mask, where bit n - 1 stands for signal n
+        const char* line = strstr(buffer, "\nSigCgt:");
+        if (line != NULL) {
+            uint64_t mask = strtoull(line + sizeof("\nSigCgt:") - 1, NULL, 16);
+            for (int sig = 1; sig < NSIG && sig <= 64; sig++) {
+                if (mask & (1ULL << (sig - 1))) {
+                    sigaddset(out_handled, sig);
+                }
+            }
+            return;
+        }
+    }
+#endif
+
+    struct sigaction current;
+    for (int sig = 1; sig < NSIG; sig++) {
+        if (sig != SIGKILL && sig != SIGSTOP && sigaction(sig, NULL, &current) == 0
+            && current.sa_handler != SIG_IGN && current.sa_handler != SIG_DFL) {
+            sigaddset(out_handled, sig);
+        }
+    }
+}
+
+// The handlers are installed once and for all, but lazily by the runtime (and at any time by PosixSignalRegistration),
+// which doesn't tell anyone: the set found by query_handled_signals is reused for this long, then queried again.
+#define HANDLED_SIGNALS_CACHE_DURATION_NS (100 * 1000 * 1000)
+
+#ifdef CLOCK_MONOTONIC_COARSE
+#define HANDLED_SIGNALS_CLOCK CLOCK_MONOTONIC_COARSE
+#else
+#define HANDLED_SIGNALS_CLOCK CLOCK_MONOTONIC
+#endif
+
+static pthread_mutex_t s_handled_signals_lock = PTHREAD_MUTEX_INITIALIZER;
+static sigset_t s_handled_signals;
+static int64_t s_handled_signals_queried_at;
+static int s_handled_signals_cached;
+
+// The signals that have a handler, which the child resets to SIG_DFL. The parent finds them once per spawn (or batch),
+// so the child, which runs with the parent suspended under CLONE_VFORK, only calls sigaction for these signals.
+// The clock is read from the vDSO, so reusing the cached set costs no syscall.
+static void get_handled_signals(sigset_t* out_handled) {
+    struct timespec now;
+    clock_gettime(HANDLED_SIGNALS_CLOCK, &now);
+    int64_t now_ns = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+
+    pthread_mutex_lock(&s_handled_signals_lock);
+    if (!s_handled_signals_cached || now_ns - s_handled_signals_queried_at >= HANDLED_SIGNALS_CACHE_DURATION_NS) {
+        query_handled_signals(&s_handled_signals);
+        s_handled_signals_queried_at = now_ns;
+        s_handled_signals_cached = 1;
+    }
+    *out_handled = s_handled_signals;
+    pthread_mutex_unlock(&s_handled_signals_lock);
+}
+
+// Helper to write errno to pipe and exit (ignores write failures)
+__attribute__((noreturn))
+static inline void write_errno_and_exit(int pipe_fd, int index, int err) {
+    exec_failure failure = { .index = index, .error = err };
+    // We're about to exit anyway, so ignore write failures
+    (void)write(pipe_fd, &failure, sizeof(failure));
+    _exit(127);
+}
+
+// Runs in the child process after fork/clone: applies the requested configuration and calls execve.
+// Never returns: on failure, the errno is reported to the parent over wait_pipe and the child exits.
+// Everything the parent could prepare (the signals to reset, the descriptors) has been, so the child makes as few syscalls as possible:
+// with no options, one sigaction per handled signal, the dup2s, close_range, sigpending, the mask and execve.
+__attribute__((noreturn))
+static void exec_child(
+    const spawn_request* request,
+    int create_suspended,
+    int detached,
+    const int wait_pipe[2],
+    int index,
+    const child_signals* signals)
+{
+    PAL_PROBE1(child__start, index);
+
+    // Put the default handlers back for the signals that have one, the ignored ones stay ignored (like execve does).
+    // All the signals are blocked until right before execve, so the handlers of the parent never run in the child.
+    struct sigaction sa_default;
+    memset(&sa_default, 0, sizeof(sa_default));
+    sa_default.sa_handler = SIG_DFL;
+
+    for (int sig = 1; sig < NSIG; sig++) {
+        if (sigismember(&signals->handled, sig) == 1) {
+            sigaction(sig, &sa_default, NULL);
+        }
+    }
+    PAL_PROBE1(child__signals__reset, index);
+    
+    // If detached is enabled, create a new session (detach from controlling terminal)
+    // setsid() creates a new session if the calling process is not a process group leader
+    // The calling process becomes the leader of the new session and the leader of a new process group
+    if (detached) {
+        if (setsid() == -1) {
+            write_errno_and_exit(wait_pipe[1], index, errno);
+        }
+    }
+    
+    // If create_new_process_group is enabled, create a new process group
+    // setpgid(0, 0) sets the process group ID of the calling process to its own PID
+    // making it the leader of a new process group
+    if (request->create_new_process_group) {
+        if (setpgid(0, 0) == -1) {
+            write_errno_and_exit(wait_pipe[1], index, errno);
+        }
+    } else if (request->process_group_id > 0) {
+        // The leader has already exec'd and is not reaped before we are started, so the group exists
+        if (setpgid(0, request->process_group_id) == -1) {
+            write_errno_and_exit(wait_pipe[1], index, errno);
+        }
+    }
+    
+    // If kill_on_parent_death is enabled, set up parent death signal
+    if (request->kill_on_parent_death) {
+#ifdef HAVE_PDEATHSIG
+        // On systems with PR_SET_PDEATHSIG (Linux), use it to set up parent death signal
+        if (prctl(PR_SET_PDEATHSIG, SIGTERM) == -1) {
+            write_errno_and_exit(wait_pipe[1], index, errno);
+        }
+        
+        // Close the race: parent may have already died before prctl() ran.
+        // Note: This checks if we've been reparented to init (PID 1).
+        // In containers or systems with different init systems, this may not
+        // work perfectly, but it's the standard approach for this functionality.
+        if (getppid() == 1) {
+            // Parent already gone; we've been reparented to init.
+            // Exit immediately to honor the kill-on-parent-death contract.
+            _exit(0);
+        }
+#else
+        // On systems without prctl, this feature is not available.
+        // We would need a different mechanism (like polling or signals),
+        // but for now we'll skip it as it's not straightforward to implement
+        // without platform-specific code.
+        // This is a limitation on systems without prctl.
+#endif
+    }
+    
+    // The read end of the wait pipe is CLOEXEC, it doesn't need to be closed.
+    // Redirect stdin/stdout/stderr
+    if (request->stdin_fd != 0) {
+        if (dup2(request->stdin_fd, 0) == -1) {
+            write_errno_and_exit(wait_pipe[1], index, errno);
+        }
+    }
+    
+    if (request->stdout_fd != 1) {
+        if (dup2(request->stdout_fd, 1) == -1) {
+            write_errno_and_exit(wait_pipe[1], index, errno);
+        }
+    }
+    
+    if (request->stderr_fd != 2) {
+        if (dup2(request->stderr_fd, 2) == -1) {
+            write_errno_and_exit(wait_pipe[1], index, errno);
+        }
+    }
+    PAL_PROBE1(child__stdio__redirected, index);
+    
+    // Prevent the child from inheriting unwanted file descriptors, but the ones it was given on purpose
+    sanitize_descriptors(request, wait_pipe[1]);
+    PAL_PROBE1(child__fds__closed, index);
+    
+    // Change working directory if specified
+    if (request->working_dir != NULL) {
+        if (chdir(request->working_dir) == -1) {
+            write_errno_and_exit(wait_pipe[1], index, errno);
+        }
+        PAL_PROBE2(child__chdir, index, request->working_dir);
+    }
+    
+    // If create_suspended is requested, close wait_pipe and stop ourselves before exec
+    // This allows the parent to get our PID and set up monitoring before we start executing
+    if (create_suspended) {
+        // Close wait_pipe to signal parent that we've successfully reached this point
+        close(wait_pipe[1]);
+        
+#if defined(HAVE_SYS_SYSCALL_H) && defined(HAVE_SYS_TGKILL)
+        // On Linux, use tgkill to send SIGSTOP to ourselves
+        // This is more reliable than kill(getpid(), SIGSTOP) or pthread_kill
+        syscall(SYS_tgkill, getpid(), syscall(SYS_gettid), SIGSTOP);
+#else
+        // On other Unix systems (non-Linux), use kill with getpid()
+        // Note: This may not work as reliably as the Linux approach
+        kill(getpid(), SIGSTOP);
+#endif
+        // When the parent resumes us with SIGCONT, execution continues here
+    }
+    
+    // Execute the program
+    // If envp is NULL, use the current environment (environ)
+    char* const* env = (request->envp != NULL) ? request->envp : environ;
+    PAL_PROBE2(child__exec, index, request->path);
+
+    // The handled signals may have been found up to HANDLED_SIGNALS_CACHE_DURATION_NS ago, so a handler installed since then
+    // is still in place: a pending signal would run it as soon as the mask is restored, on the vfork stack and,
+    // under CLONE_VM, in the memory of the suspended parent. Those are reset too, at the cost of one syscall when none is pending.
+    sigset_t pending;
+    if (sigpending(&pending) == 0) {
+        for (int sig = 1; sig < NSIG; sig++) {
+            struct sigaction current;
+            if (sig != SIGKILL && sig != SIGSTOP && sigismember(&pending, sig) == 1 && sigismember(&signals->handled, sig) != 1
+                && sigaction(sig, NULL, &current) == 0 && current.sa_handler != SIG_IGN && current.sa_handler != SIG_DFL) {
+                sigaction(sig, &sa_default, NULL);
+            }
+        }
+    }
+
+    pthread_sigmask(SIG_SETMASK, &signals->mask, NULL);
+    execve(request->path, request->argv, env);
+    
+    // If we get here, execve failed
+    // Only write to wait_pipe if it's still open (not suspended case)
+    if (!create_suspended) {
+        write_errno_and_exit(wait_pipe[1], index, errno);
+    } else {
+        _exit(127);
+    }
+}
+
+#ifdef HAVE_CLONE_VFORK
+// The size of the stack a child sharing the address space of the parent runs exec_child on.
+// exec_child needs very little, the rest is headroom for the dynamic linker resolving the symbols it calls.
+#define VFORK_STACK_SIZE (64 * 1024)
+
+typedef struct {
+    const spawn_request* request;
+    int detached;
+    const int* wait_pipe;
+    int index;
+    const child_signals* signals;
+} vfork_child_args;
+
+static int vfork_child_entry(void* arg) {
+    const vfork_child_args* args = (const vfork_child_args*)arg;
+    exec_child(args->request, 0, args->detached, args->wait_pipe, args->index, args->signals);
+}
+#endif
+
+#ifdef HAVE_CLONE_VFORK
+static pthread_key_t s_vfork_stack_key;
+static pthread_once_t s_vfork_stack_key_once = PTHREAD_ONCE_INIT;
+static int s_vfork_stack_key_created;
+
+static void free_vfork_stack(void* stack) {
+    munmap(stack, VFORK_STACK_SIZE);
+}
+
+static void create_vfork_stack_key(void) {
+    s_vfork_stack_key_created = pthread_key_create(&s_vfork_stack_key, free_vfork_stack) == 0;
+}
+#endif
+
+// Gets the stack used by fork_child to start children that share the address space of the parent.
+// Returns NULL when the platform does not support it (or the allocation failed), fork_child then copies the address space.
+// A stack can be reused for any number of sequential fork_child calls, since the calling thread is suspended
+// until the child calls execve or exits, so each thread maps its own once and keeps it until it exits:
+// spawning costs no mmap/munmap, which would change the page tables of a parent that may have a large heap.
+static void* get_vfork_stack(void) {
+#ifdef HAVE_CLONE_VFORK
+    pthread_once(&s_vfork_stack_key_once, create_vfork_stack_key);
+    if (!s_vfork_stack_key_created) {
+        return NULL;
+    }
+
+    void* stack = pthread_getspecific(s_vfork_stack_key);
+    if (stack == NULL) {
+        stack = mmap(NULL, VFORK_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (stack == MAP_FAILED) {
+            return NULL;
+        }
+
+        if (pthread_setspecific(s_vfork_stack_key, stack) != 0) {
+            munmap(stack, VFORK_STACK_SIZE);
+            return NULL;
+        }
+    }
+
+    return stack;
+#else
+    return NULL;
+#endif
+}
+
+// Forks a child that runs exec_child. Must be called with all signals blocked.
+// Returns the PID of the child in the parent, or -1 when the fork failed (errno is set).
+// On systems with clone3, the pidfd of the child is stored in out_pidfd.
+// When vfork_stack is provided (see get_vfork_stack), the child shares the address space of the parent
+// instead of getting a copy of its page tables, which makes spawning from a parent with a large heap much cheaper.
+// When clone_parent is set (clone3 only), the child becomes a child of our parent (CLONE_PARENT), see the spawn server.
+static pid_t fork_child(
+    const spawn_request* request,
+    int create_suspended,
+    int detached,
+    const int wait_pipe[2],
+    int index,
+    const child_signals* signals,
+    int* out_pidfd,
+    void* vfork_stack,
+    int clone_parent)
+{
+#ifdef HAVE_CLONE_VFORK
+    // A suspended child stops itself before exec, which would keep the parent suspended too.
+    // kill_on_parent_death is left to the regular path, as the parent death signal is tied to the forking thread.
+    // clone does not take a cgroup, clone3 does.
+    if (vfork_stack != NULL && !create_suspended && !request->kill_on_parent_death && request->cgroup_fd < 0) {
+        vfork_child_args args = {
+            .request = request,
+            .detached = detached,
+            .wait_pipe = wait_pipe,
+            .index = index,
+            .signals = signals,
+        };
+
+        // The parent stays suspended until the child calls execve or exits, so args and the stack remain valid.
+        // CLONE_PIDFD makes clone store the pidfd in the parent_tid argument.
+        // The stack grows down on all the architectures we support.
+        pid_t child_pid = clone(vfork_child_entry, (char*)vfork_stack + VFORK_STACK_SIZE,
+            CLONE_VM | CLONE_VFORK | CLONE_PIDFD | (clone_parent ? CLONE_PARENT : 0) | SIGCHLD, &args, out_pidfd);
+        PAL_PROBE2(spawn__forked, index, child_pid);
+        return child_pid;
+    }
+#else
+    (void)vfork_stack;
+#endif
+
+#ifdef HAVE_CLONE3
+    // On systems with clone3, use it to get pidfd atomically with fork
+    struct clone_args args = {0};  // Zero-initialize
+    // Note: We cannot use CLONE_VFORK when create_suspended is true, because
+    // the child will stop itself before exec, which would deadlock the parent
+    args.flags = (create_suspended ? 0 : CLONE_VFORK) | CLONE_PIDFD | (clone_parent ? CLONE_PARENT : 0);
+    args.pidfd = (uint64_t)(uintptr_t)out_pidfd;
+    args.exit_signal = SIGCHLD;
+#ifdef HAVE_CLONE_INTO_CGROUP
+    if (request->cgroup_fd >= 0) {
+        // The child is in the cgroup from its very first instruction, before it can start anything
+        args.flags |= CLONE_INTO_CGROUP;
+        args.cgroup = (uint64_t)request->cgroup_fd;
+    }
+#endif
+    
+    long clone_result = syscall(SYS_clone3, &args, sizeof(args));
+    
+    if (clone_result == 0) {
+        exec_child(request, create_suspended, detached, wait_pipe, index, signals);
+    }
+    PAL_PROBE2(spawn__forked, index, (pid_t)clone_result);
+    
+    return (pid_t)clone_result;
+#else
+    (void)out_pidfd;
+    (void)clone_parent;
+    // On systems without clone3, use fork or vfork depending on create_suspended
+    // Note: We cannot use vfork when create_suspended is true
+    pid_t child_pid = create_suspended ? fork() : vfork();
+    
+    if (child_pid == 0) {
+        exec_child(request, create_suspended, detached, wait_pipe, index, signals);
+    }
+    PAL_PROBE2(spawn__forked, index, child_pid);
+    
+    return child_pid;
+#endif
+}
+
+// Reaps a child that reported an exec failure over the wait pipe
+static void reap_failed_child(pid_t child_pid, int pidfd) {
+#ifdef HAVE_CLONE3
+    (void)child_pid;
+    siginfo_t info;
+    while (waitid(P_PIDFD, pidfd, &info, WEXITED) < 0 && errno == EINTR);
+    close(pidfd);
+#else
+    (void)pidfd;
+    int status;
+    while (waitpid(child_pid, &status, 0) < 0 && errno == EINTR);
+#endif
+}
+#endif
+
 // Spawns a process and returns success/failure
 // Returns 0 on success, -1 on error (errno is set)
 // If out_pid is not NULL, the PID of the child process is stored there
@@ -145,6 +800,8 @@ int create_kqueue_cloexec(void) {
 // If create_new_process_group is non-zero, the child process will be created in a new process group
 // If detached is non-zero, the child process will be detached (starts a new session with setsid)
 // If inherited_handles is not NULL and inherited_handles_count > 0, the specified file descriptors will be inherited
+// If cgroup_fd is not -1, the child process is started in that cgroup v2 directory (Linux only, ENOTSUP elsewhere)
+// If process_group_id is not 0 (and create_new_process_group is 0), the child process joins that existing process group
 int spawn_process(
     const char* path,
     char* const argv[],
@@ -160,8 +817,18 @@ int spawn_process(
     int create_new_process_group,
     int detached,
     const int* inherited_handles,
-    int inherited_handles_count)
+    int inherited_handles_count,
+    int cgroup_fd,
+    int process_group_id)
 {
+    // cgroups are Linux-only
+#ifndef HAVE_CLONE_INTO_CGROUP
+    if (cgroup_fd >= 0) {
+        errno = ENOTSUP;
+        return -1;
+    }
+#endif
+
 #if defined(HAVE_POSIX_SPAWN) && defined(HAVE_POSIX_SPAWN_CLOEXEC_DEFAULT) && defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDINHERIT_NP)
     // ========== POSIX_SPAWN PATH (macOS) ==========
     
@@ -205,8 +872,8 @@ int spawn_process(
     if (detached) {
         flags |= POSIX_SPAWN_SETSID;
     }
-    // If create_new_process_group is requested, add the POSIX_SPAWN_SETPGROUP flag
-    if (create_new_process_group) {
+    // If create_new_process_group is requested or an existing group is joined, add the POSIX_SPAWN_SETPGROUP flag
+    if (create_new_process_group || process_group_id > 0) {
         flags |= POSIX_SPAWN_SETPGROUP;
     }
     if ((result = posix_spawnattr_setflags(&attr, flags)) != 0) {
@@ -218,9 +885,9 @@ int spawn_process(
     
     // If create_new_process_group is set, configure the process group ID to 0
     // which means the child will become the leader of a new process group
-    if (create_new_process_group) {
+    if (create_new_process_group || process_group_id > 0) {
         // posix_spawnattr_setpgroup with pgid=0 makes the child the leader of a new process group
-        if ((result = posix_spawnattr_setpgroup(&attr, 0)) != 0) {
+        if ((result = posix_spawnattr_setpgroup(&attr, create_new_process_group ? 0 : process_group_id)) != 0) {
             int saved_errno = result;
             posix_spawnattr_destroy(&attr);
             errno = saved_errno;
@@ -334,286 +1001,825 @@ int spawn_process(
     }
 #endif
     
+    spawn_request request = {
+        .path = path,
+        .argv = argv,
+        .envp = envp,
+        .stdin_fd = stdin_fd,
+        .stdout_fd = stdout_fd,
+        .stderr_fd = stderr_fd,
+        .working_dir = working_dir,
+        .kill_on_parent_death = kill_on_parent_death,
+        .create_new_process_group = create_new_process_group,
+        .inherited_handles = inherited_handles,
+        .inherited_handles_count = inherited_handles_count,
+        .cgroup_fd = cgroup_fd,
+        .process_group_id = process_group_id,
+    };
     int wait_pipe[2];
     int pidfd = -1;
-    sigset_t all_signals, old_signals;
+    sigset_t all_signals;
+    child_signals signals;
+    PAL_PROBE1(spawn__start, path);
     
     // Create pipe for exec synchronization (CLOEXEC so child doesn't inherit it)
     if (create_cloexec_pipe(wait_pipe) != 0) {
         return -1;
     }
     
+    // Allocated (on the first spawn of the thread) before blocking the signals, NULL when the fast path is not available
+    void* vfork_stack = create_suspended || kill_on_parent_death || cgroup_fd >= 0 ? NULL : get_vfork_stack();
+
     // Block all signals before forking
+    get_handled_signals(&signals.handled);
     sigfillset(&all_signals);
-    pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &signals.mask);
     
-    pid_t child_pid;
+    pid_t child_pid = fork_child(&request, create_suspended, detached, wait_pipe, 0, &signals, &pidfd, vfork_stack, 0);
     
-#ifdef HAVE_CLONE3
-    // On systems with clone3, use it to get pidfd atomically with fork
-    struct clone_args args = {0};  // Zero-initialize
-    // Note: We cannot use CLONE_VFORK when create_suspended is true, because
-    // the child will stop itself before exec, which would deadlock the parent
-    args.flags = (create_suspended ? 0 : CLONE_VFORK) | CLONE_PIDFD;
-    args.pidfd = (uint64_t)(uintptr_t)&pidfd;
-    args.exit_signal = SIGCHLD;
+    // ========== PARENT PROCESS ==========
     
-    long clone_result = syscall(SYS_clone3, &args, sizeof(args));
+    // Restore signal mask
+    int saved_errno = errno;
+    pthread_sigmask(SIG_SETMASK, &signals.mask, NULL);
+    
+    // Close write end of wait pipe
+    close(wait_pipe[1]);
     
-    if (clone_result == -1) {
+    if (child_pid == -1) {
         // Fork failed
-        int saved_errno = errno;
-        pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
         close(wait_pipe[0]);
-        close(wait_pipe[1]);
         errno = saved_errno;
         return -1;
     }
     
-    child_pid = (pid_t)clone_result;
+    // Wait for child to exec or fail
+    exec_failure failure;
+    ssize_t bytes_read = read(wait_pipe[0], &failure, sizeof(failure));
+    close(wait_pipe[0]);
+    // The child has called execve (error is 0) or failed before or in it
+    PAL_PROBE2(spawn__exec__done, child_pid, bytes_read == sizeof(failure) ? failure.error : 0);
     
-    if (clone_result == 0) {
-#else
-    // On systems without clone3, use fork or vfork depending on create_suspended
-    // Note: We cannot use vfork when create_suspended is true
-    child_pid = create_suspended ? fork() : vfork();
+    if (bytes_read == sizeof(failure)) {
+        // Child failed to exec - reap it
+        reap_failed_child(child_pid, pidfd);
+        errno = failure.error;
+        return -1;
+    }
     
-    if (child_pid == -1) {
-        // Fork failed
-        int saved_errno = errno;
-        pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
-        close(wait_pipe[0]);
-        close(wait_pipe[1]);
-        errno = saved_errno;
-        return -1;
-    }
-    
-    if (child_pid == 0) {
-#endif
-        // ========== CHILD PROCESS ==========
+    // If create_suspended was requested, wait for the child to stop itself
+    if (create_suspended) {
+        int status;
+        pid_t wait_result;
         
-        // Restore signal mask immediately
-        pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+        // Wait for the child to stop (WUNTRACED flag)
+        // The child will send itself SIGSTOP before execve
+        while ((wait_result = waitpid(child_pid, &status, WUNTRACED)) < 0 && errno == EINTR);
         
-        // If detached is enabled, create a new session (detach from controlling terminal)
-        // setsid() creates a new session if the calling process is not a process group leader
-        // The calling process becomes the leader of the new session and the leader of a new process group
-        if (detached) {
-            if (setsid() == -1) {
-                write_errno_and_exit(wait_pipe[1], errno);
-            }
+        if (wait_result == -1) {
+            int saved_errno = errno;
+            // Child failed to stop - clean up
+#ifdef HAVE_CLONE3
+            close(pidfd);
+#endif
+            errno = saved_errno;
+            return -1;
         }
         
-        // If create_new_process_group is enabled, create a new process group
-        // setpgid(0, 0) sets the process group ID of the calling process to its own PID
-        // making it the leader of a new process group
-        if (create_new_process_group) {
-            if (setpgid(0, 0) == -1) {
-                write_errno_and_exit(wait_pipe[1], errno);
-            }
+        // Verify the child is actually stopped
+        if (!WIFSTOPPED(status)) {
+            // Child didn't stop as expected - this is an error
+#ifdef HAVE_CLONE3
+            close(pidfd);
+#endif
+            errno = ECHILD;  // Use ECHILD to indicate child state error
+            return -1;
         }
-        
-        // If kill_on_parent_death is enabled, set up parent death signal
-        if (kill_on_parent_death) {
-#ifdef HAVE_PDEATHSIG
-            // On systems with PR_SET_PDEATHSIG (Linux), use it to set up parent death signal
-            if (prctl(PR_SET_PDEATHSIG, SIGTERM) == -1) {
-                write_errno_and_exit(wait_pipe[1], errno);
+        // Child is now stopped and waiting for SIGCONT
+    }
+    
+    // Success - return PID and pidfd if requested
+    if (out_pid != NULL) {
+        *out_pid = child_pid;
+    }
+    if (out_pidfd != NULL) {
+        *out_pidfd = pidfd;
+    }
+    return 0;
+#endif
+}
+
+// Spawns a batch of processes, paying for the signal mask round trip and the exec handshake pipe once per chunk
+// instead of once per process.
+// All children of a chunk share the write end of a single CLOEXEC pipe: a child that fails to exec writes
+// its index and errno as one atomic record, a child that execs successfully closes its copy implicitly.
+// The parent reads the records until EOF, which happens once every child of the chunk has either exec'd or exited.
+// Returns the number of successfully started processes (a negative value is never returned).
+// For every request i:
+//   out_pids[i] receives the PID (or -1 when the spawn failed)
+//   out_pidfds[i] receives the pidfd (Linux only, -1 on other platforms or when the spawn failed)
+//   out_errors[i] receives 0 on success or the errno describing the failure
+int spawn_processes(
+    const spawn_request* requests,
+    int count,
+    int* out_pids,
+    int* out_pidfds,
+    int* out_errors)
+{
+    int started = 0;
+
+#if defined(HAVE_POSIX_SPAWN) && defined(HAVE_POSIX_SPAWN_CLOEXEC_DEFAULT) && defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDINHERIT_NP)
+    // posix_spawn reports exec failures synchronously, there is no handshake to amortize.
+    for (int i = 0; i < count; i++) {
+        const spawn_request* request = &requests[i];
+        if (spawn_process(request->path, request->argv, request->envp,
+                request->stdin_fd, request->stdout_fd, request->stderr_fd, request->working_dir,
+                &out_pids[i], &out_pidfds[i],
+                request->kill_on_parent_death, 0, request->create_new_process_group, 0,
+                request->inherited_handles, request->inherited_handles_count, request->cgroup_fd, request->process_group_id) == 0) {
+            out_errors[i] = 0;
+            started++;
+        } else {
+            out_pids[i] = -1;
+            out_pidfds[i] = -1;
+            out_errors[i] = errno;
+        }
+    }
+#else
+    sigset_t all_signals;
+    child_signals signals;
+    sigfillset(&all_signals);
+    // Once for the whole batch
+    get_handled_signals(&signals.handled);
+    // Shared by the whole batch: the children are started one after another
+    void* vfork_stack = get_vfork_stack();
+
+    for (int chunk_start = 0; chunk_start < count; chunk_start += SPAWN_BATCH_CHUNK_SIZE) {
+        int chunk_end = count - chunk_start > SPAWN_BATCH_CHUNK_SIZE ? chunk_start + SPAWN_BATCH_CHUNK_SIZE : count;
+        int wait_pipe[2];
+
+        if (create_cloexec_pipe(wait_pipe) != 0) {
+            int saved_errno = errno;
+            for (int i = chunk_start; i < count; i++) {
+                out_pids[i] = -1;
+                out_pidfds[i] = -1;
+                out_errors[i] = saved_errno;
             }
-            
-            // Close the race: parent may have already died before prctl() ran.
-            // Note: This checks if we've been reparented to init (PID 1).
-            // In containers or systems with different init systems, this may not
-            // work perfectly, but it's the standard approach for this functionality.
-            if (getppid() == 1) {
-                // Parent already gone; we've been reparented to init.
-                // Exit immediately to honor the kill-on-parent-death contract.
-                _exit(0);
+            return started;
+        }
+
+        PAL_PROBE2(spawn__batch__start, chunk_start, chunk_end);
+        pthread_sigmask(SIG_SETMASK, &all_signals, &signals.mask);
+
+        for (int i = chunk_start; i < chunk_end; i++) {
+            out_pidfds[i] = -1;
+#ifndef HAVE_CLONE_INTO_CGROUP
+            if (requests[i].cgroup_fd >= 0) {
+                out_pids[i] = -1;
+                out_errors[i] = ENOTSUP;
+                continue;
             }
-#else
-            // On systems without prctl, this feature is not available.
-            // We would need a different mechanism (like polling or signals),
-            // but for now we'll skip it as it's not straightforward to implement
-            // without platform-specific code.
-            // This is a limitation on systems without prctl.
 #endif
+            out_pids[i] = fork_child(&requests[i], 0, 0, wait_pipe, i, &signals, &out_pidfds[i], vfork_stack, 0);
+            out_errors[i] = out_pids[i] == -1 ? errno : 0;
         }
-        
-        // Reset all signal handlers to default
-        struct sigaction sa_default;
-        struct sigaction sa_old;
-        memset(&sa_default, 0, sizeof(sa_default));
-        sa_default.sa_handler = SIG_DFL;
-        
-        for (int sig = 1; sig < NSIG; sig++) {
-            if (sig == SIGKILL || sig == SIGSTOP) continue;
-
-            if (!sigaction(sig, NULL, &sa_old))
-            {
-                void (*oldhandler)(int) = sa_old.sa_handler;
-                if (oldhandler != SIG_IGN && oldhandler != SIG_DFL)
-                {
-                    // It has a custom handler, put the default handler back.
-                    // We check first to preserve flags on default handlers.
-                    sigaction(sig, &sa_default, NULL);
+
+        pthread_sigmask(SIG_SETMASK, &signals.mask, NULL);
+
+        // Close our copy of the write end, so EOF arrives once the last child has called execve or exited
+        close(wait_pipe[1]);
+
+        exec_failure failures[64];
+        size_t buffered = 0;
+        while (1) {
+            ssize_t bytes_read = read(wait_pipe[0], (char*)failures + buffered, sizeof(failures) - buffered);
+            if (bytes_read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytes_read <= 0) {
+                break;
+            }
+
+            buffered += (size_t)bytes_read;
+            size_t complete = buffered / sizeof(exec_failure);
+            for (size_t j = 0; j < complete; j++) {
+                int index = failures[j].index;
+                if (index >= chunk_start && index < chunk_end && out_errors[index] == 0) {
+                    reap_failed_child(out_pids[index], out_pidfds[index]);
+                    out_pids[index] = -1;
+                    out_pidfds[index] = -1;
+                    out_errors[index] = failures[j].error;
                 }
             }
+
+            buffered -= complete * sizeof(exec_failure);
+            memmove(failures, (char*)failures + complete * sizeof(exec_failure), buffered);
         }
-        
-        // Close read end of wait pipe (we only write)
         close(wait_pipe[0]);
-        
-        // Redirect stdin/stdout/stderr
-        if (stdin_fd != 0) {
-            if (dup2(stdin_fd, 0) == -1) {
-                write_errno_and_exit(wait_pipe[1], errno);
+        // Every child of the chunk has called execve or exited
+        PAL_PROBE2(spawn__batch__done, chunk_start, chunk_end);
+
+        for (int i = chunk_start; i < chunk_end; i++) {
+            if (out_errors[i] == 0) {
+                started++;
             }
         }
-        
-        if (stdout_fd != 1) {
-            if (dup2(stdout_fd, 1) == -1) {
-                write_errno_and_exit(wait_pipe[1], errno);
-            }
+    }
+#endif
+
+    return started;
+}
+
+// Spawns the stages of a pipeline (requests[0] | requests[1] | ... | requests[count - 1]) in a single call.
+// The pipes between the stages are created and closed here, so the data flows from one child to the next
+// without going through the caller.
+// requests[0].stdin_fd and requests[count - 1].stdout_fd are used as they are, the other stdin_fd/stdout_fd are overwritten.
+// pipe_capacities[i] (when not NULL and non-zero) is the capacity requested for the pipe between stage i and i + 1.
+// It is applied with F_SETPIPE_SZ on Linux, ignored elsewhere, and it's best effort: the kernel caps it for unprivileged processes.
+// When create_process_group is set, the first stage becomes the leader of a new process group and the other stages join it.
+// The results are reported like in spawn_processes; when the first stage fails to start and create_process_group is set,
+// the other stages are not started and their out_errors is ECANCELED.
+int spawn_pipeline(
+    spawn_request* requests,
+    int count,
+    const int* pipe_capacities,
+    int create_process_group,
+    int* out_pids,
+    int* out_pidfds,
+    int* out_errors)
+{
+    int pipe_count = count - 1;
+    int created = 0;
+    int saved_errno = 0;
+    int* pipe_fds = pipe_count > 0 ? malloc(sizeof(int) * 2 * (size_t)pipe_count) : NULL;
+
+    if (pipe_count > 0 && pipe_fds == NULL) {
+        saved_errno = ENOMEM;
+    }
+
+    for (; saved_errno == 0 && created < pipe_count; created++) {
+        int* fds = &pipe_fds[created * 2];
+        // CLOEXEC: every stage gets its two ends through dup2, and none of the others.
+        if (create_cloexec_pipe(fds) != 0) {
+            saved_errno = errno;
+            break;
         }
-        
-        if (stderr_fd != 2) {
-            if (dup2(stderr_fd, 2) == -1) {
-                write_errno_and_exit(wait_pipe[1], errno);
+
+        if (pipe_capacities != NULL && pipe_capacities[created] > 0) {
+            (void)set_pipe_capacity(fds[1], pipe_capacities[created]);
+        }
+
+        requests[created].stdout_fd = fds[1];
+        requests[created + 1].stdin_fd = fds[0];
+    }
+
+    int started = 0;
+    if (saved_errno != 0) {
+        for (int i = 0; i < count; i++) {
+            out_pids[i] = -1;
+            out_pidfds[i] = -1;
+            out_errors[i] = saved_errno;
+        }
+    } else if (create_process_group) {
+        // The group ID is the PID of the leader, which is known only once it has been started.
+        requests[0].create_new_process_group = 1;
+        started = spawn_processes(requests, 1, out_pids, out_pidfds, out_errors);
+
+        for (int i = 1; i < count; i++) {
+            requests[i].create_new_process_group = 0;
+            requests[i].process_group_id = out_pids[0];
+        }
+
+        if (started == 1) {
+            started += spawn_processes(requests + 1, count - 1, out_pids + 1, out_pidfds + 1, out_errors + 1);
+        } else {
+            for (int i = 1; i < count; i++) {
+                out_pids[i] = -1;
+                out_pidfds[i] = -1;
+                out_errors[i] = ECANCELED;
             }
         }
-        
-#ifdef HAVE_CLOSE_RANGE
-        // On systems with close_range (Linux and FreeBSD), use it to mark all FDs from 3 onwards as CLOEXEC
-        // This prevents the child from inheriting unwanted file descriptors
-        // FDs 0-2 are stdin/stdout/stderr
-        // We use CLOSE_RANGE_CLOEXEC to set the flag without closing the FDs
-        // This must be called AFTER the dup2 calls above, so that if stdin_fd/stdout_fd/stderr_fd
-        // are >= 3, they don't get CLOEXEC set before being duplicated to 0/1/2
-        syscall(__NR_close_range, 3, ~0U, CLOSE_RANGE_CLOEXEC);
-        // Ignore errors - if close_range is not supported, we continue anyway
-        
-        // Remove CLOEXEC flag from user-provided inherited handles
-        // so they are inherited by execve
-        if (inherited_handles != NULL && inherited_handles_count > 0) {
-            for (int i = 0; i < inherited_handles_count; i++) {
-                int fd = inherited_handles[i];
-                // Skip stdio fds as they're already handled
-                // Also skip fds < 3 as they weren't affected by close_range
-                if (fd >= 3) {
-                    int flags = fcntl(fd, F_GETFD);
-                    if (flags != -1) {
-                        fcntl(fd, F_SETFD, flags & ~FD_CLOEXEC);
-                    }
+    } else {
+        started = spawn_processes(requests, count, out_pids, out_pidfds, out_errors);
+    }
+
+    // The children have their own copies now, EOF propagates from one stage to the next as they exit.
+    for (int i = 0; i < created * 2; i++) {
+        close(pipe_fds[i]);
+    }
+    free(pipe_fds);
+
+    return started;
+}
+
+#ifdef HAVE_SPAWN_SERVER
+// ========== SPAWN SERVER ==========
+// A small helper process, forked once (ideally early, while the parent is still small) that starts the processes on behalf of the parent.
+// The parent sends the request over a SOCK_SEQPACKET socket: a header, the strings and the stdio descriptors (SCM_RIGHTS).
+// The helper starts the child with CLONE_PARENT, so the child is a child of the parent (which can wait for it and reap it as usual),
+// and sends back the pid and the pidfd (SCM_RIGHTS).
+// The requests are served one at a time, the callers must not use the same socket concurrently.
+
+// The maximum size of a request, well below the default send buffer size of AF_UNIX sockets.
+#define SPAWN_SERVER_MAX_REQUEST (128 * 1024)
+
+typedef struct {
+    int argc;
+    int envc;
+    int has_working_dir;
+    int create_new_process_group;
+    int detached;
+} spawn_server_request;
+
+typedef struct {
+    // 0 on success, the errno of the failure otherwise
+    int error;
+    // The pid of the child, also set when the child was started but failed to exec (the client reaps it)
+    int pid;
+} spawn_server_response;
+
+static ssize_t send_with_fds(int socket_fd, const void* data, size_t length, const int* fds, int fd_count) {
+    struct iovec iov = { .iov_base = (void*)data, .iov_len = length };
+    char control[CMSG_SPACE(sizeof(int) * 3)];
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (fd_count > 0) {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+    }
+
+    ssize_t result;
+    while ((result = sendmsg(socket_fd, &msg, MSG_NOSIGNAL)) < 0 && errno == EINTR);
+    return result;
+}
+
+// Receives a message and up to 3 descriptors (CLOEXEC). The descriptors that were not received are set to -1.
+static ssize_t receive_with_fds(int socket_fd, void* data, size_t length, int* fds, int max_fd_count, int* out_fd_count) {
+    struct iovec iov = { .iov_base = data, .iov_len = length };
+    char control[CMSG_SPACE(sizeof(int) * 3)];
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t result;
+    while ((result = recvmsg(socket_fd, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR);
+
+    *out_fd_count = 0;
+    for (int i = 0; i < max_fd_count; i++) {
+        fds[i] = -1;
+    }
+
+    if (result < 0) {
+        return result;
+    }
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int count = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            int* received = (int*)CMSG_DATA(cmsg);
+            for (int i = 0; i < count; i++) {
+                if (*out_fd_count < max_fd_count) {
+                    fds[(*out_fd_count)++] = received[i];
+                } else {
+                    close(received[i]);
                 }
             }
         }
+    }
+
+    // A truncated message means the client did not respect the protocol
+    if ((msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    return result;
+}
+
+// Parses the strings of a request into the pointer arrays, returns 0 on success, -1 when the request is malformed.
+static int parse_spawn_server_request(char* strings, size_t length, const spawn_server_request* header,
+    char** out_path, char** argv, char** envp, char** out_working_dir) {
+    char* current = strings;
+    char* end = strings + length;
+    int count = 1 + header->argc + header->envc + (header->has_working_dir ? 1 : 0);
+
+    for (int i = 0; i < count; i++) {
+        char* terminator = memchr(current, '\0', (size_t)(end - current));
+        if (terminator == NULL) {
+            return -1;
+        }
+
+        if (i == 0) {
+            *out_path = current;
+        } else if (i <= header->argc) {
+            argv[i - 1] = current;
+        } else if (i <= header->argc + header->envc) {
+            envp[i - 1 - header->argc] = current;
+        } else {
+            *out_working_dir = current;
+        }
+
+        current = terminator + 1;
+    }
+
+    argv[header->argc] = NULL;
+    envp[header->envc] = NULL;
+    return 0;
+}
+
+static void close_unless_socket(int fd, void* context) {
+    if (fd != *(const int*)context) {
+        close(fd);
+    }
+}
+
+__attribute__((noreturn))
+static void run_spawn_server(int socket_fd) {
+    // The signals stay blocked: the helper is in the process group of the parent and must survive Ctrl+C,
+    // it exits when the parent closes the socket. The children get an empty mask and default handlers (see exec_child).
+    // The handlers are the ones of the parent when the helper was forked, and the helper installs none.
+    sigset_t all_signals;
+    child_signals signals;
+    sigfillset(&all_signals);
+    sigemptyset(&signals.mask);
+    query_handled_signals(&signals.handled);
+    pthread_sigmask(SIG_SETMASK, &all_signals, NULL);
+
+    // Don't keep the stdio of the parent (for example the write end of a pipe read by someone else) open
+    int null_fd = open("/dev/null", O_RDWR);
+    if (null_fd >= 0) {
+        dup2(null_fd, 0);
+        dup2(null_fd, 1);
+        dup2(null_fd, 2);
+    }
+
+    // Close everything else the parent had open, but the socket
+    int closed = 0;
+#ifdef HAVE_CLOSE_RANGE
+    closed = syscall(__NR_close_range, 3, socket_fd - 1, 0) == 0 && syscall(__NR_close_range, socket_fd + 1, ~0U, 0) == 0;
 #endif
-        
-        // Change working directory if specified
-        if (working_dir != NULL) {
-            if (chdir(working_dir) == -1) {
-                write_errno_and_exit(wait_pipe[1], errno);
+    if (!closed && for_each_open_fd(3, close_unless_socket, &socket_fd) != 0) {
+        int max_fd = get_descriptor_limit();
+        for (int fd = 3; fd < max_fd; fd++) {
+            if (fd != socket_fd) {
+                close(fd);
             }
         }
-        
-        // If create_suspended is requested, close wait_pipe and stop ourselves before exec
-        // This allows the parent to get our PID and set up monitoring before we start executing
-        if (create_suspended) {
-            // Close wait_pipe to signal parent that we've successfully reached this point
-            close(wait_pipe[1]);
-            
-#if defined(HAVE_SYS_SYSCALL_H) && defined(HAVE_SYS_TGKILL)
-            // On Linux, use tgkill to send SIGSTOP to ourselves
-            // This is more reliable than kill(getpid(), SIGSTOP) or pthread_kill
-            syscall(SYS_tgkill, getpid(), syscall(SYS_gettid), SIGSTOP);
-#else
-            // On other Unix systems (non-Linux), use kill with getpid()
-            // Note: This may not work as reliably as the Linux approach
-            kill(getpid(), SIGSTOP);
-#endif
-            // When the parent resumes us with SIGCONT, execution continues here
+    }
+
+    // Every string takes at least one byte, which bounds the size of the pointer arrays
+    size_t pointers_size = (SPAWN_SERVER_MAX_REQUEST + 2) * sizeof(char*);
+    char* buffer = mmap(NULL, SPAWN_SERVER_MAX_REQUEST + 2 * pointers_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        _exit(1);
+    }
+    char** argv = (char**)(buffer + SPAWN_SERVER_MAX_REQUEST);
+    char** envp = (char**)(buffer + SPAWN_SERVER_MAX_REQUEST + pointers_size);
+    void* vfork_stack = get_vfork_stack();
+
+    while (1) {
+        int fds[3];
+        int fd_count;
+        ssize_t length = receive_with_fds(socket_fd, buffer, SPAWN_SERVER_MAX_REQUEST, fds, 3, &fd_count);
+        if (length == 0 || (length < 0 && errno != EMSGSIZE)) {
+            _exit(0); // The parent has closed the socket (or exited)
         }
-        
-        // Execute the program
-        // If envp is NULL, use the current environment (environ)
-        char* const* env = (envp != NULL) ? envp : environ;
-        execve(path, argv, env);
-        
-        // If we get here, execve failed
-        // Only write to wait_pipe if it's still open (not suspended case)
-        if (!create_suspended) {
-            write_errno_and_exit(wait_pipe[1], errno);
+
+        spawn_server_response response = { .error = 0, .pid = -1 };
+        spawn_server_request header;
+        char* path = NULL;
+        char* working_dir = NULL;
+        int pidfd = -1;
+
+        if (length < (ssize_t)sizeof(header) || fd_count != 3) {
+            response.error = length < 0 ? EMSGSIZE : EINVAL;
         } else {
-            _exit(127);
+            memcpy(&header, buffer, sizeof(header));
+            if (header.argc < 1 || header.envc < 0
+                || (size_t)header.argc + (size_t)header.envc > SPAWN_SERVER_MAX_REQUEST
+                || parse_spawn_server_request(buffer + sizeof(header), (size_t)length - sizeof(header), &header,
+                    &path, argv, envp, &working_dir) != 0) {
+                response.error = EINVAL;
+            }
+        }
+
+        if (response.error == 0) {
+            spawn_request request = {
+                .path = path,
+                .argv = argv,
+                .envp = envp,
+                .stdin_fd = fds[0],
+                .stdout_fd = fds[1],
+                .stderr_fd = fds[2],
+                .working_dir = working_dir,
+                .kill_on_parent_death = 0,
+                .create_new_process_group = header.create_new_process_group,
+                .inherited_handles = NULL,
+                .inherited_handles_count = 0,
+                .cgroup_fd = -1,
+            };
+            int wait_pipe[2];
+
+            if (create_cloexec_pipe(wait_pipe) != 0) {
+                response.error = errno;
+            } else {
+                response.pid = fork_child(&request, 0, header.detached, wait_pipe, 0, &signals, &pidfd, vfork_stack, 1);
+                if (response.pid == -1) {
+                    response.error = errno;
+                }
+                close(wait_pipe[1]);
+
+                if (response.pid != -1) {
+                    exec_failure failure;
+                    ssize_t bytes_read;
+                    while ((bytes_read = read(wait_pipe[0], &failure, sizeof(failure))) < 0 && errno == EINTR);
+                    if (bytes_read == sizeof(failure)) {
+                        // The child is not ours to reap, the client does it
+                        response.error = failure.error;
+                    }
+                }
+                close(wait_pipe[0]);
+            }
+        }
+
+        for (int i = 0; i < fd_count; i++) {
+            close(fds[i]);
+        }
+
+        send_with_fds(socket_fd, &response, sizeof(response), &pidfd, pidfd >= 0 ? 1 : 0);
+        if (pidfd >= 0) {
+            close(pidfd);
         }
     }
-    
-    // ========== PARENT PROCESS ==========
-    
-    // Restore signal mask
+}
+#endif
+
+// Starts the spawn server and returns the client end of its socket and its pid.
+// Returns 0 on success, -1 on error (errno is set, ENOTSUP when the platform is not supported).
+int spawn_server_start(int* out_socket, int* out_pid) {
+#ifdef HAVE_SPAWN_SERVER
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0) {
+        return -1;
+    }
+
+    sigset_t all_signals, old_signals;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+
+    // A regular fork: the helper must outlive this call. Only the calling thread exists in the child.
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(sockets[0]);
+        run_spawn_server(sockets[1]);
+    }
+
+    int saved_errno = errno;
     pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
-    
-    // Close write end of wait pipe
-    close(wait_pipe[1]);
-    
-    // Wait for child to exec or fail
-    int child_errno = 0;
-    ssize_t bytes_read = read(wait_pipe[0], &child_errno, sizeof(child_errno));
-    close(wait_pipe[0]);
-    
-    if (bytes_read == sizeof(child_errno)) {
-        // Child failed to exec - reap it
-#ifdef HAVE_CLONE3
-        siginfo_t info;
-        waitid(P_PIDFD, pidfd, &info, WEXITED);
-        close(pidfd);
+    close(sockets[1]);
+
+    if (pid == -1) {
+        close(sockets[0]);
+        errno = saved_errno;
+        return -1;
+    }
+
+    *out_socket = sockets[0];
+    *out_pid = pid;
+    return 0;
 #else
-        int status;
-        waitpid(child_pid, &status, 0);
+    (void)out_socket;
+    (void)out_pid;
+    errno = ENOTSUP;
+    return -1;
 #endif
-        errno = child_errno;
+}
+
+// Starts a process through the spawn server. When envp is NULL, the current environment of the caller is sent.
+// Returns 0 on success, -1 on error (errno is set, E2BIG when the request does not fit in a single message).
+// Callers must serialize the calls for the same socket.
+int spawn_server_spawn(
+    int socket_fd,
+    const char* path,
+    char* const argv[],
+    char* const envp[],
+    int stdin_fd,
+    int stdout_fd,
+    int stderr_fd,
+    const char* working_dir,
+    int create_new_process_group,
+    int detached,
+    int* out_pid,
+    int* out_pidfd)
+{
+#ifdef HAVE_SPAWN_SERVER
+    char* const* env = envp != NULL ? envp : environ;
+
+    // Like environ, the current directory is the one at the time of the request, not the one the helper was started in.
+    // When it can't be determined (it was removed), E2BIG makes the caller spawn the process directly.
+    char* current_dir = NULL;
+    if (working_dir == NULL) {
+        if ((current_dir = getcwd(NULL, 0)) == NULL) {
+            errno = E2BIG;
+            return -1;
+        }
+        working_dir = current_dir;
+    }
+
+    spawn_server_request header = {
+        .argc = 0,
+        .envc = 0,
+        .has_working_dir = 1,
+        .create_new_process_group = create_new_process_group,
+        .detached = detached,
+    };
+
+    size_t length = sizeof(header) + strlen(path) + 1;
+    for (; argv[header.argc] != NULL; header.argc++) {
+        length += strlen(argv[header.argc]) + 1;
+    }
+    for (; env[header.envc] != NULL; header.envc++) {
+        length += strlen(env[header.envc]) + 1;
+    }
+    length += strlen(working_dir) + 1;
+
+    if (length > SPAWN_SERVER_MAX_REQUEST) {
+        free(current_dir);
+        errno = E2BIG;
         return -1;
     }
-    
-    // If create_suspended was requested, wait for the child to stop itself
-    if (create_suspended) {
-        int status;
-        pid_t wait_result;
-        
-        // Wait for the child to stop (WUNTRACED flag)
-        // The child will send itself SIGSTOP before execve
-        while ((wait_result = waitpid(child_pid, &status, WUNTRACED)) < 0 && errno == EINTR);
-        
-        if (wait_result == -1) {
-            int saved_errno = errno;
-            // Child failed to stop - clean up
-#ifdef HAVE_CLONE3
+
+    char* buffer = malloc(length);
+    if (buffer == NULL) {
+        free(current_dir);
+        return -1;
+    }
+
+    memcpy(buffer, &header, sizeof(header));
+    char* current = buffer + sizeof(header);
+    size_t path_length = strlen(path) + 1;
+    memcpy(current, path, path_length);
+    current += path_length;
+    for (int i = 0; i < header.argc; i++) {
+        size_t arg_length = strlen(argv[i]) + 1;
+        memcpy(current, argv[i], arg_length);
+        current += arg_length;
+    }
+    for (int i = 0; i < header.envc; i++) {
+        size_t env_length = strlen(env[i]) + 1;
+        memcpy(current, env[i], env_length);
+        current += env_length;
+    }
+    memcpy(current, working_dir, strlen(working_dir) + 1);
+    free(current_dir);
+
+    int fds[3] = { stdin_fd, stdout_fd, stderr_fd };
+    ssize_t sent = send_with_fds(socket_fd, buffer, length, fds, 3);
+    int saved_errno = errno;
+    free(buffer);
+    if (sent < 0) {
+        errno = saved_errno;
+        return -1;
+    }
+
+    spawn_server_response response;
+    int pidfd;
+    int fd_count;
+    ssize_t received = receive_with_fds(socket_fd, &response, sizeof(response), &pidfd, 1, &fd_count);
+    if (received != (ssize_t)sizeof(response)) {
+        if (fd_count > 0) {
             close(pidfd);
-#endif
-            errno = saved_errno;
-            return -1;
         }
-        
-        // Verify the child is actually stopped
-        if (!WIFSTOPPED(status)) {
-            // Child didn't stop as expected - this is an error
-#ifdef HAVE_CLONE3
+        // EOF: the helper is gone
+        if (received >= 0) {
+            errno = ECONNRESET;
+        }
+        return -1;
+    }
+
+    if (response.error != 0) {
+        if (response.pid > 0 && fd_count > 0) {
+            // The child failed to exec: it's our child (CLONE_PARENT), reap it
+            reap_failed_child(response.pid, pidfd);
+        } else if (fd_count > 0) {
             close(pidfd);
+        }
+        errno = response.error;
+        return -1;
+    }
+
+    *out_pid = response.pid;
+    *out_pidfd = pidfd;
+    return 0;
+#else
+    (void)socket_fd; (void)path; (void)argv; (void)envp; (void)stdin_fd; (void)stdout_fd; (void)stderr_fd;
+    (void)working_dir; (void)create_new_process_group; (void)detached; (void)out_pid; (void)out_pidfd;
+    errno = ENOTSUP;
+    return -1;
 #endif
-            errno = ECHILD;  // Use ECHILD to indicate child state error
+}
+
+// Stops the spawn server: closes the client socket, which makes the helper exit, and reaps the helper.
+// Returns 0 on success, -1 on error (errno is set).
+int spawn_server_stop(int socket_fd, int pid) {
+    close(socket_fd);
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
             return -1;
         }
-        // Child is now stopped and waiting for SIGCONT
     }
-    
-    // Success - return PID and pidfd if requested
-    if (out_pid != NULL) {
-        *out_pid = child_pid;
+    return 0;
+}
+
+// Waits until no process is left in the cgroup v2: "populated 0" in its cgroup.events file, which is modified when it changes.
+// Returns 0 when the cgroup is empty, 1 on timeout (timeout_ms = -1 waits forever), -1 on error (errno is set).
+int wait_for_cgroup_empty(const char* events_path, int timeout_ms) {
+#ifdef HAVE_CLONE_INTO_CGROUP
+    int inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotify_fd < 0) {
+        return -1;
     }
-    if (out_pidfd != NULL) {
-        *out_pidfd = pidfd;
+
+    // Watch before reading the file, so a change in between is not missed
+    if (inotify_add_watch(inotify_fd, events_path, IN_MODIFY) < 0) {
+        int saved_errno = errno;
+        close(inotify_fd);
+        errno = saved_errno;
+        return -1;
     }
-    return 0;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int result;
+
+    while (1) {
+        char content[256];
+        int events_fd = open(events_path, O_RDONLY | O_CLOEXEC);
+        if (events_fd < 0) {
+            result = -1;
+            break;
+        }
+
+        ssize_t length;
+        while ((length = read(events_fd, content, sizeof(content) - 1)) < 0 && errno == EINTR);
+        close(events_fd);
+        if (length < 0) {
+            result = -1;
+            break;
+        }
+        content[length] = '\0';
+
+        char* populated = strstr(content, "populated ");
+        if (populated != NULL && populated[strlen("populated ")] == '0') {
+            result = 0;
+            break;
+        }
+
+        int remaining = timeout_ms;
+        if (timeout_ms >= 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+            if (elapsed >= timeout_ms) {
+                result = 1;
+                break;
+            }
+            remaining = timeout_ms - (int)elapsed;
+        }
+
+        struct pollfd pfd = { .fd = inotify_fd, .events = POLLIN, .revents = 0 };
+        if (poll(&pfd, 1, remaining) < 0 && errno != EINTR) {
+            result = -1;
+            break;
+        }
+
+        // Drain the notifications, the file is read again anyway
+        char events[sizeof(struct inotify_event) + 256];
+        while (read(inotify_fd, events, sizeof(events)) > 0);
+    }
+
+    int saved_errno = errno;
+    close(inotify_fd);
+    errno = saved_errno;
+    return result;
+#else
+    (void)events_path;
+    (void)timeout_ms;
+    errno = ENOTSUP;
+    return -1;
 #endif
 }
 
@@ -712,15 +1918,72 @@ static int map_status(const siginfo_t* info, int* out_exitCode, int* out_signal)
 }
 #endif
 
+// The resources used by a reaped child (and by the descendants it waited for), as reported by the kernel when reaping it.
+// The layout must match ResourceUsage in SafeChildProcessHandle.Unix.cs.
+typedef struct {
+    int64_t user_time_us;
+    int64_t system_time_us;
+    int64_t max_rss_bytes;
+    int64_t voluntary_context_switches;
+    int64_t involuntary_context_switches;
+    int64_t block_input_operations;
+    int64_t block_output_operations;
+} process_usage;
+
+static void map_usage(const struct rusage* usage, process_usage* out_usage) {
+    if (out_usage == NULL) {
+        return;
+    }
+
+    out_usage->user_time_us = (int64_t)usage->ru_utime.tv_sec * 1000000 + usage->ru_utime.tv_usec;
+    out_usage->system_time_us = (int64_t)usage->ru_stime.tv_sec * 1000000 + usage->ru_stime.tv_usec;
+#ifdef __APPLE__
+    out_usage->max_rss_bytes = (int64_t)usage->ru_maxrss; // bytes on macOS
+#else
+    out_usage->max_rss_bytes = (int64_t)usage->ru_maxrss * 1024; // kilobytes on Linux and the BSDs
+#endif
+    out_usage->voluntary_context_switches = usage->ru_nvcsw;
+    out_usage->involuntary_context_switches = usage->ru_nivcsw;
+    out_usage->block_input_operations = usage->ru_inblock;
+    out_usage->block_output_operations = usage->ru_oublock;
+}
+
+// Reaps the child (or just checks its state with WNOHANG) and gets its resource usage with the same syscall:
+// the waitid syscall takes a struct rusage, unlike the libc wrapper, and wait4 is waitpid with a struct rusage.
+#ifdef HAVE_PIDFD
+static int wait_with_usage(int pidfd, siginfo_t* info, int options, process_usage* out_usage) {
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    int ret;
+    while ((ret = (int)syscall(SYS_waitid, P_PIDFD, pidfd, info, options, &usage)) < 0 && errno == EINTR);
+    if (ret == 0 && info->si_pid != 0) {
+        map_usage(&usage, out_usage);
+    }
+    return ret;
+}
+#else
+static pid_t wait_with_usage(int pid, int* status, int options, process_usage* out_usage) {
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    pid_t ret;
+    while ((ret = wait4(pid, status, options, &usage)) < 0 && errno == EINTR);
+    if (ret > 0) {
+        map_usage(&usage, out_usage);
+    }
+    return ret;
+}
+#endif
+
 // -1 is a valid exit code, so to distinguish between a normal exit code and an error, we return 0 on success and -1 on error
 // Returns 0 if process has exited (exit code set), -1 if still running or error occurred
-int try_get_exit_code(int pidfd, int pid, int* out_exitCode, int* out_signal) {
+// out_usage (optional) receives the resource usage of the process once it has exited.
+int try_get_exit_code(int pidfd, int pid, int* out_exitCode, int* out_signal, process_usage* out_usage) {
     int ret;
 #ifdef HAVE_PIDFD
     (void)pid;
     siginfo_t info;
     memset(&info, 0, sizeof(info));
-    while ((ret = waitid(P_PIDFD, pidfd, &info, WEXITED | WNOHANG)) < 0 && errno == EINTR);
+    ret = wait_with_usage(pidfd, &info, WEXITED | WNOHANG, out_usage);
 
     if (ret == 0 && info.si_pid != 0) {
         return map_status(&info, out_exitCode, out_signal);
@@ -728,7 +1991,7 @@ int try_get_exit_code(int pidfd, int pid, int* out_exitCode, int* out_signal) {
 #else
     (void)pidfd;
     int status;
-    while ((ret = waitpid(pid, &status, WNOHANG)) < 0 && errno == EINTR);
+    ret = wait_with_usage(pid, &status, WNOHANG, out_usage);
 
     if (ret > 0) {
         return map_status(status, out_exitCode, out_signal);
@@ -739,19 +2002,24 @@ int try_get_exit_code(int pidfd, int pid, int* out_exitCode, int* out_signal) {
 }
 
 // -1 is a valid exit code, so to distinguish between a normal exit code and an error, we return 0 on success and -1 on error
-int wait_for_exit_and_reap(int pidfd, int pid, int* out_exitCode, int* out_signal) {
+int wait_for_exit_and_reap(int pidfd, int pid, int* out_exitCode, int* out_signal, process_usage* out_usage) {
     int ret;
+    PAL_PROBE1(wait__reap__start, pid);
 #ifdef HAVE_PIDFD
+    (void)pid;
     siginfo_t info;
     memset(&info, 0, sizeof(info));
-    while ((ret = waitid(P_PIDFD, pidfd, &info, WEXITED)) < 0 && errno == EINTR);
+    ret = wait_with_usage(pidfd, &info, WEXITED, out_usage);
+    PAL_PROBE2(wait__reap__done, pid, ret);
 
     if (ret != -1) {
         return map_status(&info, out_exitCode, out_signal);
     }
 #else
+    (void)pidfd;
     int status;
-    while ((ret = waitpid(pid, &status, 0)) < 0 && errno == EINTR);
+    ret = wait_with_usage(pid, &status, 0, out_usage);
+    PAL_PROBE2(wait__reap__done, pid, ret);
 
     if (ret != -1) {
         return map_status(status, out_exitCode, out_signal);
@@ -760,10 +2028,45 @@ int wait_for_exit_and_reap(int pidfd, int pid, int* out_exitCode, int* out_signa
     return -1;
 }
 
+// Reaps the given processes, which have already exited and that nobody is going to wait for, and closes their process descriptors.
+// Each one is reaped on its own (never with P_ALL or -1), so the children of other code in the process are left alone.
+// Returns how many were reaped.
+int reap_abandoned_processes(const int* pidfds, const int* pids, int count) {
+    int reaped = 0;
+    for (int i = 0; i < count; i++) {
+        process_usage usage;
+#ifdef HAVE_PIDFD
+        siginfo_t info;
+        memset(&info, 0, sizeof(info));
+        if (wait_with_usage(pidfds[i], &info, WEXITED | WNOHANG, &usage) == 0 && info.si_pid != 0) {
+            reaped++;
+        }
+
+        if (pidfds[i] >= 0) {
+            close(pidfds[i]);
+        }
+#else
+        int status;
+        if (wait_with_usage(pids[i], &status, WNOHANG, &usage) > 0) {
+            reaped++;
+        }
+#endif
+    }
+
+#ifdef HAVE_PIDFD
+    (void)pids;
+#else
+    (void)pidfds;
+#endif
+    PAL_PROBE2(reap__abandoned, count, reaped);
+    return reaped;
+}
+
 // Try to wait for exit with cancellation support
 // Returns -1 on error, 1 on cancellation (data in cancelPipeFd), or 0 if process exited.
-int try_wait_for_exit_cancellable(int pidfd, int pid, int cancelPipeFd, int* out_exitCode, int* out_signal) {
+int try_wait_for_exit_cancellable(int pidfd, int pid, int cancelPipeFd, int* out_exitCode, int* out_signal, process_usage* out_usage) {
     int ret;
+    PAL_PROBE2(wait__start, pid, -1);
 #if defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)
     // macOS and FreeBSD have kqueue which can monitor process exit
     int queue = create_kqueue_cloexec();
@@ -788,13 +2091,14 @@ int try_wait_for_exit_cancellable(int pidfd, int pid, int cancelPipeFd, int* out
 
     // Blocking wait (NULL timeout means wait indefinitely)
     while ((ret = kevent(queue, change_list, 2, &event_list, 1, NULL)) < 0 && errno == EINTR);
+    PAL_PROBE2(wait__wakeup, pid, ret);
 
     if (ret < 0) {
         int saved_errno = errno;
         close(queue);
 
         // If the target process does not exist at registration time kevent() returns -1 and errno == ESRCH.
-        if (saved_errno == ESRCH && try_get_exit_code(pidfd, pid, out_exitCode, out_signal) != -1)
+        if (saved_errno == ESRCH && try_get_exit_code(pidfd, pid, out_exitCode, out_signal, out_usage) != -1)
         {
             return 0;
         }
@@ -825,6 +2129,7 @@ int try_wait_for_exit_cancellable(int pidfd, int pid, int cancelPipeFd, int* out
 
     // Blocking wait (timeout = -1 means wait indefinitely)
     while ((ret = poll(pfds, 2, -1)) < 0 && errno == EINTR);
+    PAL_PROBE2(wait__wakeup, pid, ret);
 
     if (ret == -1) { // Error
         return -1;
@@ -842,13 +2147,14 @@ int try_wait_for_exit_cancellable(int pidfd, int pid, int cancelPipeFd, int* out
 #endif
 
     // Process exited - collect exit status
-    return wait_for_exit_and_reap(pidfd, pid, out_exitCode, out_signal);
+    return wait_for_exit_and_reap(pidfd, pid, out_exitCode, out_signal, out_usage);
 }
 
 // Try to wait for exit with timeout, but don't kill the process if timeout occurs
 // Returns -1 on error, 1 on timeout, or 0 if process exited.
-int try_wait_for_exit(int pidfd, int pid, int timeout_ms, int* out_exitCode, int* out_signal) {
+int try_wait_for_exit(int pidfd, int pid, int timeout_ms, int* out_exitCode, int* out_signal, process_usage* out_usage) {
     int ret;
+    PAL_PROBE2(wait__start, pid, timeout_ms);
 #if defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)
     // macOS and FreeBSD have kqueue which can monitor process exit
     int queue = create_kqueue_cloexec();
@@ -869,13 +2175,14 @@ int try_wait_for_exit(int pidfd, int pid, int timeout_ms, int* out_exitCode, int
     timeout.tv_nsec = (timeout_ms % 1000) * 1000 * 1000;
 
     while ((ret = kevent(queue, &change_list, 1, &event_list, 1, &timeout)) < 0 && errno == EINTR);
+    PAL_PROBE2(wait__wakeup, pid, ret);
 
     if (ret < 0) {
         int saved_errno = errno;
         close(queue);
 
         // If the target process does not exist at registration time kevent() returns -1 and errno == ESRCH.
-        if (errno == ESRCH && try_get_exit_code(pidfd, pid, out_exitCode, out_signal) != -1)
+        if (errno == ESRCH && try_get_exit_code(pidfd, pid, out_exitCode, out_signal, out_usage) != -1)
         {
             return 0;
         }
@@ -894,6 +2201,7 @@ int try_wait_for_exit(int pidfd, int pid, int timeout_ms, int* out_exitCode, int
     pfd.events = POLLHUP | POLLIN;
 
     while ((ret = poll(&pfd, 1, timeout_ms)) < 0 && errno == EINTR);
+    PAL_PROBE2(wait__wakeup, pid, ret);
 
     if (ret == -1) { // Error
         return -1;
@@ -909,13 +2217,148 @@ int try_wait_for_exit(int pidfd, int pid, int timeout_ms, int* out_exitCode, int
     }
 
     // Process exited - collect exit status
-    return wait_for_exit_and_reap(pidfd, pid, out_exitCode, out_signal);
+    return wait_for_exit_and_reap(pidfd, pid, out_exitCode, out_signal, out_usage);
+}
+
+// Waits for the first of many processes to exit with a single kernel wait, without reaping any of them.
+// Returns -1 on error, 1 on timeout, or 0 if a process exited, with its index in out_index.
+int wait_for_any_exit(const int* pidfds, const int* pids, int count, int timeout_ms, int* out_index) {
+    int ret;
+    PAL_PROBE2(wait__any__start, count, timeout_ms);
+#if defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)
+    int queue = create_kqueue_cloexec();
+    if (queue == -1) {
+        return -1;
+    }
+
+    struct kevent* changes = malloc(sizeof(struct kevent) * (size_t)count * 2);
+    if (changes == NULL) {
+        close(queue);
+        errno = ENOMEM;
+        return -1;
+    }
+    struct kevent* receipts = changes + count;
+
+    for (int i = 0; i < count; i++) {
+        memset(&changes[i], 0, sizeof(struct kevent));
+        changes[i].ident = pids[i];
+        changes[i].filter = EVFILT_PROC;
+        changes[i].fflags = NOTE_EXIT;
+        // EV_RECEIPT reports the result of every registration, instead of failing the whole call at the first process that is gone.
+        changes[i].flags = EV_ADD | EV_CLEAR | EV_RECEIPT;
+        changes[i].udata = (void*)(intptr_t)i;
+    }
+
+    struct timespec no_wait = { 0 };
+    while ((ret = kevent(queue, changes, count, receipts, count, &no_wait)) < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        int saved_errno = errno;
+        free(changes);
+        close(queue);
+        errno = saved_errno;
+        return -1;
+    }
+
+    // The processes that do not exist at registration time have already exited (they may be zombies).
+    int exited = -1;
+    for (int i = 0; i < ret; i++) {
+        if ((receipts[i].flags & EV_ERROR) && receipts[i].data != 0) {
+            int index = (int)(intptr_t)receipts[i].udata;
+            if (receipts[i].data != ESRCH) {
+                free(changes);
+                close(queue);
+                errno = (int)receipts[i].data;
+                return -1;
+            }
+            if (exited == -1 || index < exited) {
+                exited = index;
+            }
+        }
+    }
+    free(changes);
+
+    if (exited != -1) {
+        close(queue);
+        *out_index = exited;
+        return 0;
+    }
+
+    struct kevent event = { 0 };
+    struct timespec timeout = { 0 };
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000 * 1000;
+
+    while ((ret = kevent(queue, NULL, 0, &event, 1, timeout_ms < 0 ? NULL : &timeout)) < 0 && errno == EINTR);
+    PAL_PROBE2(wait__any__wakeup, count, ret);
+
+    int saved_errno = errno;
+    close(queue);
+
+    if (ret < 0) {
+        errno = saved_errno;
+        return -1;
+    }
+    if (ret == 0) {
+        return 1;
+    }
+
+    *out_index = (int)(intptr_t)event.udata;
+    return 0;
+#elif defined(HAVE_PIDFD)
+    struct pollfd* pfds = malloc(sizeof(struct pollfd) * (size_t)count);
+    if (pfds == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (pidfds[i] < 0) {
+            // poll() would silently ignore it and never report the exit
+            free(pfds);
+            errno = ENOTSUP;
+            return -1;
+        }
+        pfds[i].fd = pidfds[i];
+        pfds[i].events = POLLHUP | POLLIN;
+        pfds[i].revents = 0;
+    }
+
+    while ((ret = poll(pfds, (nfds_t)count, timeout_ms)) < 0 && errno == EINTR);
+    PAL_PROBE2(wait__any__wakeup, count, ret);
+
+    if (ret > 0) {
+        for (int i = 0; i < count; i++) {
+            if (pfds[i].revents != 0) {
+                *out_index = i;
+                break;
+            }
+        }
+    }
+
+    int saved_errno = errno;
+    free(pfds);
+    errno = saved_errno;
+
+    if (ret == -1) {
+        return -1;
+    }
+    return ret == 0 ? 1 : 0;
+#else
+    (void)pidfds;
+    (void)pids;
+    (void)count;
+    (void)timeout_ms;
+    (void)out_index;
+    errno = ENOTSUP;
+    return -1;
+#endif
 }
 
 
 // -1 is a valid exit code, so to distinguish between a normal exit code and an error, we return 0 on success and -1 on error
-int wait_for_exit_or_kill_on_timeout(int pidfd, int pid, int timeout_ms, int* out_exitCode, int* out_signal, int* out_timeout) {
-    int ret = try_wait_for_exit(pidfd, pid, timeout_ms, out_exitCode, out_signal);
+int wait_for_exit_or_kill_on_timeout(int pidfd, int pid, int timeout_ms, int* out_exitCode, int* out_signal, int* out_timeout, process_usage* out_usage) {
+    int ret = try_wait_for_exit(pidfd, pid, timeout_ms, out_exitCode, out_signal, out_usage);
     if (ret != 1) {
         return ret; // Either process exited (0) or error occurred (-1)
     }
@@ -937,7 +2380,226 @@ int wait_for_exit_or_kill_on_timeout(int pidfd, int pid, int timeout_ms, int* ou
         }
     }
 
-    return wait_for_exit_and_reap(pidfd, pid, out_exitCode, out_signal);
+    return wait_for_exit_and_reap(pidfd, pid, out_exitCode, out_signal, out_usage);
+}
+
+// Creates the process-wide queue used to get notified about process exits and pipe readiness
+// without blocking a thread per operation: kqueue on macOS and FreeBSD, epoll on Linux.
+// Returns the queue file descriptor, or -1 on error (errno is set, ENOTSUP when not supported).
+int create_reactor(void) {
+#if defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)
+    return create_kqueue_cloexec();
+#elif defined(HAVE_SYS_EPOLL_H)
+    return epoll_create1(EPOLL_CLOEXEC);
+#else
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
+
+#if !(defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)) && defined(HAVE_SYS_EPOLL_H)
+// Adds a one-shot registration for the file descriptor, or re-arms the existing one.
+static int epoll_register_oneshot(int reactor, int fd, uint64_t token) {
+    struct epoll_event event = { 0 };
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = token;
+
+    int ret = epoll_ctl(reactor, EPOLL_CTL_ADD, fd, &event);
+    if (ret < 0 && errno == EEXIST) {
+        // One-shot registrations stay in the interest list after they fire, re-arm them.
+        ret = epoll_ctl(reactor, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    return ret;
+}
+#endif
+
+// Starts monitoring the exit of the given process. The notification (carrying the token) is delivered only once.
+// Returns 0 on success, 1 if the process has already exited (no notification will be delivered), -1 on error (errno is set).
+int reactor_register_exit(int reactor, int pidfd, int pid, uint64_t token) {
+    int ret;
+#if defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)
+    (void)pidfd;
+    struct kevent change = { 0 };
+    change.ident = pid;
+    change.filter = EVFILT_PROC;
+    change.fflags = NOTE_EXIT;
+    change.flags = EV_ADD | EV_ONESHOT;
+    change.udata = (void*)(uintptr_t)token;
+
+    while ((ret = kevent(reactor, &change, 1, NULL, 0, NULL)) < 0 && errno == EINTR);
+
+    // If the target process does not exist at registration time kevent() returns -1 and errno == ESRCH.
+    if (ret < 0 && errno == ESRCH) {
+        return 1;
+    }
+
+    return ret < 0 ? -1 : 0;
+#elif defined(HAVE_PIDFD) && defined(HAVE_SYS_EPOLL_H)
+    (void)pid;
+    if (pidfd < 0) {
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    // A process descriptor becomes readable when the process exits (it stays readable until it's reaped).
+    ret = epoll_register_oneshot(reactor, pidfd, token);
+    return ret < 0 ? -1 : 0;
+#else
+    (void)reactor;
+    (void)pidfd;
+    (void)pid;
+    (void)token;
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
+
+// Starts monitoring the given file descriptor for read readiness (data or EOF).
+// The notification (carrying the token) is delivered only once.
+// Returns 0 on success, -1 on error (errno is set).
+int reactor_register_read(int reactor, int fd, uint64_t token) {
+    int ret;
+#if defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)
+    struct kevent change = { 0 };
+    change.ident = fd;
+    change.filter = EVFILT_READ;
+    change.flags = EV_ADD | EV_ONESHOT;
+    change.udata = (void*)(uintptr_t)token;
+
+    while ((ret = kevent(reactor, &change, 1, NULL, 0, NULL)) < 0 && errno == EINTR);
+#elif defined(HAVE_SYS_EPOLL_H)
+    ret = epoll_register_oneshot(reactor, fd, token);
+#else
+    (void)reactor;
+    (void)fd;
+    (void)token;
+    errno = ENOTSUP;
+    ret = -1;
+#endif
+    return ret < 0 ? -1 : 0;
+}
+
+// Stops monitoring the exit of the given process.
+// Returns 0 on success, -1 on error (errno is set, ENOENT when the process was not monitored).
+int reactor_unregister_exit(int reactor, int pidfd, int pid) {
+    int ret;
+#if defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)
+    (void)pidfd;
+    struct kevent change = { 0 };
+    change.ident = pid;
+    change.filter = EVFILT_PROC;
+    change.flags = EV_DELETE;
+
+    while ((ret = kevent(reactor, &change, 1, NULL, 0, NULL)) < 0 && errno == EINTR);
+#elif defined(HAVE_SYS_EPOLL_H)
+    (void)pid;
+    ret = epoll_ctl(reactor, EPOLL_CTL_DEL, pidfd, NULL);
+#else
+    (void)reactor;
+    (void)pidfd;
+    (void)pid;
+    errno = ENOTSUP;
+    ret = -1;
+#endif
+    return ret;
+}
+
+// Stops monitoring the given file descriptor for read readiness.
+// Returns 0 on success, -1 on error (errno is set, ENOENT when the file descriptor was not monitored).
+int reactor_unregister_read(int reactor, int fd) {
+    int ret;
+#if defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)
+    struct kevent change = { 0 };
+    change.ident = fd;
+    change.filter = EVFILT_READ;
+    change.flags = EV_DELETE;
+
+    while ((ret = kevent(reactor, &change, 1, NULL, 0, NULL)) < 0 && errno == EINTR);
+#elif defined(HAVE_SYS_EPOLL_H)
+    ret = epoll_ctl(reactor, EPOLL_CTL_DEL, fd, NULL);
+#else
+    (void)reactor;
+    (void)fd;
+    errno = ENOTSUP;
+    ret = -1;
+#endif
+    return ret;
+}
+
+// Blocks until at least one of the registrations fires and stores their tokens in out_tokens.
+// Exited processes are not reaped.
+// Returns the number of tokens stored, or -1 on error (errno is set).
+int reactor_wait(int reactor, uint64_t* out_tokens, int capacity) {
+    int ret;
+#if defined(HAVE_KQUEUE) || defined(HAVE_KQUEUEX)
+    struct kevent events[64];
+    if (capacity > 64) {
+        capacity = 64;
+    }
+
+    while ((ret = kevent(reactor, NULL, 0, events, capacity, NULL)) < 0 && errno == EINTR);
+
+    for (int i = 0; i < ret; i++) {
+        out_tokens[i] = (uint64_t)(uintptr_t)events[i].udata;
+    }
+#elif defined(HAVE_SYS_EPOLL_H)
+    struct epoll_event events[64];
+    if (capacity > 64) {
+        capacity = 64;
+    }
+
+    while ((ret = epoll_wait(reactor, events, capacity, -1)) < 0 && errno == EINTR);
+
+    for (int i = 0; i < ret; i++) {
+        out_tokens[i] = events[i].data.u64;
+    }
+#else
+    (void)reactor;
+    (void)out_tokens;
+    (void)capacity;
+    errno = ENOTSUP;
+    ret = -1;
+#endif
+    return ret;
+}
+
+// Moves all the data that is currently buffered in the non-blocking pipe into the file, without copying it to user space.
+// The data is written at *file_offset, which is advanced by the number of bytes moved.
+// Returns 1 when the pipe has been drained for now, 0 on EOF and -1 on error (errno is set).
+// errno is set to ENOTSUP when it's not supported by the platform, and to EINVAL or ESPIPE when the file does not support it.
+int splice_to_file(int pipe_fd, int file_fd, int64_t* file_offset) {
+#ifdef HAVE_SPLICE
+    // Devices like /dev/null accept the data, but it can't be read back from them.
+    struct stat file_stat;
+    if (fstat(file_fd, &file_stat) != 0) {
+        return -1;
+    }
+    if (!S_ISREG(file_stat.st_mode)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    while (1) {
+        loff_t offset = (loff_t)*file_offset;
+        ssize_t moved = splice(pipe_fd, NULL, file_fd, &offset, 1024 * 1024, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (moved > 0) {
+            *file_offset = (int64_t)offset;
+        } else if (moved == 0) {
+            return 0;
+        } else if (errno == EAGAIN) {
+            return 1;
+        } else if (errno != EINTR) {
+            return -1;
+        }
+    }
+#else
+    (void)pipe_fd;
+    (void)file_fd;
+    (void)file_offset;
+    errno = ENOTSUP;
+    return -1;
+#endif
 }
 
 // Opens an existing process by its process ID.
@@ -0,0 +1,110 @@
+// Counts the syscalls a child started by spawn_process makes between the fork and the return of execve,
+// which is the window during which the parent is suspended under CLONE_VFORK (Linux only, ptrace based).
+//
+//   cmake -S native -B native/build -DPAL_BUILD_TOOLS=ON && cmake --build native/build
+//   native/build/count_child_syscalls [iterations]
+//
+// The traced process installs handlers for the signals the .NET runtime handles and ignores SIGPIPE, like a managed app,
+// then spawns /bin/true. The reported count includes execve itself.
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+
+// Exported by libpal_process, which has no header: the managed code declares them with LibraryImport.
+int spawn_process(const char* path, char* const argv[], char* const envp[], int stdin_fd, int stdout_fd, int stderr_fd,
+    const char* working_dir, int* out_pid, int* out_pidfd, int kill_on_parent_death, int create_suspended,
+    int create_new_process_group, int detached, const int* inherited_handles, int inherited_handles_count,
+    int cgroup_fd, int process_group_id);
+int wait_for_exit_and_reap(int pidfd, int pid, int* out_exitCode, int* out_signal, void* out_usage);
+
+#define MAX_PID (1 << 22)
+
+static void handler(int sig) {
+    (void)sig;
+}
+
+static int run_traced(int iterations) {
+    static const int handled[] = { SIGINT, SIGQUIT, SIGTERM, SIGCHLD, SIGCONT, SIGWINCH, SIGTTIN, SIGTTOU,
+        SIGSEGV, SIGFPE, SIGILL, SIGBUS, SIGTRAP, SIGABRT };
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handler;
+    for (size_t i = 0; i < sizeof(handled) / sizeof(handled[0]); i++) {
+        sigaction(handled[i], &action, NULL);
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    char* argv[] = { "/bin/true", NULL };
+    for (int i = 0; i < iterations; i++) {
+        int pid, pidfd, exit_code, signal_number;
+        if (spawn_process(argv[0], argv, NULL, 0, 1, 2, NULL, &pid, &pidfd, 0, 0, 0, 0, NULL, 0, -1, 0) != 0) {
+            perror("spawn_process");
+            return 1;
+        }
+        wait_for_exit_and_reap(pidfd, pid, &exit_code, &signal_number, NULL);
+        close(pidfd);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 1;
+
+    pid_t root = fork();
+    if (root == 0) {
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+        raise(SIGSTOP);
+        _exit(run_traced(iterations));
+    }
+
+    int status;
+    waitpid(root, &status, 0);
+    ptrace(PTRACE_SETOPTIONS, root, NULL,
+        PTRACE_O_TRACECLONE | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK | PTRACE_O_TRACEEXEC | PTRACE_O_TRACESYSGOOD);
+    ptrace(PTRACE_SYSCALL, root, NULL, NULL);
+
+    // Indexed by PID: the syscall-stops alternate between entry and exit, the children are counted until their exec event
+    static unsigned char in_syscall[MAX_PID], exec_done[MAX_PID];
+    static int counts[MAX_PID];
+    long total = 0;
+    int children = 0;
+
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, __WALL)) > 0) {
+        if (!WIFSTOPPED(status)) {
+            continue;
+        }
+
+        int index = pid % MAX_PID, signal_number = WSTOPSIG(status), deliver = 0;
+        if (signal_number == (SIGTRAP | 0x80)) {
+            in_syscall[index] = !in_syscall[index];
+            if (in_syscall[index] && pid != root && !exec_done[index]) {
+                counts[index]++;
+            }
+        } else if (signal_number == SIGTRAP && (status >> 16) == PTRACE_EVENT_EXEC) {
+            // The exec-stop comes before the exit of execve, which is then reported as a syscall entry
+            if (pid != root && !exec_done[index]) {
+                exec_done[index] = 1;
+                in_syscall[index] = 1;
+                total += counts[index];
+                children++;
+            }
+        } else if (signal_number != SIGTRAP && signal_number != SIGSTOP) {
+            deliver = signal_number;
+        }
+
+        ptrace(PTRACE_SYSCALL, pid, NULL, (void*)(long)deliver);
+    }
+
+    if (children == 0) {
+        fprintf(stderr, "No child was traced\n");
+        return 1;
+    }
+
+    printf("%d children, %.1f syscalls per child between the fork and execve\n", children, (double)total / children);
+    return 0;
+}
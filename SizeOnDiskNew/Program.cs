@@ -1,8 +1,14 @@
 ﻿using System.TBA;
 
-ProcessStartOptions info = new("dotnet")
+// The startup benchmark (Benchmarks --startup) passes the child to start.
+ProcessStartOptions info = args.Length > 0 ? new(args[0]) : new("dotnet")
 {
     Arguments = { "--help" },
 };
 
+for (int i = 1; i < args.Length; i++)
+{
+    info.Arguments.Add(args[i]);
+}
+
 return ChildProcess.Inherit(info).ExitCode;
\ No newline at end of file
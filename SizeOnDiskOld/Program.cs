@@ -1,6 +1,7 @@
 ﻿using System.Diagnostics;
 
-ProcessStartInfo info = new()
+// The startup benchmark (Benchmarks --startup) passes the child to start.
+ProcessStartInfo info = args.Length > 0 ? new(args[0], args[1..]) : new()
 {
     FileName = "dotnet",
     ArgumentList = { "--help" },
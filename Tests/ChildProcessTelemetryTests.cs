@@ -0,0 +1,94 @@
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics.Metrics;
+using System.Diagnostics.Tracing;
+using System.Linq;
+using System.TBA;
+
+namespace Tests;
+
+public class ChildProcessTelemetryTests
+{
+    [Fact]
+    public static void CaptureOutput_RecordsStartPhasesAndOutputBytes()
+    {
+        // The listener is process-wide and the other tests run in parallel, so only the presence of the measurements is verified.
+        ConcurrentQueue<(string Instrument, double Value, string? Phase)> measurements = new();
+
+        using MeterListener listener = new();
+        listener.InstrumentPublished = (instrument, meterListener) =>
+        {
+            if (instrument.Meter.Name == "System.TBA.ChildProcess")
+            {
+                meterListener.EnableMeasurementEvents(instrument);
+            }
+        };
+        listener.SetMeasurementEventCallback<double>((instrument, value, tags, _) => measurements.Enqueue((instrument.Name, value, GetPhase(tags))));
+        listener.SetMeasurementEventCallback<long>((instrument, value, tags, _) => measurements.Enqueue((instrument.Name, value, null)));
+        listener.Start();
+
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "echo hello" } }
+            : new("echo") { Arguments = { "hello" } };
+
+        ProcessOutput output = ChildProcess.CaptureOutput(options);
+        Assert.Equal(0, output.ExitStatus.ExitCode);
+
+        Assert.Contains(measurements, m => m.Instrument == "tba.process.start.duration" && m.Value > 0);
+        Assert.Contains(measurements, m => m.Instrument == "tba.process.start.phase.duration" && m.Phase == "spawn");
+        Assert.Contains(measurements, m => m.Instrument == "tba.process.start.phase.duration" && m.Phase == "marshal_arguments");
+        Assert.Contains(measurements, m => m.Instrument == "tba.process.output.first_byte.duration");
+        Assert.Contains(measurements, m => m.Instrument == "tba.process.output.bytes" && m.Value >= "hello".Length);
+        Assert.Contains(measurements, m => m.Instrument == "tba.process.active" && m.Value == 1);
+        Assert.Contains(measurements, m => m.Instrument == "tba.process.active" && m.Value == -1);
+    }
+
+    [Fact]
+    public static void WaitForExit_WritesStartAndExitEvents()
+    {
+        using EventCollector collector = new();
+
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "exit 3" } }
+            : new("sh") { Arguments = { "-c", "exit 3" } };
+
+        using Microsoft.Win32.SafeHandles.SafeChildProcessHandle processHandle = Microsoft.Win32.SafeHandles.SafeChildProcessHandle.Start(options, input: null, output: null, error: null);
+        processHandle.WaitForExit();
+
+        EventWrittenEventArgs[] events = collector.Events.ToArray();
+        Assert.Contains(events, e => e.EventName == "SpawnStart" && (string?)e.Payload![0] == options.FileName);
+        Assert.Contains(events, e => e.EventName == "SpawnStop" && (int)e.Payload![0]! == processHandle.ProcessId);
+        Assert.Contains(events, e => e.EventName == "ProcessExited"
+            && (int)e.Payload![0]! == processHandle.ProcessId
+            && (int)e.Payload![1]! == 3);
+    }
+
+    private static string? GetPhase(ReadOnlySpan<KeyValuePair<string, object?>> tags)
+    {
+        foreach (KeyValuePair<string, object?> tag in tags)
+        {
+            if (tag.Key == "phase")
+            {
+                return (string?)tag.Value;
+            }
+        }
+
+        return null;
+    }
+
+    private sealed class EventCollector : EventListener
+    {
+        internal ConcurrentQueue<EventWrittenEventArgs> Events { get; } = new();
+
+        protected override void OnEventSourceCreated(EventSource eventSource)
+        {
+            if (eventSource.Name == "System.TBA.ChildProcess")
+            {
+                EnableEvents(eventSource, EventLevel.Informational);
+            }
+        }
+
+        protected override void OnEventWritten(EventWrittenEventArgs eventData) => Events.Enqueue(eventData);
+    }
+}
@@ -5,7 +5,7 @@ using Microsoft.Win32.SafeHandles;
 
 namespace Tests;
 
-public class CreatePipeTests
+public partial class CreatePipeTests
 {
     [Theory]
     [InlineData(false, false)]
@@ -104,4 +104,30 @@ public class CreatePipeTests
             Assert.Equal(message, buffer);
         }
     }
+
+    [Fact]
+    public static void CreatePipe_ThrowsForNegativeCapacity()
+    {
+        Assert.Throws<ArgumentOutOfRangeException>(() => File.CreatePipe(out _, out _, capacity: -1));
+    }
+
+#if LINUX
+    [Fact]
+#endif
+    public static void CreatePipe_AppliesTheCapacity()
+    {
+        const int F_GETPIPE_SZ = 1032;
+        const int Capacity = 256 * 1024;
+
+        File.CreatePipe(out SafeFileHandle readHandle, out SafeFileHandle writeHandle, capacity: Capacity);
+
+        using (readHandle)
+        using (writeHandle)
+        {
+            Assert.Equal(Capacity, fcntl((int)readHandle.DangerousGetHandle(), F_GETPIPE_SZ));
+        }
+    }
+
+    [System.Runtime.InteropServices.LibraryImport("libc", SetLastError = true)]
+    private static partial int fcntl(int fd, int cmd);
 }
@@ -0,0 +1,110 @@
+using System;
+using System.Diagnostics;
+using System.IO;
+using System.TBA;
+using System.Threading;
+
+namespace Tests;
+
+// The cache and its settings apply to the whole process, so the other tests must not resolve paths in the meantime.
+[CollectionDefinition(nameof(ExecutablePathCacheTests), DisableParallelization = true)]
+public class ExecutablePathCacheCollection
+{
+}
+
+[Collection(nameof(ExecutablePathCacheTests))]
+public class ExecutablePathCacheTests
+{
+    [Fact]
+    public static void ResolvePath_SecondResolutionIsServedFromTheCache()
+    {
+        string executable = OperatingSystem.IsWindows() ? "cmd" : "sh";
+
+        string first = ProcessStartOptions.ResolvePath(executable).FileName;
+        long hits = ExecutablePathCache.Hits;
+        string second = ProcessStartOptions.ResolvePath(executable).FileName;
+
+        Assert.Equal(first, second);
+        Assert.True(ExecutablePathCache.Hits > hits);
+    }
+
+    [Fact]
+    public static void ResolvePath_CachesFilesThatCouldNotBeFound()
+    {
+        string fileName = Guid.NewGuid().ToString() + ".tmp";
+        string fullPath = Path.Combine(Directory.GetCurrentDirectory(), fileName);
+
+        long misses = ExecutablePathCache.Misses;
+        Assert.Throws<FileNotFoundException>(() => ProcessStartOptions.ResolvePath(fileName));
+        Assert.True(ExecutablePathCache.Misses > misses);
+
+        try
+        {
+            File.WriteAllText(fullPath, "test");
+
+            // The negative entry has not expired yet.
+            long hits = ExecutablePathCache.Hits;
+            Assert.Throws<FileNotFoundException>(() => ProcessStartOptions.ResolvePath(fileName));
+            Assert.True(ExecutablePathCache.Hits > hits);
+
+            ExecutablePathCache.Clear();
+
+            Assert.Equal(fullPath, ProcessStartOptions.ResolvePath(fileName).FileName);
+        }
+        finally
+        {
+            File.Delete(fullPath);
+        }
+    }
+
+    [Fact]
+    public static void WatchPathDirectories_InvalidatesTheCacheWhenFilesAreCreated()
+    {
+        string fileName = Guid.NewGuid().ToString() + ".tmp";
+        string fullPath = Path.Combine(Directory.GetCurrentDirectory(), fileName);
+
+        // Without the notification, the negative entry would never expire.
+        TimeSpan negativeEntryTimeToLive = ExecutablePathCache.NegativeEntryTimeToLive;
+        ExecutablePathCache.NegativeEntryTimeToLive = Timeout.InfiniteTimeSpan;
+        ExecutablePathCache.WatchPathDirectories = true;
+
+        try
+        {
+            Assert.Throws<FileNotFoundException>(() => ProcessStartOptions.ResolvePath(fileName));
+
+            File.WriteAllText(fullPath, "test");
+
+            // The notification is asynchronous.
+            Stopwatch stopwatch = Stopwatch.StartNew();
+            string? resolved = null;
+            while (resolved is null && stopwatch.Elapsed < TimeSpan.FromSeconds(5))
+            {
+                try
+                {
+                    resolved = ProcessStartOptions.ResolvePath(fileName).FileName;
+                }
+                catch (FileNotFoundException)
+                {
+                    Thread.Sleep(10);
+                }
+            }
+
+            Assert.Equal(fullPath, resolved);
+        }
+        finally
+        {
+            ExecutablePathCache.WatchPathDirectories = false;
+            ExecutablePathCache.NegativeEntryTimeToLive = negativeEntryTimeToLive;
+            File.Delete(fullPath);
+        }
+    }
+
+    [Fact]
+    public static void TimeToLive_ThrowsForNegativeValues()
+    {
+        Assert.Throws<ArgumentOutOfRangeException>(() => ExecutablePathCache.PositiveEntryTimeToLive = TimeSpan.FromSeconds(-1));
+        Assert.Throws<ArgumentOutOfRangeException>(() => ExecutablePathCache.NegativeEntryTimeToLive = TimeSpan.FromSeconds(-1));
+
+        Assert.Equal(TimeSpan.FromMinutes(1), ExecutablePathCache.PositiveEntryTimeToLive);
+    }
+}
@@ -1,5 +1,6 @@
 using System;
 using System.IO;
+using System.Runtime.InteropServices;
 using System.Text;
 using System.Threading.Tasks;
 using System.TBA;
@@ -199,4 +200,35 @@ public class InheritedHandlesTests
         int exitCode = processHandle.WaitForExit().ExitCode;
         Assert.Equal(0, exitCode);
     }
+
+#if !WINDOWS
+    [Theory]
+#endif
+    [InlineData(true)]
+    [InlineData(false)]
+    public static void InheritedHandles_OnlyThoseAreInherited_EvenWithoutCloseOnExec(bool inherit)
+    {
+        // Unlike the descriptors opened by .NET, the ones created by socketpair don't have FD_CLOEXEC set
+        int[] fds = new int[2];
+        Assert.Equal(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+        using SafeFileHandle first = new((IntPtr)fds[0], ownsHandle: true);
+        using SafeFileHandle second = new((IntPtr)fds[1], ownsHandle: true);
+
+        ProcessStartOptions options = new("sh") { Arguments = { "-c", $"test -e /dev/fd/{fds[0]}" } };
+        if (inherit)
+        {
+            options.InheritedHandles.Add(first);
+        }
+
+        using SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input: null, output: null, error: null);
+
+        Assert.Equal(inherit ? 0 : 1, processHandle.WaitForExit().ExitCode);
+    }
+
+    private const int AF_UNIX = 1;
+    private const int SOCK_STREAM = 1;
+
+    [DllImport("libc", SetLastError = true)]
+    private static extern int socketpair(int domain, int type, int protocol, int[] sv);
 }
@@ -0,0 +1,81 @@
+using System;
+using System.Buffers;
+using System.TBA;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace Tests;
+
+public class InterleavedOutputTests
+{
+    [Theory]
+    [InlineData(true)]
+    [InlineData(false)]
+    public static async Task CaptureInterleaved_RecordsTheStreamAndOrderOfTheChunks(bool useAsync)
+    {
+        // The pauses make sure every line is read on its own.
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("powershell") { Arguments = { "-InputFormat", "None", "-Command",
+                "[Console]::Out.Write('one;'); Start-Sleep -Milliseconds 200; [Console]::Error.Write('two;'); Start-Sleep -Milliseconds 200; [Console]::Out.Write('three;'); exit 3" } }
+            : new("sh") { Arguments = { "-c", "printf 'one;'; sleep 0.2; printf 'two;' >&2; sleep 0.2; printf 'three;'; exit 3" } };
+
+        using InterleavedOutput result = useAsync
+            ? await ChildProcess.CaptureInterleavedAsync(options)
+            : ChildProcess.CaptureInterleaved(options);
+
+        Assert.Equal(3, result.ExitStatus.ExitCode);
+        Assert.Equal("one;three;", Encoding.UTF8.GetString(result.StandardOutput));
+        Assert.Equal("two;", Encoding.UTF8.GetString(result.StandardError));
+        Assert.Equal("one;two;three;", result.GetText());
+
+        ProcessOutputChunk[] chunks = result.Chunks.ToArray();
+        Assert.Equal(3, chunks.Length);
+        Assert.Equal("one;", Encoding.UTF8.GetString(result.GetBytes(chunks[0])));
+        Assert.Equal("two;", Encoding.UTF8.GetString(result.GetBytes(chunks[1])));
+        Assert.Equal("three;", Encoding.UTF8.GetString(result.GetBytes(chunks[2])));
+        Assert.False(chunks[0].StandardError);
+        Assert.True(chunks[1].StandardError);
+        Assert.False(chunks[2].StandardError);
+        Assert.Equal(0, chunks[1].Offset);
+        Assert.Equal(4, chunks[2].Offset);
+        Assert.True(chunks[0].Timestamp < chunks[1].Timestamp && chunks[1].Timestamp < chunks[2].Timestamp);
+    }
+
+    [Fact]
+    public static void CaptureInterleaved_ChunksCoverAllTheOutput()
+    {
+        // Far more than a pipe can hold, so it's read in many chunks.
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("powershell") { Arguments = { "-InputFormat", "None", "-Command", "1..100000 | ForEach-Object { $_; [Console]::Error.WriteLine($_) }" } }
+            : new("sh") { Arguments = { "-c", "seq 100000 | tee /dev/stderr" } };
+
+        using InterleavedOutput result = ChildProcess.CaptureInterleaved(options);
+
+        long outputLength = 0, errorLength = 0;
+        foreach (ProcessOutputChunk chunk in result.Chunks)
+        {
+            ref long length = ref chunk.StandardError ? ref errorLength : ref outputLength;
+            Assert.Equal(length, chunk.Offset);
+            length += chunk.Length;
+        }
+
+        Assert.True(result.Chunks.Length > 2);
+        Assert.Equal(result.StandardOutput.Length, outputLength);
+        Assert.Equal(result.StandardError.Length, errorLength);
+        Assert.Equal(result.StandardOutput.ToArray(), result.StandardError.ToArray());
+    }
+
+    [Fact]
+    public static void InterleavedOutput_ThrowsAfterDispose()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo Hello" } }
+            : new("sh") { Arguments = { "-c", "echo Hello" } };
+
+        InterleavedOutput result = ChildProcess.CaptureInterleaved(options);
+        result.Dispose();
+
+        Assert.Throws<ObjectDisposedException>(() => result.StandardOutput);
+        Assert.Throws<ObjectDisposedException>(() => result.Chunks.Length);
+    }
+}
@@ -1,5 +1,6 @@
 using System.IO;
 using System;
+using System.Threading;
 using System.Threading.Tasks;
 using System.TBA;
 using PosixSignal = System.TBA.PosixSignal;
@@ -63,4 +64,140 @@ public class PipingTests
             Assert.Equal(expectedOutput, result, ignoreLineEndingDifferences: true);
         }
     }
+
+    [Fact]
+    public static void StartPipeline_ConnectsAllTheStages()
+    {
+        ProcessStartOptions[] stages = OperatingSystem.IsWindows()
+            ? [
+                new("cmd") { Arguments = { "/c", "echo b-test & echo skipped & echo a-test" } },
+                new("findstr") { Arguments = { "test" } },
+                new("sort"),
+            ]
+            : [
+                new("printf") { Arguments = { "b-test\\nskipped\\na-test\\n" } },
+                new("grep") { Arguments = { "test" } },
+                new("sort"),
+            ];
+
+        File.CreatePipe(out SafeFileHandle readPipe, out SafeFileHandle writePipe);
+
+        using (readPipe)
+        {
+            SafeChildProcessHandle[] handles = SafeChildProcessHandle.StartPipeline(stages, input: null, output: writePipe, error: null);
+
+            // The write end has been closed by StartPipeline, so EOF comes once the last stage exits.
+            using StreamReader reader = new(new FileStream(readPipe, FileAccess.Read, bufferSize: 1));
+            string output = reader.ReadToEnd().Replace(" ", "");
+
+            Assert.Equal("a-test\nb-test\n", output, ignoreLineEndingDifferences: true);
+            foreach (SafeChildProcessHandle handle in handles)
+            {
+                using (handle)
+                {
+                    Assert.Equal(0, handle.WaitForExit().ExitCode);
+                }
+            }
+        }
+    }
+
+    [Fact]
+    public static void StartPipeline_DoesNotStartAnythingWhenAStageCantBeResolved()
+    {
+        ProcessStartOptions[] stages = [new(OperatingSystem.IsWindows() ? "cmd" : "sh"), new("there-is-no-such-executable"), new("sort")];
+
+        Assert.ThrowsAny<Exception>(() => SafeChildProcessHandle.StartPipeline(stages, input: null, output: null, error: null));
+    }
+
+    [Fact]
+    public static void OutputPipeCapacity_ThrowsForNegativeValues()
+    {
+        ProcessStartOptions options = new("sort");
+
+        Assert.Throws<ArgumentOutOfRangeException>(() => options.OutputPipeCapacity = -1);
+        Assert.Equal(0, options.OutputPipeCapacity);
+    }
+
+    [Fact(Skip = ConditionalTests.UnixOnly)]
+    public static void Pipeline_MovesLargeOutputThroughPipesWithCustomCapacity()
+    {
+        ProcessStartOptions[] stages =
+        [
+            new("head") { Arguments = { "-c", "4194304", "/dev/zero" }, OutputPipeCapacity = 1024 * 1024 },
+            new("cat") { OutputPipeCapacity = 1024 * 1024 },
+            new("wc") { Arguments = { "-c" } },
+        ];
+
+        File.CreatePipe(out SafeFileHandle readPipe, out SafeFileHandle writePipe);
+
+        using (readPipe)
+        {
+            ProcessExitStatus[] exitStatuses = ChildProcess.Pipeline(stages, input: null, output: writePipe, error: null, timeout: TimeSpan.FromSeconds(30));
+
+            using StreamReader reader = new(new FileStream(readPipe, FileAccess.Read, bufferSize: 1));
+            Assert.Equal("4194304", reader.ReadToEnd().Trim());
+            Assert.All(exitStatuses, exitStatus => Assert.Equal(0, exitStatus.ExitCode));
+        }
+    }
+
+    [Fact(Skip = ConditionalTests.UnixOnly)]
+    public static void Pipeline_KillsAllTheStagesOnTimeout()
+    {
+        ProcessStartOptions[] stages =
+        [
+            new("sh") { Arguments = { "-c", "sleep 60 & wait" } },
+            new("sleep") { Arguments = { "60" } },
+        ];
+
+        System.Diagnostics.Stopwatch stopwatch = System.Diagnostics.Stopwatch.StartNew();
+        ProcessExitStatus[] exitStatuses = ChildProcess.Pipeline(stages, input: null, output: null, error: null, timeout: TimeSpan.FromMilliseconds(200));
+
+        Assert.True(stopwatch.Elapsed < TimeSpan.FromSeconds(10), $"Took {stopwatch.Elapsed}");
+        Assert.All(exitStatuses, exitStatus =>
+        {
+            Assert.True(exitStatus.Canceled);
+            Assert.Equal(PosixSignal.SIGKILL, exitStatus.Signal);
+        });
+    }
+
+    [Fact(Skip = ConditionalTests.UnixOnly)]
+    public static async Task PipelineAsync_KillsAllTheStagesOnCancellation()
+    {
+        ProcessStartOptions[] stages =
+        [
+            new("printf") { Arguments = { "done" } },
+            new("sleep") { Arguments = { "60" } },
+        ];
+
+        using CancellationTokenSource cts = new(TimeSpan.FromMilliseconds(200));
+        ProcessExitStatus[] exitStatuses = await ChildProcess.PipelineAsync(stages, cancellationToken: cts.Token);
+
+        Assert.False(exitStatuses[0].Canceled);
+        Assert.Equal(0, exitStatuses[0].ExitCode);
+        Assert.True(exitStatuses[1].Canceled);
+        Assert.Equal(PosixSignal.SIGKILL, exitStatuses[1].Signal);
+    }
+
+    [Fact(Skip = ConditionalTests.UnixOnly)]
+    public static void StartPipeline_StartsAllTheStagesInTheProcessGroupOfTheFirstOne()
+    {
+        ProcessStartOptions[] stages =
+        [
+            new("sleep") { Arguments = { "60" } },
+            new("sleep") { Arguments = { "60" } },
+            new("sleep") { Arguments = { "60" } },
+        ];
+
+        SafeChildProcessHandle[] handles = SafeChildProcessHandle.StartPipeline(stages, input: null, output: null, error: null, createNewProcessGroup: true);
+
+        Assert.True(handles[0].KillProcessGroup());
+
+        foreach (SafeChildProcessHandle handle in handles)
+        {
+            using (handle)
+            {
+                Assert.Equal(PosixSignal.SIGKILL, handle.WaitForExitOrKillOnTimeout(TimeSpan.FromSeconds(5)).Signal);
+            }
+        }
+    }
 }
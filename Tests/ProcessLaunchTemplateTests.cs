@@ -0,0 +1,167 @@
+using System;
+using System.IO;
+using System.Linq;
+using System.TBA;
+using Microsoft.Win32.SafeHandles;
+
+namespace Tests;
+
+public class ProcessLaunchTemplateTests
+{
+    [Fact]
+    public static void Start_CanBeCalledManyTimes()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "echo test" } }
+            : new("echo") { Arguments = { "test" } };
+
+        using ProcessLaunchTemplate template = new(options);
+
+        Assert.True(Path.IsPathRooted(template.FileName));
+
+        for (int i = 0; i < 3; i++)
+        {
+            Assert.Equal("test", StartAndReadOutput(template, []));
+        }
+    }
+
+    [Fact]
+    public static void Start_ReplacesOnlyTheProvidedArguments()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "echo", "a", "b", "c" } }
+            : new("echo") { Arguments = { "a", "b", "c" } };
+        int offset = OperatingSystem.IsWindows() ? 2 : 0;
+
+        using ProcessLaunchTemplate template = new(options);
+
+        string?[] arguments = new string?[offset + 2];
+        arguments[offset + 1] = "replaced";
+
+        Assert.Equal("a replaced c", StartAndReadOutput(template, arguments));
+        // The override does not stick to the template.
+        Assert.Equal("a b c", StartAndReadOutput(template, []));
+    }
+
+    [Fact]
+    public static void Start_EncodesLongNonAsciiArguments()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "echo", "placeholder" } }
+            : new("echo") { Arguments = { "placeholder" } };
+
+        using ProcessLaunchTemplate template = new(options);
+
+        // Larger than what is encoded on the stack. cmd.exe echoes using the console code page, so Windows sticks to ASCII.
+        string argument = new(OperatingSystem.IsWindows() ? 'x' : 'é', 2000);
+        string?[] arguments = OperatingSystem.IsWindows() ? [null, null, argument] : [argument];
+
+        Assert.Equal(argument, StartAndReadOutput(template, arguments));
+    }
+
+    [Fact]
+    public static void Start_ReplacesArgumentsOfTemplatesWithManyArguments()
+    {
+        // More arguments than the argv pointers that fit on the stack, still within the command line limit of cmd.exe.
+        const int ArgumentCount = 2000;
+        int offset = OperatingSystem.IsWindows() ? 2 : 0;
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "echo" } }
+            : new("echo");
+        for (int i = 0; i < ArgumentCount; i++)
+        {
+            options.Arguments.Add("a");
+        }
+
+        using ProcessLaunchTemplate template = new(options);
+
+        string?[] arguments = new string?[offset + ArgumentCount];
+        arguments[^1] = "replaced";
+
+        Assert.Equal(string.Join(' ', Enumerable.Repeat("a", ArgumentCount - 1)) + " replaced", StartAndReadOutput(template, arguments));
+    }
+
+    [Fact]
+    public static void Start_UsesPreparedEnvironmentAndWorkingDirectory()
+    {
+        DirectoryInfo workingDirectory = Directory.CreateTempSubdirectory();
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "echo %TEMPLATE_TEST_VAR% & cd" } }
+            : new("sh") { Arguments = { "-c", "echo $TEMPLATE_TEST_VAR && pwd -P" } };
+        options.Environment["TEMPLATE_TEST_VAR"] = "template_value";
+        options.WorkingDirectory = workingDirectory.FullName;
+
+        try
+        {
+            using ProcessLaunchTemplate template = new(options);
+
+            string[] lines = StartAndReadOutput(template, []).Split(Environment.NewLine);
+
+            Assert.Equal("template_value", lines[0].Trim());
+            // The temp directory itself may be behind a symbolic link.
+            Assert.Equal(workingDirectory.Name, Path.GetFileName(lines[1]));
+        }
+        finally
+        {
+            workingDirectory.Delete();
+        }
+    }
+
+    [Fact]
+    public static void Start_DoesNotObserveChangesMadeToTheOptions()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "echo before" } }
+            : new("echo") { Arguments = { "before" } };
+
+        using ProcessLaunchTemplate template = new(options);
+
+        options.Arguments[options.Arguments.Count - 1] = OperatingSystem.IsWindows() ? "echo after" : "after";
+        options.Arguments.Add("extra");
+
+        Assert.Equal("before", StartAndReadOutput(template, []));
+        Assert.Equal(OperatingSystem.IsWindows() ? 2 : 1, template.ArgumentCount);
+    }
+
+    [Fact]
+    public static void Start_ThrowsForTooManyArguments()
+    {
+        using ProcessLaunchTemplate template = new(new("echo") { Arguments = { "test" } });
+
+        Assert.Throws<ArgumentOutOfRangeException>(() => template.Start(null, null, null, ["a", "b"]));
+    }
+
+    [Fact]
+    public static void Start_ThrowsAfterDispose()
+    {
+        ProcessLaunchTemplate template = new(new("echo") { Arguments = { "test" } });
+        template.Dispose();
+        template.Dispose(); // second Dispose is a no-op
+
+        Assert.Throws<ObjectDisposedException>(() => template.Start(null, null, null));
+    }
+
+    [Fact]
+    public static void Constructor_ThrowsForInvalidArguments()
+    {
+        Assert.Throws<ArgumentNullException>(() => new ProcessLaunchTemplate(null!));
+        Assert.Throws<FileNotFoundException>(() => new ProcessLaunchTemplate(new("nonexistent_executable_12345")));
+    }
+
+    private static string StartAndReadOutput(ProcessLaunchTemplate template, string?[] arguments)
+    {
+        File.CreatePipe(out SafeFileHandle readPipe, out SafeFileHandle writePipe);
+
+        using (readPipe)
+        {
+            // The parent copy of the write end is closed by Start, so reading to the end does not hang.
+            using SafeChildProcessHandle handle = template.Start(input: null, output: writePipe, error: null, arguments);
+            using StreamReader reader = new(new FileStream(readPipe, FileAccess.Read, bufferSize: 0));
+            string output = reader.ReadToEnd();
+
+            Assert.Equal(0, handle.WaitForExitOrKillOnTimeout(TimeSpan.FromSeconds(5)).ExitCode);
+
+            return output.TrimEnd();
+        }
+    }
+}
@@ -0,0 +1,276 @@
+using System;
+using System.Buffers;
+using System.IO;
+using System.TBA;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace Tests;
+
+public class ProcessOutputBytesTests
+{
+    [Theory]
+    [InlineData(true)]
+    [InlineData(false)]
+    public static async Task CaptureOutputBytes_SeparatesStdOutAndStdErr(bool useAsync)
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo Hello from stdout && echo Error from stderr 1>&2" } }
+            : new("sh") { Arguments = { "-c", "echo 'Hello from stdout' && echo 'Error from stderr' >&2" } };
+
+        using ProcessOutputBytes result = useAsync
+            ? await ChildProcess.CaptureOutputBytesAsync(options)
+            : ChildProcess.CaptureOutputBytes(options);
+
+        Assert.Equal(OperatingSystem.IsWindows() ? "Hello from stdout \r\n" : "Hello from stdout\n", Encoding.UTF8.GetString(result.StandardOutput));
+        Assert.Equal(OperatingSystem.IsWindows() ? "Error from stderr \r\n" : "Error from stderr\n", Encoding.UTF8.GetString(result.StandardError));
+        Assert.Equal(0, result.ExitStatus.ExitCode);
+    }
+
+    [Fact]
+    public static void CaptureOutputBytes_ManyConcurrentCaptures()
+    {
+        // On Windows, all the captures share the same completion port and job object.
+        Parallel.For(0, 32, new ParallelOptions { MaxDegreeOfParallelism = 32 }, i =>
+        {
+            ProcessStartOptions options = OperatingSystem.IsWindows()
+                ? new("cmd") { Arguments = { "/c", $"echo out{i} && echo err{i} 1>&2 && exit {i}" } }
+                : new("sh") { Arguments = { "-c", $"echo out{i} && echo err{i} >&2 && exit {i}" } };
+
+            using ProcessOutputBytes result = ChildProcess.CaptureOutputBytes(options, timeout: TimeSpan.FromSeconds(30));
+
+            Assert.Equal($"out{i}", Encoding.UTF8.GetString(result.StandardOutput).TrimEnd());
+            Assert.Equal($"err{i}", Encoding.UTF8.GetString(result.StandardError).TrimEnd());
+            Assert.Equal(i, result.ExitStatus.ExitCode);
+        });
+    }
+
+    [Theory]
+    [InlineData(true)]
+    [InlineData(false)]
+    public static async Task CaptureOutputBytes_HandlesEmptyOutput(bool useAsync)
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "exit 42" } }
+            : new("sh") { Arguments = { "-c", "exit 42" } };
+
+        using ProcessOutputBytes result = useAsync
+            ? await ChildProcess.CaptureOutputBytesAsync(options)
+            : ChildProcess.CaptureOutputBytes(options);
+
+        Assert.True(result.StandardOutput.IsEmpty);
+        Assert.True(result.StandardError.IsEmpty);
+        Assert.Equal(42, result.ExitStatus.ExitCode);
+    }
+
+    [Theory]
+    [InlineData(true)]
+    [InlineData(false)]
+    public static async Task CaptureOutputBytes_LargeOutputSpansMultipleSegments(bool useAsync)
+    {
+        byte[] expected = new byte[3 * 1024 * 1024];
+        new Random(42).NextBytes(expected);
+
+        string filePath = Path.GetTempFileName();
+        File.WriteAllBytes(filePath, expected);
+
+        try
+        {
+            ProcessStartOptions options = OperatingSystem.IsWindows()
+                ? new("cmd") { Arguments = { "/c", "type", filePath } }
+                : new("cat") { Arguments = { filePath } };
+
+            using ProcessOutputBytes result = useAsync
+                ? await ChildProcess.CaptureOutputBytesAsync(options)
+                : ChildProcess.CaptureOutputBytes(options);
+
+            Assert.False(result.StandardOutput.IsSingleSegment);
+            Assert.Equal(expected, result.StandardOutput.ToArray());
+            Assert.True(result.StandardError.IsEmpty);
+            Assert.Equal(0, result.ExitStatus.ExitCode);
+        }
+        finally
+        {
+            File.Delete(filePath);
+        }
+    }
+
+    [Fact]
+    public static void CaptureOutputBytes_ThrowsAfterDispose()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo test" } }
+            : new("sh") { Arguments = { "-c", "echo test" } };
+
+        ProcessOutputBytes result = ChildProcess.CaptureOutputBytes(options);
+        result.Dispose();
+        result.Dispose(); // It's fine to dispose it twice
+
+        Assert.Throws<ObjectDisposedException>(() => result.StandardOutput);
+        Assert.Throws<ObjectDisposedException>(() => result.StandardError);
+        Assert.Equal(0, result.ExitStatus.ExitCode);
+    }
+
+    [Theory(Skip = ConditionalTests.UnixOnly)]
+    [InlineData(0)]
+    [InlineData(1024 * 1024)]
+    public static void CaptureOutputBytes_ReadsHighVolumeOutput(int outputPipeCapacity)
+    {
+        const int Length = 16 * 1024 * 1024;
+
+        // The pipe is full most of the time, so the capture loop grows it when no capacity is given.
+        ProcessStartOptions options = new("head") { Arguments = { "-c", Length.ToString(), "/dev/zero" }, OutputPipeCapacity = outputPipeCapacity };
+
+        using ProcessOutputBytes result = ChildProcess.CaptureOutputBytes(options, timeout: TimeSpan.FromSeconds(30));
+
+        Assert.Equal(0, result.ExitStatus.ExitCode);
+        Assert.Equal(Length, result.StandardOutput.Length);
+        foreach (ReadOnlyMemory<byte> segment in result.StandardOutput)
+        {
+            Assert.Equal(-1, segment.Span.IndexOfAnyExcept((byte)0));
+        }
+    }
+
+    [Theory]
+    [InlineData(OutputLimitPolicy.KeepHead, true)]
+    [InlineData(OutputLimitPolicy.KeepHead, false)]
+    [InlineData(OutputLimitPolicy.KeepTail, true)]
+    [InlineData(OutputLimitPolicy.KeepTail, false)]
+    [InlineData(OutputLimitPolicy.KeepHeadAndTail, true)]
+    [InlineData(OutputLimitPolicy.KeepHeadAndTail, false)]
+    public static async Task CaptureOutputBytes_KeepsAtMostMaxOutputBytes(OutputLimitPolicy policy, bool useAsync)
+    {
+        const int Limit = 100_001;
+
+        byte[] written = new byte[3 * 1024 * 1024];
+        new Random(42).NextBytes(written);
+
+        string filePath = Path.GetTempFileName();
+        File.WriteAllBytes(filePath, written);
+
+        try
+        {
+            ProcessStartOptions options = OperatingSystem.IsWindows()
+                ? new("cmd") { Arguments = { "/c", "type", filePath } }
+                : new("cat") { Arguments = { filePath } };
+            options.MaxOutputBytes = Limit;
+            options.OutputLimitPolicy = policy;
+
+            using ProcessOutputBytes result = useAsync
+                ? await ChildProcess.CaptureOutputBytesAsync(options)
+                : ChildProcess.CaptureOutputBytes(options);
+
+            byte[] expected = policy switch
+            {
+                OutputLimitPolicy.KeepHead => written[..Limit],
+                OutputLimitPolicy.KeepTail => written[^Limit..],
+                _ => [.. written[..(Limit - Limit / 2)], .. written[^(Limit / 2)..]],
+            };
+
+            Assert.Equal(expected, result.StandardOutput.ToArray());
+            Assert.Equal(written.Length - Limit, result.StandardOutputDroppedBytes);
+            Assert.True(result.StandardError.IsEmpty);
+            Assert.Equal(0, result.StandardErrorDroppedBytes);
+            Assert.Equal(0, result.ExitStatus.ExitCode);
+        }
+        finally
+        {
+            File.Delete(filePath);
+        }
+    }
+
+    [Theory]
+    [InlineData(OutputLimitPolicy.KeepHead)]
+    [InlineData(OutputLimitPolicy.KeepTail)]
+    [InlineData(OutputLimitPolicy.KeepHeadAndTail)]
+    public static void CaptureOutput_KeepsAllTheOutputUnderTheLimit(OutputLimitPolicy policy)
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo Hello && echo World 1>&2" } }
+            : new("sh") { Arguments = { "-c", "echo Hello && echo World >&2" } };
+        options.MaxOutputBytes = 1024;
+        options.OutputLimitPolicy = policy;
+
+        ProcessOutput result = ChildProcess.CaptureOutput(options);
+
+        Assert.Equal("Hello", result.StandardOutput.Trim());
+        Assert.Equal("World", result.StandardError.Trim());
+        Assert.Equal(0, result.StandardOutputDroppedBytes);
+        Assert.Equal(0, result.StandardErrorDroppedBytes);
+    }
+
+    [Fact]
+    public static void CaptureOutputBytes_WritesInputWhileReadingOutput()
+    {
+        // Much more than both pipes can hold: the process blocks on its output until it's read, while there is still input to write.
+        StringBuilder builder = new();
+        for (int i = 0; builder.Length < 4 * 1024 * 1024; i++)
+        {
+            builder.Append("line ").Append(i).Append(OperatingSystem.IsWindows() ? "\r\n" : "\n");
+        }
+        byte[] input = Encoding.UTF8.GetBytes(builder.ToString());
+
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("findstr") { Arguments = { "^" } }
+            : new("cat");
+
+        using ProcessOutputBytes result = ChildProcess.CaptureOutputBytes(options, input, TimeSpan.FromMinutes(1));
+
+        Assert.Equal(0, result.ExitStatus.ExitCode);
+        Assert.Equal(input, result.StandardOutput.ToArray());
+    }
+
+    [Fact]
+    public static void CaptureOutputBytes_WritesAllTheSegmentsOfTheInput()
+    {
+        string newLine = OperatingSystem.IsWindows() ? "\r\n" : "\n";
+        BufferSegment first = new(Encoding.UTF8.GetBytes("Hel"));
+        BufferSegment last = first
+            .Append(Array.Empty<byte>())
+            .Append(Encoding.UTF8.GetBytes($"lo{newLine}Wor"))
+            .Append(Encoding.UTF8.GetBytes($"ld{newLine}"));
+
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("findstr") { Arguments = { "^" } }
+            : new("cat");
+
+        using ProcessOutputBytes result = ChildProcess.CaptureOutputBytes(options, new ReadOnlySequence<byte>(first, 0, last, last.Memory.Length));
+
+        Assert.Equal($"Hello{newLine}World{newLine}", Encoding.UTF8.GetString(result.StandardOutput));
+        Assert.Equal(0, result.ExitStatus.ExitCode);
+    }
+
+    [Fact]
+    public static void CaptureOutputBytes_DropsTheInputNotReadByTheProcess()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo done && exit 3" } }
+            : new("sh") { Arguments = { "-c", "echo done && exit 3" } };
+
+        using ProcessOutputBytes result = ChildProcess.CaptureOutputBytes(options, new byte[4 * 1024 * 1024], TimeSpan.FromMinutes(1));
+
+        Assert.Equal("done", Encoding.UTF8.GetString(result.StandardOutput).Trim());
+        Assert.Equal(3, result.ExitStatus.ExitCode);
+    }
+
+    [Fact]
+    public static void MaxOutputBytes_ThrowsForInvalidValues()
+    {
+        ProcessStartOptions options = new("test");
+
+        Assert.Throws<ArgumentOutOfRangeException>(() => options.MaxOutputBytes = -1);
+        Assert.Throws<ArgumentOutOfRangeException>(() => options.OutputLimitPolicy = (OutputLimitPolicy)42);
+    }
+}
+
+internal sealed class BufferSegment : ReadOnlySequenceSegment<byte>
+{
+    internal BufferSegment(ReadOnlyMemory<byte> memory) => Memory = memory;
+
+    internal BufferSegment Append(ReadOnlyMemory<byte> memory)
+    {
+        BufferSegment next = new(memory) { RunningIndex = RunningIndex + Memory.Length };
+        Next = next;
+        return next;
+    }
+}
@@ -0,0 +1,161 @@
+using System;
+using System.ComponentModel;
+using System.IO;
+using System.TBA;
+using Microsoft.Win32.SafeHandles;
+
+namespace Tests;
+
+// The spawn server is used by every process start of the current process, so the other tests must not start processes in the meantime.
+[CollectionDefinition(nameof(ProcessSpawnServerTests), DisableParallelization = true)]
+public class ProcessSpawnServerCollection
+{
+}
+
+[Collection(nameof(ProcessSpawnServerTests))]
+public class ProcessSpawnServerTests
+{
+    [Fact]
+    public static void Start_IsSupportedOnlyOnLinux()
+    {
+        try
+        {
+            Assert.Equal(OperatingSystem.IsLinux(), ProcessSpawnServer.Start());
+            Assert.Equal(OperatingSystem.IsLinux(), ProcessSpawnServer.IsRunning);
+            // A second call is a no-op.
+            Assert.Equal(OperatingSystem.IsLinux(), ProcessSpawnServer.Start());
+        }
+        finally
+        {
+            ProcessSpawnServer.Stop();
+        }
+
+        Assert.False(ProcessSpawnServer.IsRunning);
+        ProcessSpawnServer.Stop(); // second Stop is a no-op
+    }
+
+    [Fact]
+    public static void Start_ChildrenAreChildrenOfTheCurrentProcess()
+    {
+        if (!ProcessSpawnServer.Start())
+        {
+            return;
+        }
+
+        DirectoryInfo workingDirectory = Directory.CreateTempSubdirectory();
+        try
+        {
+            ProcessStartOptions options = new("sh") { Arguments = { "-c", "echo $PPID $SPAWN_SERVER_TEST_VAR && pwd -P && exit 42" } };
+            options.Environment["SPAWN_SERVER_TEST_VAR"] = "server_value";
+            options.WorkingDirectory = workingDirectory.FullName;
+
+            string[] lines = StartAndReadOutput(options, out int exitCode).Split('\n');
+
+            Assert.Equal($"{Environment.ProcessId} server_value", lines[0]);
+            // The temp directory itself may be behind a symbolic link.
+            Assert.Equal(workingDirectory.Name, Path.GetFileName(lines[1]));
+            Assert.Equal(42, exitCode);
+        }
+        finally
+        {
+            ProcessSpawnServer.Stop();
+            workingDirectory.Delete();
+        }
+    }
+
+    [Fact]
+    public static void Start_ChildrenUseTheCurrentDirectoryOfTheRequest()
+    {
+        if (!ProcessSpawnServer.Start())
+        {
+            return;
+        }
+
+        string currentDirectory = Environment.CurrentDirectory;
+        DirectoryInfo workingDirectory = Directory.CreateTempSubdirectory();
+        try
+        {
+            // The server was started in the previous directory.
+            Directory.SetCurrentDirectory(workingDirectory.FullName);
+
+            ProcessStartOptions options = new("sh") { Arguments = { "-c", "pwd -P" } };
+
+            // The temp directory itself may be behind a symbolic link.
+            Assert.Equal(workingDirectory.Name, Path.GetFileName(StartAndReadOutput(options, out int exitCode)));
+            Assert.Equal(0, exitCode);
+            Assert.True(ProcessSpawnServer.IsRunning);
+        }
+        finally
+        {
+            Directory.SetCurrentDirectory(currentDirectory);
+            ProcessSpawnServer.Stop();
+            workingDirectory.Delete();
+        }
+    }
+
+    [Fact]
+    public static void Start_ReportsExecFailures()
+    {
+        if (!ProcessSpawnServer.Start())
+        {
+            return;
+        }
+
+        string notExecutable = Path.GetTempFileName();
+        try
+        {
+            ProcessStartOptions options = new(notExecutable);
+
+            Win32Exception exception = Assert.Throws<Win32Exception>(() => SafeChildProcessHandle.Start(options, null, null, null));
+
+            Assert.Equal(13, exception.NativeErrorCode); // EACCES
+            Assert.True(ProcessSpawnServer.IsRunning);
+        }
+        finally
+        {
+            ProcessSpawnServer.Stop();
+            File.Delete(notExecutable);
+        }
+    }
+
+    [Fact]
+    public static void Start_LaunchesTheServerCanNotServeAreStartedDirectly()
+    {
+        if (!ProcessSpawnServer.Start())
+        {
+            return;
+        }
+
+        try
+        {
+            using SafeFileHandle inherited = File.OpenNullFileHandle();
+            ProcessStartOptions options = new("sh") { Arguments = { "-c", "echo $PPID" }, KillOnParentExit = true };
+            options.InheritedHandles.Add(inherited);
+
+            Assert.Equal(Environment.ProcessId.ToString(), StartAndReadOutput(options, out int exitCode));
+            Assert.Equal(0, exitCode);
+        }
+        finally
+        {
+            ProcessSpawnServer.Stop();
+        }
+    }
+
+    private static string StartAndReadOutput(ProcessStartOptions options, out int exitCode)
+    {
+        File.CreatePipe(out SafeFileHandle readPipe, out SafeFileHandle writePipe);
+
+        using (readPipe)
+        {
+            string output;
+            using (SafeChildProcessHandle handle = SafeChildProcessHandle.Start(options, input: null, output: writePipe, error: null))
+            {
+                using StreamReader reader = new(new FileStream(readPipe, FileAccess.Read, bufferSize: 0));
+                output = reader.ReadToEnd();
+                exitCode = handle.WaitForExitOrKillOnTimeout(TimeSpan.FromSeconds(5)).ExitCode;
+            }
+
+            return output.TrimEnd();
+        }
+    }
+}
@@ -451,4 +451,57 @@ public class ReadOutputLinesTests
 
         Assert.Equal(10, lineCount);
     }
-}
\ No newline at end of file
+
+    [Fact]
+    public static void EnumerateLineViews_HandlesBothLineEndings()
+    {
+        // The long line does not fit into the initial buffer, so it's split across multiple reads.
+        string longLine = new('X', 100_000);
+        string filePath = Path.GetTempFileName();
+        File.WriteAllText(filePath, $"unix\nwindows\r\n\n\r\n{longLine}\r\nno line ending");
+
+        try
+        {
+            ProcessStartOptions options = OperatingSystem.IsWindows()
+                ? new("cmd") { Arguments = { "/c", "type", filePath } }
+                : new("cat") { Arguments = { filePath } };
+
+            ProcessOutputLines processOutputLines = ChildProcess.StreamOutputLines(options);
+            List<string> lines = [];
+            foreach (ProcessOutputLineView line in processOutputLines.EnumerateLineViews())
+            {
+                Assert.False(line.StandardError);
+                lines.Add(line.GetText());
+            }
+
+            Assert.Equal(["unix", "windows", "", "", longLine, "no line ending"], lines);
+            Assert.Equal(0, processOutputLines.ExitStatus.ExitCode);
+        }
+        finally
+        {
+            File.Delete(filePath);
+        }
+    }
+
+    [Fact]
+    public static void EnumerateLineViews_CanBeDecodedWithoutAllocatingStrings()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "for /L %i in (1,1,100) do @echo Line %i" } }
+            : new("sh") { Arguments = { "-c", "for i in $(seq 1 100); do echo \"Line $i\"; done" } };
+
+        Span<char> chars = stackalloc char[64];
+        int lineCount = 0;
+
+        foreach (ProcessOutputLineView line in ChildProcess.StreamOutputLines(options).EnumerateLineViews())
+        {
+            lineCount++;
+            Assert.True(line.GetMaxCharCount() <= chars.Length);
+
+            int charCount = line.GetChars(chars);
+            Assert.Equal($"Line {lineCount}", chars.Slice(0, charCount).TrimEnd(' ').ToString());
+        }
+
+        Assert.Equal(100, lineCount);
+    }
+}
@@ -0,0 +1,116 @@
+using Microsoft.Win32.SafeHandles;
+using System;
+using System.Diagnostics;
+using System.Runtime.InteropServices;
+using System.TBA;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Tests;
+
+// ReapAbandonedProcesses applies to the whole process, so the other tests must not start or abandon processes in the meantime.
+[CollectionDefinition(nameof(ReapAbandonedProcessesTests), DisableParallelization = true)]
+public class ReapAbandonedProcessesCollection
+{
+}
+
+[Collection(nameof(ReapAbandonedProcessesTests))]
+public class ReapAbandonedProcessesTests
+{
+    private const int ESRCH = 3;
+
+    [Fact]
+    public static void FireAndForget_ProcessesAreReaped_WhenEnabled()
+    {
+        ProcessStartOptions options = new("sh") { Arguments = { "-c", "exit 0" } };
+
+        SafeChildProcessHandle.ReapAbandonedProcesses = true;
+        try
+        {
+            int[] processIds = [ChildProcess.FireAndForget(options), ChildProcess.FireAndForget(options), ChildProcess.FireAndForget(options)];
+
+            // Until it's reaped, the process is a zombie that can still be signaled.
+            foreach (int processId in processIds)
+            {
+                Assert.True(WaitUntilReaped(processId, TimeSpan.FromSeconds(10)), $"Process {processId} was not reaped");
+            }
+        }
+        finally
+        {
+            SafeChildProcessHandle.ReapAbandonedProcesses = false;
+        }
+    }
+
+    [Fact]
+    public static void OpenedProcesses_AreNotReaped()
+    {
+        ProcessStartOptions options = new("sh") { Arguments = { "-c", "exit 5" } };
+
+        // It's started before the reaper is enabled, so it's abandoned without being reaped.
+        int processId = ChildProcess.FireAndForget(options);
+
+        SafeChildProcessHandle.ReapAbandonedProcesses = true;
+        try
+        {
+            // The handle is not the one returned when the process was started, so it's left to its owner.
+            SafeChildProcessHandle.Open(processId).Dispose();
+            Thread.Sleep(TimeSpan.FromMilliseconds(500));
+
+            using SafeChildProcessHandle handle = SafeChildProcessHandle.Open(processId);
+            Assert.Equal(5, handle.WaitForExit().ExitCode);
+        }
+        finally
+        {
+            SafeChildProcessHandle.ReapAbandonedProcesses = false;
+        }
+    }
+
+    [Fact]
+    public static async Task AbandonedProcesses_AreNotReaped_WhileAwaitedThroughAnotherHandle()
+    {
+        // On Linux, every handle has its own process descriptor. Elsewhere, kqueue has a single exit filter per process ID.
+        if (OperatingSystem.IsLinux())
+        {
+            return;
+        }
+
+        ProcessStartOptions options = new("sh") { Arguments = { "-c", "sleep 0.2; exit 3" } };
+
+        SafeChildProcessHandle.ReapAbandonedProcesses = true;
+        try
+        {
+            SafeChildProcessHandle started = SafeChildProcessHandle.Start(options, input: null, output: null, error: null);
+            using SafeChildProcessHandle opened = SafeChildProcessHandle.Open(started.ProcessId);
+            Task<ProcessExitStatus> exited = opened.WaitForExitAsync();
+
+            // Reaping it would replace the filter of the pending wait, which would never complete.
+            started.Dispose();
+
+            ProcessExitStatus exitStatus = await exited.WaitAsync(TimeSpan.FromSeconds(10));
+            Assert.Equal(3, exitStatus.ExitCode);
+        }
+        finally
+        {
+            SafeChildProcessHandle.ReapAbandonedProcesses = false;
+        }
+    }
+
+    private static bool WaitUntilReaped(int processId, TimeSpan timeout)
+    {
+        Stopwatch stopwatch = Stopwatch.StartNew();
+        while (kill(processId, 0) == 0 || Marshal.GetLastPInvokeError() != ESRCH)
+        {
+            if (stopwatch.Elapsed > timeout)
+            {
+                return false;
+            }
+
+            Thread.Sleep(TimeSpan.FromMilliseconds(10));
+        }
+
+        return true;
+    }
+
+    [DllImport("libc", SetLastError = true)]
+    private static extern int kill(int pid, int sig);
+}
@@ -1,5 +1,6 @@
 using System;
 using System.ComponentModel;
+using System.Diagnostics.CodeAnalysis;
 using System.IO;
 using System.TBA;
 using PosixSignal = System.TBA.PosixSignal;
@@ -186,4 +187,161 @@ public partial class SafeChildProcessHandleTests
                 $"Grandchild should have been killed quickly, took {stopwatch.ElapsedMilliseconds}ms");
         }
     }
+
+    [Fact]
+    public static async Task WaitForExitAsync_ManyConcurrentWaits_AllComplete()
+    {
+        SafeChildProcessHandle[] handles = new SafeChildProcessHandle[64];
+        for (int i = 0; i < handles.Length; i++)
+        {
+            ProcessStartOptions options = new("sh") { Arguments = { "-c", $"sleep 0.1; exit {i}" } };
+            handles[i] = SafeChildProcessHandle.Start(options, input: null, output: null, error: null);
+        }
+
+        try
+        {
+            using CancellationTokenSource cts = new(TimeSpan.FromSeconds(10));
+            Task<ProcessExitStatus>[] waits = new Task<ProcessExitStatus>[handles.Length];
+            for (int i = 0; i < handles.Length; i++)
+            {
+                waits[i] = handles[i].WaitForExitAsync(cts.Token);
+            }
+
+            ProcessExitStatus[] statuses = await Task.WhenAll(waits);
+
+            for (int i = 0; i < statuses.Length; i++)
+            {
+                Assert.Equal(i, statuses[i].ExitCode);
+                Assert.False(statuses[i].Canceled);
+            }
+        }
+        finally
+        {
+            foreach (SafeChildProcessHandle handle in handles)
+            {
+                handle.Dispose();
+            }
+        }
+    }
+
+    [Fact]
+    public static async Task WaitForExitAsync_CanBeAwaitedAgainAfterCancellation()
+    {
+        ProcessStartOptions options = new("sleep") { Arguments = { "0.5" } };
+
+        using SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input: null, output: null, error: null);
+
+        using (CancellationTokenSource cts = new(TimeSpan.FromMilliseconds(50)))
+        {
+            await Assert.ThrowsAnyAsync<OperationCanceledException>(async () => await processHandle.WaitForExitAsync(cts.Token));
+        }
+
+        ProcessExitStatus exitStatus = await processHandle.WaitForExitAsync();
+
+        Assert.Equal(0, exitStatus.ExitCode);
+        Assert.False(exitStatus.Canceled);
+    }
+
+    [Fact]
+    public async Task KillProcessTree_KillsDescendantsThatLeftTheProcessGroup()
+    {
+        if (!OperatingSystem.IsLinux())
+        {
+            Assert.Throws<PlatformNotSupportedException>(() => SafeChildProcessHandle.Start(
+                new ProcessStartOptions("sh") { Arguments = { "-c", "exit 0" }, IsolateProcessTree = true }, input: null, output: null, error: null));
+            return;
+        }
+
+        File.CreatePipe(out SafeFileHandle pipeReadHandle, out SafeFileHandle pipeWriteHandle);
+
+        using (pipeReadHandle)
+        using (pipeWriteHandle)
+        {
+            // The grandchildren start their own sessions and outlive the shell: KillProcessGroup can't reach them.
+            ProcessStartOptions options = new("sh")
+            {
+                Arguments = { "-c", "setsid sleep 300 & setsid sh -c 'sleep 300 & wait' & exit 0" },
+                IsolateProcessTree = true
+            };
+            options.InheritedHandles.Add(pipeWriteHandle);
+
+            if (!TryStartIsolated(() => SafeChildProcessHandle.Start(options, input: null, output: null, error: null), out SafeChildProcessHandle? started))
+            {
+                return;
+            }
+
+            using SafeChildProcessHandle processHandle = started;
+            Assert.Equal(0, processHandle.WaitForExitOrKillOnTimeout(TimeSpan.FromSeconds(5)).ExitCode);
+            pipeWriteHandle.Dispose();
+
+            using FileStream readStream = new(pipeReadHandle, FileAccess.Read, bufferSize: 1, isAsync: false);
+            Task<int> readTask = Task.Run(() => readStream.Read(new byte[1], 0, 1));
+
+            await Task.Delay(50);
+            Assert.False(readTask.IsCompleted, "The grandchildren should still be running");
+
+            Assert.True(processHandle.KillProcessTree());
+
+            // KillProcessTree returns once they are all gone, so the pipe is already closed.
+            Assert.True(readTask.Wait(TimeSpan.FromSeconds(1)), "The grandchildren should have been killed");
+            Assert.Equal(0, await readTask);
+
+            Assert.False(processHandle.KillProcessTree());
+        }
+    }
+
+    [Fact]
+    public void KillProcessTree_ThrowsWhenTheTreeIsNotIsolated()
+    {
+        ProcessStartOptions options = new("sleep") { Arguments = { "60" } };
+
+        using SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input: null, output: null, error: null);
+
+        Assert.Throws<InvalidOperationException>(() => processHandle.KillProcessTree());
+
+        processHandle.Kill();
+        processHandle.WaitForExit();
+    }
+
+    [Fact]
+    public void KillProcessTree_WorksWithStartMany()
+    {
+        if (!OperatingSystem.IsLinux())
+        {
+            return;
+        }
+
+        ProcessStartOptions isolated = new("sh") { Arguments = { "-c", "setsid sleep 300 & wait" }, IsolateProcessTree = true };
+        ProcessStartOptions regular = new("sleep") { Arguments = { "60" } };
+
+        if (!TryStartIsolated(() => SafeChildProcessHandle.StartMany([isolated, regular], input: null, output: null, error: null), out SafeChildProcessHandle[]? handles))
+        {
+            return;
+        }
+
+        using SafeChildProcessHandle isolatedHandle = handles[0];
+        using SafeChildProcessHandle regularHandle = handles[1];
+
+        Assert.True(isolatedHandle.KillProcessTree());
+        Assert.Equal(PosixSignal.SIGKILL, isolatedHandle.WaitForExit().Signal);
+
+        Assert.Throws<InvalidOperationException>(() => regularHandle.KillProcessTree());
+        regularHandle.Kill();
+        regularHandle.WaitForExit();
+    }
+
+    // The cgroup of the test process is not always delegated to the current user (CI runners, containers): the tests are skipped then.
+    private static bool TryStartIsolated<T>(Func<T> start, [NotNullWhen(true)] out T? started) where T : class
+    {
+        try
+        {
+            started = start();
+            return true;
+        }
+        catch (PlatformNotSupportedException)
+        {
+            started = null;
+            return false;
+        }
+    }
 }
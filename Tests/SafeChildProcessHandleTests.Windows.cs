@@ -1,4 +1,5 @@
 using System;
+using System.Diagnostics;
 using System.TBA;
 using PosixSignal = System.TBA.PosixSignal;
 using Microsoft.Win32.SafeHandles;
@@ -150,4 +151,26 @@ public partial class SafeChildProcessHandleTests
 
         Assert.True(processHandle.Kill());
     }
+
+    [Theory]
+    [InlineData(true, false)]
+    [InlineData(false, true)]
+    public void CaptureCombined_ReturnsWhenChildInItsOwnJobExits_EvenWithRunningGrandchild(bool killOnParentExit, bool createNewProcessGroup)
+    {
+        // The child is already in a job, so it can't be assigned to the one reporting the exits to the completion port.
+        ProcessStartOptions options = new("cmd.exe")
+        {
+            Arguments = { "/c", "echo Child output && start powershell.exe -InputFormat None -Command \"Start-Sleep 3\" && exit" },
+            KillOnParentExit = killOnParentExit,
+            CreateNewProcessGroup = createNewProcessGroup
+        };
+
+        Stopwatch started = Stopwatch.StartNew();
+        CombinedOutput result = ChildProcess.CaptureCombined(options, timeout: TimeSpan.FromSeconds(5));
+
+        // Well before the periodic check of the process handle (every second) would notice the exit.
+        Assert.InRange(started.Elapsed, TimeSpan.Zero, TimeSpan.FromMilliseconds(900));
+        Assert.Equal(0, result.ExitStatus.ExitCode);
+        Assert.Equal("Child output \r\n", result.GetText());
+    }
 }
@@ -310,6 +310,42 @@ public partial class SafeChildProcessHandleTests
 #endif
     }
 
+    [Fact]
+    public static void WaitForExit_ReportsResourceUsage()
+    {
+        // A busy loop, so the process spends measurable time running user code.
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("powershell") { Arguments = { "-InputFormat", "None", "-Command", "$i = 0; while ($i -lt 2000000) { $i++ }" } }
+            : new("sh") { Arguments = { "-c", "i=0; while [ $i -lt 200000 ]; do i=$((i+1)); done" } };
+
+        using SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input: null, output: null, error: null);
+        ProcessExitStatus exitStatus = processHandle.WaitForExit();
+
+        Assert.Equal(0, exitStatus.ExitCode);
+        Assert.NotNull(exitStatus.ResourceUsage);
+        Assert.True(exitStatus.ResourceUsage.UserProcessorTime > TimeSpan.Zero, $"UserProcessorTime was {exitStatus.ResourceUsage.UserProcessorTime}");
+        Assert.True(exitStatus.ResourceUsage.PrivilegedProcessorTime >= TimeSpan.Zero);
+        Assert.Equal(exitStatus.ResourceUsage.UserProcessorTime + exitStatus.ResourceUsage.PrivilegedProcessorTime, exitStatus.ResourceUsage.TotalProcessorTime);
+        Assert.True(exitStatus.ResourceUsage.PeakWorkingSet > 0, $"PeakWorkingSet was {exitStatus.ResourceUsage.PeakWorkingSet}");
+    }
+
+    [Fact]
+    public static async Task WaitForExitOrKillOnCancellationAsync_ReportsResourceUsageWhenKilled()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("powershell") { Arguments = { "-InputFormat", "None", "-Command", "Start-Sleep 10" } }
+            : new("sleep") { Arguments = { "10" } };
+
+        using SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(options, input: null, output: null, error: null);
+        using CancellationTokenSource cts = new(TimeSpan.FromMilliseconds(100));
+
+        ProcessExitStatus exitStatus = await processHandle.WaitForExitOrKillOnCancellationAsync(cts.Token);
+
+        Assert.True(exitStatus.Canceled);
+        Assert.NotNull(exitStatus.ResourceUsage);
+        Assert.True(exitStatus.ResourceUsage.PeakWorkingSet > 0, $"PeakWorkingSet was {exitStatus.ResourceUsage.PeakWorkingSet}");
+    }
+
     [Fact]
     public static void Kill_CanBeCalledMultipleTimes()
     {
@@ -897,6 +933,94 @@ public partial class SafeChildProcessHandleTests
         Assert.NotEqual(0, exitStatus.ExitCode);
     }
 
+    [Fact]
+    public static void StartMany_ReturnsHandlesInTheSameOrderAsOptions()
+    {
+        ProcessStartOptions[] options = new ProcessStartOptions[20];
+        for (int i = 0; i < options.Length; i++)
+        {
+            options[i] = OperatingSystem.IsWindows()
+                ? new("cmd.exe") { Arguments = { "/c", $"exit {i}" } }
+                : new("sh") { Arguments = { "-c", $"exit {i}" } };
+        }
+
+        SafeChildProcessHandle[] handles = SafeChildProcessHandle.StartMany(options, input: null, output: null, error: null);
+
+        Assert.Equal(options.Length, handles.Length);
+        for (int i = 0; i < handles.Length; i++)
+        {
+            using SafeChildProcessHandle handle = handles[i];
+
+            ProcessExitStatus exitStatus = handle.WaitForExitOrKillOnTimeout(TimeSpan.FromSeconds(5));
+            Assert.Equal(i, exitStatus.ExitCode);
+            Assert.False(exitStatus.Canceled);
+        }
+    }
+
+    [Fact]
+    public static void StartMany_SharedOutputPipe_ReceivesOutputOfAllProcesses()
+    {
+        ProcessStartOptions[] options = new ProcessStartOptions[3];
+        for (int i = 0; i < options.Length; i++)
+        {
+            options[i] = OperatingSystem.IsWindows()
+                ? new("cmd.exe") { Arguments = { "/c", $"echo {i}" } }
+                : new("echo") { Arguments = { i.ToString() } };
+        }
+
+        File.CreatePipe(out SafeFileHandle readPipe, out SafeFileHandle writePipe);
+
+        using (readPipe)
+        {
+            SafeChildProcessHandle[] handles = SafeChildProcessHandle.StartMany(options, input: null, output: writePipe, error: null);
+
+            // The parent copy of the write end is closed by StartMany, so reading to the end does not hang.
+            using StreamReader reader = new(new FileStream(readPipe, FileAccess.Read, bufferSize: 0));
+            string output = reader.ReadToEnd();
+
+            foreach (SafeChildProcessHandle handle in handles)
+            {
+                using (handle)
+                {
+                    Assert.Equal(0, handle.WaitForExitOrKillOnTimeout(TimeSpan.FromSeconds(5)).ExitCode);
+                }
+            }
+
+            string[] lines = output.Split(Environment.NewLine, StringSplitOptions.RemoveEmptyEntries);
+            Array.Sort(lines, StringComparer.Ordinal);
+            Assert.Equal(["0", "1", "2"], lines);
+        }
+    }
+
+    [Fact]
+    public static void StartMany_EmptyOptions_ReturnsEmptyArray()
+    {
+        SafeChildProcessHandle[] handles = SafeChildProcessHandle.StartMany([], input: null, output: null, error: null);
+
+        Assert.Empty(handles);
+    }
+
+    [Fact]
+    public static void StartMany_NullOptions_ThrowsArgumentNullException()
+    {
+        ProcessStartOptions[] options = [new("echo"), null!];
+
+        Assert.Throws<ArgumentNullException>(() => SafeChildProcessHandle.StartMany(options, input: null, output: null, error: null));
+    }
+
+    [Fact]
+    public static void StartMany_OneProcessFailsToStart_ThrowsWin32Exception()
+    {
+        ProcessStartOptions valid = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "echo test" } }
+            : new("echo") { Arguments = { "test" } };
+        ProcessStartOptions invalid = OperatingSystem.IsWindows()
+            ? new("cmd.exe") { Arguments = { "/c", "echo test" }, WorkingDirectory = Path.Combine(Path.GetTempPath(), Guid.NewGuid().ToString("N")) }
+            : new("echo") { Arguments = { "test" }, WorkingDirectory = Path.Combine(Path.GetTempPath(), Guid.NewGuid().ToString("N")) };
+
+        Assert.Throws<System.ComponentModel.Win32Exception>(() => SafeChildProcessHandle.StartMany([valid, invalid, valid], input: null, output: null, error: null));
+    }
+
     [Fact]
     public static void PublicConstructor_NegativeProcessId_ThrowsArgumentOutOfRangeException()
     {
@@ -910,4 +1034,140 @@ public partial class SafeChildProcessHandleTests
         var ex = Assert.Throws<ArgumentOutOfRangeException>(() => new SafeChildProcessHandle(IntPtr.Zero, 0, ownsHandle: false));
         Assert.Equal("processId", ex.ParamName);
     }
+
+    [Fact]
+    public static void WaitAny_ReturnsTheIndexOfTheProcessThatExited()
+    {
+        using SafeChildProcessHandle sleeping = SafeChildProcessHandle.Start(CreateSleepOptions(10), input: null, output: null, error: null);
+        using SafeChildProcessHandle exiting = SafeChildProcessHandle.Start(CreateSleepOptions(0), input: null, output: null, error: null);
+
+        try
+        {
+            Assert.Equal(1, SafeChildProcessHandle.WaitAny([sleeping, exiting], TimeSpan.FromSeconds(5)));
+
+            // The process is not reaped, so its exit status is still available.
+            Assert.True(exiting.TryWaitForExit(TimeSpan.Zero, out ProcessExitStatus? exitStatus));
+            Assert.Equal(0, exitStatus.ExitCode);
+        }
+        finally
+        {
+            sleeping.Kill();
+            sleeping.WaitForExit();
+        }
+    }
+
+    [Fact]
+    public static void WaitAny_ReturnsMinusOneOnTimeout()
+    {
+        using SafeChildProcessHandle first = SafeChildProcessHandle.Start(CreateSleepOptions(10), input: null, output: null, error: null);
+        using SafeChildProcessHandle second = SafeChildProcessHandle.Start(CreateSleepOptions(10), input: null, output: null, error: null);
+
+        try
+        {
+            Stopwatch stopwatch = Stopwatch.StartNew();
+            Assert.Equal(-1, SafeChildProcessHandle.WaitAny([first, second], TimeSpan.FromMilliseconds(300)));
+            Assert.InRange(stopwatch.Elapsed, TimeSpan.FromMilliseconds(290), TimeSpan.FromSeconds(5));
+        }
+        finally
+        {
+            first.Kill();
+            second.Kill();
+            first.WaitForExit();
+            second.WaitForExit();
+        }
+    }
+
+    [Fact]
+    public static void WaitAny_ThrowsForNoHandles()
+    {
+        Assert.Throws<ArgumentException>(() => SafeChildProcessHandle.WaitAny([], TimeSpan.FromSeconds(1)));
+        Assert.Throws<ArgumentNullException>(() => SafeChildProcessHandle.WaitAny([null!], TimeSpan.FromSeconds(1)));
+    }
+
+    [Fact]
+    public static void WaitAll_WaitsForAllTheProcesses()
+    {
+        SafeChildProcessHandle[] handles = SafeChildProcessHandle.StartMany(
+            [CreateSleepOptions(0), CreateSleepOptions(1), CreateSleepOptions(0)], input: null, output: null, error: null);
+
+        try
+        {
+            Assert.True(SafeChildProcessHandle.WaitAll(handles, TimeSpan.FromSeconds(10)));
+
+            foreach (SafeChildProcessHandle handle in handles)
+            {
+                Assert.True(handle.TryWaitForExit(TimeSpan.Zero, out _));
+            }
+        }
+        finally
+        {
+            foreach (SafeChildProcessHandle handle in handles)
+            {
+                handle.Dispose();
+            }
+        }
+    }
+
+    [Fact]
+    public static void WaitAll_ReturnsFalseOnTimeout()
+    {
+        using SafeChildProcessHandle exiting = SafeChildProcessHandle.Start(CreateSleepOptions(0), input: null, output: null, error: null);
+        using SafeChildProcessHandle sleeping = SafeChildProcessHandle.Start(CreateSleepOptions(10), input: null, output: null, error: null);
+
+        try
+        {
+            Assert.False(SafeChildProcessHandle.WaitAll([exiting, sleeping], TimeSpan.FromMilliseconds(500)));
+        }
+        finally
+        {
+            sleeping.Kill();
+            sleeping.WaitForExit();
+            exiting.WaitForExit();
+        }
+    }
+
+    [Fact]
+    public static async Task WaitForExitsAsync_ReportsTheExitsInCompletionOrder()
+    {
+        using SafeChildProcessHandle slow = SafeChildProcessHandle.Start(CreateSleepOptions(2), input: null, output: null, error: null);
+        using SafeChildProcessHandle fast = SafeChildProcessHandle.Start(CreateSleepOptions(0), input: null, output: null, error: null);
+
+        List<SafeChildProcessHandle> exited = new();
+        using CancellationTokenSource cts = new(TimeSpan.FromSeconds(10));
+        await foreach ((SafeChildProcessHandle handle, ProcessExitStatus exitStatus) in SafeChildProcessHandle.WaitForExitsAsync([slow, fast], cts.Token))
+        {
+            Assert.Equal(0, exitStatus.ExitCode);
+            exited.Add(handle);
+        }
+
+        Assert.Equal(2, exited.Count);
+        Assert.Same(fast, exited[0]);
+        Assert.Same(slow, exited[1]);
+    }
+
+    [Fact]
+    public static async Task WaitForExitsAsync_ThrowsOnCancellation()
+    {
+        using SafeChildProcessHandle processHandle = SafeChildProcessHandle.Start(CreateSleepOptions(10), input: null, output: null, error: null);
+
+        try
+        {
+            using CancellationTokenSource cts = new(TimeSpan.FromMilliseconds(200));
+            await Assert.ThrowsAnyAsync<OperationCanceledException>(async () =>
+            {
+                await foreach ((SafeChildProcessHandle, ProcessExitStatus) _ in SafeChildProcessHandle.WaitForExitsAsync([processHandle], cts.Token))
+                {
+                }
+            });
+        }
+        finally
+        {
+            processHandle.Kill();
+            processHandle.WaitForExit();
+        }
+    }
+
+    private static ProcessStartOptions CreateSleepOptions(int seconds) => OperatingSystem.IsWindows()
+        ? new("powershell") { Arguments = { "-InputFormat", "None", "-Command", $"Start-Sleep {seconds}" } }
+        : new("sleep") { Arguments = { seconds.ToString() } };
 }
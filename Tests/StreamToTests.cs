@@ -0,0 +1,87 @@
+using System;
+using System.Buffers;
+using System.TBA;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace Tests;
+
+public class StreamToTests
+{
+    [Theory]
+    [InlineData(true)]
+    [InlineData(false)]
+    public static async Task StreamTo_WritesStdOutAndStdErrToTheWriters(bool useAsync)
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo Hello from stdout && echo Error from stderr 1>&2 && exit 3" } }
+            : new("sh") { Arguments = { "-c", "echo 'Hello from stdout' && echo 'Error from stderr' >&2 && exit 3" } };
+
+        ArrayBufferWriter<byte> output = new(), error = new();
+
+        ProcessExitStatus exitStatus = useAsync
+            ? await ChildProcess.StreamToAsync(options, output, error)
+            : ChildProcess.StreamTo(options, output, error);
+
+        Assert.Equal(OperatingSystem.IsWindows() ? "Hello from stdout \r\n" : "Hello from stdout\n", Encoding.UTF8.GetString(output.WrittenSpan));
+        Assert.Equal(OperatingSystem.IsWindows() ? "Error from stderr \r\n" : "Error from stderr\n", Encoding.UTF8.GetString(error.WrittenSpan));
+        Assert.Equal(3, exitStatus.ExitCode);
+    }
+
+    [Theory]
+    [InlineData(true)]
+    [InlineData(false)]
+    public static async Task StreamTo_AsksForNewMemoryAfterEveryRead(bool useAsync)
+    {
+        // seq prints 488895 bytes, far more than a pipe can hold.
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("powershell") { Arguments = { "-InputFormat", "None", "-Command", "1..100000 | ForEach-Object { $_ }" } }
+            : new("seq") { Arguments = { "100000" } };
+
+        SmallChunksWriter output = new();
+        ArrayBufferWriter<byte> error = new();
+
+        ProcessExitStatus exitStatus = useAsync
+            ? await ChildProcess.StreamToAsync(options, output, error)
+            : ChildProcess.StreamTo(options, output, error);
+
+        string[] lines = Encoding.UTF8.GetString(output.Written.WrittenSpan).Split(OperatingSystem.IsWindows() ? "\r\n" : "\n", StringSplitOptions.RemoveEmptyEntries);
+        Assert.Equal(100000, lines.Length);
+        Assert.Equal("1", lines[0]);
+        Assert.Equal("100000", lines[^1]);
+        Assert.Equal(0, exitStatus.ExitCode);
+    }
+
+    [Fact]
+    public static async Task StreamTo_ThrowsForInvalidArguments()
+    {
+        ProcessStartOptions options = new("echo");
+        ArrayBufferWriter<byte> writer = new();
+
+        Assert.Throws<ArgumentNullException>(() => ChildProcess.StreamTo(null!, writer, new ArrayBufferWriter<byte>()));
+        Assert.Throws<ArgumentNullException>(() => ChildProcess.StreamTo(options, null!, writer));
+        Assert.Throws<ArgumentNullException>(() => ChildProcess.StreamTo(options, writer, null!));
+        Assert.Throws<ArgumentException>(() => ChildProcess.StreamTo(options, writer, writer));
+        await Assert.ThrowsAsync<ArgumentException>(() => ChildProcess.StreamToAsync(options, writer, writer));
+    }
+
+    // Returns a few bytes at a time, and a new array after every Advance: the bytes read into the previous one would be lost.
+    private sealed class SmallChunksWriter : IBufferWriter<byte>
+    {
+        private const int ChunkSize = 7;
+
+        private byte[] _chunk = new byte[ChunkSize];
+
+        internal ArrayBufferWriter<byte> Written { get; } = new();
+
+        public void Advance(int count)
+        {
+            Written.Write(_chunk.AsSpan(0, count));
+            _chunk = new byte[ChunkSize];
+        }
+
+        public Memory<byte> GetMemory(int sizeHint = 0) => _chunk;
+
+        public Span<byte> GetSpan(int sizeHint = 0) => _chunk;
+    }
+}
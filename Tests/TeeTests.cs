@@ -0,0 +1,140 @@
+using System;
+using System.IO;
+using System.Linq;
+using System.TBA;
+using System.Text;
+
+namespace Tests;
+
+public class TeeTests
+{
+    [Fact]
+    public static void Tee_WritesOutputToFileAndReturnsTail()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo Hello from stdout && echo Error from stderr 1>&2" } }
+            : new("sh") { Arguments = { "-c", "echo 'Hello from stdout' && echo 'Error from stderr' >&2" } };
+
+        string filePath = Path.GetTempFileName();
+
+        try
+        {
+            CombinedOutput result = ChildProcess.Tee(options, filePath, tailLength: 10);
+
+            string expected = OperatingSystem.IsWindows()
+                ? "Hello from stdout \r\nError from stderr \r\n"
+                : "Hello from stdout\nError from stderr\n";
+
+            Assert.Equal(expected, File.ReadAllText(filePath));
+            Assert.Equal(expected.Substring(expected.Length - 10), result.GetText());
+            Assert.Equal(0, result.ExitStatus.ExitCode);
+        }
+        finally
+        {
+            File.Delete(filePath);
+        }
+    }
+
+    [Theory]
+    [InlineData(0)]
+    [InlineData(1)]
+    [InlineData(100_000)]
+    [InlineData(10_000_000)]
+    public static void Tee_HandlesLargeOutput(int tailLength)
+    {
+        byte[] expected = new byte[3 * 1024 * 1024];
+        new Random(42).NextBytes(expected);
+
+        string inputPath = Path.GetTempFileName();
+        string outputPath = Path.GetTempFileName();
+        File.WriteAllBytes(inputPath, expected);
+
+        try
+        {
+            ProcessStartOptions options = OperatingSystem.IsWindows()
+                ? new("cmd") { Arguments = { "/c", "type", inputPath } }
+                : new("cat") { Arguments = { inputPath } };
+
+            CombinedOutput result = ChildProcess.Tee(options, outputPath, tailLength);
+
+            Assert.Equal(expected, File.ReadAllBytes(outputPath));
+            Assert.Equal(expected.Skip(Math.Max(0, expected.Length - tailLength)).ToArray(), result.Bytes.ToArray());
+            Assert.Equal(0, result.ExitStatus.ExitCode);
+        }
+        finally
+        {
+            File.Delete(inputPath);
+            File.Delete(outputPath);
+        }
+    }
+
+    [Fact]
+    public static void Tee_OverwritesExistingFile()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo new" } }
+            : new("sh") { Arguments = { "-c", "echo new" } };
+
+        string filePath = Path.GetTempFileName();
+        File.WriteAllText(filePath, new string('x', 1000));
+
+        try
+        {
+            CombinedOutput result = ChildProcess.Tee(options, filePath);
+
+            string expected = OperatingSystem.IsWindows() ? "new\r\n" : "new\n";
+            Assert.Equal(expected, File.ReadAllText(filePath));
+            Assert.Equal(expected, result.GetText());
+        }
+        finally
+        {
+            File.Delete(filePath);
+        }
+    }
+
+    [Fact]
+    public static void Tee_ReturnsTailWhenTheFileCanNotBeReadBack()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("cmd") { Arguments = { "/c", "echo test" } }
+            : new("sh") { Arguments = { "-c", "echo test" } };
+
+        CombinedOutput result = ChildProcess.Tee(options, OperatingSystem.IsWindows() ? "NUL" : "/dev/null");
+
+        Assert.Equal(OperatingSystem.IsWindows() ? "test\r\n" : "test\n", result.GetText());
+        Assert.Equal(0, result.ExitStatus.ExitCode);
+    }
+
+    [Fact]
+    public static void Tee_KillsOnTimeout()
+    {
+        ProcessStartOptions options = OperatingSystem.IsWindows()
+            ? new("powershell") { Arguments = { "-InputFormat", "None", "-Command", "Write-Output started; Start-Sleep 10" } }
+            : new("sh") { Arguments = { "-c", "echo started && sleep 10" } };
+
+        string filePath = Path.GetTempFileName();
+
+        try
+        {
+            CombinedOutput result = ChildProcess.Tee(options, filePath, timeout: TimeSpan.FromMilliseconds(500));
+
+            Assert.True(result.ExitStatus.Canceled);
+            Assert.True(File.ReadAllText(filePath).StartsWith("started", StringComparison.Ordinal));
+        }
+        finally
+        {
+            File.Delete(filePath);
+        }
+    }
+
+    [Fact]
+    public static void Tee_ThrowsForInvalidArguments()
+    {
+        ProcessStartOptions options = new("sh");
+
+        Assert.Throws<ArgumentNullException>(() => ChildProcess.Tee(null!, "file"));
+        Assert.Throws<ArgumentNullException>(() => ChildProcess.Tee(options, null!));
+        Assert.Throws<ArgumentException>(() => ChildProcess.Tee(options, ""));
+        Assert.Throws<ArgumentOutOfRangeException>(() => ChildProcess.Tee(options, "file", tailLength: -1));
+    }
+}